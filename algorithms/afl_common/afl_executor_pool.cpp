@@ -0,0 +1,157 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+#include "fuzzuf/algorithms/afl/afl_executor_pool.hpp"
+
+#include "fuzzuf/algorithms/afl/afl_option.hpp"
+#include "fuzzuf/utils/common.hpp"
+#include "fuzzuf/utils/cpu_affinity.hpp"
+
+namespace fuzzuf::algorithm::afl {
+
+ExecutionRecorder::ExecutionRecorder(executor::AFLExecutorInterface &executor,
+                                     ExecutionRecord &record)
+    : executor(executor), record(record) {}
+
+const RecordedExecution &ExecutionRecorder::Run(const u8 *buf, u32 len,
+                                                u32 tmout) {
+  u64 start_us = utils::GetCurTimeUs();
+  executor.Run(buf, len, tmout);
+  u64 stop_us = utils::GetCurTimeUs();
+
+  RecordedExecution execution{0, executor.GetExitStatusFeedback(),
+                              stop_us - start_us};
+
+  auto inp_feed = executor.GetAFLFeedback();
+  inp_feed.ShowMemoryToFunc([this, &execution](const u8 *trace_bits,
+                                               u32 map_size) {
+    u32 cksum = utils::Hash32(trace_bits, map_size,
+                              option::GetHashConst<option::AFLTag>());
+    auto &cksums = record.trace_cksums;
+    for (execution.trace_id = 0; execution.trace_id < cksums.size();
+         execution.trace_id++) {
+      if (cksums[execution.trace_id] == cksum) return;
+    }
+    record.traces.emplace_back(trace_bits, trace_bits + map_size);
+    cksums.emplace_back(cksum);
+  });
+
+  record.executions.emplace_back(execution);
+  return record.executions.back();
+}
+
+AFLExecutorPool::AFLExecutorPool(
+    std::vector<std::shared_ptr<executor::AFLExecutorInterface>> &&executors,
+    std::vector<int> &&locked_cpus)
+    : executors(std::move(executors)), locked_cpus(std::move(locked_cpus)) {}
+
+AFLExecutorPool::~AFLExecutorPool() {
+  Stop();
+
+  // The fork servers must be gone before the cores are handed to others
+  executors.clear();
+  for (int cpuid : locked_cpus) utils::ReleaseVacantCpu(cpuid);
+}
+
+void AFLExecutorPool::Start(std::size_t n, Job &&new_job) {
+  Stop();
+
+  job = std::move(new_job);
+  job_count = n;
+  next_job = 0;
+  next_record = 0;
+  stopping = false;
+  records.clear();
+  errors.clear();
+
+  for (auto &executor : executors) {
+    workers.emplace_back([this, &executor] { Work(*executor); });
+  }
+}
+
+ExecutionRecord AFLExecutorPool::Take() {
+  std::unique_lock<std::mutex> lock(mutex);
+
+  std::size_t index = next_record++;
+  job_done.wait(lock, [this, index] {
+    return records.count(index) || errors.count(index);
+  });
+  job_taken.notify_all();
+
+  auto error = errors.find(index);
+  if (error != errors.end()) {
+    std::rethrow_exception(error->second);
+  }
+
+  auto record = std::move(records.at(index));
+  records.erase(index);
+  return record;
+}
+
+void AFLExecutorPool::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  job_taken.notify_all();
+
+  for (auto &worker : workers) worker.join();
+  workers.clear();
+}
+
+void AFLExecutorPool::ReceiveStopSignal() {
+  for (auto &executor : executors) executor->ReceiveStopSignal();
+}
+
+void AFLExecutorPool::Work(executor::AFLExecutorInterface &executor) {
+  // Each executor has at most two jobs waiting to be taken
+  const std::size_t window = executors.size() * 2;
+
+  while (true) {
+    std::size_t index;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      job_taken.wait(lock, [this, window] {
+        return stopping || next_job == job_count ||
+               next_job < next_record + window;
+      });
+      if (stopping || next_job == job_count) return;
+      index = next_job++;
+    }
+
+    ExecutionRecord record;
+    std::exception_ptr error;
+    try {
+      ExecutionRecorder recorder(executor, record);
+      job(index, recorder);
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (error) {
+        errors.emplace(index, error);
+      } else {
+        records.emplace(index, std::move(record));
+      }
+    }
+    job_done.notify_all();
+  }
+}
+
+}  // namespace fuzzuf::algorithm::afl
@@ -0,0 +1,174 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file afl_trim_engine.cpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#include "fuzzuf/algorithms/afl/afl_trim_engine.hpp"
+
+#include <algorithm>
+
+namespace fuzzuf::algorithm::afl {
+
+AFLTrimEngine::AFLTrimEngine(const u8 *buf, u32 len, u32 exec_cksum,
+                             u32 min_bytes, u32 start_steps, u32 end_steps,
+                             u32 batch_size)
+    : input(buf, buf + len),
+      exec_cksum(exec_cksum),
+      min_bytes(min_bytes),
+      end_steps(end_steps),
+      batch_size(std::max(batch_size, 1u)) {
+  /* Select initial chunk len, starting with large steps. */
+  remove_len = std::max<u32>(utils::NextP2(len) / start_steps, min_bytes);
+  max_chunk = remove_len;
+  UpdateEndLen();
+}
+
+// end_len is re-calculated everytime the input gets shorter
+void AFLTrimEngine::UpdateEndLen() {
+  end_len = std::max<u32>(utils::NextP2(input.size()) / end_steps, min_bytes);
+}
+
+// Hash of the input without [pos, pos + len), computed without copying it
+u64 AFLTrimEngine::HashWithGap(u32 pos, u32 len) const {
+  XXH3_state_t hash_state;
+  XXH3_64bits_reset(&hash_state);
+  XXH3_64bits_update(&hash_state, input.data(), pos);
+  XXH3_64bits_update(&hash_state, input.data() + pos + len,
+                     input.size() - pos - len);
+  return XXH3_64bits_digest(&hash_state);
+}
+
+bool AFLTrimEngine::Consume(const Candidate &candidate, u32 cksum) {
+  /* If the deletion had no impact on the trace, make it permanent. This
+     isn't perfect for variable-path inputs, but we're just making a
+     best-effort pass, so it's not a big deal if we end up with false
+     negatives every now and then. */
+
+  if (cksum == exec_cksum) {
+    input.erase(input.begin() + candidate.pos,
+                input.begin() + candidate.pos + candidate.len);
+    trimmed = true;
+    UpdateEndLen();
+
+    // Try a longer chunk next, in case the removable region goes on
+    chunk = std::max(std::min(candidate.len * 2, max_chunk), remove_len);
+    return true;
+  }
+
+  if (chunk > remove_len)
+    chunk = remove_len;
+  else
+    remove_pos += remove_len;
+  return false;
+}
+
+bool AFLTrimEngine::Run(const Runner &runner, const OnPass &on_pass) {
+  std::vector<Candidate> candidates;
+  std::vector<std::size_t> executed_candidates;
+  std::vector<std::size_t> offsets;
+  std::vector<u8> data;
+  std::vector<executor::BatchInput> inputs;
+
+  /* Continue until the number of steps gets too high or the stepover
+     gets too small. */
+
+  for (; remove_len >= end_len; remove_len >>= 1) {
+    on_pass(remove_len, input.size() / remove_len);
+
+    remove_pos = remove_len;
+    chunk = remove_len;
+    while (remove_pos < input.size()) {
+      // Make the candidates from here, assuming each is rejected
+      candidates.clear();
+      for (u32 pos = remove_pos, len = chunk;
+           candidates.size() < batch_size && pos < input.size();) {
+        u32 avail = std::min<u32>(len, input.size() - pos);
+        u64 hash = HashWithGap(pos, avail);
+
+        // The same candidate may appear twice in a batch, e.g. when removing
+        // any chunk of a run of the same bytes. Only the first is executed
+        bool cached =
+            cache.count(hash) ||
+            std::any_of(candidates.begin(), candidates.end(),
+                        [hash](const Candidate &c) { return c.hash == hash; });
+        candidates.emplace_back(Candidate{pos, avail, hash, cached});
+
+        if (len > remove_len)
+          len = remove_len;
+        else
+          pos += remove_len;
+      }
+
+      executed_candidates.clear();
+      offsets.clear();
+      data.clear();
+      for (std::size_t k = 0; k < candidates.size(); k++) {
+        const auto &candidate = candidates[k];
+        if (candidate.cached) continue;
+
+        executed_candidates.emplace_back(k);
+        offsets.emplace_back(data.size());
+        data.insert(data.end(), input.begin(), input.begin() + candidate.pos);
+        data.insert(data.end(),
+                    input.begin() + candidate.pos + candidate.len,
+                    input.end());
+      }
+      inputs.clear();
+      for (std::size_t i = 0; i < executed_candidates.size(); i++) {
+        inputs.emplace_back(executor::BatchInput{
+            data.data() + offsets[i],
+            u32(input.size() - candidates[executed_candidates[i]].len)});
+      }
+
+      // The candidates are consumed in order, the cached ones included
+      std::size_t next = 0;
+      bool accepted = false;
+      auto consume_cached = [&](std::size_t until) {
+        for (; !accepted && next < until; next++) {
+          cache_hits++;
+          accepted =
+              Consume(candidates[next], cache.at(candidates[next].hash));
+        }
+      };
+
+      consume_cached(executed_candidates.empty() ? candidates.size()
+                                                 : executed_candidates[0]);
+      if (accepted || inputs.empty()) continue;
+
+      bool completed = runner(
+          executor::BatchInputRange(inputs.data(),
+                                    inputs.data() + inputs.size()),
+          [&](std::size_t i, u32 cksum) {
+            std::size_t k = executed_candidates[i];
+            cache.emplace(candidates[k].hash, cksum);
+            accepted = Consume(candidates[k], cksum);
+            next = k + 1;
+            consume_cached(i + 1 < executed_candidates.size()
+                               ? executed_candidates[i + 1]
+                               : candidates.size());
+            return accepted;
+          });
+      if (!completed) return false;
+    }
+  }
+
+  return true;
+}
+
+}  // namespace fuzzuf::algorithm::afl
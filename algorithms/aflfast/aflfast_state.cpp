@@ -50,46 +50,15 @@ void AFLFastState::UpdateBitmapScoreWithRawTrace(AFLFastTestcase &testcase,
   u64 fuzz_p2 = fuzzuf::utils::NextP2(testcase.n_fuzz);
   u64 fav_factor = testcase.exec_us * testcase.input->GetLen();
 
-  for (u32 i = 0; i < map_size; i++) {
-    if (trace_bits[i]) {
-      if (top_rated[i]) {
-        auto &top_testcase = top_rated[i].value().get();
-
+  UpdateTopRated(
+      testcase, trace_bits, map_size,
+      [fuzz_p2, fav_factor](const AFLFastTestcase &top_testcase) {
         u64 top_rated_fuzz_p2 = fuzzuf::utils::NextP2(top_testcase.n_fuzz);
-        u64 factor = top_testcase.exec_us * top_testcase.input->GetLen();
-
-        if (fuzz_p2 > top_rated_fuzz_p2)
-          continue;
-        else if (fuzz_p2 == top_rated_fuzz_p2) {
-          if (fav_factor > factor) continue;
-        }
-
-        /* Looks like we're going to win. Decrease ref count for the
-           previous winner, discard its trace_bits[] if necessary. */
-        --top_testcase.tc_ref;
-        if (top_testcase.tc_ref == 0) {
-          top_testcase.trace_mini.reset();
-        }
-      }
-
-      /* Insert ourselves as the new winner. */
-
-      top_rated[i] = std::ref(testcase);
-      testcase.tc_ref++;
-
-      if (!testcase.trace_mini) {
-        testcase.trace_mini.reset(
-            new std::bitset<afl::option::GetMapSize<Tag>()>());
-
-        auto &trace_mini = *testcase.trace_mini;
-        for (u32 j = 0; j < afl::option::GetMapSize<Tag>(); j++) {
-          trace_mini[j] = trace_bits[j] != 0;
-        }
-      }
-
-      score_changed = true;
-    }
-  }
+        if (fuzz_p2 != top_rated_fuzz_p2)
+          return fuzz_p2 < top_rated_fuzz_p2;
+        return fav_factor <=
+               top_testcase.exec_us * top_testcase.input->GetLen();
+      });
 }
 
 bool AFLFastState::SaveIfInteresting(
@@ -692,4 +661,13 @@ void AFLFastState::ShowStats(void) {
   fflush(0);
 }
 
+void AFLFastState::SaveCheckpointExtension(
+    utils::CheckpointWriter &writer) const {
+  for (const auto &testcase : case_queue) writer.Write(testcase->n_fuzz);
+}
+
+void AFLFastState::LoadCheckpointExtension(utils::CheckpointReader &reader) {
+  for (auto &testcase : case_queue) testcase->n_fuzz = reader.Read<u64>();
+}
+
 }  // namespace fuzzuf::algorithm::aflfast
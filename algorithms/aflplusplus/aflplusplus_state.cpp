@@ -17,6 +17,7 @@
  */
 #include "fuzzuf/algorithms/aflplusplus/aflplusplus_state.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <memory>
 
@@ -36,9 +37,7 @@ AFLplusplusState::AFLplusplusState(
     std::unique_ptr<optimizer::HavocOptimizer> &&havoc_optimizer)
     : afl::AFLStateTemplate<AFLplusplusTestcase>(setting, executor,
                                                  std::move(havoc_optimizer)),
-      setting(setting),
-      prev_queued_items(0),
-      alias_probability(nullptr) {
+      setting(setting) {
   n_fuzz.reset(new u32[option::GetNFuzzSize<Tag>()]);
 }
 
@@ -56,47 +55,20 @@ void AFLplusplusState::UpdateBitmapScoreWithRawTrace(
   u64 fuzz_p2 = fuzzuf::utils::NextP2(n_fuzz[testcase.n_fuzz_entry]);
   u64 fav_factor = testcase.exec_us * testcase.input->GetLen();
 
-  for (u32 i = 0; i < map_size; i++) {
-    if (trace_bits[i]) {
-      if (top_rated[i]) {
-        auto &top_testcase = top_rated[i].value().get();
-
+  UpdateTopRated(
+      testcase, trace_bits, map_size,
+      [this, fuzz_p2, fav_factor](const AFLplusplusTestcase &top_testcase) {
         u64 top_rated_fuzz_p2 =
             fuzzuf::utils::NextP2(n_fuzz[top_testcase.n_fuzz_entry]);
-        u64 factor = top_testcase.exec_us * top_testcase.input->GetLen();
-
-        if (fuzz_p2 > top_rated_fuzz_p2)
-          continue;
-        else if (fuzz_p2 == top_rated_fuzz_p2) {
-          if (fav_factor > factor) continue;
-        }
-
-        /* Looks like we're going to win. Decrease ref count for the
-           previous winner, discard its trace_bits[] if necessary. */
-        --top_testcase.tc_ref;
-        if (top_testcase.tc_ref == 0) {
-          top_testcase.trace_mini.reset();
-        }
-      }
-
-      /* Insert ourselves as the new winner. */
-
-      top_rated[i] = std::ref(testcase);
-      testcase.tc_ref++;
-
-      if (!testcase.trace_mini) {
-        testcase.trace_mini.reset(
-            new std::bitset<afl::option::GetMapSize<Tag>()>());
-
-        auto &trace_mini = *testcase.trace_mini;
-        for (u32 j = 0; j < afl::option::GetMapSize<Tag>(); j++) {
-          trace_mini[j] = trace_bits[j] != 0;
-        }
-      }
+        if (fuzz_p2 != top_rated_fuzz_p2)
+          return fuzz_p2 < top_rated_fuzz_p2;
+        return fav_factor <=
+               top_testcase.exec_us * top_testcase.input->GetLen();
+      });
+}
 
-      score_changed = true;
-    }
-  }
+void AFLplusplusState::OnTestcaseChanged(AFLplusplusTestcase &testcase) {
+  seed_weights.changed.push_back(testcase.qid);
 }
 
 bool AFLplusplusState::SaveIfInteresting(
@@ -733,4 +705,47 @@ void AFLplusplusState::ShowStats(void) {
   fflush(0);
 }
 
+/* Only the nonzero entries of n_fuzz are saved, since it is large and
+   sparse. */
+void AFLplusplusState::SaveCheckpointExtension(
+    utils::CheckpointWriter &writer) const {
+  for (const auto &testcase : case_queue) writer.Write(testcase->n_fuzz_entry);
+
+  std::vector<u32> indices;
+  std::vector<u32> values;
+  for (u32 i = 0; i < option::GetNFuzzSize<Tag>(); i++) {
+    if (!n_fuzz[i]) continue;
+    indices.push_back(i);
+    values.push_back(n_fuzz[i]);
+  }
+  writer.WriteVector(indices);
+  writer.WriteVector(values);
+}
+
+void AFLplusplusState::LoadCheckpointExtension(
+    utils::CheckpointReader &reader) {
+  for (auto &testcase : case_queue) {
+    testcase->n_fuzz_entry = reader.Read<u64>();
+    if (testcase->n_fuzz_entry >= option::GetNFuzzSize<Tag>()) {
+      throw exceptions::invalid_file("Checkpoint has a broken n_fuzz_entry",
+                                     __FILE__, __LINE__);
+    }
+  }
+
+  auto indices = reader.ReadVector<u32>();
+  auto values = reader.ReadVector<u32>();
+  if (indices.size() != values.size()) {
+    throw exceptions::invalid_file("Checkpoint has broken n_fuzz", __FILE__,
+                                   __LINE__);
+  }
+  std::fill_n(n_fuzz.get(), option::GetNFuzzSize<Tag>(), 0);
+  for (std::size_t i = 0; i < indices.size(); i++) {
+    if (indices[i] >= option::GetNFuzzSize<Tag>()) {
+      throw exceptions::invalid_file("Checkpoint has broken n_fuzz", __FILE__,
+                                     __LINE__);
+    }
+    n_fuzz[indices[i]] = values[i];
+  }
+}
+
 }  // namespace fuzzuf::algorithm::aflplusplus
@@ -22,6 +22,7 @@
  */
 #include "fuzzuf/algorithms/die/die_hierarflow_routines.hpp"
 
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -38,9 +39,7 @@ namespace fuzzuf::algorithm::die::routine::mutation {
  * @param (testcase) Testcase to mutate
  */
 DIEMutCalleeRef DIEMutate::operator()(std::shared_ptr<DIETestcase> testcase) {
-  int fd;
-  u8 *buf_js, *buf_ty;
-  u32 len_js, len_ty;
+  std::vector<DIEMutatorWorker::Mutant> mutants;
   std::vector<std::string> cmd;
 
   fs::path path_die = fs::absolute(state.setting->die_dir);
@@ -60,69 +59,76 @@ DIEMutCalleeRef DIEMutate::operator()(std::shared_ptr<DIETestcase> testcase) {
   state.stage_cur = 0;
   state.stage_max = mut_cnt;
 
-  /* Call esfuzz to mutate testcase */
-  cmd = {
-      "timeout",
-      "30",
-      state.setting->cmd_node,
-      path_esfuzz.string(),                 // Path to esfuzz.js
-      testcase->input->GetPath().string(),  // Input JS
-      path_mutate.string(),                 // Output directory
-      afl::util::DescribeInteger(mut_cnt),  // Number of mutation
-      afl::util::DescribeInteger(seed)      // Seed
-  };
-  fuzzuf::utils::ExecuteCommand(cmd);
-
-  /* Add generated files to queue */
-  for (int n = 0; n < mut_cnt; n++) {
-    state.stage_cur++;
-
-    /* Create path string of output js and type files */
-    fs::path path_js =
-        fuzzuf::utils::StrPrintf("%s/%d.js", path_mutate.c_str(), n);
-    fs::path path_type = path_js.string() + ".t";
-
-    if (!fs::exists(path_js) || !fs::exists(path_type)) {
-      /* esfuzz died for some reason */
-      continue;
-    }
-
-    len_js = fs::file_size(path_js);
-    len_ty = fs::file_size(path_type);
-    if (len_js == 0 || len_ty == 0) {
-      /* esfuzz couldn't write file for some reason */
-      continue;
+  /* Ask the worker to mutate testcase, which returns the generated files */
+  std::optional<int> worker_status;
+  if (state.mutator_worker) {
+    worker_status = state.mutator_worker->Mutate(
+        testcase->input->GetPath().string(), path_mutate.string(), mut_cnt,
+        seed, mutants);
+  }
+  bool use_worker = worker_status.has_value();
+
+  if (!use_worker || mutants.empty()) {
+    /* Call esfuzz to mutate testcase */
+    cmd = {
+        "timeout",
+        "30",
+        state.setting->cmd_node,
+        path_esfuzz.string(),                 // Path to esfuzz.js
+        testcase->input->GetPath().string(),  // Input JS
+        path_mutate.string(),                 // Output directory
+        afl::util::DescribeInteger(mut_cnt),  // Number of mutation
+        afl::util::DescribeInteger(seed)      // Seed
+    };
+    fuzzuf::utils::ExecuteCommand(cmd);
+
+    /* Load generated files */
+    for (int n = 0; n < mut_cnt; n++) {
+      /* Create path string of output js and type files */
+      fs::path path_js =
+          fuzzuf::utils::StrPrintf("%s/%d.js", path_mutate.c_str(), n);
+      fs::path path_type = path_js.string() + ".t";
+
+      if (!fs::exists(path_js) || !fs::exists(path_type)) {
+        /* esfuzz died for some reason */
+        continue;
+      }
+
+      DIEMutatorWorker::Mutant mutant;
+      mutant.js.resize(fs::file_size(path_js));
+      mutant.type.resize(fs::file_size(path_type));
+      if (mutant.js.empty() || mutant.type.empty()) {
+        /* esfuzz couldn't write file for some reason */
+        continue;
+      }
+
+      int fd = fuzzuf::utils::OpenFile(path_js.string(), O_RDONLY);
+      fuzzuf::utils::ReadFile(fd, mutant.js.data(), mutant.js.size());
+      fuzzuf::utils::CloseFile(fd);
+
+      fd = fuzzuf::utils::OpenFile(path_type.string(), O_RDONLY);
+      fuzzuf::utils::ReadFile(fd, mutant.type.data(), mutant.type.size());
+      fuzzuf::utils::CloseFile(fd);
+
+      mutants.emplace_back(std::move(mutant));
     }
 
-    /* Load JS file */
-    fd = fuzzuf::utils::OpenFile(path_js.string(), O_RDONLY);
-    buf_js = static_cast<u8*>(
-        mmap(nullptr, len_js, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0));
-    fuzzuf::utils::CloseFile(fd);
-
-    if (buf_js == MAP_FAILED) {
-      ERROR("Unable to mmap '%s' : %s", path_js.c_str(), strerror(errno));
+    if (use_worker && *worker_status == 0 && !mutants.empty()) {
+      /* The worker failed where esfuzz alone succeeded. It may have been
+         left in a bad state by an earlier mutation, so restart it. */
+      ACTF("esfuzz worker generated nothing. Restarting it...");
+      state.mutator_worker->Reset();
     }
+  }
 
-    /* Load type file */
-    fd = fuzzuf::utils::OpenFile(path_type.string(), O_RDONLY);
-    buf_ty = static_cast<u8*>(
-        mmap(nullptr, len_ty, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0));
-    fuzzuf::utils::CloseFile(fd);
-
-    if (buf_ty == MAP_FAILED) {
-      ERROR("Unable to mmap '%s' : %s", path_type.c_str(), strerror(errno));
-    }
+  /* Execute PUT for each generated file */
+  for (auto& mutant : mutants) {
+    state.stage_cur++;
 
-    /* Execute PUT */
-    if (this->CallSuccessors(buf_js, len_js, buf_ty, len_ty)) {
-      munmap(buf_js, len_js);
-      munmap(buf_ty, len_ty);
+    if (this->CallSuccessors(mutant.js.data(), mutant.js.size(),
+                             mutant.type.data(), mutant.type.size())) {
       return this->GoToParent();
     }
-
-    munmap(buf_js, len_js);
-    munmap(buf_ty, len_ty);
   }
 
   return GoToDefaultNext();
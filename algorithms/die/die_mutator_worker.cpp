@@ -0,0 +1,237 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file die_mutator_worker.cpp
+ * @brief Persistent node process running esfuzz and typer of DIE
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#include "fuzzuf/algorithms/die/die_mutator_worker.hpp"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "fuzzuf/algorithms/afl/afl_util.hpp"
+#include "fuzzuf/logger/logger.hpp"
+
+namespace fuzzuf::algorithm::die {
+
+namespace {
+
+/* File descriptors of the worker to receive requests and send responses */
+constexpr int WORKER_REQUEST_FD = 3;
+constexpr int WORKER_RESPONSE_FD = 4;
+
+/* Upper bound of a buffer in a response, to detect a broken stream */
+constexpr u32 MAX_BUFFER_SIZE = 1u << 30;
+
+void AppendU32(std::vector<u8>& dest, u32 value) {
+  for (int i = 0; i < 4; i++, value >>= 8) dest.push_back(value & 0xFFu);
+}
+
+u32 LoadU32(const u8* src) {
+  return u32(src[0]) | u32(src[1]) << 8 | u32(src[2]) << 16 |
+         u32(src[3]) << 24;
+}
+
+}  // namespace
+
+DIEMutatorWorker::DIEMutatorWorker(const std::string& cmd_node,
+                                   const std::string& worker_path,
+                                   const std::string& die_ts_dir,
+                                   u32 timeout_ms)
+    : cmd_node(cmd_node),
+      worker_path(worker_path),
+      die_ts_dir(die_ts_dir),
+      timeout_ms(timeout_ms) {}
+
+DIEMutatorWorker::~DIEMutatorWorker() { Reset(); }
+
+/**
+ * @fn
+ * @brief Spawn node running mutator_worker.js
+ * @return False if the worker couldn't be spawned
+ */
+bool DIEMutatorWorker::Start() {
+  int req_pipe[2], resp_pipe[2];
+
+  if (pipe2(req_pipe, O_CLOEXEC) < 0) return false;
+  if (pipe2(resp_pipe, O_CLOEXEC) < 0) {
+    close(req_pipe[0]);
+    close(req_pipe[1]);
+    return false;
+  }
+
+  pid = fork();
+  if (pid < 0) ERROR("fork() failed");
+
+  if (pid == 0) {
+    /* Child process: Move the pipes to the fds the worker expects. Each end
+       is moved out of the range first, as it may already be on 3 or 4. */
+    int req_fd = fcntl(req_pipe[0], F_DUPFD_CLOEXEC, 10);
+    int resp_fd = fcntl(resp_pipe[1], F_DUPFD_CLOEXEC, 10);
+    if (req_fd < 0 || resp_fd < 0 || dup2(req_fd, WORKER_REQUEST_FD) < 0 ||
+        dup2(resp_fd, WORKER_RESPONSE_FD) < 0) {
+      _exit(-1);
+    }
+
+    execlp(cmd_node.c_str(), cmd_node.c_str(), worker_path.c_str(),
+           die_ts_dir.c_str(), nullptr);
+    _exit(-1);
+  }
+
+  /* Parent process */
+  close(req_pipe[0]);
+  close(resp_pipe[1]);
+  request_fd = req_pipe[1];
+  response_fd = resp_pipe[0];
+
+  return true;
+}
+
+void DIEMutatorWorker::Reset() {
+  if (pid > 0) {
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+    pid = -1;
+  }
+  if (request_fd >= 0) {
+    close(request_fd);
+    request_fd = -1;
+  }
+  if (response_fd >= 0) {
+    close(response_fd);
+    response_fd = -1;
+  }
+}
+
+/**
+ * @fn
+ * @brief Read exactly len bytes of a response unless the deadline passes
+ * @return False if the worker closed the pipe or the deadline passed
+ */
+bool DIEMutatorWorker::ReadExact(void* buf, u32 len, u64 deadline_ms) {
+  if (len == 0) return true;
+
+  u64 now = fuzzuf::utils::GetCurTimeMs();
+  if (now >= deadline_ms) return false;
+
+  u32 remain_ms = deadline_ms - now;
+  u32 ret = fuzzuf::utils::ReadFileTimed(response_fd, buf, len, remain_ms);
+  return ret != 0 && ret <= remain_ms;
+}
+
+/**
+ * @fn
+ * @brief Send a request to the worker and receive its response
+ * @param (fields) Name of the operation followed by the arguments
+ * @param (buffers) Buffers in the response are stored to this if not null
+ * @return Exit status of the script, or std::nullopt on failure
+ */
+std::optional<u32> DIEMutatorWorker::Request(
+    const std::vector<std::string>& fields,
+    std::vector<std::vector<u8>>* buffers) {
+  if (broken) return std::nullopt;
+  if (pid < 0 && !Start()) return std::nullopt;
+
+  std::vector<u8> request;
+  AppendU32(request, fields.size());
+  for (const auto& field : fields) {
+    AppendU32(request, field.size());
+    request.insert(request.end(), field.begin(), field.end());
+  }
+
+  try {
+    fuzzuf::utils::WriteFile(request_fd, request.data(), request.size());
+  } catch (const fuzzuf::utils::FileError&) {
+    /* The worker has exited. If it hasn't answered any request yet, node or
+       the scripts are unusable, so don't try again. */
+    if (!answered) broken = true;
+    Reset();
+    return std::nullopt;
+  }
+
+  u64 deadline_ms = fuzzuf::utils::GetCurTimeMs() + timeout_ms;
+  u8 header[8];
+  if (!ReadExact(header, sizeof(header), deadline_ms)) {
+    /* Same as above if the worker closes the pipe without answering */
+    if (!answered && fuzzuf::utils::GetCurTimeMs() < deadline_ms) {
+      broken = true;
+    }
+    Reset();
+    return std::nullopt;
+  }
+
+  u32 status = LoadU32(header);
+  u32 count = LoadU32(header + 4);
+  for (u32 i = 0; i < count; i++) {
+    u8 size[4];
+    if (!ReadExact(size, sizeof(size), deadline_ms) ||
+        LoadU32(size) > MAX_BUFFER_SIZE) {
+      Reset();
+      return std::nullopt;
+    }
+
+    std::vector<u8> buffer(LoadU32(size));
+    if (!ReadExact(buffer.data(), buffer.size(), deadline_ms)) {
+      Reset();
+      return std::nullopt;
+    }
+    if (buffers) buffers->emplace_back(std::move(buffer));
+  }
+
+  answered = true;
+  return status;
+}
+
+std::optional<int> DIEMutatorWorker::Mutate(const std::string& path_js,
+                                            const std::string& out_dir,
+                                            int count, u32 seed,
+                                            std::vector<Mutant>& mutants) {
+  std::vector<std::vector<u8>> buffers;
+  auto status = Request({"mutate", path_js, out_dir,
+                         afl::util::DescribeInteger(count),
+                         afl::util::DescribeInteger(seed)},
+                        &buffers);
+  if (!status) return std::nullopt;
+
+  /* Buffers are pairs of a JS file and its type file */
+  for (size_t i = 0; i + 1 < buffers.size(); i += 2) {
+    mutants.push_back({std::move(buffers[i]), std::move(buffers[i + 1])});
+  }
+
+  /* esfuzz threw or exited with an error. Unlike a node process run for
+     each mutation, the worker keeps the state of the modules, so start
+     over with a fresh one. */
+  if (*status != 0) Reset();
+
+  return int(*status);
+}
+
+std::optional<int> DIEMutatorWorker::Instrument(const std::string& path_js,
+                                                const std::string& path_jsi) {
+  auto status = Request({"instrument", path_js, path_jsi}, nullptr);
+  if (!status) return std::nullopt;
+  return int(*status);
+}
+
+}  // namespace fuzzuf::algorithm::die
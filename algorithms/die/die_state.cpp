@@ -23,6 +23,7 @@
 #include "fuzzuf/algorithms/die/die_state.hpp"
 
 #include <istream>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -196,6 +197,15 @@ void DIEState::ReadTestcases(void) {
     ERROR("Invalid path to 'typer.py': '%s'", setting->typer_path.c_str());
   }
 
+  /* Start esfuzz and typer in a persistent worker if it's installed */
+  fs::path path_worker =
+      fs::path(setting->typer_path).parent_path() / "mutator_worker.js";
+  if (fs::exists(path_worker)) {
+    mutator_worker = std::make_unique<DIEMutatorWorker>(
+        setting->cmd_node, fs::absolute(path_worker).string(),
+        (path_die / "fuzz/TS").string());
+  }
+
   MSG("Pre-processing input JavaScript files...\n"
       "(This process may take a while if it's the first time.)\n");
 
@@ -250,11 +260,21 @@ void DIEState::ReadTestcases(void) {
     /* Instrument JS file */
     ACTF("Instrumenting '%s'...", path_js.c_str());
 
-    cmd = {setting->cmd_node,    // node
-           path_typer.string(),  // typer.js
-           path_js.string(),     // js file
-           path_jsi.string()};   // instrumented js file
-    status = fuzzuf::utils::ExecuteCommand(cmd);
+    std::optional<int> worker_status;
+    if (mutator_worker) {
+      worker_status =
+          mutator_worker->Instrument(path_js.string(), path_jsi.string());
+    }
+
+    if (worker_status) {
+      status = *worker_status;
+    } else {
+      cmd = {setting->cmd_node,    // node
+             path_typer.string(),  // typer.js
+             path_js.string(),     // js file
+             path_jsi.string()};   // instrumented js file
+      status = fuzzuf::utils::ExecuteCommand(cmd);
+    }
 
     if (status != 0) {
       /* Skip if instrumentation failed */
@@ -0,0 +1,135 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file cmp_trace.cpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#include "fuzzuf/algorithms/libfuzzer/cmp_trace.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <string_view>
+
+namespace fuzzuf::algorithm::libfuzzer {
+
+namespace {
+
+std::size_t GetHits(const coverage::CmpHeader &header) {
+  const std::size_t height = header.type == coverage::CMP_TYPE_RTN
+                                 ? coverage::CMP_MAP_RTN_H
+                                 : coverage::CMP_MAP_H;
+  return std::min<std::size_t>(header.hits, height);
+}
+
+const coverage::CmpFnOperands *GetFnOperands(const coverage::CmpMap &map,
+                                             std::size_t index) {
+  return reinterpret_cast<const coverage::CmpFnOperands *>(map.log[index]);
+}
+
+std::size_t GetFnOperandsSize(const coverage::CmpFnOperands &operands) {
+  return std::min<std::size_t>({operands.v0_len, operands.v1_len,
+                                sizeof(operands.v0)});
+}
+
+void ToLittleEndian(std::uint64_t value, std::size_t size, std::uint8_t *dest) {
+  for (std::size_t i = 0u; i != size; ++i, value >>= 8)
+    dest[i] = value & 0xFFu;
+}
+
+}  // namespace
+
+void TableOfRecentCompares::Insert(std::size_t index, const std::uint8_t *arg1,
+                                   const std::uint8_t *arg2, std::size_t size,
+                                   bool integer) {
+  auto &entry = table[index % SIZE];
+  entry.arg1.assign(arg1, arg1 + size);
+  entry.arg2.assign(arg2, arg2 + size);
+  entry.integer = integer;
+}
+
+void UpdateValueProfile(const coverage::CmpMap &map, ValueProfileMap &dest) {
+  for (std::size_t i = 0u; i != coverage::CMP_MAP_W; ++i) {
+    const auto &header = map.headers[i];
+    const std::size_t hits = GetHits(header);
+    if (header.type == coverage::CMP_TYPE_INS) {
+      for (std::size_t j = 0u; j != hits; ++j) {
+        const auto &operands = map.log[i][j];
+        const std::size_t hamming_distance =
+            __builtin_popcountll(operands.v0 ^ operands.v1);
+        const std::size_t absolute_distance =
+            operands.v0 == operands.v1
+                ? 0u
+                : __builtin_clzll(operands.v0 - operands.v1) + 1u;
+        // The ids of the comparisons are dense unlike PCs, so that they are
+        // spread by the prime rather than truncated by the map size
+        dest.AddValueModPrime(i * 128u + hamming_distance);
+        dest.AddValueModPrime(i * 128u + 64u + absolute_distance);
+      }
+    } else if (header.type == coverage::CMP_TYPE_RTN) {
+      const auto *operands = GetFnOperands(map, i);
+      for (std::size_t j = 0u; j != hits; ++j) {
+        const auto &op = operands[j];
+        const std::size_t size = GetFnOperandsSize(op);
+        std::size_t prefix = 0u;
+        std::size_t hamming_distance = 0u;
+        for (; prefix != size; ++prefix) {
+          if (op.v0[prefix] != op.v1[prefix]) {
+            hamming_distance =
+                __builtin_popcount(op.v0[prefix] ^ op.v1[prefix]);
+            break;
+          }
+        }
+        dest.AddValue(((i & 4095u) | (prefix << 12)) + hamming_distance);
+      }
+    }
+  }
+}
+
+void UpdateTableOfRecentCompares(const coverage::CmpMap &map,
+                                 TableOfRecentCompares &dest) {
+  std::uint8_t arg1[sizeof(std::uint64_t)];
+  std::uint8_t arg2[sizeof(std::uint64_t)];
+  for (std::size_t i = 0u; i != coverage::CMP_MAP_W; ++i) {
+    const auto &header = map.headers[i];
+    const std::size_t hits = GetHits(header);
+    if (header.type == coverage::CMP_TYPE_INS) {
+      const std::size_t size = header.shape + 1u;
+      if (size != 2u && size != 4u && size != 8u) continue;
+      if (header.attribute & coverage::CMP_ATTR_IS_FP) continue;
+      for (std::size_t j = 0u; j != hits; ++j) {
+        const auto &operands = map.log[i][j];
+        if (operands.v0 == operands.v1) continue;
+        ToLittleEndian(operands.v0, size, arg1);
+        ToLittleEndian(operands.v1, size, arg2);
+        dest.Insert(operands.v0 ^ operands.v1, arg1, arg2, size, true);
+      }
+    } else if (header.type == coverage::CMP_TYPE_RTN) {
+      const auto *operands = GetFnOperands(map, i);
+      for (std::size_t j = 0u; j != hits; ++j) {
+        const auto &op = operands[j];
+        const std::size_t size = GetFnOperandsSize(op);
+        if (!size || std::equal(op.v0, op.v0 + size, op.v1)) continue;
+        const std::size_t hash = std::hash<std::string_view>()(
+            std::string_view(reinterpret_cast<const char *>(op.v0), size));
+        dest.Insert(i ^ hash, op.v0, op.v1, size, false);
+      }
+    }
+  }
+}
+
+}  // namespace fuzzuf::algorithm::libfuzzer
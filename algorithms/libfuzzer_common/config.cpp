@@ -74,6 +74,7 @@ auto toString(std::string &dest, const FuzzerCreateInfo &value,
   FUZZUF_ALGORITHMS_LIBFUZZER_DUMP_MEMBER(bb_shm_size)
   FUZZUF_ALGORITHMS_LIBFUZZER_DUMP_MEMBER(cpuid_to_bind)
   FUZZUF_ALGORITHMS_LIBFUZZER_DUMP_MEMBER(use_afl_coverage)
+  FUZZUF_ALGORITHMS_LIBFUZZER_DUMP_MEMBER(use_cmp)
   FUZZUF_ALGORITHMS_LIBFUZZER_DUMP_MEMBER(sparse_energy_updates)
   FUZZUF_ALGORITHMS_LIBFUZZER_DUMP_MEMBER(crashed_only)
   FUZZUF_ALGORITHMS_LIBFUZZER_DUMP_MEMBER(max_input_length)
@@ -100,6 +101,7 @@ auto toString(std::string &dest, const FuzzerCreateInfo &value,
   FUZZUF_ALGORITHMS_LIBFUZZER_DUMP_MEMBER(shuffle)
   FUZZUF_ALGORITHMS_LIBFUZZER_DUMP_MEMBER(prefer_small)
   FUZZUF_ALGORITHMS_LIBFUZZER_DUMP_MEMBER(check_input_sha1)
+  FUZZUF_ALGORITHMS_LIBFUZZER_DUMP_MEMBER(parallel_targets)
   return true;
 }
 
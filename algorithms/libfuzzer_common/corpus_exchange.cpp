@@ -0,0 +1,72 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file corpus_exchange.cpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#include "fuzzuf/algorithms/libfuzzer/corpus_exchange.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace fuzzuf::algorithm::libfuzzer {
+
+void CorpusExchange::SetWorkerCount(std::size_t count) {
+  std::lock_guard<std::mutex> lock(mutex);
+  cursors.resize(count, trimmed);
+}
+
+void CorpusExchange::Publish(std::size_t worker,
+                             std::vector<std::uint8_t> &&input) {
+  auto shared =
+      std::make_shared<const std::vector<std::uint8_t>>(std::move(input));
+  std::lock_guard<std::mutex> lock(mutex);
+  log.emplace_back(worker, std::move(shared));
+}
+
+void CorpusExchange::Fetch(std::size_t worker, std::vector<Input> &dest) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &cursor = cursors.at(worker);
+  for (; cursor < trimmed + log.size(); ++cursor) {
+    const auto &[publisher, input] = log[cursor - trimmed];
+    if (publisher != worker) dest.push_back(input);
+  }
+  Trim();
+}
+
+void CorpusExchange::Leave(std::size_t worker) {
+  std::lock_guard<std::mutex> lock(mutex);
+  cursors.at(worker) = std::numeric_limits<std::size_t>::max();
+  Trim();
+}
+
+std::size_t CorpusExchange::GetLogSize() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return log.size();
+}
+
+void CorpusExchange::Trim() {
+  if (cursors.empty()) return;
+  const auto end = trimmed + log.size();
+  const auto read = std::min(*std::min_element(cursors.begin(), cursors.end()),
+                             end);
+  log.erase(log.begin(), log.begin() + (read - trimmed));
+  trimmed = read;
+}
+
+}  // namespace fuzzuf::algorithm::libfuzzer
@@ -21,54 +21,174 @@
  */
 #include "fuzzuf/algorithms/libfuzzer/cli_compat/fuzzer.hpp"
 
+#include <algorithm>
 #include <boost/program_options.hpp>
 #include <cstdint>
 #include <fstream>
+#include <iterator>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_set>
 
 #include "fuzzuf/algorithms/libfuzzer/cli_compat/options.hpp"
 #include "fuzzuf/algorithms/libfuzzer/config.hpp"
 #include "fuzzuf/algorithms/libfuzzer/create.hpp"
+#include "fuzzuf/algorithms/libfuzzer/feature/collect_features.hpp"
+#include "fuzzuf/algorithms/libfuzzer/merge.hpp"
 #include "fuzzuf/cli/fuzzer_args.hpp"
 #include "fuzzuf/cli/global_fuzzer_options.hpp"
+#include "fuzzuf/coverage/cmplog_attacher.hpp"
 #include "fuzzuf/logger/logger.hpp"
+#include "fuzzuf/utils/sha1.hpp"
 
 namespace fuzzuf::algorithm::libfuzzer {
-LibFuzzer::LibFuzzer(cli::FuzzerArgs &fuzzer_args,
-                     const cli::GlobalFuzzerOptions &global,
-                     std::function<void(std::string &&)> &&sink_)
-    : node_tracer([this](std::string &&m) { sink("trace : " + m); }) {
-  Options opts;
-  opts.output_dir = global.out_dir;
-  auto [desc, pd] = createOptions(opts);
 
-  if (!postProcess(fuzzer_args.global_options_description.add(desc), pd,
-                   fuzzer_args.argc, fuzzer_args.argv, global, std::move(sink_),
-                   opts)) {
-    end_ = true;
-    return;
+/**
+ * @struct LibFuzzer::Worker
+ * @brief Variables and flows of a worker other than the worker 0
+ * @details The State in vars, including global_feature_freqs and the rare
+ * features, is deliberately not shared with the other workers. The rare
+ * features are tied to the corpus of the worker: AddRareFeature removes a
+ * dropped feature from the frequencies kept by each input of the corpus, and
+ * resets the global frequency of a feature to 0 when the worker first finds
+ * it. With a shared table, a worker would wipe the counts collected by the
+ * others, and every collected feature would need an atomic operation or a
+ * lock in the hot path. The workers of the original libFuzzer are processes
+ * which keep their own tables too. The frequencies still reflect the other
+ * workers, since their inputs are executed on import.
+ */
+struct LibFuzzer::Worker {
+  Worker(std::size_t index, std::function<void(std::string &&)> &&trace_sink)
+      : index(index), node_tracer(std::move(trace_sink)) {}
+
+  std::size_t index;
+  Variables vars;
+  utils::DumpTracer node_tracer;
+  utils::ElapsedTimeTracer ett;
+  // Takes over the initial corpus of the worker 0
+  std::function<void()> take_over;
+  std::function<void()> import_inputs;
+  std::function<void()> runone;
+  std::vector<CorpusExchange::Input> imported_inputs;
+  testcase_id_t next_id_to_publish = 0u;
+};
+
+namespace {
+
+/**
+ * Publish the inputs added to the corpus since the last call
+ * New inputs are always appended to the end of the sequential index, and their
+ * ids are greater than any existing one.
+ */
+void PublishNewInputs(Variables &vars, std::size_t worker,
+                      testcase_id_t &next_id, CorpusExchange &exchange) {
+  const auto &sequential = vars.corpus.corpus.get<Sequential>();
+  auto begin = sequential.end();
+  while (begin != sequential.begin() && std::prev(begin)->id >= next_id)
+    --begin;
+
+  for (auto iter = begin; iter != sequential.end(); ++iter) {
+    next_id = std::max(next_id, iter->id + 1u);
+    auto input = vars.corpus.inputs.get_ref(iter->id);
+    if (!input) continue;
+    const auto &exec_input = input->get();
+    exchange.Publish(worker, std::vector<std::uint8_t>(
+                                 exec_input.GetBuf(),
+                                 exec_input.GetBuf() + exec_input.GetLen()));
   }
-  create_info = opts.create_info;
-  vars.state.create_info = opts.create_info;
-  vars.rng = std::move(opts.rng);
+}
 
-  exec_input::ExecInputSet initial_inputs = loadInitialInputs(opts, vars.rng);
-  vars.max_input_size =
-      opts.create_info.len_control ? 4u : opts.create_info.max_input_length;
-  sink = std::move(opts.sink);
-  total_cycles = opts.total_cycles;
-  print_final_stats = opts.print_final_stats;
+/**
+ * Run each input found by the other workers through the flow run, which adds
+ * it to the corpus if valuable
+ * The inputs added here are not published again.
+ */
+void ImportInputs(Variables &vars, std::vector<CorpusExchange::Input> &inputs,
+                  const std::function<void()> &run, testcase_id_t &next_id) {
+  if (inputs.empty()) return;
 
-  vars.begin_date = std::chrono::system_clock::now();
-  const auto output_file_path = create_info.output_dir / "result";
-  const auto path_to_write_seed = create_info.output_dir / "cur_input";
-  const auto symcc_dir = create_info.output_dir / "symcc";
-  vars.executors.reserve(opts.targets.size());
+  for (const auto &input : inputs) {
+    vars.input[0].assign(input->begin(), input->end());
+    run();
+  }
+  inputs.clear();
+
+  const auto &sequential = vars.corpus.corpus.get<Sequential>();
+  if (!sequential.empty())
+    next_id = std::max(next_id, std::prev(sequential.end())->id + 1u);
+}
+
+/**
+ * Decide the number of workers from -workers and -jobs
+ * Unlike the original libFuzzer, the workers are threads of this process,
+ * and each of them runs until the fuzzer stops. Thus -jobs only gives the
+ * number of workers when -workers is not specified.
+ * In merge mode, the workers collect the features of the inputs, and all the
+ * workers available are used by default.
+ */
+std::size_t GetWorkerCount(const FuzzerCreateInfo &create_info,
+                           const std::function<void(std::string &&)> &sink) {
+  const std::size_t available =
+      std::max(1u, std::thread::hardware_concurrency() / 2u);
+  std::size_t count = create_info.workers;
+  if (count == 0u) {
+    if (create_info.merge)
+      count = available;
+    else if (create_info.jobs > 1u)
+      count = std::min<std::size_t>(create_info.jobs, available);
+  }
+  if (count <= 1u) return 1u;
+
+  // Without fork server, NativeLinuxExecutor times out executions with a
+  // process-wide signal, which can't be shared by several executors
+  if (!create_info.forksrv) {
+    sink("-workers requires the fork server, so only one worker runs");
+    return 1u;
+  }
+  // The SymCC targets always run without fork server
+  if (create_info.symcc_target_count > 0u) {
+    sink("-workers can't be used with SymCC targets, so only one worker runs");
+    return 1u;
+  }
+  return count;
+}
+
+/**
+ * Create the comparison log shared with the target, if value profile or CMP
+ * tracing is enabled. Otherwise, returns nullptr.
+ */
+auto CreateCmpLog(const FuzzerCreateInfo &create_info)
+    -> std::shared_ptr<coverage::CmpLogAttacher> {
+  if (!create_info.config.use_value_profile_mask && !create_info.use_cmp)
+    return nullptr;
+  auto cmp_log = std::make_shared<coverage::CmpLogAttacher>();
+  cmp_log->Setup();
+  return cmp_log;
+}
+
+/**
+ * Create the executors for each target
+ * Each worker has its own files to pass inputs to the PUT, distinguished by
+ * suffix. If cmp_log is not nullptr, it is attached to the target executed by
+ * the fuzzing flow.
+ */
+auto CreateExecutors(const FuzzerCreateInfo &create_info,
+                     const std::vector<fs::path> &targets,
+                     const std::string &suffix,
+                     const std::shared_ptr<coverage::CmpLogAttacher> &cmp_log)
+    -> std::vector<fuzzuf::executor::LibFuzzerExecutorInterface> {
+  const auto output_file_path = create_info.output_dir / ("result" + suffix);
+  const auto path_to_write_seed =
+      create_info.output_dir / ("cur_input" + suffix);
+  const auto symcc_dir = create_info.output_dir / ("symcc" + suffix);
+  std::vector<fuzzuf::executor::LibFuzzerExecutorInterface> executors;
+  executors.reserve(targets.size());
   std::size_t i = 0u;
-  for (const auto &target_path : opts.targets) {
+  for (const auto &target_path : targets) {
     if (i >= create_info.symcc_target_offset &&
         i < create_info.symcc_target_offset + create_info.symcc_target_count) {
-      vars.executors.push_back(
+      executors.push_back(
           std::shared_ptr<fuzzuf::executor::NativeLinuxExecutor>(
               new fuzzuf::executor::NativeLinuxExecutor(
                   {target_path.string(), output_file_path.string()},
@@ -77,16 +197,70 @@ LibFuzzer::LibFuzzer(cli::FuzzerArgs &fuzzer_args,
                   create_info.bb_shm_size, false,
                   {"SYMCC_OUTPUT_DIR=" + symcc_dir.string()}, {symcc_dir})));
     } else {
-      vars.executors.push_back(
+      std::vector<std::string> environment;
+      if (cmp_log && i == create_info.target_offset)
+        environment.push_back(cmp_log->GetEnvironmentVariable());
+      executors.push_back(
           std::shared_ptr<fuzzuf::executor::NativeLinuxExecutor>(
               new fuzzuf::executor::NativeLinuxExecutor(
                   {target_path.string(), output_file_path.string()},
                   create_info.exec_timelimit_ms, create_info.exec_memlimit,
                   create_info.forksrv, path_to_write_seed,
-                  create_info.afl_shm_size, create_info.bb_shm_size)));
+                  create_info.afl_shm_size, create_info.bb_shm_size, false,
+                  std::move(environment))));
     }
     ++i;
   }
+  return executors;
+}
+
+}  // namespace
+
+LibFuzzer::LibFuzzer(cli::FuzzerArgs &fuzzer_args,
+                     const cli::GlobalFuzzerOptions &global,
+                     std::function<void(std::string &&)> &&sink_)
+    : node_tracer([this](std::string &&m) { sink("trace : " + m); }) {
+  Options opts;
+  opts.output_dir = global.out_dir;
+  auto [desc, pd] = createOptions(opts);
+
+  if (!postProcess(fuzzer_args.global_options_description.add(desc), pd,
+                   fuzzer_args.argc, fuzzer_args.argv, global, std::move(sink_),
+                   opts)) {
+    end_ = true;
+    return;
+  }
+  create_info = opts.create_info;
+  vars.state.create_info = opts.create_info;
+  vars.rng = std::move(opts.rng);
+  sink = std::move(opts.sink);
+  total_cycles = opts.total_cycles;
+  print_final_stats = opts.print_final_stats;
+
+  const std::size_t worker_count = GetWorkerCount(create_info, sink);
+  if (worker_count > 1u) {
+    // The workers output messages from their own threads
+    sink = [mutex = std::make_shared<std::mutex>(),
+            sink = std::move(sink)](std::string &&m) {
+      std::lock_guard<std::mutex> lock(*mutex);
+      sink(std::move(m));
+    };
+  }
+
+  if (create_info.merge) {
+    Merge(opts.input_dir, opts.targets, worker_count);
+    end_ = true;
+    return;
+  }
+
+  exec_input::ExecInputSet initial_inputs = loadInitialInputs(opts, vars.rng);
+  vars.max_input_size =
+      opts.create_info.len_control ? 4u : opts.create_info.max_input_length;
+
+  vars.begin_date = std::chrono::system_clock::now();
+  vars.cmp_trace.cmp_log = CreateCmpLog(create_info);
+  vars.executors =
+      CreateExecutors(create_info, opts.targets, "", vars.cmp_trace.cmp_log);
   {
     auto root = createInitialize<Func, Order>(opts.create_info, initial_inputs,
                                               false, sink);
@@ -102,14 +276,208 @@ LibFuzzer::LibFuzzer(cli::FuzzerArgs &fuzzer_args,
     runone_wrapped(vars, node_tracer, ett);
   };
 
+  if (worker_count > 1u) {
+    auto import_wrapped = hf::WrapToMakeHeadNode(
+        createImport<Func, Order>(opts.create_info, false, sink));
+    import_inputs = [this, import_wrapped]() mutable {
+      import_wrapped(vars, node_tracer, ett);
+    };
+
+    for (std::size_t i = 1u; i < worker_count; ++i) {
+      auto worker = std::make_unique<Worker>(
+          i, [this, i](std::string &&m) {
+            sink("trace[" + std::to_string(i) + "] : " + m);
+          });
+      auto &w = *worker;
+      w.vars.state.create_info = opts.create_info;
+      w.vars.rng.seed(vars.rng());
+      w.vars.max_input_size = vars.max_input_size;
+      w.vars.begin_date = vars.begin_date;
+      w.vars.cmp_trace.cmp_log = CreateCmpLog(create_info);
+      w.vars.executors =
+          CreateExecutors(create_info, opts.targets, "." + std::to_string(i),
+                          w.vars.cmp_trace.cmp_log);
+
+      auto take_over_wrapped = hf::WrapToMakeHeadNode(
+          createImport<Func, Order>(opts.create_info, true, sink));
+      w.take_over = [&w, take_over_wrapped]() mutable {
+        take_over_wrapped(w.vars, w.node_tracer, w.ett);
+      };
+      auto worker_import_wrapped = hf::WrapToMakeHeadNode(
+          createImport<Func, Order>(opts.create_info, false, sink));
+      w.import_inputs = [&w, worker_import_wrapped]() mutable {
+        worker_import_wrapped(w.vars, w.node_tracer, w.ett);
+      };
+      auto worker_runone_wrapped = hf::WrapToMakeHeadNode(
+          createRunone<Func, Order>(opts.create_info, initial_inputs, sink));
+      w.runone = [&w, worker_runone_wrapped]() mutable {
+        worker_runone_wrapped(w.vars, w.node_tracer, w.ett);
+      };
+      workers.push_back(std::move(worker));
+    }
+
+    // The other workers start from the initial corpus of the worker 0
+    corpus_exchange.SetWorkerCount(worker_count);
+    PublishNewInputs(vars, 0u, next_id_to_publish, corpus_exchange);
+    for (auto &worker : workers) {
+      worker_threads.emplace_back([this, &w = *worker] { RunWorker(w); });
+    }
+  }
+
   DEBUG("[*] LibFuzzer::LibFuzzer(): Done");
 }
+
+void LibFuzzer::Merge(const std::vector<std::string> &input_dirs,
+                      const std::vector<fs::path> &targets,
+                      std::size_t worker_count) {
+  std::size_t first_corpus_size = 0u;
+  auto inputs = ListMergeInputs(input_dirs, first_corpus_size);
+
+  // Without merge_control_file, the control file is removed after the merge
+  const bool keep_control_file = !create_info.merge_control_file.empty();
+  const fs::path control_path =
+      keep_control_file ? fs::path(create_info.merge_control_file)
+                        : create_info.output_dir / "merge_control_file";
+  bool resumed = false;
+  {
+    std::ifstream src(control_path.string());
+    resumed = src && LoadMergeControlFile(src, inputs, first_corpus_size);
+  }
+  std::ofstream control(control_path.string(),
+                        resumed ? std::ios::app : std::ios::trunc);
+  if (!control) {
+    ERROR("Unable to open the merge control file: %s", control_path.c_str());
+  }
+  if (!resumed) WriteMergeControlHeader(control, inputs, first_corpus_size);
+
+  const auto processed_earlier = std::count_if(
+      inputs.begin(), inputs.end(),
+      [](const MergeInput &input) { return input.done; });
+  sink("MERGE-OUTER: " + std::to_string(inputs.size()) + " files, " +
+       std::to_string(first_corpus_size) + " in the initial corpus, " +
+       std::to_string(processed_earlier) + " processed earlier");
+
+  // Only the target executed by the fuzzing flow is used
+  const std::vector<fs::path> target{targets[create_info.target_offset]};
+  std::vector<std::vector<fuzzuf::executor::LibFuzzerExecutorInterface>>
+      executors;
+  for (std::size_t i = 0u; i < worker_count; ++i) {
+    executors.push_back(CreateExecutors(
+        create_info, target, i == 0u ? "" : "." + std::to_string(i), nullptr));
+  }
+  std::vector<coverage_t> coverages(worker_count);
+
+  const auto run = [&](std::size_t worker,
+                       const std::vector<std::uint8_t> &input,
+                       std::vector<std::uint32_t> &features) {
+    auto &executor = executors[worker].front();
+    executor.Run(input.data(), input.size());
+    const auto exit_reason = executor.GetExitStatusFeedback().exit_reason;
+    // The inputs crashing the PUT are not merged, as the original libFuzzer
+    if (exit_reason == feedback::PUTExitReasonType::FAULT_CRASH ||
+        exit_reason == feedback::PUTExitReasonType::FAULT_TMOUT ||
+        exit_reason == feedback::PUTExitReasonType::FAULT_ERROR)
+      return false;
+
+    auto &coverage = coverages[worker];
+    const auto assign = [&](const u8 *head, u32 size) {
+      coverage.assign(head, std::next(head, size));
+    };
+    if (create_info.use_afl_coverage)
+      executor.GetAFLFeedback().ShowMemoryToFunc(assign);
+    else
+      executor.GetBBFeedback().ShowMemoryToFunc(assign);
+    // Only create_info of the state is referred here, so the state can be
+    // shared among the workers
+    feature::CollectFeatures(vars.state, coverage, 0u,
+                             [&](auto f) -> void { features.push_back(f); });
+    return true;
+  };
+  const std::size_t executed = CollectMergeFeatures(
+      inputs, worker_count, run, control, stop_workers);
+  if (stop_workers) {
+    sink("MERGE-OUTER: stopped after executing " + std::to_string(executed) +
+         " files. Run again with the same merge_control_file to resume");
+    return;
+  }
+
+  const auto selected = SelectMergeInputs(inputs, first_corpus_size);
+  std::unordered_set<std::uint32_t> covered;
+  for (std::size_t i = 0u; i < first_corpus_size; ++i)
+    covered.insert(inputs[i].features.begin(), inputs[i].features.end());
+  const std::size_t initial_features = covered.size();
+
+  std::vector<std::uint8_t> data;
+  for (auto index : selected) {
+    covered.insert(inputs[index].features.begin(),
+                   inputs[index].features.end());
+    std::ifstream src(inputs[index].path.string(),
+                      std::ios::in | std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(src),
+                std::istreambuf_iterator<char>());
+    std::ofstream dest(
+        (create_info.input_dir / utils::ToSerializedSha1(data)).string(),
+        std::ios::out | std::ios::binary);
+    std::copy(data.begin(), data.end(), std::ostreambuf_iterator(dest));
+  }
+  sink("MERGE-OUTER: " + std::to_string(selected.size()) +
+       " new files with " + std::to_string(covered.size() - initial_features) +
+       " new features added; " + std::to_string(executed) +
+       " files executed");
+
+  control.close();
+  if (!keep_control_file) fs::remove(control_path);
+}
+
+LibFuzzer::~LibFuzzer() { StopWorkers(); }
+
+void LibFuzzer::RunWorker(Worker &worker) {
+  try {
+    corpus_exchange.Fetch(worker.index, worker.imported_inputs);
+    ImportInputs(worker.vars, worker.imported_inputs, worker.take_over,
+                 worker.next_id_to_publish);
+
+    while (!stop_workers) {
+      corpus_exchange.Fetch(worker.index, worker.imported_inputs);
+      ImportInputs(worker.vars, worker.imported_inputs, worker.import_inputs,
+                   worker.next_id_to_publish);
+      worker.runone();
+      PublishNewInputs(worker.vars, worker.index, worker.next_id_to_publish,
+                       corpus_exchange);
+      if (total_cycles >= 0 && worker.vars.count >= std::size_t(total_cycles))
+        break;
+    }
+  } catch (const std::exception &e) {
+    sink("worker " + std::to_string(worker.index) +
+         " stopped: " + std::string(e.what()));
+  }
+  corpus_exchange.Leave(worker.index);
+}
+
+void LibFuzzer::StopWorkers() {
+  stop_workers = true;
+  for (auto &thread : worker_threads) {
+    if (thread.joinable()) thread.join();
+  }
+  worker_threads.clear();
+}
+
+void LibFuzzer::ReceiveStopSignal(void) { stop_workers = true; }
+
 void LibFuzzer::OneLoop() {
   // DEBUG("[*] LibFuzzer::OneLoop(): end_: %s", end_ ? "true" : "false");
   if (!end_) {
+    if (!workers.empty()) {
+      corpus_exchange.Fetch(0u, imported_inputs);
+      ImportInputs(vars, imported_inputs, import_inputs, next_id_to_publish);
+    }
     runone();
+    if (!workers.empty()) {
+      PublishNewInputs(vars, 0u, next_id_to_publish, corpus_exchange);
+    }
     if (total_cycles >= 0 && vars.count >= std::size_t(total_cycles)) {
       end_ = true;
+      StopWorkers();
       if (print_final_stats) {
         std::string message;
         utils::toStringADL(message, vars.state, 0, "  ");
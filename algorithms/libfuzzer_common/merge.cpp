@@ -0,0 +1,256 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file merge.cpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#include "fuzzuf/algorithms/libfuzzer/merge.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <thread>
+
+#include "fuzzuf/logger/logger.hpp"
+
+namespace fuzzuf::algorithm::libfuzzer {
+
+namespace {
+
+void SortFeatures(std::vector<std::uint32_t> &features) {
+  std::sort(features.begin(), features.end());
+  features.erase(std::unique(features.begin(), features.end()),
+                 features.end());
+}
+
+}  // namespace
+
+auto ListMergeInputs(const std::vector<std::string> &dirs,
+                     std::size_t &first_corpus_size)
+    -> std::vector<MergeInput> {
+  std::vector<MergeInput> inputs;
+  first_corpus_size = 0u;
+  for (std::size_t i = 0u; i < dirs.size(); ++i) {
+    if (!fs::is_directory(dirs[i])) {
+      ERROR("ListMergeInputs: Path is not directory: dir=%s", dirs[i].c_str());
+    }
+
+    std::vector<fs::path> paths;
+    for (const auto &p : fs::recursive_directory_iterator(dirs[i])) {
+      if (fs::is_regular_file(p)) paths.push_back(p.path());
+    }
+    // Sorted, so that the list is the same when the merge is resumed
+    std::sort(paths.begin(), paths.end());
+    for (auto &path : paths) {
+      MergeInput input;
+      input.size = fs::file_size(path);
+      input.path = std::move(path);
+      inputs.push_back(std::move(input));
+    }
+    if (i == 0u) first_corpus_size = inputs.size();
+  }
+  return inputs;
+}
+
+void WriteMergeControlHeader(std::ostream &dest,
+                             const std::vector<MergeInput> &inputs,
+                             std::size_t first_corpus_size) {
+  dest << inputs.size() << '\n' << first_corpus_size << '\n';
+  for (const auto &input : inputs) dest << input.path.string() << '\n';
+  dest << std::flush;
+}
+
+bool LoadMergeControlFile(std::istream &src, std::vector<MergeInput> &inputs,
+                          std::size_t first_corpus_size) {
+  std::size_t count = 0u;
+  std::size_t first = 0u;
+  if (!(src >> count >> first)) return false;
+  if (count != inputs.size() || first != first_corpus_size) return false;
+
+  std::string line;
+  std::getline(src, line);
+  for (const auto &input : inputs) {
+    if (!std::getline(src, line) || line != input.path.string()) return false;
+  }
+
+  std::vector<unsigned int> started(count, 0u);
+  std::vector<bool> done(count, false);
+  std::vector<std::vector<std::uint32_t>> features(count);
+  while (std::getline(src, line)) {
+    std::istringstream fields(line);
+    std::string marker;
+    std::size_t index = 0u;
+    // The last line may be incomplete if the merge was killed
+    if (!(fields >> marker >> index) || index >= count) continue;
+
+    if (marker == "STARTED") {
+      ++started[index];
+    } else if (marker == "FT") {
+      done[index] = true;
+      features[index].assign(std::istream_iterator<std::uint32_t>(fields),
+                             std::istream_iterator<std::uint32_t>());
+    }
+  }
+
+  for (std::size_t i = 0u; i < count; ++i) {
+    if (done[i]) {
+      inputs[i].done = true;
+      inputs[i].features = std::move(features[i]);
+      SortFeatures(inputs[i].features);
+    } else if (started[i] >= 2u) {
+      inputs[i].done = true;
+      inputs[i].features.clear();
+    }
+  }
+  return true;
+}
+
+std::size_t CollectMergeFeatures(
+    std::vector<MergeInput> &inputs, std::size_t worker_count,
+    const std::function<bool(std::size_t, const std::vector<std::uint8_t> &,
+                             std::vector<std::uint32_t> &)> &run,
+    std::ostream &control, const std::atomic<bool> &stop) {
+  std::atomic<std::size_t> next = 0u;
+  std::atomic<std::size_t> executed = 0u;
+  std::mutex mutex;
+  std::exception_ptr error;
+
+  // Each input is taken by exactly one worker, so the workers write to
+  // different elements of inputs
+  auto work = [&](std::size_t worker) {
+    std::vector<std::uint8_t> data;
+    std::vector<std::uint32_t> features;
+    std::string line;
+    while (!stop) {
+      const std::size_t index = next++;
+      if (index >= inputs.size()) break;
+      auto &input = inputs[index];
+      if (input.done) continue;
+
+      std::ifstream file(input.path.string(), std::ios::in | std::ios::binary);
+      data.assign(std::istreambuf_iterator<char>(file),
+                  std::istreambuf_iterator<char>());
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        control << "STARTED " << index << ' ' << data.size() << '\n'
+                << std::flush;
+      }
+
+      features.clear();
+      if (!file || !run(worker, data, features)) features.clear();
+      SortFeatures(features);
+
+      line = "FT " + std::to_string(index);
+      for (auto feature : features) line += ' ' + std::to_string(feature);
+      line += '\n';
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        control << line << std::flush;
+      }
+
+      input.size = data.size();
+      input.features = features;
+      input.done = true;
+      ++executed;
+    }
+  };
+
+  if (worker_count <= 1u) {
+    work(0u);
+    return executed;
+  }
+
+  std::atomic<bool> failed = false;
+  std::vector<std::thread> threads;
+  for (std::size_t worker = 0u; worker < worker_count; ++worker) {
+    threads.emplace_back([&, worker] {
+      try {
+        work(worker);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!failed.exchange(true)) error = std::current_exception();
+        // Let the other workers stop at the next input
+        next = inputs.size();
+      }
+    });
+  }
+  for (auto &thread : threads) thread.join();
+  if (error) std::rethrow_exception(error);
+  return executed;
+}
+
+auto SelectMergeInputs(const std::vector<MergeInput> &inputs,
+                       std::size_t first_corpus_size)
+    -> std::vector<std::size_t> {
+  std::uint32_t max_feature = 0u;
+  for (const auto &input : inputs) {
+    if (!input.features.empty())
+      max_feature = std::max(max_feature, input.features.back());
+  }
+  std::vector<bool> covered(std::size_t(max_feature) + 1u, false);
+  for (std::size_t i = 0u; i < first_corpus_size && i < inputs.size(); ++i) {
+    for (auto feature : inputs[i].features) covered[feature] = true;
+  }
+
+  const auto count_new_features = [&](std::size_t index) {
+    return std::size_t(std::count_if(
+        inputs[index].features.begin(), inputs[index].features.end(),
+        [&](std::uint32_t feature) { return !covered[feature]; }));
+  };
+
+  // (new features, index) ordered so that the top has the most new features,
+  // and the smallest size among them
+  using Candidate = std::pair<std::size_t, std::size_t>;
+  const auto worse = [&](const Candidate &l, const Candidate &r) {
+    if (l.first != r.first) return l.first < r.first;
+    if (inputs[l.second].size != inputs[r.second].size)
+      return inputs[l.second].size > inputs[r.second].size;
+    return l.second > r.second;
+  };
+  std::priority_queue<Candidate, std::vector<Candidate>, decltype(worse)>
+      candidates(worse);
+  for (std::size_t i = first_corpus_size; i < inputs.size(); ++i) {
+    const std::size_t new_features = count_new_features(i);
+    if (new_features) candidates.emplace(new_features, i);
+  }
+
+  // Lazy greedy: the number of new features of an input never increases as
+  // others are selected, so an input still at the top after recounting is
+  // the best one
+  std::vector<std::size_t> selected;
+  while (!candidates.empty()) {
+    auto top = candidates.top();
+    candidates.pop();
+    top.first = count_new_features(top.second);
+    if (top.first == 0u) continue;
+    if (!candidates.empty() && worse(top, candidates.top())) {
+      candidates.push(top);
+      continue;
+    }
+
+    for (auto feature : inputs[top.second].features) covered[feature] = true;
+    selected.push_back(top.second);
+  }
+  return selected;
+}
+
+}  // namespace fuzzuf::algorithm::libfuzzer
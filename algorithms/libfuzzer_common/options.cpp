@@ -110,15 +110,15 @@ auto createOptions(Options &dest)
       "merge", po::value<bool>(&dest.create_info.merge),
       "If 1, the 2-nd, 3-rd, etc corpora will be "
       "merged into the 1-st corpus. Only interesting units will be taken. "
-      "This flag can be used to minimize a corpus. Default to 0.")(
+      "This flag can be used to minimize a corpus. The features of the "
+      "inputs are collected by -workers threads in parallel. Default to 0.")(
       "merge_control_file",
       po::value<std::string>(&dest.create_info.merge_control_file),
       "Specify a control file used for the merge process. "
       "If a merge process gets killed it tries to leave this file "
       "in a state suitable for resuming the merge. "
       "By default a temporary file will be used."
-      "The same file can be used for multistep merge process."
-      "(not implemented yet)")(
+      "The same file can be used for multistep merge process.")(
       "minimize_crash",
       po::value<std::size_t>(&dest.create_info.minimize_crash),
       "If 1, minimizes the provided"
@@ -134,14 +134,13 @@ auto createOptions(Options &dest)
       " discovered by other processes. If 0, disabled. Default to 0."
       "(not implemented yet)")(
       "jobs", po::value<std::size_t>(&dest.create_info.jobs),
-      "Number of jobs to run. If jobs >= 1 we spawn"
-      " this number of jobs in separate worker processes"
-      " with stdout/stderr redirected to fuzz-JOB.log. Default to 0"
-      "(not implemented yet)")(
+      "Number of jobs to run. If -workers is 0, this number of workers"
+      " (up to NumberOfCpuCores()/2) fuzz in parallel sharing the corpus."
+      " Default to 0.")(
       "workers", po::value<std::size_t>(&dest.create_info.workers),
-      "Number of simultaneous worker processes to run the jobs."
-      " If zero, \"min(jobs,NumberOfCpuCores()/2)\" is used. Default to 0."
-      "(not implemented yet)")(
+      "Number of simultaneous worker threads to fuzz in parallel sharing the"
+      " corpus. Requires the fork server. If zero,"
+      " \"min(jobs,NumberOfCpuCores()/2)\" is used. Default to 0.")(
       "dict", po::value<std::vector<std::string>>(&dest.dicts)->multitoken(),
       "Experimental. Use the dictionary file. Default to no dictionaries.")(
       "use_counters", po::value<bool>(&dest.create_info.config.use_counters),
@@ -152,9 +151,12 @@ auto createOptions(Options &dest)
       "sets. Default to 0.")(
       "use_value_profile",
       po::value<bool>(&dest.create_info.config.use_value_profile_mask),
-      "Experimental. If non-zero, use value profile to guide fuzzing. Default "
-      "to 0."
-      "(not implemented yet)")(
+      "Experimental. If non-zero, use value profile to guide fuzzing. The "
+      "target must be built with AFL++'s CmpLog. Default to 0.")(
+      "use_cmp", po::value<bool>(&dest.create_info.use_cmp),
+      "If non-zero, use the operands of the comparisons the target made as "
+      "dictionary words. The target must be built with AFL++'s CmpLog. "
+      "Default to 0.")(
       "only_ascii", po::value<bool>(&dest.create_info.only_ascii),
       "If 1, generate only ASCII (isprint+isspace) inputs. Default to 0.")(
       "artifact_prefix", po::value<std::string>(&dest.output_dir),
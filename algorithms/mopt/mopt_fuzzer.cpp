@@ -60,12 +60,15 @@ void MOptFuzzer::BuildFuzzFlow() {
     auto trim_case =
         CreateNode<TrimCaseTemplate<MOptState>>(*state, *abandon_node);
     auto calc_score = CreateNode<CalcScoreTemplate<MOptState>>(*state, *abandon_node);
+    auto apply_input_to_state =
+        CreateNode<ApplyInputToStateTemplate<MOptState>>(*state, *abandon_node);
     auto apply_det_muts =
         CreateNode<ApplyDetMutsTemplate<MOptState>>(*state, *abandon_node);
     auto apply_rand_muts =
         CreateNode<ApplyRandMutsTemplate<MOptState>>(*state, *abandon_node);
 
     // actual mutations
+    auto input_to_state = CreateNode<InputToStateTemplate<MOptState>>(*state);
     auto bit_flip1 =
         CreateNode<BitFlip1WithAutoDictBuildTemplate<MOptState>>(*state);
     auto bit_flip_other = CreateNode<BitFlipOtherTemplate<MOptState>>(*state);
@@ -111,7 +114,10 @@ void MOptFuzzer::BuildFuzzFlow() {
     fuzz_loop << (cull_queue || select_seed);
 
     select_seed << (consider_skip_mut || retry_calibrate || trim_case ||
-                    calc_score || check_pacemaker ||
+                    calc_score ||
+                    apply_input_to_state << input_to_state << execute.HardLink()
+                                         << normal_update.HardLink() ||
+                    check_pacemaker ||
                     apply_det_muts
                         << (bit_flip1
                                 << execute
@@ -0,0 +1,52 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file fingerprint.cpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#include "fuzzuf/algorithms/nezha/fingerprint.hpp"
+
+#include "fuzzuf/utils/common.hpp"
+
+namespace fuzzuf::algorithm::nezha {
+
+Fingerprint MakeFingerprint(const void *data, std::size_t size) {
+  const auto hash = XXH3_128bits(data, size);
+  return Fingerprint{hash.low64, hash.high64};
+}
+
+Fingerprint MakeFingerprint(const std::vector<bool> &value) {
+  XXH3_state_t state;
+  XXH3_128bits_reset(&state);
+  std::uint64_t word = 0u;
+  std::size_t pos = 0u;
+  for (const bool v : value) {
+    word |= std::uint64_t(v) << (pos % 64u);
+    if (++pos % 64u == 0u) {
+      XXH3_128bits_update(&state, &word, sizeof(word));
+      word = 0u;
+    }
+  }
+  if (pos % 64u) XXH3_128bits_update(&state, &word, sizeof(word));
+  const std::uint64_t size = value.size();
+  XXH3_128bits_update(&state, &size, sizeof(size));
+  const auto hash = XXH3_128bits_digest(&state);
+  return Fingerprint{hash.low64, hash.high64};
+}
+
+}  // namespace fuzzuf::algorithm::nezha
@@ -45,13 +45,22 @@ NezhaFuzzer::NezhaFuzzer(const cli::FuzzerArgs &fuzzer_args,
   auto [desc, pd] = libfuzzer::createOptions(opts);
 
   unsigned int use_output = 0U;
+  unsigned int parallel_targets = 0U;
+  unsigned int verify_fingerprints = 0U;
 
   desc.add_options()(
       "use_output", po::value<unsigned int>(&use_output),
       "If 0, the exit status difference of each target are treated "
       "as differences of targets. Otherwise, the standard output "
       "difference of each target is treated as the difference of "
-      "the targets. Default to 0.");
+      "the targets. Default to 0.")(
+      "parallel_targets", po::value<unsigned int>(&parallel_targets),
+      "If 1, the targets are run concurrently on each input, one thread per "
+      "target. Ignored if the fork server is not used. Default to 0.")(
+      "verify_fingerprints", po::value<unsigned int>(&verify_fingerprints),
+      "If 1, the tuples of traces, statuses and outputs are kept in addition "
+      "to their fingerprints, so that a novel tuple is never taken for a "
+      "known one. Default to 0.");
 
   if (!libfuzzer::postProcess(desc, pd, fuzzer_args.argc, fuzzer_args.argv,
                               global, std::move(sink_), opts)) {
@@ -59,9 +68,13 @@ NezhaFuzzer::NezhaFuzzer(const cli::FuzzerArgs &fuzzer_args,
     return;
   }
 
+  opts.create_info.parallel_targets = parallel_targets != 0U;
   create_info = opts.create_info;
   libfuzzer_variables.state.create_info = opts.create_info;
   libfuzzer_variables.rng = std::move(opts.rng);
+  nezha_variables.known_traces = known_traces_t(verify_fingerprints != 0U);
+  nezha_variables.known_status = known_status_t(verify_fingerprints != 0U);
+  nezha_variables.known_outputs = known_outputs_t(verify_fingerprints != 0U);
 
   exec_input::ExecInputSet initial_inputs =
       loadInitialInputs(opts, libfuzzer_variables.rng);
@@ -71,16 +84,24 @@ NezhaFuzzer::NezhaFuzzer(const cli::FuzzerArgs &fuzzer_args,
   total_cycles = opts.total_cycles;
   print_final_stats = opts.print_final_stats;
 
-  const auto output_file_path = create_info.output_dir / "result";
-  const auto path_to_write_seed = create_info.output_dir / "cur_input";
+  // The targets running concurrently must not share the working files
+  const bool parallel = RunTargetsInParallel(create_info);
   for (const auto &target_path : opts.targets) {
+    const auto suffix =
+        parallel ? "." + std::to_string(libfuzzer_variables.executors.size())
+                 : std::string();
+    const auto output_file_path = create_info.output_dir / ("result" + suffix);
+    const auto path_to_write_seed =
+        create_info.output_dir / ("cur_input" + suffix);
     libfuzzer_variables.executors.push_back(
         std::shared_ptr<fuzzuf::executor::NativeLinuxExecutor>(
             new fuzzuf::executor::NativeLinuxExecutor(
                 {target_path.string(), output_file_path.string()},
                 create_info.exec_timelimit_ms, create_info.exec_memlimit,
                 create_info.forksrv, path_to_write_seed,
-                create_info.afl_shm_size, create_info.bb_shm_size, true)));
+                create_info.afl_shm_size, create_info.bb_shm_size,
+                // The outputs are compared only if use_output is set
+                use_output != 0U)));
   }
 
   libfuzzer_variables.begin_date = std::chrono::system_clock::now();
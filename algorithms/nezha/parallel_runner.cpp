@@ -0,0 +1,87 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file parallel_runner.cpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#include "fuzzuf/algorithms/nezha/parallel_runner.hpp"
+
+namespace fuzzuf::algorithm::nezha {
+
+ParallelRunner::ParallelRunner(std::size_t thread_count) {
+  for (std::size_t i = 0; i != thread_count; ++i) {
+    workers.emplace_back([this] { Work(); });
+  }
+}
+
+ParallelRunner::~ParallelRunner() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  job_posted.notify_all();
+  for (auto &worker : workers) worker.join();
+}
+
+void ParallelRunner::Run(std::size_t n, const Job &new_job) {
+  std::unique_lock<std::mutex> lock(mutex);
+  job = &new_job;
+  job_count = n;
+  next_job = 0;
+  done_count = 0;
+  error = nullptr;
+  job_posted.notify_all();
+
+  TakeJobs(lock);
+  job_done.wait(lock, [this] { return done_count == job_count; });
+
+  job = nullptr;
+  job_count = 0;
+  next_job = 0;
+  if (error) std::rethrow_exception(error);
+}
+
+void ParallelRunner::Work() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    job_posted.wait(lock, [this] { return stopping || next_job < job_count; });
+    if (stopping) return;
+    TakeJobs(lock);
+  }
+}
+
+void ParallelRunner::TakeJobs(std::unique_lock<std::mutex> &lock) {
+  while (next_job < job_count) {
+    const std::size_t index = next_job++;
+    const Job &current = *job;
+
+    lock.unlock();
+    std::exception_ptr current_error;
+    try {
+      current(index);
+    } catch (...) {
+      current_error = std::current_exception();
+    }
+    lock.lock();
+
+    if (current_error && !error) error = current_error;
+    if (++done_count == job_count) job_done.notify_all();
+  }
+}
+
+}  // namespace fuzzuf::algorithm::nezha
@@ -75,14 +75,8 @@ RezzufSelectSeed::operator()(void) {
     runs_in_current_cycle++;
   }
 
-  if (state.prev_queued_items < state.case_queue.size()) {
-    // we have new queue entries since the last run, recreate alias table
-    state.prev_queued_items = state.case_queue.size();
-    aflplusplus::util::CreateAliasTable(state);
-  }
-
   // get the testcase indexed by state.current_entry and start mutations
-  state.current_entry = (*state.alias_probability)();
+  state.current_entry = aflplusplus::util::SelectSeed(state);
   auto &testcase = state.case_queue[state.current_entry];
   this->CallSuccessors(testcase);
 
@@ -221,6 +215,10 @@ AFLMidCalleeRef<RezzufState> RezzufAbandonEntry::operator()(
   if (!state.stop_soon && !testcase->cal_failed && !testcase->WasFuzzed()) {
     state.pending_not_fuzzed--;
     if (testcase->favored) state.pending_favored--;
+  } else if (testcase->favored && !testcase->WasFuzzed()) {
+    /* fuzz_level is raised below anyway, so the entry stops being pending
+       even if the calibration has failed. */
+    state.pending_favored--;
   }
 
   testcase->fuzz_level++;
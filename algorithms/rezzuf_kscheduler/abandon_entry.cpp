@@ -36,6 +36,10 @@ afl::routine::other::AFLMidCalleeRef<State> AbandonEntry::operator()(
   if (!state.stop_soon && !testcase->cal_failed && !testcase->WasFuzzed()) {
     state.pending_not_fuzzed--;
     if (testcase->favored) state.pending_favored--;
+  } else if (testcase->favored && !testcase->WasFuzzed()) {
+    /* fuzz_level is raised below anyway, so the entry stops being pending
+       even if the calibration has failed. */
+    state.pending_favored--;
   }
 
   testcase->fuzz_level++;
@@ -62,16 +62,10 @@ SelectSeed::operator()(void) {
     runs_in_current_cycle++;
   }
 
-  if (state.prev_queued_items < state.case_queue.size()) {
-    // we have new queue entries since the last run, recreate alias table
-    state.prev_queued_items = state.case_queue.size();
-    aflplusplus::util::CreateAliasTable(state);
-  }
-
   // get the testcase indexed by state.current_entry and start mutations
   using Tag = typename State::Tag;
   if constexpr ( !afl::option::EnableKScheduler< Tag >() ) {
-    state.current_entry = (*state.alias_probability)();
+    state.current_entry = aflplusplus::util::SelectSeed(state);
     auto &testcase = state.case_queue[state.current_entry];
     this->CallSuccessors(testcase);
   }
@@ -37,9 +37,7 @@ State::State(
     std::unique_ptr<optimizer::HavocOptimizer> &&havoc_optimizer)
     : afl::AFLStateTemplate<Testcase>(setting, executor,
                                             std::move(havoc_optimizer)),
-      setting(setting),
-      prev_queued_items(0),
-      alias_probability(nullptr) {
+      setting(setting) {
   using aflplusplus::option::GetNFuzzSize;
   n_fuzz.reset(new u32[GetNFuzzSize<Tag>()]);
 }
@@ -96,50 +94,23 @@ void State::UpdateBitmapScoreWithRawTrace(Testcase &testcase,
     u64 fuzz_p2 = fuzzuf::utils::NextP2(n_fuzz[testcase.n_fuzz_entry]);
     u64 fav_factor = testcase.exec_us * testcase.input->GetLen();
  
-    for (u32 i = 0; i < map_size; i++) {
-      if (trace_bits[i]) {
-        if (top_rated[i]) {
-          auto &top_testcase = top_rated[i].value().get();
- 
+    UpdateTopRated(
+        testcase, trace_bits, map_size,
+        [this, fuzz_p2, fav_factor](const Testcase &top_testcase) {
           u64 top_rated_fuzz_p2 =
               fuzzuf::utils::NextP2(n_fuzz[top_testcase.n_fuzz_entry]);
-          u64 factor = top_testcase.exec_us * top_testcase.input->GetLen();
- 
-          if (fuzz_p2 > top_rated_fuzz_p2)
-            continue;
-          else if (fuzz_p2 == top_rated_fuzz_p2) {
-            if (fav_factor > factor) continue;
-          }
- 
-          /* Looks like we're going to win. Decrease ref count for the
-             previous winner, discard its trace_bits[] if necessary. */
-          --top_testcase.tc_ref;
-          if (top_testcase.tc_ref == 0) {
-            top_testcase.trace_mini.reset();
-          }
-        }
- 
-        /* Insert ourselves as the new winner. */
- 
-        top_rated[i] = std::ref(testcase);
-        testcase.tc_ref++;
- 
-        if (!testcase.trace_mini) {
-          testcase.trace_mini.reset(
-              new std::bitset<afl::option::GetMapSize<Tag>()>());
- 
-          auto &trace_mini = *testcase.trace_mini;
-          for (u32 j = 0; j < afl::option::GetMapSize<Tag>(); j++) {
-            trace_mini[j] = trace_bits[j] != 0;
-          }
-        }
- 
-        score_changed = true;
-      }
-    }
+          if (fuzz_p2 != top_rated_fuzz_p2)
+            return fuzz_p2 < top_rated_fuzz_p2;
+          return fav_factor <=
+                 top_testcase.exec_us * top_testcase.input->GetLen();
+        });
   }
 }
 
+void State::OnTestcaseChanged(Testcase &testcase) {
+  seed_weights.changed.push_back(testcase.qid);
+}
+
 bool State::SaveIfInteresting(const u8 *buf, u32 len,
                                     feedback::InplaceMemoryFeedback &inp_feed,
                                     feedback::ExitStatusFeedback &exit_status) {
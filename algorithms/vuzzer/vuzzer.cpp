@@ -60,16 +60,15 @@ void VUzzer::PerformDryRun(VUzzerState& state) {
   }
 
   /* Execute PUT with initial seeds (valid inputs) */
-  for (const auto& testcase : state.pending_queue) {
-    testcase->input->Load();
-    auto inp_feed = state.RunExecutor(testcase->input->GetBuf(),
-                                      testcase->input->GetLen(), exit_status);
-    std::map<u64, u32> bb_cov;
-    boost::dynamic_bitset<> bb_set;
-    vuzzer::util::ParseBBCov(inp_feed, bb_cov);
-    for (const auto& bbc : bb_cov) state.good_bbs.insert(bbc.first);
-    testcase->input->Unload();
-  }
+  state.RunExecutors(
+      state.pending_queue,
+      [&state](const std::shared_ptr<VUzzerTestcase>&,
+               feedback::FileFeedback& inp_feed,
+               feedback::ExitStatusFeedback&) {
+        bb_cov_t bb_cov;
+        vuzzer::util::ParseBBCov(inp_feed, bb_cov);
+        for (const auto& bbc : bb_cov) state.good_bbs.insert(bbc.first);
+      });
 
   DEBUG("Good BBs");
   for ([[maybe_unused]] const auto& bb : state.good_bbs) DEBUG("0x%llx,", bb);
@@ -87,7 +86,7 @@ void VUzzer::PerformDryRun(VUzzerState& state) {
 
     auto inp_feed =
         state.RunExecutor(mutator.GetBuf(), mutator.GetLen(), exit_status);
-    std::map<u64, u32> bb_cov;
+    bb_cov_t bb_cov;
     vuzzer::util::ParseBBCov(inp_feed, bb_cov);
     for (const auto& bbc : bb_cov) {
       u64 addr = bbc.first;
@@ -104,13 +103,13 @@ void VUzzer::PerformDryRun(VUzzerState& state) {
   ** It'll be used in FillSeeds
   */
   DEBUG("Get taint info from initial seeds");
-  for (const auto& testcase : state.pending_queue) {
-    testcase->input->Load();
-    auto inp_feed = state.RunTaintExecutor(
-        testcase->input->GetBuf(), testcase->input->GetLen(), exit_status);
-    vuzzer::util::ParseTaintInfo(state, testcase, inp_feed);
-    testcase->input->Unload();
-  }
+  state.RunTaintExecutors(
+      state.pending_queue,
+      [&state](const std::shared_ptr<VUzzerTestcase>& testcase,
+               feedback::FileFeedback& inp_feed,
+               feedback::ExitStatusFeedback&) {
+        vuzzer::util::ParseTaintInfo(state, testcase, inp_feed);
+      });
 }
 
 /**
@@ -71,7 +71,6 @@ RunEHB::RunEHB(VUzzerState &state) : state(state) {}
  * @brief Detect EHBs based on bb traces taken during executions
  */
 VUzzerMidCalleeRef RunEHB::operator()(void) {
-  feedback::ExitStatusFeedback exit_status;
   std::vector<u64> all_bb;
   std::vector<boost::dynamic_bitset<>> bb_sets;
   if (state.loop_cnt > 40 && state.loop_cnt % state.bbslide == 0) {
@@ -82,17 +81,16 @@ VUzzerMidCalleeRef RunEHB::operator()(void) {
      * seed1  01000001....
      * seed2  01100000....
      */
-    for (const auto &testcase : state.seed_queue) {
-      testcase->input->Load();
-      auto inp_feed = state.RunExecutor(testcase->input->GetBuf(),
-                                        testcase->input->GetLen(), exit_status);
-      std::map<u64, u32> bb_cov;
-      boost::dynamic_bitset<> bb_set;
-      vuzzer::util::ParseBBCov(inp_feed, bb_cov);
-      vuzzer::util::DictToBitsWithKeys(bb_cov, all_bb, bb_set);
-      bb_sets.emplace_back(bb_set);
-      testcase->input->Unload();
-    }
+    state.RunExecutors(
+        state.seed_queue,
+        [&](const std::shared_ptr<VUzzerTestcase> &,
+            feedback::FileFeedback &inp_feed, feedback::ExitStatusFeedback &) {
+          bb_cov_t bb_cov;
+          boost::dynamic_bitset<> bb_set;
+          vuzzer::util::ParseBBCov(inp_feed, bb_cov);
+          vuzzer::util::DictToBitsWithKeys(bb_cov, all_bb, bb_set);
+          bb_sets.emplace_back(bb_set);
+        });
 
     /* Count frequencies of every bbs */
     const u32 ratio =
@@ -122,14 +120,11 @@ ExecutePUT::ExecutePUT(VUzzerState &state) : state(state) {}
  */
 VUzzerMidCalleeRef ExecutePUT::operator()(void) {
   DEBUG("ExecutePUT pending(%zu)\n", state.pending_queue.size());
-  feedback::ExitStatusFeedback exit_status;
-  /* Execute all inputs from pending_queue */
-  for (const auto &testcase : state.pending_queue) {
-    testcase->input->Load();
-
-    auto inp_feed = state.RunExecutor(testcase->input->GetBuf(),
-                                      testcase->input->GetLen(), exit_status);
-
+  /* Execute all inputs from pending_queue. The executions run in parallel, and
+   * their results are merged in the order of pending_queue. */
+  state.RunExecutors(state.pending_queue, [this](const auto &testcase,
+                                                 auto &inp_feed,
+                                                 auto &exit_status) {
     /* Calculate fitness score in child node (i.e. UpdateFitness method) */
     auto score = CallSuccessors(testcase, inp_feed);
     testcase->fitness = score;
@@ -159,10 +154,9 @@ VUzzerMidCalleeRef ExecutePUT::operator()(void) {
       }
       /* TODO: Implement STOPONCRASH mode */
     }
-    testcase->input->Unload();
     /* Move a seed to seed_queue from pending_queue. */
     state.seed_queue.emplace_back(testcase);
-  }
+  });
   state.pending_queue.clear();
   return GoToDefaultNext();
 }
@@ -177,7 +171,7 @@ VUzzerMidCalleeRef ExecuteTaintPUT::operator()(void) {
   if (state.taint_queue.empty()) return GoToDefaultNext();
 
   /* Execute PUT with seeds taken from taint_queue */
-  feedback::ExitStatusFeedback exit_status;
+  std::vector<std::shared_ptr<VUzzerTestcase>> testcases;
   for (const auto &testcase : state.taint_queue) {
     u64 id = testcase->input->GetID();
     /* If we have already executed the seed then continue.
@@ -187,14 +181,16 @@ VUzzerMidCalleeRef ExecuteTaintPUT::operator()(void) {
     if (state.taint_cmp_offsets.find(id) != state.taint_cmp_offsets.end() ||
         state.taint_lea_offsets.find(id) != state.taint_lea_offsets.end())
       continue;
-    testcase->input->Load();
-    auto inp_feed = state.RunTaintExecutor(
-        testcase->input->GetBuf(), testcase->input->GetLen(), exit_status);
-
-    CallSuccessors(testcase, inp_feed);
-
-    testcase->input->Unload();
+    /* The same seed can be queued twice before it's executed */
+    if (std::find(testcases.begin(), testcases.end(), testcase) ==
+        testcases.end())
+      testcases.emplace_back(testcase);
   }
+
+  state.RunTaintExecutors(
+      testcases, [this](const auto &testcase, auto &inp_feed, auto &) {
+        CallSuccessors(testcase, inp_feed);
+      });
   return GoToDefaultNext();
 }
 
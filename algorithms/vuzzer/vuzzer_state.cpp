@@ -25,7 +25,10 @@
 #include <sys/ioctl.h>
 #include <unistd.h>
 
+#include <future>
+
 #include "fuzzuf/algorithms/vuzzer/vuzzer.hpp"
+#include "fuzzuf/algorithms/vuzzer/vuzzer_feedback_format.hpp"
 #include "fuzzuf/executor/pintool_executor.hpp"
 #include "fuzzuf/feedback/exit_status_feedback.hpp"
 #include "fuzzuf/feedback/inplace_memory_feedback.hpp"
@@ -43,6 +46,9 @@ VUzzerState::VUzzerState(
     : setting(setting),
       executor(executor),
       taint_executor(texecutor),
+      executors{executor},
+      bb_cov_paths{"bb.out"},
+      taint_executors{texecutor},
       all_chars_dict(256),
       high_chars_dict(128) {
   /* Build 255 dictionaries with characters \x0, \x1 .... \x255 */
@@ -75,7 +81,8 @@ feedback::FileFeedback VUzzerState::RunExecutor(
     executor->Run(buf, len, tmout);
   }
 
-  auto inp_feed = executor->GetFileFeedback("bb.out");
+  auto inp_feed =
+      executor->GetFileFeedback("bb.out", feedback_format::BB_COV_MAGIC);
   exit_status = executor->GetExitStatusFeedback();
 
   return feedback::FileFeedback(std::move(inp_feed));
@@ -100,16 +107,107 @@ feedback::FileFeedback VUzzerState::RunTaintExecutor(
     taint_executor->Run(buf, len, tmout);
   }
 
-  auto inp_feed = executor->GetFileFeedback(setting->path_to_taint_file);
-  exit_status = executor->GetExitStatusFeedback();
+  auto inp_feed = taint_executor->GetFileFeedback(
+      setting->path_to_taint_file, feedback_format::TAINT_MAGIC);
+  exit_status = taint_executor->GetExitStatusFeedback();
 
   return feedback::FileFeedback(std::move(inp_feed));
 }
 
+/**
+ * @brief Add executors used by RunExecutors and RunTaintExecutors. They must
+ * write their feedback files and inputs to paths other than the existing ones.
+ * @param (executor) Executor for BB coverage
+ * @param (bb_cov_path) Path to the BB coverage file written by executor
+ * @param (texecutor) Executor for taint analysis
+ */
+void VUzzerState::AddExecutors(
+    std::shared_ptr<fuzzuf::executor::PinToolExecutor> executor,
+    const fs::path &bb_cov_path,
+    std::shared_ptr<fuzzuf::executor::PolyTrackerExecutor> texecutor) {
+  executors.emplace_back(executor);
+  bb_cov_paths.emplace_back(bb_cov_path);
+  taint_executors.emplace_back(texecutor);
+}
+
+namespace {
+
+/* Execute the testcases in batches of executors.size(), running each batch at
+ * once on separate threads. The callback is called in the order of testcases
+ * after each batch finishes, while the feedback files are not overwritten. */
+template <class Executor, class GetFeedPath>
+void RunInBatches(const std::vector<std::shared_ptr<Executor>> &executors,
+                  const std::vector<std::shared_ptr<VUzzerTestcase>> &testcases,
+                  GetFeedPath get_feed_path, const char (&feed_tag)[4],
+                  const VUzzerState::RunCallback &callback) {
+  const auto batch_size = executors.size();
+  for (std::size_t begin = 0; begin < testcases.size(); begin += batch_size) {
+    const auto end = std::min(begin + batch_size, testcases.size());
+    for (auto i = begin; i < end; i++) testcases[i]->input->Load();
+
+    std::vector<std::future<void>> runs;
+    for (auto i = begin + 1; i < end; i++) {
+      runs.emplace_back(std::async(
+          std::launch::async, [&executor = *executors[i - begin],
+                               &input = *testcases[i]->input] {
+            executor.Run(input.GetBuf(), input.GetLen());
+          }));
+    }
+    const auto &input = *testcases[begin]->input;
+    executors[0]->Run(input.GetBuf(), input.GetLen());
+    for (auto &run : runs) run.get();
+
+    for (auto i = begin; i < end; i++) {
+      auto &executor = *executors[i - begin];
+      auto inp_feed =
+          executor.GetFileFeedback(get_feed_path(i - begin), feed_tag);
+      auto exit_status = executor.GetExitStatusFeedback();
+      callback(testcases[i], inp_feed, exit_status);
+      testcases[i]->input->Unload();
+    }
+  }
+}
+
+}  // namespace
+
+/**
+ * @brief Execute a PUT with each testcase, running as many of them at once as
+ * executors
+ * @param (testcases) Testcases to execute
+ * @param (callback) Called with each testcase and its feedback, in the order
+ * of testcases. The input of the testcase is loaded during the call.
+ */
+void VUzzerState::RunExecutors(
+    const std::vector<std::shared_ptr<VUzzerTestcase>> &testcases,
+    const RunCallback &callback) {
+  RunInBatches(
+      executors, testcases,
+      [this](std::size_t i) { return bb_cov_paths[i]; },
+      feedback_format::BB_COV_MAGIC, callback);
+}
+
+/**
+ * @brief Execute a PUT by dynamic taint analysis technique with each
+ * testcase, running as many of them at once as taint_executors
+ * @param (testcases) Testcases to execute
+ * @param (callback) Called with each testcase and its feedback, in the order
+ * of testcases. The input of the testcase is loaded during the call.
+ */
+void VUzzerState::RunTaintExecutors(
+    const std::vector<std::shared_ptr<VUzzerTestcase>> &testcases,
+    const RunCallback &callback) {
+  RunInBatches(
+      taint_executors, testcases,
+      [this](std::size_t i) {
+        return fs::path(taint_executors[i]->path_str_to_output);
+      },
+      feedback_format::TAINT_MAGIC, callback);
+}
+
 void VUzzerState::ReceiveStopSignal(void) {
   stop_soon = 1;
-  executor->ReceiveStopSignal();
-  taint_executor->ReceiveStopSignal();
+  for (auto &e : executors) e->ReceiveStopSignal();
+  for (auto &e : taint_executors) e->ReceiveStopSignal();
 }
 
 /**
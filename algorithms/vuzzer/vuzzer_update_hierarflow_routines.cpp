@@ -40,24 +40,24 @@ VUzzerUpdCalleeRef UpdateFitness::operator()(
     const std::shared_ptr<VUzzerTestcase> &testcase,
     feedback::FileFeedback &inp_feed) {
   DEBUG("UpdateFitness");
-  std::map<u64, u32> bb_cov;
+  bb_cov_t bb_cov;
   std::set<u64> bb_without_ehb;
   std::vector<u64> diff;
-  std::set<u64> ehb_all;
 
   int ehb_cnt = 0;
   double score = 0.0, ehb_score = 0.0;
   u32 input_len = testcase->input->GetLen();
 
-  ehb_all = state.ehb;
-  ehb_all.merge(state.ehb_inc);
+  const auto is_ehb = [this](u64 addr) {
+    return state.ehb.count(addr) || state.ehb_inc.count(addr);
+  };
 
   /* Parse a BB cov file taken during the execution */
   vuzzer::util::ParseBBCov(inp_feed, bb_cov);
 
   /* Collect BBs except EHB from bb_cov */
   for (const auto &bb : bb_cov) {
-    if (ehb_all.find(bb.first) == ehb_all.end()) {
+    if (!is_ehb(bb.first)) {
       bb_without_ehb.insert(bb.first);
     } else {
       ehb_cnt++;  // Count EHBs from BB coverage
@@ -102,13 +102,14 @@ VUzzerUpdCalleeRef UpdateFitness::operator()(
 
     int cnt_log = int(std::log2(cnt + 1));
 
-    if (ehb_all.find(addr) != ehb_all.end()) {
+    if (is_ehb(addr)) {
       /* EHB */
       score = score + (cnt_log * ehb_score);
-    } else if (state.bb_weights.find(addr) != state.bb_weights.end()) {
+    } else if (auto weight = state.bb_weights.find(addr);
+               weight != state.bb_weights.end()) {
       /* BB which has already been found by static analysis tool (BB-weight.py)
        */
-      score = score + (cnt_log * state.bb_weights[addr]);
+      score = score + (cnt_log * weight->second);
     } else {
       /* Otherwise */
       score = score + cnt_log;
@@ -187,9 +188,9 @@ TrimQueue::TrimQueue(VUzzerState &state) : state(state) {}
  * @param (bb_cov) BB coverage of new seed
  */
 utils::NullableRef<hierarflow::HierarFlowCallee<void(
-    const std::shared_ptr<VUzzerTestcase> &testcase, std::map<u64, u32> &)>>
+    const std::shared_ptr<VUzzerTestcase> &testcase, bb_cov_t &)>>
 TrimQueue::operator()(const std::shared_ptr<VUzzerTestcase> &testcase,
-                      std::map<u64, u32> &bb_cov) {
+                      bb_cov_t &bb_cov) {
   DEBUG("TrimeQueue queue size(%zu)", state.seed_queue.size());
   boost::dynamic_bitset<> bb_set;
   /* Convert BB cov to bitset like: {0x4000100 : 10, 0x4000f00 : 1 ... } ->
@@ -22,8 +22,14 @@
  */
 #include "fuzzuf/algorithms/vuzzer/vuzzer_util.hpp"
 
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <iterator>
 #include <sstream>
+#include <string_view>
 
+#include "fuzzuf/algorithms/vuzzer/vuzzer_feedback_format.hpp"
 #include "fuzzuf/feedback/put_exit_reason_type.hpp"
 #include "fuzzuf/utils/common.hpp"
 
@@ -70,47 +76,171 @@ void ParseBBWeights(VUzzerState& state, const fs::path& path) {
   }
 }
 
-/**
- * @brief Parse basic block coverage file.
- * @param (inp_feed) FileFeedback obtained by PUT execution
- * @param (bb_cov) A result of the parsing
- */
-void ParseBBCov(feedback::FileFeedback& inp_feed, std::map<u64, u32>& bb_cov) {
-  /* BB coverage file format
-   * addr count
-   * addr is address of BB.
-   * count is
-   */
-  std::string feed_raw, line;
-  fs::path feed_path = inp_feed.feed_path.native();
+namespace {
 
-  int feed_fd = fuzzuf::utils::OpenFile(feed_path.native(), O_RDONLY);
+/* Return the contents of the feedback. If the executor received it in
+ * memory, the file is not read. Otherwise buf holds the file contents. */
+std::string_view ReadFeedback(const feedback::FileFeedback& inp_feed,
+                              std::string& buf) {
+  if (inp_feed.in_memory)
+    return std::string_view(reinterpret_cast<const char*>(inp_feed.mem),
+                            inp_feed.len);
+
+  int fd = fuzzuf::utils::OpenFile(inp_feed.feed_path.native(), O_RDONLY);
 
   struct stat sb {};
 
-  fstat(feed_fd, &sb);
-  feed_raw.resize(sb.st_size);
+  fstat(fd, &sb);
+  buf.resize(sb.st_size);
 
-  fuzzuf::utils::ReadFile(feed_fd, (u8*)(feed_raw.data()), sb.st_size);
-  fuzzuf::utils::CloseFile(feed_fd);
+  fuzzuf::utils::ReadFile(fd, (u8*)(buf.data()), sb.st_size);
+  fuzzuf::utils::CloseFile(fd);
+  return buf;
+}
 
-  std::stringstream feed_stream{feed_raw};
+bool HasMagic(std::string_view raw, const char (&magic)[4]) {
+  return raw.size() >= sizeof(magic) &&
+         std::equal(magic, magic + sizeof(magic), raw.data());
+}
 
-  while (std::getline(feed_stream, line)) {
-    std::stringstream line_stream(line);
-    std::string token;
-    std::vector<std::string> tokens;
-    while (std::getline(line_stream, token, ' ')) tokens.emplace_back(token);
+/* Copy a value of T at pos of raw, and advance pos */
+template <typename T>
+T ReadBinary(std::string_view raw, std::size_t& pos) {
+  T value;
+  if (raw.size() < pos + sizeof(T))
+    throw -1;  // XXX: Implment exception class for parse error;
+  std::memcpy(&value, raw.data() + pos, sizeof(T));
+  pos += sizeof(T);
+  return value;
+}
 
-    if (tokens.size() != 2)
+/* Call f with each non-empty line of raw, split into fields by spaces.
+ * Unlike stringstream, a trailing empty field is kept. */
+template <typename F>
+void ForEachLine(std::string_view raw, std::size_t field_count, F f) {
+  std::vector<std::string_view> fields;
+  std::string_view rest = raw;
+  while (!rest.empty()) {
+    const auto line_end = std::min(rest.find('\n'), rest.size());
+    auto line = rest.substr(0, line_end);
+    rest.remove_prefix(std::min(line_end + 1, rest.size()));
+    if (line.empty()) continue;
+
+    fields.clear();
+    while (true) {
+      const auto field_end = line.find(' ');
+      fields.emplace_back(line.substr(0, field_end));
+      if (field_end == std::string_view::npos) break;
+      line.remove_prefix(field_end + 1);
+    }
+    if (fields.size() != field_count)
       throw -1;  // XXX: Implment exception class for parse error;
+    f(fields);
+  }
+}
+
+/* Parse an integer such as "0x1f" or "1f" if base is 16, like strtoll.
+ * Returns 0 if the string doesn't start with digits. */
+u64 ParseInteger(std::string_view str, int base) {
+  if (base == 16 && str.size() >= 2 && str[0] == '0' &&
+      (str[1] == 'x' || str[1] == 'X'))
+    str.remove_prefix(2);
+  u64 value = 0;
+  std::from_chars(str.data(), str.data() + str.size(), value, base);
+  return value;
+}
 
-    u64 addr = strtoll(tokens[0].c_str(), NULL, 16);
-    u32 cnt = strtol(tokens[1].c_str(), NULL, 16);
-    bb_cov[addr] = cnt;
+/* Call f with each element of a comma separated list */
+template <typename F>
+void ForEachElement(std::string_view list, F f) {
+  while (!list.empty()) {
+    const auto elem_end = std::min(list.find(','), list.size());
+    f(list.substr(0, elem_end));
+    list.remove_prefix(std::min(elem_end + 1, list.size()));
   }
 }
 
+/* Make bb_cov sorted by address without duplicates, keeping the last count of
+ * each address as std::map::operator[] would do. */
+void SortBBCov(bb_cov_t& bb_cov) {
+  const auto not_ascending = [](const auto& l, const auto& r) {
+    return l.first >= r.first;
+  };
+  if (std::adjacent_find(bb_cov.begin(), bb_cov.end(), not_ascending) ==
+      bb_cov.end())
+    return;
+
+  std::stable_sort(
+      bb_cov.begin(), bb_cov.end(),
+      [](const auto& l, const auto& r) { return l.first < r.first; });
+  auto out = bb_cov.begin();
+  for (auto itr = bb_cov.begin(); itr != bb_cov.end(); ++itr) {
+    if (out != bb_cov.begin() && std::prev(out)->first == itr->first)
+      *std::prev(out) = *itr;
+    else
+      *out++ = *itr;
+  }
+  bb_cov.erase(out, bb_cov.end());
+}
+
+void RecordTaint(VUzzerState& state, u64 id, u32 type, u32 offset,
+                 std::vector<u32>&& values) {
+  namespace ff = feedback_format;
+  if (type == ff::TAINT_TYPE_CMP) {
+    for ([[maybe_unused]] auto v : values)
+      DEBUG("taint_cmp_all[%llu][0x%x] = 0x%x", id, offset, v);
+
+    state.taint_cmp_all[id][offset] = std::move(values);
+    state.taint_cmp_offsets[id].insert(offset);
+  } else if (type == ff::TAINT_TYPE_LEA) {
+    state.taint_lea_offsets[id].insert(offset);
+  } else {
+    throw -1;
+  }
+}
+
+}  // namespace
+
+/**
+ * @brief Parse basic block coverage file.
+ * @param (inp_feed) FileFeedback obtained by PUT execution
+ * @param (bb_cov) A result of the parsing
+ */
+void ParseBBCov(feedback::FileFeedback& inp_feed, bb_cov_t& bb_cov) {
+  /* BB coverage file is in either of the following formats
+   * - Binary format defined in vuzzer_feedback_format.hpp
+   * - Text format
+   *   addr count
+   *   addr is address of BB.
+   *   count is the number of times the BB was executed, in decimal.
+   */
+  namespace ff = feedback_format;
+  std::string buf;
+  const auto feed_raw = ReadFeedback(inp_feed, buf);
+  bb_cov.clear();
+
+  if (HasMagic(feed_raw, ff::BB_COV_MAGIC)) {
+    std::size_t pos = 0;
+    const auto header = ReadBinary<ff::BBCovHeader>(feed_raw, pos);
+    if (feed_raw.size() - pos < std::size_t(header.record_count) *
+                                    sizeof(ff::BBCovRecord))
+      throw -1;  // XXX: Implment exception class for parse error;
+
+    bb_cov.reserve(header.record_count);
+    for (u32 i = 0; i < header.record_count; i++) {
+      const auto record = ReadBinary<ff::BBCovRecord>(feed_raw, pos);
+      bb_cov.emplace_back(record.addr, record.count);
+    }
+  } else {
+    ForEachLine(feed_raw, 2, [&](const std::vector<std::string_view>& tokens) {
+      bb_cov.emplace_back(ParseInteger(tokens[0], 16),
+                          u32(ParseInteger(tokens[1], 10)));
+    });
+  }
+
+  SortBBCov(bb_cov);
+}
+
 /**
  * @brief Parse taint file.
  * @param (state) VUzzer state
@@ -120,61 +250,52 @@ void ParseBBCov(feedback::FileFeedback& inp_feed, std::map<u64, u32>& bb_cov) {
 void ParseTaintInfo(VUzzerState& state,
                     const std::shared_ptr<VUzzerTestcase>& testcase,
                     feedback::FileFeedback& inp_feed) {
-  /* Taint file format
-   * CMP|LEA o1,o2,o3...o_n v1,v2,v3...v_m
-   * o_n is offsets touched by cmp/lea op.
-   * v_m is values referred by cmp/lea op.
+  /* Taint file is in either of the following formats
+   * - Binary format defined in vuzzer_feedback_format.hpp
+   * - Text format
+   *   CMP|LEA o1,o2,o3...o_n v1,v2,v3...v_m
+   *   o_n is offsets touched by cmp/lea op.
+   *   v_m is values referred by cmp/lea op.
    */
+  namespace ff = feedback_format;
   u64 id = testcase->input->GetID();
-  std::string feed_raw, line;
-  fs::path feed_path = inp_feed.feed_path.native();
-
-  int feed_fd = fuzzuf::utils::OpenFile(feed_path.native(), O_RDONLY);
-
-  struct stat sb {};
-
-  fstat(feed_fd, &sb);
-  feed_raw.resize(sb.st_size);
-
-  fuzzuf::utils::ReadFile(feed_fd, (u8*)(feed_raw.data()), sb.st_size);
-  fuzzuf::utils::CloseFile(feed_fd);
-
-  std::stringstream feed_stream{feed_raw};
-
-  while (std::getline(feed_stream, line)) {
-    std::stringstream line_stream(line);
-    std::string token;
-    std::vector<std::string> tokens;
-    while (std::getline(line_stream, token, ' ')) tokens.emplace_back(token);
-
-    if (tokens.size() != 3)
-      throw -1;  // XXX: Implment exception class for parse error;
-
-    std::stringstream off_stream(tokens[1]);
-    std::stringstream val_stream(tokens[2]);
-    std::string off_str, val_str;
+  std::string buf;
+  const auto feed_raw = ReadFeedback(inp_feed, buf);
+
+  if (HasMagic(feed_raw, ff::TAINT_MAGIC)) {
+    std::size_t pos = 0;
+    const auto header = ReadBinary<ff::TaintHeader>(feed_raw, pos);
+    for (u32 i = 0; i < header.record_count; i++) {
+      const auto record = ReadBinary<ff::TaintRecordHeader>(feed_raw, pos);
+      if (feed_raw.size() - pos < std::size_t(record.value_count) * sizeof(u32))
+        throw -1;  // XXX: Implment exception class for parse error;
+
+      std::vector<u32> values(record.value_count);
+      std::memcpy(values.data(), feed_raw.data() + pos,
+                  values.size() * sizeof(u32));
+      pos += values.size() * sizeof(u32);
+      RecordTaint(state, id, record.type, record.offset, std::move(values));
+    }
+    return;
+  }
 
-    std::getline(off_stream, off_str, ',');  // Take only offsets[0]
-    u32 offset = strtol(off_str.c_str(), NULL, 16);
+  ForEachLine(feed_raw, 3, [&](const std::vector<std::string_view>& tokens) {
+    // Take only offsets[0]
+    const auto off_str = tokens[1].substr(0, tokens[1].find(','));
+    u32 offset = ParseInteger(off_str, 16);
 
     if (tokens[0] == "CMP") {
       std::vector<u32> values;
-      while (std::getline(val_stream, val_str, ',')) {
-        u32 value = strtol(val_str.c_str(), NULL, 16);
-        values.emplace_back(value);
-      }
-      state.taint_cmp_all[id][offset] = values;
-      state.taint_cmp_offsets[id].insert(offset);
-
-      for ([[maybe_unused]] auto v : values)
-        DEBUG("taint_cmp_all[%llu][0x%x] = 0x%x", id, offset, v);
-
+      ForEachElement(tokens[2], [&](std::string_view val_str) {
+        values.emplace_back(ParseInteger(val_str, 16));
+      });
+      RecordTaint(state, id, ff::TAINT_TYPE_CMP, offset, std::move(values));
     } else if (tokens[0] == "LEA") {
-      state.taint_lea_offsets[id].insert(offset);
+      RecordTaint(state, id, ff::TAINT_TYPE_LEA, offset, {});
     } else {
       throw -1;
     }
-  }
+  });
 }
 
 /**
@@ -187,7 +308,7 @@ void ParseTaintInfo(VUzzerState& state,
  * @param (keys) Global key set
  * @param (bits) Bitsets
  */
-void DictToBitsWithKeys(std::map<u64, u32>& dict, std::vector<u64>& keys,
+void DictToBitsWithKeys(const bb_cov_t& dict, std::vector<u64>& keys,
                         boost::dynamic_bitset<>& bits) {
   for (const auto& d : dict) {
     u64 key = d.first;
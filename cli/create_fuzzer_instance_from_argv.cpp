@@ -25,6 +25,8 @@
 #include "fuzzuf/logger/log_file_logger.hpp"
 #include "fuzzuf/logger/logger.hpp"
 #include "fuzzuf/logger/stdout_logger.hpp"
+#include "fuzzuf/utils/common.hpp"
+#include "fuzzuf/utils/cpu_affinity.hpp"
 
 namespace fuzzuf::cli {
 
@@ -61,6 +63,17 @@ std::unique_ptr<fuzzer::Fuzzer> CreateFuzzerInstanceFromArgv(
         __LINE__);
   }
 
+  // If a CPU core is given explicitly, bind it before the fuzzer is built, so
+  // that fork servers launched by executors inherit the affinity. Fuzzers
+  // calling BindCpu later get the same core. Otherwise each fuzzer decides
+  // whether it binds, since pinning the whole process to one core would
+  // serialize the fuzzers running several threads or PUT processes at once.
+  // The builders of such fuzzers bind before they create the executors.
+  utils::SetCpuLockDir(global_options.cpu_lock_dir);
+  utils::SetBindPutToSmtSibling(global_options.bind_put_to_smt_sibling);
+  if (global_options.cpuid_to_bind_specified)
+    utils::BindCpu(utils::GetCpuCore(), global_options.cpuid_to_bind);
+
   // Prepare a fuzzer specified by the command line as it states
   return FuzzerBuilderRegister::Get(global_options.fuzzer)(fuzzer_args,
                                                            global_options);
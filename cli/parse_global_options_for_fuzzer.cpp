@@ -78,6 +78,25 @@ FuzzerArgs ParseGlobalOptionsForFuzzer(GlobalArgs& global_args,
       po::value<int>(&global_options.cpuid_to_bind)
           ->default_value(global_options.cpuid_to_bind),
       "Choose a CPU core to bind the PUT process to. Valid values: -2=\"never bind\", -1=\"use any free core\", 0 ~ num_of_cpus-1=(the id of a specific core).")(
+      "bind_put_to_smt_sibling",
+      po::bool_switch(&global_options.bind_put_to_smt_sibling),
+      "Bind the PUT process to an SMT sibling of the core the fuzzer is bound "
+      "to, instead of the same core.")(
+      "cpu_lock_dir",
+      po::value<std::string>()->default_value(
+          global_options.cpu_lock_dir.string()),
+      "Set the directory of lock files used to allocate CPU cores among "
+      "fuzzuf instances. Default is `/tmp/fuzzuf-cpu-lock`.")(
+      "standby_fork_server",
+      po::bool_switch(&global_options.standby_fork_server),
+      "Keep a standby fork server of the PUT initialized, which replaces the "
+      "active one immediately if it dies. Only used by `native` executor in "
+      "fork server mode.")(
+      "shm_backend", po::value<std::string>()->default_value("sysv"),
+      "Specify shared memory used for the coverage map of `native` executor. "
+      "Valid values: sysv, posix, posix_huge. posix and posix_huge require "
+      "the PUT runtime to map the memory with shm_open(). Default is "
+      "`sysv`.")(
       "proxy_path",
       global_options.proxy_path ? po::value<std::string>()->default_value(
                                       global_options.proxy_path->string())
@@ -160,6 +179,23 @@ FuzzerArgs ParseGlobalOptionsForFuzzer(GlobalArgs& global_args,
         __FILE__, __LINE__);
   }
 
+  global_options.cpuid_to_bind_specified = !vm["bind_cpuid"].defaulted();
+  global_options.cpu_lock_dir = vm["cpu_lock_dir"].as<std::string>();
+
+  auto shm_backend = vm["shm_backend"].as<std::string>();
+  if (shm_backend == "sysv") {
+    global_options.shm_backend = coverage::ShmBackend::SYSV;
+  } else if (shm_backend == "posix") {
+    global_options.shm_backend = coverage::ShmBackend::POSIX;
+  } else if (shm_backend == "posix_huge") {
+    global_options.shm_backend = coverage::ShmBackend::POSIX_HUGE;
+  } else {
+    throw exceptions::cli_error(
+        "Invalid value is fed to `--shm_backend`. Valid values: sysv, posix, "
+        "posix_huge",
+        __FILE__, __LINE__);
+  }
+
   // since type T = { std::optional, fs::path, Logger (enum) }, is not cpmatible
   // with po::value<T>()
   if (vm.count("exec_timelimit_ms")) {
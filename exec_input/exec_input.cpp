@@ -21,7 +21,7 @@
 
 namespace fuzzuf::exec_input {
 
-u64 ExecInput::id_counter = 0;
+std::atomic<u64> ExecInput::id_counter = 0;
 
 ExecInput::ExecInput() : id(id_counter++), len(0) {}
 
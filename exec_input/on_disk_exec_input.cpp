@@ -17,6 +17,11 @@
  */
 #include "fuzzuf/exec_input/on_disk_exec_input.hpp"
 
+#include <unistd.h>
+
+#include <atomic>
+#include <vector>
+
 #include "fuzzuf/exec_input/exec_input.hpp"
 #include "fuzzuf/logger/logger.hpp"
 #include "fuzzuf/utils/common.hpp"
@@ -26,18 +31,48 @@ namespace fuzzuf::exec_input {
 
 class ExecInput;
 
+namespace {
+
+void WriteContent(const fs::path& path, const u8* buf, u32 len,
+                  bool sync_data) {
+  int fd = fuzzuf::utils::OpenFile(path.string(), O_WRONLY | O_CREAT | O_TRUNC,
+                                   0600);
+  try {
+    fuzzuf::utils::WriteFile(fd, buf, len);
+    if (sync_data && fdatasync(fd) == -1) {
+      throw fuzzuf::utils::FileError("Unable to sync " + path.string());
+    }
+  } catch (...) {
+    fuzzuf::utils::CloseFile(fd);
+    throw;
+  }
+  fuzzuf::utils::CloseFile(fd);
+}
+
+}  // namespace
+
+// The content of a file which is not written yet. Only writer's thread sets
+// done, after the file has been written.
+struct OnDiskExecInput::PendingWrite {
+  std::vector<u8> data;
+  utils::AsyncWriter* writer;
+  std::atomic<bool> done = false;
+};
+
 OnDiskExecInput::OnDiskExecInput(const fs::path& path, bool hardlinked)
     : ExecInput(), path(path), hardlinked(hardlinked) {}
 
 OnDiskExecInput::OnDiskExecInput(OnDiskExecInput&& orig)
     : ExecInput(std::move(orig)),
       path(std::move(orig.path)),
-      hardlinked(orig.hardlinked) {}
+      hardlinked(orig.hardlinked),
+      pending_write(std::move(orig.pending_write)) {}
 
 OnDiskExecInput& OnDiskExecInput::operator=(OnDiskExecInput&& orig) {
   ExecInput::operator=(std::move(orig));
   path = std::move(orig.path);
   hardlinked = orig.hardlinked;
+  pending_write = std::move(orig.pending_write);
   return *this;
 }
 
@@ -56,6 +91,14 @@ void OnDiskExecInput::LoadIfNotLoaded(void) {
 }
 
 void OnDiskExecInput::Load(void) {
+  if (pending_write && !pending_write->done.load(std::memory_order_acquire)) {
+    const auto& data = pending_write->data;
+    ReallocBufIfLack(data.size());
+    std::memcpy(buf.get(), data.data(), len);
+    return;
+  }
+  pending_write.reset();
+
   ReallocBufIfLack(fs::file_size(path));
 
   int fd = fuzzuf::utils::OpenFile(path.string(), O_RDONLY);
@@ -66,6 +109,9 @@ void OnDiskExecInput::Load(void) {
 void OnDiskExecInput::Unload(void) { buf.reset(); }
 
 void OnDiskExecInput::Save(void) {
+  // Otherwise the pending write would overwrite the new content later
+  WaitForPendingWrite();
+
   if (hardlinked) {
     fuzzuf::utils::DeleteFileOrDirectory(path.string());
     hardlinked = false;
@@ -93,11 +139,9 @@ void OnDiskExecInput::OverwriteKeepingLoaded(std::unique_ptr<u8[]>&& new_buf,
 
 void OnDiskExecInput::OverwriteThenUnload(const u8* new_buf, u32 new_len) {
   buf.reset();
+  WaitForPendingWrite();
 
-  int fd = fuzzuf::utils::OpenFile(path.string(), O_WRONLY | O_CREAT | O_TRUNC,
-                                   0600);
-  fuzzuf::utils::WriteFile(fd, new_buf, new_len);
-  fuzzuf::utils::CloseFile(fd);
+  WriteContent(path, new_buf, new_len, false);
 }
 
 void OnDiskExecInput::OverwriteThenUnload(std::unique_ptr<u8[]>&& new_buf,
@@ -106,7 +150,40 @@ void OnDiskExecInput::OverwriteThenUnload(std::unique_ptr<u8[]>&& new_buf,
   OverwriteThenUnload(will_delete.get(), new_len);
 }
 
+void OnDiskExecInput::OverwriteInBackground(const u8* new_buf, u32 new_len,
+                                            utils::AsyncWriter* writer,
+                                            bool sync_data) {
+  buf.reset();
+  WaitForPendingWrite();
+
+  if (writer) {
+    auto pending = std::make_shared<PendingWrite>();
+    pending->data.assign(new_buf, new_buf + new_len);
+    pending->writer = writer;
+
+    writer->PostOrWait([path = path, pending, sync_data] {
+      WriteContent(path, pending->data.data(), pending->data.size(),
+                   sync_data);
+      pending->done.store(true, std::memory_order_release);
+    });
+    pending_write = std::move(pending);
+    return;
+  }
+
+  WriteContent(path, new_buf, new_len, sync_data);
+}
+
+void OnDiskExecInput::WaitForPendingWrite(void) {
+  if (!pending_write) return;
+  if (!pending_write->done.load(std::memory_order_acquire)) {
+    pending_write->writer->Flush();
+  }
+  pending_write.reset();
+}
+
 void OnDiskExecInput::LoadByMmap(void) {
+  WaitForPendingWrite();
+
   int fd = fuzzuf::utils::OpenFile(path.string(), O_RDONLY);
   auto file_len = fs::file_size(path);
 
@@ -126,10 +203,12 @@ void OnDiskExecInput::LoadByMmap(void) {
 }
 
 bool OnDiskExecInput::Link(const fs::path& dest_path) {
+  WaitForPendingWrite();
   return link(path.c_str(), dest_path.c_str()) == 0;
 }
 
 void OnDiskExecInput::Copy(const fs::path& dest_path) {
+  WaitForPendingWrite();
   fuzzuf::utils::CopyFile(path.string(), dest_path.string());
 }
 
@@ -17,14 +17,17 @@
  */
 #include "fuzzuf/executor/base_proxy_executor.hpp"
 
+#include <fcntl.h>
 #include <sched.h>
 
 #include <boost/container/static_vector.hpp>
 #include <cassert>
 #include <chrono>
 #include <cstddef>
+#include <cstring>
 #include <memory>
 #include <optional>
+#include <thread>
 
 #include "fuzzuf/algorithms/afl/afl_option.hpp"
 #include "fuzzuf/exceptions.hpp"
@@ -34,6 +37,7 @@
 #include "fuzzuf/feedback/put_exit_reason_type.hpp"
 #include "fuzzuf/logger/logger.hpp"
 #include "fuzzuf/utils/common.hpp"
+#include "fuzzuf/utils/cpu_affinity.hpp"
 #include "fuzzuf/utils/errno_to_system_error.hpp"
 #include "fuzzuf/utils/interprocess_shared_object.hpp"
 #include "fuzzuf/utils/is_executable.hpp"
@@ -396,6 +400,7 @@ void BaseProxyExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
 
   // Aliases
   ResetSharedMemories();
+  shm_feedback.Reset();
   if (record_stdout_and_err) {
     stdout_buffer.clear();
     stderr_buffer.clear();
@@ -419,6 +424,76 @@ void BaseProxyExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
   auto child_state = fuzzuf::utils::interprocess::create_shared_object(
       fuzzuf::executor::ChildState{0, 0});
 
+  ExecuteWrittenInput(timeout_ms, *child_state);
+}
+
+/**
+ * Precondition:
+ *  - Same as BaseProxyExecutor::Run for each element of inputs.
+ * Postcondition:
+ *  - Each input is executed in order as if BaseProxyExecutor::Run is called,
+ * and callback is called with the index of the input after each execution. If
+ * callback returns true, the rest of the inputs are not executed.
+ *  - Unlike calling Run repeatedly, the timeout is resolved, the command line
+ * is logged and the interprocess state for the child is allocated only once per
+ * batch, and the input file is truncated only when it shrinks.
+ */
+std::size_t BaseProxyExecutor::RunBatch(BatchInputRange inputs,
+                                        const BatchCallback &callback,
+                                        u32 timeout_ms) {
+  if (inputs.empty()) return 0u;
+
+  // if timeout_ms is 0, then we use exec_timelimit_ms;
+  if (timeout_ms == 0) timeout_ms = exec_timelimit_ms;
+
+  DEBUG("RunBatch: ");
+  std::for_each(cargv.begin(), cargv.end(),
+                []([[maybe_unused]] const char *v) { DEBUG("%s ", v); });
+  DEBUG("\n")
+
+  auto child_state = fuzzuf::utils::interprocess::create_shared_object(
+      fuzzuf::executor::ChildState{0, 0});
+
+  std::size_t executed = 0u;
+  u32 prev_len = 0u;
+  for (const auto &input : inputs) {
+    // locked until std::shared_ptr<u8> lock is used in other places
+    while (IsFeedbackLocked()) {
+      usleep(100);
+    }
+
+    ResetSharedMemories();
+    shm_feedback.Reset();
+    if (record_stdout_and_err) {
+      stdout_buffer.clear();
+      stderr_buffer.clear();
+    }
+
+    if (executed == 0u)
+      WriteTestInputToFile(input.buf, input.len);
+    else
+      OverwriteTestInputFile(input.buf, input.len, prev_len);
+    prev_len = input.len;
+
+    *child_state = fuzzuf::executor::ChildState{0, 0};
+    ExecuteWrittenInput(timeout_ms, *child_state);
+
+    if (callback(executed++)) break;
+  }
+  return executed;
+}
+
+/**
+ * Precondition:
+ *  - The input to be executed has already been written to the file refered by
+ * input_fd, and shared memories have been reset.
+ *  - child_state is shared with child processes (i.e. created by
+ * create_shared_object) and initialized to {0, 0}.
+ * Postcondition:
+ *  - Same as (2) to (5) of BaseProxyExecutor::Run.
+ */
+void BaseProxyExecutor::ExecuteWrittenInput(
+    u32 timeout_ms, fuzzuf::executor::ChildState &child_state) {
   std::array<int, 2u> stdout_fd{0, 0};
   std::array<int, 2u> stderr_fd{0, 0};
   constexpr std::size_t read_size = 8u;
@@ -509,17 +584,23 @@ void BaseProxyExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
 
     if (child_pid <= 0) ERROR("Fork server is misbehaving (OOM?)");
   } else {
+    // With EnableConcurrentRun, other threads may fork at the same time. The
+    // pipes have O_CLOEXEC so that their PUTs never inherit the write ends,
+    // which would keep the pipes open after this PUT exits. dup2 below clears
+    // the flag of the fds the PUT writes to.
     if (record_stdout_and_err) {
-      if (pipe(stdout_fd.data()) < 0) {
+      if (pipe2(stdout_fd.data(), O_CLOEXEC) < 0) {
         throw fuzzuf::utils::errno_to_system_error(
             errno, "Unable to create stdout pipe");
       }
-      if (pipe(stderr_fd.data()) < 0) {
+      if (pipe2(stderr_fd.data(), O_CLOEXEC) < 0) {
         throw fuzzuf::utils::errno_to_system_error(
             errno, "Unable to create stderr pipe");
       }
     }
 
+    CreateChildEnvironment();
+
     child_pid = fuzzuf::utils::Fork();
     if (child_pid < 0) ERROR("fork() failed");
 
@@ -538,6 +619,8 @@ void BaseProxyExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
 
       setrlimit(RLIMIT_CORE, &r); /* Ignore errors */
 
+      utils::BindPutCpu();
+
       /* Isolate the process and configure standard descriptors. If out_file is
           specified, stdin is /dev/null; otherwise, out_fd is cloned instead. */
       setsid();
@@ -563,13 +646,17 @@ void BaseProxyExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
 
       // Execute new executable binary on the child process.
       // If failed, that matter is recorded to child_state.
-      child_state->exec_result = execv(cargv[0], (char **)cargv.data());
-      child_state->exec_errno = errno;
+      child_state.exec_result =
+          execve(cargv[0], (char **)cargv.data(),
+                 const_cast<char **>(child_environment.data()));
+      child_state.exec_errno = errno;
 
       /* Use a distinctive bitmap value to tell the parent about execv()
           falling through. */
 
-      exit(0);
+      // _exit, since exit is not async-signal-safe and would run the atexit
+      // handlers of the parent
+      _exit(0);
     }
   }
 
@@ -608,12 +695,14 @@ void BaseProxyExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
     child_timed_out = false;
 
     static struct itimerval it;
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::chrono::milliseconds(timeout_ms);
 
     // Set timer to make SIGALRM to be sent on timeout.
     // The handler for SIGALRM is set to BaseProxyExecutor::AlarmHandler, and
     // the PUT is killed in inside. Yet SIGALRM is not set if exec_timelimit_ms
-    // is set to 0.
-    if (exec_timelimit_ms) {
+    // is set to 0. In concurrent run, WaitChildUntil kills the PUT instead.
+    if (exec_timelimit_ms && !concurrent_run) {
       it.it_value.tv_sec = (timeout_ms / 1000);
       it.it_value.tv_usec = (timeout_ms % 1000) * 1000;
       setitimer(ITIMER_REAL, &it, NULL);
@@ -689,7 +778,10 @@ void BaseProxyExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
       close(epoll_fd);
     }
 
-    if (waitpid(child_pid, &put_status, 0) <= 0) ERROR("waitpid() failed");
+    if (concurrent_run)
+      WaitChildUntil(deadline, put_status);
+    else if (waitpid(child_pid, &put_status, 0) <= 0)
+      ERROR("waitpid() failed");
 
     if (record_stdout_and_err) {
       {
@@ -709,7 +801,7 @@ void BaseProxyExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
     }
 
     // Reset the timer.
-    if (exec_timelimit_ms) {
+    if (exec_timelimit_ms && !concurrent_run) {
       it.it_value.tv_sec = 0;
       it.it_value.tv_usec = 0;
       setitimer(ITIMER_REAL, &it, NULL);
@@ -734,7 +826,7 @@ void BaseProxyExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
   u32 tb4 = 0;
 
   // Consider execution was failed if execv of child process failed.
-  if (child_state->exec_result < 0) tb4 = EXEC_FAIL_SIG;
+  if (child_state.exec_result < 0) tb4 = EXEC_FAIL_SIG;
 
   last_exit_reason = feedback::PUTExitReasonType::FAULT_NONE;
   last_signal = 0;
@@ -768,6 +860,65 @@ void BaseProxyExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
   return;
 }
 
+/**
+ * Postcondition:
+ *  - The PUT has exited and put_status holds its status. If the PUT is still
+ * running at deadline and exec_timelimit_ms is not 0, the PUT is killed and
+ * child_timed_out is set, as AlarmHandler does.
+ */
+void BaseProxyExecutor::WaitChildUntil(
+    std::chrono::steady_clock::time_point deadline, int &put_status) {
+  // Poll frequently at first, so that fast PUTs are not kept waiting
+  auto interval = std::chrono::microseconds(100);
+  const auto pid = child_pid;
+  while (true) {
+    const auto waited = waitpid(pid, &put_status, WNOHANG);
+    if (waited < 0) ERROR("waitpid() failed");
+    if (waited > 0) return;
+
+    if (exec_timelimit_ms && std::chrono::steady_clock::now() >= deadline) {
+      KillChildWithoutWait();
+      child_timed_out = true;
+      if (waitpid(pid, &put_status, 0) <= 0) ERROR("waitpid() failed");
+      return;
+    }
+    std::this_thread::sleep_for(interval);
+    interval = std::min(interval * 2, std::chrono::microseconds(10000));
+  }
+}
+
+void BaseProxyExecutor::EnableConcurrentRun() { concurrent_run = true; }
+
+void BaseProxyExecutor::EnableShmFeedback(u32 capacity) {
+  shm_feedback.Setup(capacity);
+
+  // The fork server has to be restarted to pass the name of the region
+  if (forksrv && forksrv_pid > 0) {
+    TerminateForkServer();
+    SetupForkServer();
+  }
+}
+
+// Called in the parent process right before fork. The variable naming
+// shm_feedback is not set by SetupEnvironmentVariablesForTarget, because each
+// instance has its own region while the environment is shared by the whole
+// process. It is not set in the child either, since setenv is not
+// async-signal-safe and other threads may fork at the same time.
+void BaseProxyExecutor::CreateChildEnvironment() {
+  const std::string prefix = std::string(feedback::SHM_FEEDBACK_ENV_VAR) + "=";
+
+  child_environment.clear();
+  for (auto e = environ; *e; ++e) {
+    if (std::strncmp(*e, prefix.c_str(), prefix.size()) != 0)
+      child_environment.push_back(*e);
+  }
+  if (shm_feedback.IsSetUp()) {
+    shm_feedback_environment_variable = prefix + shm_feedback.GetName();
+    child_environment.push_back(shm_feedback_environment_variable.c_str());
+  }
+  child_environment.push_back(nullptr);
+}
+
 feedback::InplaceMemoryFeedback BaseProxyExecutor::GetStdOut() {
   return feedback::InplaceMemoryFeedback(stdout_buffer.data(),
                                          stdout_buffer.size(), lock);
@@ -782,6 +933,19 @@ feedback::FileFeedback BaseProxyExecutor::GetFileFeedback(fs::path feed_path) {
   return feedback::FileFeedback(feed_path, lock);
 }
 
+feedback::FileFeedback BaseProxyExecutor::GetFileFeedback(
+    fs::path feed_path, const char (&tag)[4]) {
+  // The proxy falls back to the file if the feedback doesn't fit
+  if (!shm_feedback.IsAttached() || shm_feedback.IsOverflowed())
+    return feedback::FileFeedback(feed_path, lock);
+
+  // If the proxy is attached but wrote no such record, the feedback is empty
+  // as if the proxy created an empty file
+  u32 len = 0;
+  const u8 *mem = shm_feedback.Find(tag, len);
+  return feedback::FileFeedback(feed_path, mem, mem ? len : 0, lock);
+}
+
 feedback::ExitStatusFeedback BaseProxyExecutor::GetExitStatusFeedback() {
   return feedback::ExitStatusFeedback(last_exit_reason, last_signal);
 }
@@ -874,22 +1038,28 @@ void BaseProxyExecutor::SetupEnvironmentVariablesForTarget() {
 void BaseProxyExecutor::SetupForkServer() {
   // set of fd of pipe.
   // Each is used for parent -> child and child -> parent data transfer.
+  // The pipes have O_CLOEXEC, so that PUTs forked later by other executors
+  // never inherit them. The ends used by the fork server are dup2-ed below,
+  // which clears the flag.
   int par2chld[2], chld2par[2];
 
-  if (pipe(par2chld) || pipe(chld2par)) ERROR("pipe() failed");
+  if (pipe2(par2chld, O_CLOEXEC) || pipe2(chld2par, O_CLOEXEC))
+    ERROR("pipe() failed");
 
   std::array<int, 2u> stdout_fd{-1, -1};
   std::array<int, 2u> stderr_fd{-1, -1};
 
   if (record_stdout_and_err) {
-    if (pipe(stdout_fd.data()) < 0) {
+    if (pipe2(stdout_fd.data(), O_CLOEXEC) < 0) {
       ERROR("Unable to create stdout pipe");
     }
-    if (pipe(stderr_fd.data()) < 0) {
+    if (pipe2(stderr_fd.data(), O_CLOEXEC) < 0) {
       ERROR("Unable to create stderr pipe");
     }
   }
 
+  CreateChildEnvironment();
+
   forksrv_pid = fork();
   if (forksrv_pid < 0) ERROR("fork() failed");
 
@@ -924,6 +1094,8 @@ void BaseProxyExecutor::SetupForkServer() {
     r.rlim_max = r.rlim_cur = 0;
     setrlimit(RLIMIT_CORE, &r);
 
+    utils::BindPutCpu();
+
     setsid();
 
     if (record_stdout_and_err) {
@@ -950,10 +1122,11 @@ void BaseProxyExecutor::SetupForkServer() {
     close(chld2par[0]);
     close(chld2par[1]);
 
-    execve(cargv[0], (char **)cargv.data(), environ);
+    execve(cargv[0], (char **)cargv.data(),
+           const_cast<char **>(child_environment.data()));
     // TODO: It must be discussed whether it is needed that equivalent to
     // EXEC_FAIL_SIG that is used in non-fork server mode.
-    exit(0);
+    _exit(0);
   }
 
   DEBUG("cargv[0]: %s", cargv[0]);
@@ -61,7 +61,7 @@ Executor::Executor(const std::vector<std::string> &argv, u32 exec_timelimit_ms,
 void Executor::OpenExecutorDependantFiles() {
   input_fd = fuzzuf::utils::OpenFile(path_str_to_write_input,
                                      O_RDWR | O_CREAT | O_CLOEXEC, 0600);
-  null_fd = fuzzuf::utils::OpenFile("/dev/null", O_RDONLY | O_CLOEXEC);
+  null_fd = fuzzuf::utils::OpenFile("/dev/null", O_RDWR | O_CLOEXEC);
   assert(input_fd > -1 && null_fd > -1);
 }
 
@@ -91,6 +91,36 @@ void Executor::WriteTestInputToFile(const u8 *buf, u32 len) {
   fuzzuf::utils::SeekFile(input_fd, 0, SEEK_SET);
 }
 
+/**
+ * Postcondition:
+ *  - The contents of the file refered by input_fd matches to buf with length
+ * of len, and its offset is 0 if the PUT reads it as stdin.
+ *  - Unlike WriteTestInputToFile, ftruncate is issued only if the file
+ * shrinks, and the trailing lseek only in stdin mode. Inputs generated by one
+ * stage often have the same length, so this saves up to two syscalls per
+ * execution in RunBatch.
+ */
+void Executor::OverwriteTestInputFile(const u8 *buf, u32 len, u32 prev_len) {
+  assert(input_fd > -1);
+
+  fuzzuf::utils::SeekFile(input_fd, 0, SEEK_SET);
+  fuzzuf::utils::WriteFile(input_fd, buf, len);
+  if (len < prev_len) {
+    if (fuzzuf::utils::TruncateFile(input_fd, len)) ERROR("ftruncate() failed");
+  }
+  if (stdin_mode) fuzzuf::utils::SeekFile(input_fd, 0, SEEK_SET);
+}
+
+std::size_t Executor::RunBatch(BatchInputRange inputs,
+                               const BatchCallback &callback, u32 timeout_ms) {
+  std::size_t executed = 0u;
+  for (const auto &input : inputs) {
+    Run(input.buf, input.len, timeout_ms);
+    if (callback(executed++)) break;
+  }
+  return executed;
+}
+
 /*
  * Postcondition:
  *  - When child_pid has valid value,
@@ -193,15 +193,7 @@ void LinuxForkServerExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
     usleep(100);
   }
 
-  if (timeout_ms == 0) {
-    // if timeout_ms is 0, then we use exec_timelimit_ms;
-    timeout_ms = exec_timelimit_ms;
-  }
-  if (timeout_ms != last_timeout_ms) {
-    // Update timeout
-    put_channel.SetPUTExecutionTimeout(timeout_ms * 1000);
-    last_timeout_ms = timeout_ms;
-  }
+  SetTimeout(timeout_ms);
 
   // Aliases
   ResetSharedMemories();
@@ -218,6 +210,82 @@ void LinuxForkServerExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
   DEBUG("\n")
   //#endif
 
+  ExecuteWrittenInput();
+}
+
+/**
+ * Precondition:
+ *  - Same as LinuxForkServerExecutor::Run for each element of inputs.
+ * Postcondition:
+ *  - Each input is executed in order as if LinuxForkServerExecutor::Run is
+ * called, and callback is called with the index of the input after each
+ * execution. If callback returns true, the rest of the inputs are not executed.
+ *  - Unlike calling Run repeatedly, the timeout is sent to the fork server and
+ * the command line is logged only once per batch, and the input file is
+ * truncated only when it shrinks.
+ */
+std::size_t LinuxForkServerExecutor::RunBatch(BatchInputRange inputs,
+                                              const BatchCallback &callback,
+                                              u32 timeout_ms) {
+  if (inputs.empty()) return 0u;
+
+  SetTimeout(timeout_ms);
+
+  DEBUG("RunBatch: ");
+  std::for_each(cargv.begin(), cargv.end(),
+                []([[maybe_unused]] const char *v) { DEBUG("%s ", v); });
+  DEBUG("\n")
+
+  std::size_t executed = 0u;
+  u32 prev_len = 0u;
+  for (const auto &input : inputs) {
+    // locked until std::shared_ptr<u8> lock is used in other places
+    while (IsFeedbackLocked()) {
+      usleep(100);
+    }
+
+    ResetSharedMemories();
+
+    if (executed == 0u)
+      WriteTestInputToFile(input.buf, input.len);
+    else
+      OverwriteTestInputFile(input.buf, input.len, prev_len);
+    prev_len = input.len;
+
+    ExecuteWrittenInput();
+
+    if (callback(executed++)) break;
+  }
+  return executed;
+}
+
+/**
+ * Postcondition:
+ *  - The fork server kills the PUT after timeout_ms milliseconds. If
+ * timeout_ms is 0, exec_timelimit_ms is used instead.
+ *  - The request is sent to the fork server only if the value differs from
+ * the last one.
+ */
+void LinuxForkServerExecutor::SetTimeout(u32 timeout_ms) {
+  if (timeout_ms == 0) {
+    // if timeout_ms is 0, then we use exec_timelimit_ms;
+    timeout_ms = exec_timelimit_ms;
+  }
+  if (timeout_ms != last_timeout_ms) {
+    // Update timeout
+    put_channel.SetPUTExecutionTimeout(timeout_ms * 1000);
+    last_timeout_ms = timeout_ms;
+  }
+}
+
+/**
+ * Precondition:
+ *  - The input to be executed has already been written to the file refered by
+ * input_fd, and shared memories have been reset.
+ * Postcondition:
+ *  - Same as (2) to (4) of LinuxForkServerExecutor::Run.
+ */
+void LinuxForkServerExecutor::ExecuteWrittenInput() {
   last_exit_reason = feedback::PUTExitReasonType::FAULT_NONE;
   last_signal = 0;
 
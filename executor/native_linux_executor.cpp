@@ -25,6 +25,7 @@
 #include <cstddef>
 #include <memory>
 #include <optional>
+#include <utility>
 
 #include "fuzzuf/algorithms/afl/afl_option.hpp"
 #include "fuzzuf/exceptions.hpp"
@@ -35,6 +36,7 @@
 #include "fuzzuf/logger/logger.hpp"
 #include "fuzzuf/utils/check_crash_handling.hpp"
 #include "fuzzuf/utils/common.hpp"
+#include "fuzzuf/utils/cpu_affinity.hpp"
 #include "fuzzuf/utils/errno_to_system_error.hpp"
 #include "fuzzuf/utils/interprocess_shared_object.hpp"
 #include "fuzzuf/utils/is_executable.hpp"
@@ -73,24 +75,44 @@ NativeLinuxExecutor *NativeLinuxExecutor::active_instance = nullptr;
 NativeLinuxExecutor::NativeLinuxExecutor(
     const std::vector<std::string> &argv, u32 exec_timelimit_ms,
     u64 exec_memlimit, bool forksrv, const fs::path &path_to_write_input,
-    u32 afl_shm_size, u32 bb_shm_size, bool record_stdout_and_err,
+    u32 afl_shm_size, u32 bb_shm_size, RecordedOutputs recorded_outputs,
     std::vector<std::string> &&environment_variables_,
-    std::vector<fs::path> &&allowed_path_)
+    std::vector<fs::path> &&allowed_path_, bool keep_standby_fork_server,
+    coverage::ShmBackend shm_backend, int put_cpuid)
     : Executor(argv, exec_timelimit_ms, exec_memlimit,
                path_to_write_input.string()),
       forksrv(forksrv),
-      afl_edge_coverage(afl_shm_size),
+      keep_standby_fork_server(keep_standby_fork_server),
+      put_cpuid(put_cpuid),
+      afl_edge_coverage(afl_shm_size, shm_backend),
+      // The runtime of fuzzuf-cc only attaches System V shared memory
       fuzzuf_bb_coverage(bb_shm_size),
+      standby_afl_edge_coverage(afl_shm_size, shm_backend),
+      standby_fuzzuf_bb_coverage(bb_shm_size),
 
       // cargv and stdin_mode are initialized at SetCArgvAndDecideInputMode
       forksrv_pid(0),
       forksrv_read_fd(-1),
       forksrv_write_fd(-1),
       child_timed_out(false),
-      record_stdout_and_err(record_stdout_and_err),
       filesystem(std::move(allowed_path_)) {
   fuzzuf::utils::CheckCrashHandling();
 
+  // The buffers are allocated here, so that no execution allocates them.
+  // Other fds than stdout and stderr would need the pipes to be kept away from
+  // the fds used by the fork server, which is not implemented.
+  for (int fd : recorded_outputs.fds) {
+    if (fd != STDOUT_FILENO && fd != STDERR_FILENO)
+      throw exceptions::invalid_argument(
+          "Only stdout and stderr of the PUT can be recorded", __FILE__,
+          __LINE__);
+    if (std::any_of(output_channels.begin(), output_channels.end(),
+                    [fd](const auto &channel) { return channel.fd == fd; }))
+      continue;
+    output_channels.push_back(
+        {fd, OutputRingBuffer(recorded_outputs.capacity)});
+  }
+
   if (!has_setup_sighandlers) {
     // For the time being, as signal handler is set globally, this function is
     // static method, therefore it is not needed to set again if
@@ -112,6 +134,7 @@ NativeLinuxExecutor::NativeLinuxExecutor(
   SetupSharedMemories();
   SetupEnvironmentVariablesForTarget();
   CreateJoinedEnvironmentVariables(std::move(environment_variables_));
+  if (forksrv && keep_standby_fork_server) CreateStandbyEnvironmentVariables();
 
   if (forksrv) {
     SetupForkServer();
@@ -152,6 +175,7 @@ NativeLinuxExecutor::~NativeLinuxExecutor() {
   EraseSharedMemories();
 
   if (forksrv) {
+    if (standby_fork_server) CloseForkServer(*standby_fork_server);
     TerminateForkServer();
     // Although, PUT process should be handled by fork server, kill it just in
     // case. (Since fork server is expected to be killed using kill, therefore
@@ -203,15 +227,8 @@ void NativeLinuxExecutor::TerminateForkServer() {
     forksrv_write_fd = -1;
   }
 
-  if (fork_server_stdout_fd != -1) {
-    close(fork_server_stdout_fd);
-    fork_server_stdout_fd = -1;
-  }
-
-  if (fork_server_stderr_fd != -1) {
-    close(fork_server_stderr_fd);
-    fork_server_stderr_fd = -1;
-  }
+  for (int fd : fork_server_output_fds) close(fd);
+  fork_server_output_fds.clear();
 
   if (forksrv_pid > 0) {
     int status;
@@ -291,28 +308,6 @@ void NativeLinuxExecutor::SetupSignalHandlers() {
   sigaction(SIGALRM, &sa, NULL);
 }
 
-namespace detail {
-template <typename Dest>
-bool read_chunk(Dest &dest, int fd) {
-  std::size_t cur_size = dest.size();
-  dest.resize(cur_size + fuzzuf::executor::output_block_size);
-  auto read_stat = read(fd, std::next(dest.data(), cur_size),
-                        fuzzuf::executor::output_block_size);
-  if (read_stat < 0) {
-    dest.resize(cur_size);  // reset dest, whatever the error is
-
-    int e = errno;
-    if (e == EAGAIN || e == EWOULDBLOCK)
-      return false;
-    else if (!(e == EINTR))
-      throw fuzzuf::utils::errno_to_system_error(
-          e, "read from child process failed during the execution");
-  } else
-    dest.resize(cur_size + read_stat);
-  return read_stat != 0;
-}
-}  // namespace detail
-
 /**
  * Precondition:
  *  - input_fd has a file descriptor that is set by
@@ -354,10 +349,7 @@ void NativeLinuxExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
 
   // Aliases
   ResetSharedMemories();
-  if (record_stdout_and_err) {
-    stdout_buffer.clear();
-    stderr_buffer.clear();
-  }
+  for (auto &channel : output_channels) channel.buffer.Clear();
 
   WriteTestInputToFile(buf, len);
 
@@ -377,8 +369,73 @@ void NativeLinuxExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
   auto child_state = fuzzuf::utils::interprocess::create_shared_object(
       fuzzuf::executor::ChildState{0, 0});
 
-  std::array<int, 2u> stdout_fd{0, 0};
-  std::array<int, 2u> stderr_fd{0, 0};
+  ExecuteWrittenInput(timeout_ms, *child_state);
+}
+
+/**
+ * Precondition:
+ *  - Same as NativeLinuxExecutor::Run for each element of inputs.
+ * Postcondition:
+ *  - Each input is executed in order as if NativeLinuxExecutor::Run is called,
+ * and callback is called with the index of the input after each execution. If
+ * callback returns true, the rest of the inputs are not executed.
+ *  - Unlike calling Run repeatedly, the timeout is resolved, the command line
+ * is logged and the interprocess state for the child is allocated only once per
+ * batch, and the input file is truncated only when it shrinks.
+ */
+std::size_t NativeLinuxExecutor::RunBatch(BatchInputRange inputs,
+                                          const BatchCallback &callback,
+                                          u32 timeout_ms) {
+  if (inputs.empty()) return 0u;
+
+  // if timeout_ms is 0, then we use exec_timelimit_ms;
+  if (timeout_ms == 0) timeout_ms = exec_timelimit_ms;
+
+  DEBUG("RunBatch: ");
+  std::for_each(cargv.begin(), cargv.end(),
+                []([[maybe_unused]] const char *v) { DEBUG("%s ", v); });
+  DEBUG("\n")
+
+  auto child_state = fuzzuf::utils::interprocess::create_shared_object(
+      fuzzuf::executor::ChildState{0, 0});
+
+  std::size_t executed = 0u;
+  u32 prev_len = 0u;
+  for (const auto &input : inputs) {
+    // locked until std::shared_ptr<u8> lock is used in other places
+    while (IsFeedbackLocked()) {
+      usleep(100);
+    }
+
+    ResetSharedMemories();
+    for (auto &channel : output_channels) channel.buffer.Clear();
+
+    if (executed == 0u)
+      WriteTestInputToFile(input.buf, input.len);
+    else
+      OverwriteTestInputFile(input.buf, input.len, prev_len);
+    prev_len = input.len;
+
+    *child_state = fuzzuf::executor::ChildState{0, 0};
+    ExecuteWrittenInput(timeout_ms, *child_state);
+
+    if (callback(executed++)) break;
+  }
+  return executed;
+}
+
+/**
+ * Precondition:
+ *  - The input to be executed has already been written to the file refered by
+ * input_fd, and shared memories have been reset.
+ *  - child_state is shared with child processes (i.e. created by
+ * create_shared_object) and initialized to {0, 0}.
+ * Postcondition:
+ *  - Same as (2) to (5) of NativeLinuxExecutor::Run.
+ */
+void NativeLinuxExecutor::ExecuteWrittenInput(
+    u32 timeout_ms, fuzzuf::executor::ChildState &child_state) {
+  std::vector<std::array<int, 2u>> output_pipes;
   constexpr std::size_t read_size = 8u;
   boost::container::static_vector<std::uint8_t, read_size> read_buffer;
   bool timeout = true;
@@ -386,6 +443,8 @@ void NativeLinuxExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
     // The value tmp which is needed only on persistent mode that is currently
     // not implemented.
     static u8 tmp[4];
+    bool fork_server_lost = false;
+    child_pid = 0;
 
     // Request creating PUT process to fork server
     // The new PUT execution can be requested to the fork server by writing
@@ -414,17 +473,7 @@ void NativeLinuxExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
           break;
         else {
           if (event.events & EPOLLIN) {
-            if (event.data.fd == fork_server_stdout_fd)
-              // Although the buffer may contain data larger than
-              // output_block_size, that is not a problem as it is level
-              // trigger.
-              detail::read_chunk(stdout_buffer, fork_server_stdout_fd);
-            else if (event.data.fd == fork_server_stderr_fd)
-              // Although the buffer may contain data larger than
-              // output_block_size, that is not a problem as it is level
-              // trigger.
-              detail::read_chunk(stderr_buffer, fork_server_stderr_fd);
-            else if (event.data.fd == forksrv_read_fd) {
+            if (event.data.fd == forksrv_read_fd) {
               std::size_t cur_size = read_buffer.size();
               read_buffer.resize(read_size);
               auto read_stat =
@@ -444,8 +493,19 @@ void NativeLinuxExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
                   timeout = false;
                 }
               }
+            } else {
+              // Although the pipe may contain more data than one read
+              // receives, that is not a problem as it is level trigger.
+              ReadOutput(event.data.fd, fork_server_output_fds);
             }
           }
+          if (event.data.fd == forksrv_read_fd &&
+              (event.events & (EPOLLHUP | EPOLLERR)) &&
+              !(event.events & EPOLLIN)) {
+            // The fork server died during the execution
+            fork_server_lost = true;
+            break;
+          }
           if (event.events == EPOLLHUP || event.events == EPOLLERR)
             ERROR("pipe to the child process was unexpectedly closed");
         }
@@ -460,23 +520,24 @@ void NativeLinuxExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
           left_ms -= elapsed;
       }
     } catch (const utils::FileError &e) {
-      ERROR("Unable to request new process from fork server (OOM?)");
+      // The pid has not been received
+      read_buffer.clear();
+      fork_server_lost = true;
     }
     if (read_buffer.size() >= 4u)
       child_pid = *reinterpret_cast<std::uint32_t *>(read_buffer.data());
 
+    if (fork_server_lost) {
+      // The PUT process may be left if the fork server died during the
+      // execution
+      KillChildWithoutWait();
+      if (RetryWithStandbyForkServer(timeout_ms, child_state)) return;
+      ERROR("Unable to request new process from fork server (OOM?)");
+    }
+
     if (child_pid <= 0) ERROR("Fork server is misbehaving (OOM?)");
   } else {
-    if (record_stdout_and_err) {
-      if (pipe(stdout_fd.data()) < 0) {
-        throw fuzzuf::utils::errno_to_system_error(
-            errno, "Unable to create stdout pipe");
-      }
-      if (pipe(stderr_fd.data()) < 0) {
-        throw fuzzuf::utils::errno_to_system_error(
-            errno, "Unable to create stderr pipe");
-      }
-    }
+    output_pipes = CreateOutputPipes();
 
     child_pid = fuzzuf::utils::Fork();
     if (child_pid < 0) ERROR("fork() failed");
@@ -496,21 +557,13 @@ void NativeLinuxExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
 
       setrlimit(RLIMIT_CORE, &r); /* Ignore errors */
 
+      utils::BindPutCpu(put_cpuid);
+
       /* Isolate the process and configure standard descriptors. If out_file is
          specified, stdin is /dev/null; otherwise, out_fd is cloned instead. */
       setsid();
 
-      if (record_stdout_and_err) {
-        dup2(stdout_fd[1], 1);
-        dup2(stderr_fd[1], 2);
-        close(stdout_fd[0]);
-        close(stdout_fd[1]);
-        close(stderr_fd[0]);
-        close(stderr_fd[1]);
-      } else {
-        dup2(null_fd, 1);
-        dup2(null_fd, 2);
-      }
+      RedirectOutputs(output_pipes);
 
       if (stdin_mode) {
         dup2(input_fd, 0);
@@ -520,10 +573,10 @@ void NativeLinuxExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
       }
       // Execute new executable binary on the child process.
       // If failed, that matter is recorded to child_state.
-      child_state->exec_result =
+      child_state.exec_result =
           execve(cargv[0], (char **)cargv.data(),
                  const_cast<char **>(raw_environment_variables.data()));
-      child_state->exec_errno = errno;
+      child_state.exec_errno = errno;
 
       /* Use a distinctive bitmap value to tell the parent about execv()
          falling through. */
@@ -544,17 +597,18 @@ void NativeLinuxExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
     if (read_buffer.size() < 8u) {
       std::size_t cur_size = read_buffer.size();
       read_buffer.resize(read_size);
-      fuzzuf::utils::ReadFile(forksrv_read_fd,
-                              std::next(read_buffer.data(), cur_size),
-                              read_size - cur_size, false);
+      try {
+        fuzzuf::utils::ReadFile(forksrv_read_fd,
+                                std::next(read_buffer.data(), cur_size),
+                                read_size - cur_size, false);
+      } catch (const utils::FileError &e) {
+        // The fork server died while the PUT was being killed
+        if (RetryWithStandbyForkServer(timeout_ms, child_state)) return;
+        ERROR("Unable to communicate with fork server (OOM?)");
+      }
     }
 
-    if (record_stdout_and_err) {
-      while (detail::read_chunk(stdout_buffer, fork_server_stdout_fd))
-        ;
-      while (detail::read_chunk(stderr_buffer, fork_server_stderr_fd))
-        ;
-    }
+    DrainOutputs(fork_server_output_fds);
 
     if (read_buffer.size() >= 8u)
       put_status =
@@ -566,6 +620,11 @@ void NativeLinuxExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
     // It is set in the signal handler.
     child_timed_out = false;
 
+    // AlarmHandler kills the child of active_instance. Since another instance
+    // may have been created after this one (e.g. an executor for the CmpLog
+    // build of the PUT), point it to this instance.
+    active_instance = this;
+
     static struct itimerval it;
 
     // Set timer to make SIGALRM to be sent on timeout.
@@ -578,34 +637,30 @@ void NativeLinuxExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
       setitimer(ITIMER_REAL, &it, NULL);
     }
 
-    // If record_stdout_and_err is true, here starts the loop for saving outputs
-    // to buffers.
-    if (record_stdout_and_err) {
-      close(stdout_fd[1]);
-      close(stderr_fd[1]);
+    std::vector<int> read_fds;
+    for (auto &pipe_fd : output_pipes) {
+      close(pipe_fd[1]);
+      read_fds.push_back(pipe_fd[0]);
+    }
 
+    // If some outputs are recorded, here starts the loop for saving them to
+    // the buffers.
+    if (!read_fds.empty()) {
       auto epoll_fd = epoll_create(1);
-      epoll_event stdout_event;
-      stdout_event.data.fd = stdout_fd[0];
-      stdout_event.events = EPOLLIN | EPOLLRDHUP;
-      if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stdout_fd[0], &stdout_event) < 0) {
-        throw fuzzuf::utils::errno_to_system_error(
-            errno, "Unable to epoll stdout pipe");
-      }
-
-      epoll_event stderr_event;
-      stderr_event.data.fd = stderr_fd[0];
-      stderr_event.events = EPOLLIN | EPOLLRDHUP;
-      if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stderr_fd[0], &stderr_event) < 0) {
-        throw fuzzuf::utils::errno_to_system_error(
-            errno, "Unable to epoll stdout pipe");
+      for (int fd : read_fds) {
+        epoll_event output_event;
+        output_event.data.fd = fd;
+        output_event.events = EPOLLIN | EPOLLRDHUP;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &output_event) < 0) {
+          throw fuzzuf::utils::errno_to_system_error(
+              errno, "Unable to epoll output pipe");
+        }
+        fcntl(fd, F_SETFL, O_NONBLOCK);
       }
 
       epoll_event event;
       auto left_ms = timeout_ms;
-      unsigned int closed_count = 0u;
-      fcntl(stdout_fd[0], F_SETFL, O_NONBLOCK);
-      fcntl(stderr_fd[0], F_SETFL, O_NONBLOCK);
+      std::size_t closed_count = 0u;
       while (left_ms > 0) {
         const auto begin_date = std::chrono::steady_clock::now();
         auto event_count = epoll_wait(epoll_fd, &event, 1, left_ms);
@@ -618,21 +673,16 @@ void NativeLinuxExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
         } else if (event_count == 0)
           break;
         else {
-          if (event.events & EPOLLIN) {
-            if (event.data.fd == stdout_fd[0])
-              // Although the buffer may contain data larger than
-              // output_block_size, that is not a problem as it is level
-              // trigger.
-              detail::read_chunk(stdout_buffer, stdout_fd[0]);
-            else if (event.data.fd == stderr_fd[0])
-              // Although the buffer may contain data larger than
-              // output_block_size, that is not a problem as it is level
-              // trigger.
-              detail::read_chunk(stderr_buffer, stderr_fd[0]);
-          }
+          if (event.events & EPOLLIN)
+            // Although the pipe may contain more data than one read
+            // receives, that is not a problem as it is level trigger.
+            ReadOutput(event.data.fd, read_fds);
           if (event.events == EPOLLHUP || event.events == EPOLLERR) {
+            // Nothing is left in the pipe. Stop watching it, as it would be
+            // reported again.
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, event.data.fd, nullptr);
             ++closed_count;
-            if (closed_count == 2u) break;
+            if (closed_count == read_fds.size()) break;
           }
         }
         const auto end_date = std::chrono::steady_clock::now();
@@ -650,18 +700,8 @@ void NativeLinuxExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
 
     if (waitpid(child_pid, &put_status, 0) <= 0) ERROR("waitpid() failed");
 
-    if (record_stdout_and_err) {
-      bool cont = true;
-      while (cont) {
-        cont = detail::read_chunk(stdout_buffer, stdout_fd[0]);
-      }
-      cont = true;
-      while (cont) {
-        cont = detail::read_chunk(stderr_buffer, stderr_fd[0]);
-      }
-      close(stdout_fd[0]);
-      close(stderr_fd[0]);
-    }
+    DrainOutputs(read_fds);
+    for (int fd : read_fds) close(fd);
 
     // Reset the timer.
     if (exec_timelimit_ms) {
@@ -689,7 +729,7 @@ void NativeLinuxExecutor::Run(const u8 *buf, u32 len, u32 timeout_ms) {
   u32 tb4 = 0;
 
   // Consider execution was failed if execv of child process failed.
-  if (child_state->exec_result < 0) tb4 = EXEC_FAIL_SIG;
+  if (child_state.exec_result < 0) tb4 = EXEC_FAIL_SIG;
 
   last_exit_reason = feedback::PUTExitReasonType::FAULT_NONE;
   last_signal = 0;
@@ -743,14 +783,79 @@ feedback::InplaceMemoryFeedback NativeLinuxExecutor::GetBBFeedback() {
   return fuzzuf_bb_coverage.GetFeedback();
 }
 
+/*
+ * Postcondition:
+ *  - A pipe is created for each of output_channels, in the same order. Both
+ * ends have O_CLOEXEC so that only the fds the PUT writes to are inherited.
+ */
+std::vector<std::array<int, 2u>> NativeLinuxExecutor::CreateOutputPipes() {
+  std::vector<std::array<int, 2u>> pipes(output_channels.size());
+  for (auto &pipe_fd : pipes) {
+    if (pipe2(pipe_fd.data(), O_CLOEXEC) < 0) {
+      throw fuzzuf::utils::errno_to_system_error(
+          errno, "Unable to create output pipe");
+    }
+  }
+  return pipes;
+}
+
+/*
+ * Precondition:
+ *  - Called in the child process, with the pipes made by CreateOutputPipes.
+ * Postcondition:
+ *  - Each recorded fd is bound to the write end of its pipe, and stdout and
+ * stderr are bound to /dev/null unless they are recorded.
+ */
+void NativeLinuxExecutor::RedirectOutputs(
+    const std::vector<std::array<int, 2u>> &pipes) {
+  dup2(null_fd, 1);
+  dup2(null_fd, 2);
+  for (std::size_t i = 0; i < output_channels.size(); i++)
+    dup2(pipes[i][1], output_channels[i].fd);
+}
+
+/*
+ * Postcondition:
+ *  - If fd is one of read_fds, which are the read ends of the pipes in the
+ * same order as output_channels, the data available in it is appended to the
+ * corresponding buffer and true is returned. Otherwise false is returned.
+ */
+bool NativeLinuxExecutor::ReadOutput(int fd, const std::vector<int> &read_fds) {
+  for (std::size_t i = 0; i < read_fds.size(); i++) {
+    if (read_fds[i] == fd) {
+      output_channels[i].buffer.ReadFrom(fd);
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Postcondition:
+ *  - All data left in read_fds is appended to the buffers.
+ */
+void NativeLinuxExecutor::DrainOutputs(const std::vector<int> &read_fds) {
+  for (std::size_t i = 0; i < read_fds.size(); i++) {
+    while (output_channels[i].buffer.ReadFrom(read_fds[i]))
+      ;
+  }
+}
+
+feedback::InplaceMemoryFeedback NativeLinuxExecutor::GetOutput(int fd) {
+  for (auto &channel : output_channels) {
+    if (channel.fd == fd)
+      return feedback::InplaceMemoryFeedback(
+          channel.buffer.Data(), channel.buffer.Size(), lock);
+  }
+  return feedback::InplaceMemoryFeedback(nullptr, 0, lock);
+}
+
 feedback::InplaceMemoryFeedback NativeLinuxExecutor::GetStdOut() {
-  return feedback::InplaceMemoryFeedback(stdout_buffer.data(),
-                                         stdout_buffer.size(), lock);
+  return GetOutput(STDOUT_FILENO);
 }
 
 feedback::InplaceMemoryFeedback NativeLinuxExecutor::GetStdErr() {
-  return feedback::InplaceMemoryFeedback(stderr_buffer.data(),
-                                         stderr_buffer.size(), lock);
+  return GetOutput(STDERR_FILENO);
 }
 
 feedback::ExitStatusFeedback NativeLinuxExecutor::GetExitStatusFeedback() {
@@ -768,6 +873,10 @@ bool NativeLinuxExecutor::IsFeedbackLocked() {
 void NativeLinuxExecutor::SetupSharedMemories() {
   afl_edge_coverage.Setup();
   fuzzuf_bb_coverage.Setup();
+  if (forksrv && keep_standby_fork_server) {
+    standby_afl_edge_coverage.Setup();
+    standby_fuzzuf_bb_coverage.Setup();
+  }
 }
 
 // Since shared memory is reused, it is initialized every time before passed to
@@ -781,6 +890,8 @@ void NativeLinuxExecutor::ResetSharedMemories() {
 void NativeLinuxExecutor::EraseSharedMemories() {
   afl_edge_coverage.Erase();
   fuzzuf_bb_coverage.Erase();
+  standby_afl_edge_coverage.Erase();
+  standby_fuzzuf_bb_coverage.Erase();
 }
 
 // Since PUT that is instrumented using afl-clang-fast or fuzzuf-cc
@@ -864,6 +975,45 @@ void NativeLinuxExecutor::CreateJoinedEnvironmentVariables(
   raw_environment_variables.shrink_to_fit();
 }
 
+/*
+ * Precondition:
+ *  - The standby shared memories are set up, and environment_variables is
+ * created.
+ * Postcondition:
+ *  - standby_environment_variables is a copy of environment_variables, where
+ * the shared memories passed to the PUT are replaced with the standby ones.
+ *  - raw_standby_environment_variables points its values.
+ */
+void NativeLinuxExecutor::CreateStandbyEnvironmentVariables() {
+  // Pairs of "NAME=" and the value of the standby shared memory
+  const std::pair<std::string, std::string> shm_variables[] = {
+      {std::string(coverage::AFLEdgeCovAttacher::SHM_ENV_VAR) + "=",
+       standby_afl_edge_coverage.GetEnvironmentVariableValue()},
+      {std::string(coverage::FuzzufBBCovAttacher::SHM_ENV_VAR) + "=",
+       standby_fuzzuf_bb_coverage.GetEnvironmentVariableValue()}};
+
+  standby_environment_variables.clear();
+  raw_standby_environment_variables.clear();
+  for (const auto &e : environment_variables) {
+    auto replaced = std::find_if(
+        std::begin(shm_variables), std::end(shm_variables),
+        [&e](const auto &v) { return e.rfind(v.first, 0) == 0; });
+    if (replaced == std::end(shm_variables))
+      standby_environment_variables.push_back(e);
+    else if (!replaced->second.empty())
+      standby_environment_variables.push_back(replaced->first +
+                                              replaced->second);
+  }
+  standby_environment_variables.shrink_to_fit();
+  raw_standby_environment_variables.reserve(
+      standby_environment_variables.size() + 1);
+  std::transform(standby_environment_variables.begin(),
+                 standby_environment_variables.end(),
+                 std::back_inserter(raw_standby_environment_variables),
+                 [](const auto &e) { return e.c_str(); });
+  raw_standby_environment_variables.push_back(nullptr);
+}
+
 /*
  * Precondition:
  *  - The target PUT is a binary that supports fork server mode.
@@ -873,30 +1023,73 @@ void NativeLinuxExecutor::CreateJoinedEnvironmentVariables(
  *  - Apply proper limits ( ex. memory limits ) on PUT.
  *  - Setup the pipe between parent process ( the process that runs fuzzuf ) and
  * child process.
+ *  - If keep_standby_fork_server is true, a standby fork server is launched
+ * too. Its handshake is not read yet.
  */
 void NativeLinuxExecutor::SetupForkServer() {
+  ActivateForkServer(LaunchForkServer(raw_environment_variables));
+
+  // Wait for fork server to launch with 10 seconds of time limit (Conforming
+  // AFL++ that looks waiting 10 seconds.). The handshake is sent from remote on
+  // launched.
+  u8 tmp[4];
+  u32 time_limit = 10000;
+  u32 time_ms =
+      fuzzuf::utils::ReadFileTimed(forksrv_read_fd, &tmp, 4, time_limit);
+  if (time_ms == 0) {
+    // Error during reading
+    TerminateForkServer();
+    MSG("\n" cLRD "[-] " cRST
+        "Hmm, looks like the target binary terminated before we could complete "
+        "a\n"
+        "handshake with the injected code. You can try the following:\n\n"
+        "    - Possibly the target is not a valid executable. Check:\n"
+        "      - The target exists and a valid ELF binary.\n"
+        "      - The target is instrumented.\n"
+        "        Retry with fork server disabled.\n");
+    ABORT("Fork server handshake failed");
+  } else if (time_ms > time_limit) {
+    // Timeout
+    TerminateForkServer();
+    ABORT("Timeout while initializing fork server (Default time limit is 10s)");
+  }
+
+  if (keep_standby_fork_server) ReplenishStandbyForkServer();
+
+  return;
+}
+
+/*
+ * Postcondition:
+ *  - Generate child process, then launch PUT in fork server mode on the child
+ * process side. The handshake is not read yet.
+ *  - Apply proper limits ( ex. memory limits ) on PUT.
+ *  - Returns the parent side of the pipes to the fork server without touching
+ * the members of this class, so that this can also launch standby fork
+ * servers. The PUT receives environment, which decides the shared memories
+ * it writes the coverage to.
+ *  - The child process only calls async-signal-safe functions before execve,
+ * since other threads of fuzzuf may hold locks at the time of fork().
+ */
+NativeLinuxExecutor::ForkServerHandle NativeLinuxExecutor::LaunchForkServer(
+    const std::vector<const char *> &environment) {
   // set of fd of pipe.
   // Each is used for parent -> child and child -> parent data transfer.
+  // The pipes are created with O_CLOEXEC so that fork servers launched later
+  // (i.e. standby fork servers) never inherit the pipes of the others. The
+  // ends used by the fork server are dup2-ed below, which clears the flag.
   int par2chld[2], chld2par[2];
 
-  if (pipe(par2chld) || pipe(chld2par)) ERROR("pipe() failed");
+  if (pipe2(par2chld, O_CLOEXEC) || pipe2(chld2par, O_CLOEXEC))
+    ERROR("pipe() failed");
 
-  std::array<int, 2u> stdout_fd{-1, -1};
-  std::array<int, 2u> stderr_fd{-1, -1};
+  auto output_pipes = CreateOutputPipes();
 
-  if (record_stdout_and_err) {
-    if (pipe(stdout_fd.data()) < 0) {
-      ERROR("Unable to create stdout pipe");
-    }
-    if (pipe(stderr_fd.data()) < 0) {
-      ERROR("Unable to create stderr pipe");
-    }
-  }
-
-  forksrv_pid = fork();
-  if (forksrv_pid < 0) ERROR("fork() failed");
+  ForkServerHandle handle;
+  handle.pid = fork();
+  if (handle.pid < 0) ERROR("fork() failed");
 
-  if (!forksrv_pid) {
+  if (!handle.pid) {
     struct rlimit r;
     /* Umpf. On OpenBSD, the default fd limit for root users is set to
        soft 128. Let's try to fix that... */
@@ -927,17 +1120,11 @@ void NativeLinuxExecutor::SetupForkServer() {
     r.rlim_max = r.rlim_cur = 0;
     setrlimit(RLIMIT_CORE, &r);
 
+    utils::BindPutCpu(put_cpuid);
+
     setsid();
 
-    if (record_stdout_and_err) {
-      dup2(stdout_fd[1], 1);
-      dup2(stderr_fd[1], 2);
-      close(stdout_fd[0]);
-      close(stderr_fd[0]);
-    } else {
-      dup2(null_fd, 1);
-      dup2(null_fd, 2);
-    }
+    RedirectOutputs(output_pipes);
 
     if (stdin_mode) {
       dup2(input_fd, 0);
@@ -945,8 +1132,9 @@ void NativeLinuxExecutor::SetupForkServer() {
       dup2(null_fd, 0);
     }
 
-    if (dup2(par2chld[0], FORKSRV_FD_READ) < 0) ERROR("dup2() failed");
-    if (dup2(chld2par[1], FORKSRV_FD_WRITE) < 0) ERROR("dup2() failed");
+    // The parent notices the failure as the handshake doesn't arrive
+    if (dup2(par2chld[0], FORKSRV_FD_READ) < 0) _exit(EXIT_FAILURE);
+    if (dup2(chld2par[1], FORKSRV_FD_WRITE) < 0) _exit(EXIT_FAILURE);
 
     close(par2chld[0]);
     close(par2chld[1]);
@@ -954,76 +1142,173 @@ void NativeLinuxExecutor::SetupForkServer() {
     close(chld2par[1]);
 
     execve(cargv[0], (char **)cargv.data(),
-           const_cast<char **>(raw_environment_variables.data()));
+           const_cast<char **>(environment.data()));
     // TODO: It must be discussed whether it is needed that equivalent to
     // EXEC_FAIL_SIG that is used in non-fork server mode.
-    exit(0);
+    _exit(0);
   }
 
   close(par2chld[0]);
   close(chld2par[1]);
 
-  if (record_stdout_and_err) {
-    close(stdout_fd[1]);
-    close(stderr_fd[1]);
-    fork_server_stdout_fd = stdout_fd[0];
-    fork_server_stderr_fd = stderr_fd[0];
-    fcntl(fork_server_stdout_fd, F_SETFL, O_NONBLOCK);
-    fcntl(fork_server_stderr_fd, F_SETFL, O_NONBLOCK);
+  for (auto &pipe_fd : output_pipes) {
+    close(pipe_fd[1]);
+    fcntl(pipe_fd[0], F_SETFL, O_NONBLOCK);
+    handle.output_fds.push_back(pipe_fd[0]);
   }
 
-  fork_server_epoll_fd = epoll_create(1);
-  if (record_stdout_and_err) {
-    fork_server_stdout_event.data.fd = fork_server_stdout_fd;
-    fork_server_stdout_event.events = EPOLLIN | EPOLLRDHUP;
-    if (epoll_ctl(fork_server_epoll_fd, EPOLL_CTL_ADD, fork_server_stdout_fd,
-                  &fork_server_stdout_event) < 0) {
-      ERROR("Unable to epoll stdout pipe");
-    }
+  handle.write_fd = par2chld[1];
+  handle.read_fd = chld2par[0];
+  return handle;
+}
+
+/*
+ * Precondition:
+ *  - No fork server is active (i.e. TerminateForkServer has been called, or
+ * the fork server has never been launched).
+ * Postcondition:
+ *  - The fork server specified by handle becomes the one used by Run.
+ *  - The pipes of the fork server are registered to fork_server_epoll_fd.
+ */
+void NativeLinuxExecutor::ActivateForkServer(const ForkServerHandle &handle) {
+  forksrv_pid = handle.pid;
+  forksrv_read_fd = handle.read_fd;
+  forksrv_write_fd = handle.write_fd;
+  fork_server_output_fds = handle.output_fds;
 
-    fork_server_stderr_event.data.fd = fork_server_stderr_fd;
-    fork_server_stderr_event.events = EPOLLIN | EPOLLRDHUP;
-    if (epoll_ctl(fork_server_epoll_fd, EPOLL_CTL_ADD, fork_server_stderr_fd,
-                  &fork_server_stderr_event) < 0) {
-      ERROR("Unable to epoll stderr pipe");
+  fork_server_epoll_fd = epoll_create(1);
+  for (int fd : fork_server_output_fds) {
+    epoll_event output_event;
+    output_event.data.fd = fd;
+    output_event.events = EPOLLIN | EPOLLRDHUP;
+    if (epoll_ctl(fork_server_epoll_fd, EPOLL_CTL_ADD, fd, &output_event) < 0) {
+      ERROR("Unable to epoll output pipe");
     }
   }
 
-  forksrv_write_fd = par2chld[1];
-  forksrv_read_fd = chld2par[0];
   fork_server_read_event.data.fd = forksrv_read_fd;
   fork_server_read_event.events = EPOLLIN | EPOLLRDHUP;
   if (epoll_ctl(fork_server_epoll_fd, EPOLL_CTL_ADD, forksrv_read_fd,
                 &fork_server_read_event) < 0) {
     ERROR("Unable to epoll read pipe");
   }
+}
 
-  // Wait for fork server to launch with 10 seconds of time limit (Conforming
-  // AFL++ that looks waiting 10 seconds.). The handshake is sent from remote on
-  // launched.
+/*
+ * Postcondition:
+ *  - The pipes in handle are closed, and the fork server is killed and reaped.
+ *  - All values in handle are invalidated (fail-safe).
+ */
+void NativeLinuxExecutor::CloseForkServer(ForkServerHandle &handle) {
+  for (auto fd : {&handle.read_fd, &handle.write_fd}) {
+    if (*fd != -1) {
+      close(*fd);
+      *fd = -1;
+    }
+  }
+  for (int fd : handle.output_fds) close(fd);
+  handle.output_fds.clear();
+
+  if (handle.pid > 0) {
+    int status;
+    kill(handle.pid, SIGKILL);
+    waitpid(handle.pid, &status, 0);
+    handle.pid = -1;
+  }
+}
+
+/*
+ * Postcondition:
+ *  - If there is no standby fork server, a new fork server is launched and
+ * kept in standby_fork_server. It initializes itself in parallel with the
+ * fuzzing, and its handshake is read by SwapInStandbyForkServer.
+ *  - The standby fork server writes to the standby shared memories, so that
+ * what its initialization records never mixes with the running executions.
+ *  - The fork server is launched from the calling thread, which is the one
+ * running the executor, instead of a helper thread.
+ */
+void NativeLinuxExecutor::ReplenishStandbyForkServer() {
+  if (standby_fork_server) return;
+  standby_fork_server = LaunchForkServer(raw_standby_environment_variables);
+}
+
+/*
+ * Postcondition:
+ *  - If the standby fork server completes the handshake, the active fork
+ * server is terminated, the standby one takes its place together with its
+ * shared memories, and the next standby fork server is launched. Returns true
+ * in this case. The shared memories must be reset before the next execution.
+ *  - Otherwise, the standby fork server is discarded, the active one is not
+ * changed and false is returned. A new standby fork server is launched on the
+ * next swap.
+ *  - If the standby fork server is still initializing, this waits for it,
+ * which is still faster than launching a new one from scratch.
+ */
+bool NativeLinuxExecutor::SwapInStandbyForkServer() {
+  if (!keep_standby_fork_server) return false;
+
+  if (!standby_fork_server) {
+    ReplenishStandbyForkServer();
+    return false;
+  }
+
+  // Same time limit as SetupForkServer
   u8 tmp[4];
-  u32 time_limit = 10000;
-  u32 time_ms =
-      fuzzuf::utils::ReadFileTimed(forksrv_read_fd, &tmp, 4, time_limit);
-  if (time_ms == 0) {
-    // Error during reading
-    TerminateForkServer();
-    MSG("\n" cLRD "[-] " cRST
-        "Hmm, looks like the target binary terminated before we could complete "
-        "a\n"
-        "handshake with the injected code. You can try the following:\n\n"
-        "    - Possibly the target is not a valid executable. Check:\n"
-        "      - The target exists and a valid ELF binary.\n"
-        "      - The target is instrumented.\n"
-        "        Retry with fork server disabled.\n");
-    ABORT("Fork server handshake failed");
-  } else if (time_ms > time_limit) {
-    // Timeout
-    TerminateForkServer();
-    ABORT("Timeout while initializing fork server (Default time limit is 10s)");
+  constexpr u32 time_limit = 10000;
+  u32 time_ms = fuzzuf::utils::ReadFileTimed(standby_fork_server->read_fd,
+                                             &tmp, 4, time_limit);
+  if (time_ms == 0 || time_ms > time_limit) {
+    CloseForkServer(*standby_fork_server);
+    standby_fork_server.reset();
+    return false;
   }
 
-  return;
+  TerminateForkServer();
+  ActivateForkServer(*standby_fork_server);
+  standby_fork_server.reset();
+
+  // The PUTs forked from now on write to the shared memories of the standby
+  // fork server, and the next standby one takes over the current ones
+  afl_edge_coverage.Swap(standby_afl_edge_coverage);
+  fuzzuf_bb_coverage.Swap(standby_fuzzuf_bb_coverage);
+  environment_variables.swap(standby_environment_variables);
+  raw_environment_variables.swap(raw_standby_environment_variables);
+
+  ReplenishStandbyForkServer();
+  return true;
+}
+
+/*
+ * Precondition:
+ *  - The active fork server has died during ExecuteWrittenInput, and the PUT
+ * process has been killed.
+ * Postcondition:
+ *  - If the standby fork server is swapped in, the written input is executed
+ * again with it, and true is returned. This is done only once per input, so
+ * that a PUT killing every fork server doesn't loop.
+ *  - Otherwise, nothing is done and false is returned.
+ */
+bool NativeLinuxExecutor::RetryWithStandbyForkServer(
+    u32 timeout_ms, fuzzuf::executor::ChildState &child_state) {
+  if (retrying_with_standby_fork_server || !SwapInStandbyForkServer())
+    return false;
+
+  DEBUG("Fork server was lost. Switched to the standby fork server.");
+
+  // Forget what the aborted execution left
+  ResetSharedMemories();
+  for (auto &channel : output_channels) channel.buffer.Clear();
+  if (stdin_mode) fuzzuf::utils::SeekFile(input_fd, 0, SEEK_SET);
+
+  retrying_with_standby_fork_server = true;
+  try {
+    ExecuteWrittenInput(timeout_ms, child_state);
+  } catch (...) {
+    retrying_with_standby_fork_server = false;
+    throw;
+  }
+  retrying_with_standby_fork_server = false;
+  return true;
 }
 
 // this function may be called in signal handlers.
@@ -1042,11 +1327,19 @@ void NativeLinuxExecutor::ReceiveStopSignal(void) {
 }
 
 fuzzuf::executor::output_t NativeLinuxExecutor::MoveStdOut() {
-  return std::move(stdout_buffer);
+  fuzzuf::executor::output_t output;
+  GetStdOut().ShowMemoryToFunc([&](const u8 *head, u32 size) {
+    output.assign(head, std::next(head, size));
+  });
+  return output;
 }
 
 fuzzuf::executor::output_t NativeLinuxExecutor::MoveStdErr() {
-  return std::move(stderr_buffer);
+  fuzzuf::executor::output_t output;
+  GetStdErr().ShowMemoryToFunc([&](const u8 *head, u32 size) {
+    output.assign(head, std::next(head, size));
+  });
+  return output;
 }
 
 }  // namespace fuzzuf::executor
@@ -0,0 +1,138 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file output_ring_buffer.cpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#include "fuzzuf/executor/output_ring_buffer.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <utility>
+
+#include "fuzzuf/logger/logger.hpp"
+#include "fuzzuf/utils/errno_to_system_error.hpp"
+
+namespace fuzzuf::executor {
+
+OutputRingBuffer::OutputRingBuffer(std::size_t capacity_) {
+  const std::size_t page_size = sysconf(_SC_PAGESIZE);
+  capacity = (std::max<std::size_t>(capacity_, 1u) + page_size - 1) /
+             page_size * page_size;
+
+  memfd = memfd_create("fuzzuf_output", MFD_CLOEXEC);
+  if (memfd < 0) ERROR("memfd_create() failed");
+  if (ftruncate(memfd, capacity) < 0) ERROR("ftruncate() failed");
+
+  // Reserve the address range first, then map the same pages to both halves
+  void *addr = mmap(nullptr, capacity * 2, PROT_NONE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr == MAP_FAILED) ERROR("mmap() failed");
+  base = static_cast<u8 *>(addr);
+
+  for (std::size_t offset : {std::size_t(0), capacity}) {
+    if (mmap(base + offset, capacity, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_FIXED, memfd, 0) == MAP_FAILED)
+      ERROR("mmap() failed");
+  }
+}
+
+OutputRingBuffer::~OutputRingBuffer() { Release(); }
+
+OutputRingBuffer::OutputRingBuffer(OutputRingBuffer &&src) noexcept {
+  *this = std::move(src);
+}
+
+OutputRingBuffer &OutputRingBuffer::operator=(OutputRingBuffer &&src) noexcept {
+  if (this != &src) {
+    Release();
+    base = std::exchange(src.base, nullptr);
+    capacity = std::exchange(src.capacity, 0);
+    memfd = std::exchange(src.memfd, -1);
+    splice_unsupported = src.splice_unsupported;
+    head = std::exchange(src.head, 0);
+    size = std::exchange(src.size, 0);
+    total_size = std::exchange(src.total_size, 0);
+  }
+  return *this;
+}
+
+void OutputRingBuffer::Release() {
+  if (base != nullptr) {
+    munmap(base, capacity * 2);
+    base = nullptr;
+  }
+  if (memfd != -1) {
+    close(memfd);
+    memfd = -1;
+  }
+}
+
+bool OutputRingBuffer::ReadFrom(int fd) {
+  // New bytes go right after the kept ones. Since the pages are mapped twice,
+  // up to capacity bytes can be written from there, and the oldest bytes are
+  // the last to be overwritten.
+  const std::size_t tail = (head + size) % capacity;
+
+  ssize_t read_stat = -1;
+  if (!splice_unsupported) {
+    // The offsets in memfd don't wrap around, unlike the addresses
+    loff_t offset = tail;
+    read_stat = splice(fd, nullptr, memfd, &offset, capacity - tail,
+                       SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    // fd is not a pipe
+    if (read_stat < 0 && errno == EINVAL) splice_unsupported = true;
+  }
+  if (splice_unsupported) read_stat = read(fd, base + tail, capacity);
+
+  if (read_stat < 0) {
+    int e = errno;
+    if (e == EAGAIN || e == EWOULDBLOCK)
+      return false;
+    else if (e == EINTR)
+      return true;
+    throw fuzzuf::utils::errno_to_system_error(
+        e, "read from child process failed during the execution");
+  }
+
+  Commit(read_stat);
+  return read_stat != 0;
+}
+
+void OutputRingBuffer::Commit(std::size_t len) {
+  total_size += len;
+  size += len;
+  if (size > capacity) {
+    head = (head + size - capacity) % capacity;
+    size = capacity;
+  }
+}
+
+RecordedOutputs::RecordedOutputs(bool record_stdout_and_err)
+    : capacity(OutputRingBuffer::DEFAULT_CAPACITY) {
+  if (record_stdout_and_err) fds = {STDOUT_FILENO, STDERR_FILENO};
+}
+
+RecordedOutputs::RecordedOutputs(std::vector<int> fds, std::size_t capacity)
+    : fds(std::move(fds)), capacity(capacity) {}
+
+}  // namespace fuzzuf::executor
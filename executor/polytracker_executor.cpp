@@ -82,6 +82,8 @@ void PolyTrackerExecutor::SetCArgvAndDecideInputMode() {
   cargv.emplace_back("-o");
   cargv.emplace_back(path_str_to_output.c_str());
 
+  cargv.emplace_back("--binary");
+
   cargv.emplace_back(nullptr);
 }
 }  // namespace fuzzuf::executor
@@ -33,11 +33,26 @@ FileFeedback::FileFeedback(fs::path feed_path,
                            std::shared_ptr<u8> executor_lock)
     : feed_path(feed_path), executor_lock(executor_lock) {}
 
+FileFeedback::FileFeedback(fs::path feed_path, const u8* mem, u32 len,
+                           std::shared_ptr<u8> executor_lock)
+    : feed_path(feed_path),
+      in_memory(true),
+      mem(mem),
+      len(len),
+      executor_lock(executor_lock) {}
+
 FileFeedback::FileFeedback(FileFeedback&& orig)
-    : feed_path(orig.feed_path), executor_lock(std::move(orig.executor_lock)) {}
+    : feed_path(orig.feed_path),
+      in_memory(orig.in_memory),
+      mem(orig.mem),
+      len(orig.len),
+      executor_lock(std::move(orig.executor_lock)) {}
 
 FileFeedback& FileFeedback::operator=(FileFeedback&& orig) {
   std::swap(feed_path, orig.feed_path);
+  std::swap(in_memory, orig.in_memory);
+  std::swap(mem, orig.mem);
+  std::swap(len, orig.len);
   std::swap(executor_lock, orig.executor_lock);
 
   return *this;
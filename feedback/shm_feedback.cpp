@@ -0,0 +1,127 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file shm_feedback.cpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#include "fuzzuf/feedback/shm_feedback.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include "fuzzuf/logger/logger.hpp"
+#include "fuzzuf/utils/common.hpp"
+
+namespace fuzzuf::feedback {
+
+void ShmFeedbackRegion::Setup(std::uint32_t capacity) {
+  Erase();
+
+  static std::atomic<u32> shm_count(0);
+  name = "/fuzzuf_feedback_" + std::to_string(getpid()) + "_" +
+         std::to_string(shm_count++);
+
+  shm_fd =
+      shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+  if (shm_fd < 0) ERROR("shm_open() failed");
+
+  // Pages are allocated when the proxy touches them, so that a large
+  // capacity costs nothing unless it's used
+  mapped_size = sizeof(ShmFeedbackHeader) + capacity;
+  if (ftruncate(shm_fd, mapped_size) < 0) ERROR("ftruncate() failed");
+
+  void *addr = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    shm_fd, 0);
+  if (addr == MAP_FAILED) ERROR("mmap() failed");
+  header = static_cast<ShmFeedbackHeader *>(addr);
+
+  std::memcpy(header->magic, SHM_FEEDBACK_MAGIC, sizeof(header->magic));
+  header->version = SHM_FEEDBACK_VERSION;
+  header->capacity = capacity;
+  Reset();
+}
+
+void ShmFeedbackRegion::Erase() {
+  if (header != nullptr) {
+    if (munmap(header, mapped_size) == -1) ERROR("munmap() failed");
+    header = nullptr;
+    mapped_size = 0;
+  }
+  if (shm_fd != -1) {
+    close(shm_fd);
+    shm_fd = -1;
+  }
+  if (!name.empty()) {
+    shm_unlink(name.c_str());
+    name.clear();
+  }
+}
+
+void ShmFeedbackRegion::Reset() {
+  if (header == nullptr) return;
+
+  header->flags = 0;
+  header->size = 0;
+  header->record_count = 0;
+
+  MEM_BARRIER();
+}
+
+bool ShmFeedbackRegion::IsAttached() const {
+  return header != nullptr && (header->flags & SHM_FEEDBACK_ATTACHED);
+}
+
+bool ShmFeedbackRegion::IsOverflowed() const {
+  return header != nullptr && (header->flags & SHM_FEEDBACK_OVERFLOW);
+}
+
+const std::uint8_t *ShmFeedbackRegion::Find(const char (&tag)[4],
+                                            std::uint32_t &len) const {
+  if (!IsAttached()) return nullptr;
+
+  // Don't trust the values written by the proxy
+  const std::size_t size = std::min(header->size, header->capacity);
+  const auto *records = reinterpret_cast<const std::uint8_t *>(header + 1);
+
+  std::size_t pos = 0;
+  for (std::uint32_t i = 0; i < header->record_count; i++) {
+    if (size - pos < sizeof(ShmFeedbackRecordHeader)) return nullptr;
+
+    const auto *record =
+        reinterpret_cast<const ShmFeedbackRecordHeader *>(records + pos);
+    pos += sizeof(ShmFeedbackRecordHeader);
+    if (size - pos < record->length) return nullptr;
+
+    if (std::equal(tag, tag + sizeof(tag), record->tag)) {
+      len = record->length;
+      return records + pos;
+    }
+
+    pos += (std::size_t(record->length) + SHM_FEEDBACK_RECORD_ALIGN - 1) /
+           SHM_FEEDBACK_RECORD_ALIGN * SHM_FEEDBACK_RECORD_ALIGN;
+    if (pos > size) return nullptr;
+  }
+  return nullptr;
+}
+
+}  // namespace fuzzuf::feedback
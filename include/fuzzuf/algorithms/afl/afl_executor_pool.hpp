@@ -0,0 +1,149 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file afl_executor_pool.hpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+
+#ifndef FUZZUF_INCLUDE_ALGORITHM_AFL_AFL_EXECUTOR_POOL_HPP
+#define FUZZUF_INCLUDE_ALGORITHM_AFL_AFL_EXECUTOR_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "fuzzuf/executor/afl_executor_interface.hpp"
+#include "fuzzuf/feedback/exit_status_feedback.hpp"
+#include "fuzzuf/utils/common.hpp"
+
+namespace fuzzuf::algorithm::afl {
+
+struct RecordedExecution {
+  u32 trace_id;  // Index of ExecutionRecord::traces
+  feedback::ExitStatusFeedback exit_status;
+  u64 exec_us;
+};
+
+/**
+ * @struct ExecutionRecord
+ * @brief Executions of a PUT done by an executor of AFLExecutorPool, in the
+ * order they were done.
+ * @details The traces are kept before ClassifyCounts is applied. Executions
+ * producing the same trace share it, so that a stable testcase costs one
+ * trace however many times it is run.
+ */
+struct ExecutionRecord {
+  std::vector<std::vector<u8>> traces;
+  std::vector<u32> trace_cksums;
+  std::vector<RecordedExecution> executions;
+};
+
+/**
+ * @class ExecutionRecorder
+ * @brief Runs an executor of AFLExecutorPool and appends the results to an
+ * ExecutionRecord.
+ */
+class ExecutionRecorder {
+ public:
+  ExecutionRecorder(executor::AFLExecutorInterface &executor,
+                    ExecutionRecord &record);
+
+  const RecordedExecution &Run(const u8 *buf, u32 len, u32 tmout);
+
+  // Checksum of the raw trace of the execution
+  u32 GetCksum(const RecordedExecution &execution) const {
+    return record.trace_cksums[execution.trace_id];
+  }
+
+ private:
+  executor::AFLExecutorInterface &executor;
+  ExecutionRecord &record;
+};
+
+/**
+ * @class AFLExecutorPool
+ * @brief Runs independent jobs, such as calibrating each initial seed, on
+ * several executors in parallel, and hands their records back in job order.
+ * @details The executors must not share anything with each other nor with
+ * the executor of the state, e.g. the file to write inputs to, and must time
+ * out executions without process-wide signals. Start() runs job(i, recorder)
+ * for each i in [0, n), and Take() returns the records in ascending order of
+ * i. The caller replays the records on its own thread with
+ * AFLStateTemplate::ReplayExecutions, so that the state evolves exactly as if
+ * the executions were done one by one in that order. Only a window of jobs
+ * ahead of the next record to be taken is run, which bounds the memory held
+ * by records waiting to be taken.
+ */
+class AFLExecutorPool {
+ public:
+  using Job = std::function<void(std::size_t, ExecutionRecorder &)>;
+
+  // locked_cpus are the CPU cores locked by utils::LockVacantCpu for the
+  // executors, which are released by the destructor after the executors.
+  explicit AFLExecutorPool(
+      std::vector<std::shared_ptr<executor::AFLExecutorInterface>>
+          &&executors,
+      std::vector<int> &&locked_cpus = {});
+  ~AFLExecutorPool();
+
+  AFLExecutorPool(const AFLExecutorPool &) = delete;
+  AFLExecutorPool &operator=(const AFLExecutorPool &) = delete;
+
+  std::size_t Size() const { return executors.size(); }
+
+  void Start(std::size_t n, Job &&job);
+
+  // Waits for the record of the next job. Rethrows the exception if the job
+  // threw one. Must not be called more than n times after Start().
+  ExecutionRecord Take();
+
+  // Cancels the jobs not started yet and waits for the running ones. Called
+  // by Start() and the destructor too.
+  void Stop();
+
+  void ReceiveStopSignal();
+
+ private:
+  void Work(executor::AFLExecutorInterface &executor);
+
+  std::vector<std::shared_ptr<executor::AFLExecutorInterface>> executors;
+  std::vector<int> locked_cpus;
+  std::vector<std::thread> workers;
+
+  std::mutex mutex;
+  std::condition_variable job_taken;
+  std::condition_variable job_done;
+  Job job;
+  std::size_t job_count = 0;
+  std::size_t next_job = 0;
+  std::size_t next_record = 0;
+  bool stopping = false;
+  std::map<std::size_t, ExecutionRecord> records;
+  std::map<std::size_t, std::exception_ptr> errors;
+};
+
+}  // namespace fuzzuf::algorithm::afl
+
+#endif
@@ -0,0 +1,168 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file afl_favored_cover.hpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+
+#ifndef FUZZUF_INCLUDE_ALGORITHM_AFL_AFL_FAVORED_COVER_HPP
+#define FUZZUF_INCLUDE_ALGORITHM_AFL_AFL_FAVORED_COVER_HPP
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "fuzzuf/utils/common.hpp"
+
+namespace fuzzuf::algorithm::afl {
+
+/**
+ * @class FavoredCover
+ * @brief Keeps the favored flags of a queue equal to the result of AFL's
+ * greedy set cover in cull_queue(), without redoing it from scratch.
+ * @details cull_queue() walks the edges in ascending order and favors
+ * top_rated[i] whenever edge i is not yet covered by a testcase favored
+ * before. The decision made at edge i only depends on top_rated[0..i], so
+ * once top_rated changes at edges not below first_changed, the decisions
+ * made below first_changed stay as they are. Update() rolls back the
+ * decisions made at or above first_changed and redoes only those. The
+ * edges above first_changed are not scanned one by one: only the changed
+ * edges and the ones the rollback has chosen at or uncovered can decide
+ * differently, since the others are either without top_rated or still
+ * covered by a decision below first_changed.
+ */
+template <class Testcase>
+class FavoredCover {
+ public:
+  explicit FavoredCover(u32 map_size)
+      : map_size(map_size),
+        first_changed(map_size),
+        covered_by(map_size, UNCOVERED) {}
+
+  // Called whenever top_rated[edge] is (re)assigned
+  void MarkChanged(u32 edge) {
+    first_changed = std::min(first_changed, edge);
+    redo_edges.push_back(edge);
+  }
+
+  /**
+   * @brief Recomputes the favored flags after top_rated changed.
+   * @param top_rated The top_rated entries of the state.
+   * @param on_toggle Called once for each testcase whose favored flag has
+   * been flipped by this call, after all flags are settled.
+   */
+  template <class OnToggle>
+  void Update(const std::vector<utils::NullableRef<Testcase>> &top_rated,
+              OnToggle &&on_toggle) {
+    if (first_changed >= map_size) return;
+
+    // Testcases whose flags may change, with the flags before this call
+    std::vector<std::pair<Testcase *, bool>> touched;
+
+    while (!chosen.empty() && chosen.back().first >= first_changed) {
+      auto *testcase = chosen.back().second;
+      touched.emplace_back(testcase, testcase->favored);
+      if (--n_chosen[testcase] == 0) {
+        n_chosen.erase(testcase);
+        testcase->favored = false;
+      }
+      redo_edges.push_back(chosen.back().first);
+      chosen.pop_back();
+    }
+
+    while (!cover_log.empty() &&
+           covered_by[cover_log.back()] >= first_changed) {
+      u32 edge = cover_log.back();
+      covered_by[edge] = UNCOVERED;
+      if (edge >= first_changed) redo_edges.push_back(edge);
+      cover_log.pop_back();
+    }
+
+    std::sort(redo_edges.begin(), redo_edges.end());
+    redo_edges.erase(std::unique(redo_edges.begin(), redo_edges.end()),
+                     redo_edges.end());
+
+    for (u32 i : redo_edges) {
+      if (!top_rated[i] || covered_by[i] != UNCOVERED) continue;
+
+      auto &testcase = top_rated[i].value().get();
+      touched.emplace_back(&testcase, testcase.favored);
+
+      testcase.trace_mini->ForEach([this, i](u32 j) {
+        if (covered_by[j] != UNCOVERED) return;
+        covered_by[j] = i;
+        cover_log.push_back(j);
+      });
+
+      chosen.emplace_back(i, &testcase);
+      n_chosen[&testcase]++;
+      testcase.favored = true;
+    }
+
+    first_changed = map_size;
+    redo_edges.clear();
+
+    // Keep only the first record of each testcase, which has the flag
+    // before this call
+    std::stable_sort(
+        touched.begin(), touched.end(),
+        [](const auto &l, const auto &r) { return l.first < r.first; });
+    touched.erase(std::unique(touched.begin(), touched.end(),
+                              [](const auto &l, const auto &r) {
+                                return l.first == r.first;
+                              }),
+                  touched.end());
+
+    for (auto &[testcase, was_favored] : touched) {
+      if (testcase->favored != was_favored) on_toggle(*testcase);
+    }
+  }
+
+ private:
+  static constexpr u32 UNCOVERED = std::numeric_limits<u32>::max();
+
+  u32 map_size;
+
+  // The smallest edge whose top_rated changed since the last Update()
+  u32 first_changed;
+
+  // Edges to decide again in the next Update(). Filled by MarkChanged() and
+  // by the rollback, and may hold duplicates until sorted.
+  std::vector<u32> redo_edges;
+
+  // The edge whose decision covered each edge, or UNCOVERED
+  std::vector<u32> covered_by;
+
+  // Covered edges in the order they have been covered
+  std::vector<u32> cover_log;
+
+  // Favored testcases with the edges they have been chosen at, in ascending
+  // order of the edges
+  std::vector<std::pair<u32, Testcase *>> chosen;
+
+  // Number of occurrences of each testcase in chosen. A testcase can be
+  // chosen twice if it has won an edge outside of its trace_mini.
+  std::unordered_map<Testcase *, u32> n_chosen;
+};
+
+}  // namespace fuzzuf::algorithm::afl
+
+#endif  // FUZZUF_INCLUDE_ALGORITHM_AFL_AFL_FAVORED_COVER_HPP
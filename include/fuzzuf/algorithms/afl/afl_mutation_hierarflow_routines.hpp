@@ -17,12 +17,17 @@
  */
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "fuzzuf/algorithms/afl/afl_mutator.hpp"
 #include "fuzzuf/algorithms/afl/afl_state.hpp"
 #include "fuzzuf/algorithms/afl/afl_util.hpp"
+#include "fuzzuf/coverage/cmplog_attacher.hpp"
 #include "fuzzuf/exec_input/exec_input.hpp"
+#include "fuzzuf/executor/executor.hpp"
 #include "fuzzuf/hierarflow/hierarflow_intermediates.hpp"
 #include "fuzzuf/hierarflow/hierarflow_node.hpp"
 #include "fuzzuf/hierarflow/hierarflow_routine.hpp"
@@ -39,6 +44,99 @@ using AFLMutCalleeRef =
 
 using AFLMutOutputType = bool(const u8 *, u32);
 
+// Mutants made by a deterministic stage, which are executed together with
+// AFLStateTemplate::RunBatchWithClassifyCounts instead of one by one.
+// Add() copies a mutant along with the stage variables the successors refer
+// to (stage_cur, stage_cur_byte and so on), and Flush() puts those variables
+// back while passing each mutant to the successors. Thus the successors see
+// the same state as when the mutant was executed as soon as it was made.
+// The deterministic stages can make mutants ahead of their execution because
+// what they make depends only on the effector map, which is completed by
+// ByteFlip1WithEffMapBuild before the stages reading it start.
+template <class State>
+class DeterministicBatch {
+ public:
+  using Successors = std::function<bool(const u8 *, u32)>;
+
+  DeterministicBatch(State &state, Successors &&successors)
+      : state(state), successors(std::move(successors)) {}
+
+  // Both return true if the successors requested to abort the stage
+  bool Add(const u8 *buf, u32 len) {
+    mutants.emplace_back(Mutant{data.size(), len, state.stage_cur,
+                                state.stage_cur_byte, state.stage_cur_val,
+                                state.stage_val_type,
+                                state.ShouldConstructAutoDict()});
+    data.insert(data.end(), buf, buf + len);
+
+    if (mutants.size() < option::GetDetBatchSize(state) &&
+        data.size() < option::GetDetBatchBytes(state))
+      return false;
+    return Flush();
+  }
+
+  bool Flush() {
+    inputs.clear();
+    for (const auto &mutant : mutants) {
+      inputs.emplace_back(
+          executor::BatchInput{data.data() + mutant.offset, mutant.len});
+    }
+
+    // The stage goes on making mutants from where it was
+    s32 stage_cur = state.stage_cur;
+    s32 stage_cur_byte = state.stage_cur_byte;
+    s32 stage_cur_val = state.stage_cur_val;
+    option::StageVal stage_val_type = state.stage_val_type;
+    bool should_construct_auto_dict = state.ShouldConstructAutoDict();
+
+    bool aborted = false;
+    std::size_t done = 0;
+    while (!aborted && done < inputs.size()) {
+      const std::size_t head = done;
+      done += state.RunBatchWithClassifyCounts(
+          executor::BatchInputRange(inputs.data() + head,
+                                    inputs.data() + inputs.size()),
+          [this, head](std::size_t i) {
+            const auto &mutant = mutants[head + i];
+            state.stage_cur = mutant.stage_cur;
+            state.stage_cur_byte = mutant.stage_cur_byte;
+            state.stage_cur_val = mutant.stage_cur_val;
+            state.stage_val_type = mutant.stage_val_type;
+            state.SetShouldConstructAutoDict(mutant.should_construct_auto_dict);
+            return successors(inputs[head + i].buf, inputs[head + i].len);
+          },
+          aborted);
+    }
+
+    state.stage_cur = stage_cur;
+    state.stage_cur_byte = stage_cur_byte;
+    state.stage_cur_val = stage_cur_val;
+    state.stage_val_type = stage_val_type;
+    state.SetShouldConstructAutoDict(should_construct_auto_dict);
+
+    mutants.clear();
+    data.clear();
+    return aborted;
+  }
+
+ private:
+  struct Mutant {
+    std::size_t offset;
+    u32 len;
+    s32 stage_cur;
+    s32 stage_cur_byte;
+    s32 stage_cur_val;
+    option::StageVal stage_val_type;
+    bool should_construct_auto_dict;
+  };
+
+  State &state;
+  Successors successors;
+  std::vector<u8> data;
+  std::vector<Mutant> mutants;
+  std::vector<executor::BatchInput> inputs;
+};
+
 template <class State>
 struct BitFlip1WithAutoDictBuildTemplate
     : public hierarflow::HierarFlowRoutine<AFLMutInputType<State>,
@@ -141,6 +239,10 @@ bool ArithTemplate<State>::DoArith(AFLMutatorTemplate<State> &mutator) {
   state.stage_max =
       times_mut_per_unit * num_mutable_pos * option::GetArithMax<Tag>();
 
+  DeterministicBatch<State> batch(state, [this](const u8 *buf, u32 len) {
+    return this->CallSuccessors(buf, len);
+  });
+
   for (u32 i = 0; i < num_mutable_pos; i++) {
     const auto head = EFF_APOS<Tag>(i);
     const auto tail = EFF_APOS<Tag>(i + byte_width - 1);
@@ -159,19 +261,19 @@ bool ArithTemplate<State>::DoArith(AFLMutatorTemplate<State> &mutator) {
 
       if (mutator.template AddN<UInt>(i, j, false)) {
         state.stage_cur_val = j;
-        if (this->CallSuccessors(mutator.GetBuf(), mutator.GetLen()))
-          return true;
+        bool should_abort = batch.Add(mutator.GetBuf(), mutator.GetLen());
         state.stage_cur++;
         mutator.template RestoreOverwrite<UInt>();
+        if (should_abort) return true;
       } else
         state.stage_max--;
 
       if (mutator.template SubN<UInt>(i, j, false)) {
         state.stage_cur_val = -j;
-        if (this->CallSuccessors(mutator.GetBuf(), mutator.GetLen()))
-          return true;
+        bool should_abort = batch.Add(mutator.GetBuf(), mutator.GetLen());
         state.stage_cur++;
         mutator.template RestoreOverwrite<UInt>();
+        if (should_abort) return true;
       } else
         state.stage_max--;
 
@@ -182,24 +284,26 @@ bool ArithTemplate<State>::DoArith(AFLMutatorTemplate<State> &mutator) {
 
       if (mutator.template AddN<UInt>(i, j, true)) {
         state.stage_cur_val = j;
-        if (this->CallSuccessors(mutator.GetBuf(), mutator.GetLen()))
-          return true;
+        bool should_abort = batch.Add(mutator.GetBuf(), mutator.GetLen());
         state.stage_cur++;
         mutator.template RestoreOverwrite<UInt>();
+        if (should_abort) return true;
       } else
         state.stage_max--;
 
       if (mutator.template SubN<UInt>(i, j, true)) {
         state.stage_cur_val = -j;
-        if (this->CallSuccessors(mutator.GetBuf(), mutator.GetLen()))
-          return true;
+        bool should_abort = batch.Add(mutator.GetBuf(), mutator.GetLen());
         state.stage_cur++;
         mutator.template RestoreOverwrite<UInt>();
+        if (should_abort) return true;
       } else
         state.stage_max--;
     }
   }
 
+  if (batch.Flush()) return true;
+
   int stage_idx;
   if (byte_width == 1)
     stage_idx = option::STAGE_ARITH8;
@@ -269,6 +373,10 @@ bool InterestTemplate<State>::DoInterest(AFLMutatorTemplate<State> &mutator) {
   state.stage_cur = 0;
   state.stage_max = num_endians * num_mutable_pos * interest_values->size();
 
+  DeterministicBatch<State> batch(state, [this](const u8 *buf, u32 len) {
+    return this->CallSuccessors(buf, len);
+  });
+
   for (u32 i = 0; i < num_mutable_pos; i++) {
     /* Let's consult the effector map... */
 
@@ -290,11 +398,10 @@ bool InterestTemplate<State>::DoInterest(AFLMutatorTemplate<State> &mutator) {
       if (mutator.template InterestN<UInt>(i, j, false)) {
         state.stage_val_type = option::STAGE_VAL_LE;
 
-        if (this->CallSuccessors(mutator.GetBuf(), mutator.GetLen()))
-          return true;
-
+        bool should_abort = batch.Add(mutator.GetBuf(), mutator.GetLen());
         state.stage_cur++;
         mutator.template RestoreOverwrite<UInt>();
+        if (should_abort) return true;
       } else
         state.stage_max--;
 
@@ -303,16 +410,17 @@ bool InterestTemplate<State>::DoInterest(AFLMutatorTemplate<State> &mutator) {
       if (mutator.template InterestN<UInt>(i, j, true)) {
         state.stage_val_type = option::STAGE_VAL_BE;
 
-        if (this->CallSuccessors(mutator.GetBuf(), mutator.GetLen()))
-          return true;
-
+        bool should_abort = batch.Add(mutator.GetBuf(), mutator.GetLen());
         state.stage_cur++;
         mutator.template RestoreOverwrite<UInt>();
+        if (should_abort) return true;
       } else
         state.stage_max--;
     }
   }
 
+  if (batch.Flush()) return true;
+
   int stage_idx;
   if constexpr (byte_width == 1)
     stage_idx = option::STAGE_INTEREST8;
@@ -477,6 +585,51 @@ struct UserDictInsertTemplate
 
 using UserDictInsert = UserDictInsertTemplate<AFLState>;
 
+// Input-to-state stage of RedQueen, compatible with AFL++'s CmpLog.
+// First, bytes of the input that can be randomized without changing the
+// execution path are searched (colorization). Then, operands of comparisons
+// which are found in those bytes are replaced with the other operands.
+// This requires state.cmplog_executor and state.cmplog_map.
+template <class State>
+struct InputToStateTemplate
+    : public hierarflow::HierarFlowRoutine<AFLMutInputType<State>,
+                                           AFLMutOutputType> {
+ public:
+  InputToStateTemplate(State &state);
+
+  AFLMutCalleeRef<State> operator()(AFLMutatorTemplate<State> &mutator);
+
+ private:
+  bool RunCmpLog(const u8 *buf, u32 len);
+  void SaveOrigCmpMap(void);
+  bool Colorize(const u8 *buf, u32 len);
+  bool TryInsReplacement(const coverage::CmpHeader &header,
+                         const coverage::CmpOperands &ops,
+                         const coverage::CmpOperands &orig_ops, const u8 *buf,
+                         u32 len);
+  bool TryRtnReplacement(const coverage::CmpFnOperands &ops,
+                         const coverage::CmpFnOperands &orig_ops,
+                         const u8 *buf, u32 len);
+  bool TryCandidate(u32 pos, const u8 *repl, u32 repl_len, const u8 *buf,
+                    u32 len);
+
+  State &state;
+
+  // The input whose bytes in taint are randomized
+  std::vector<u8> colored;
+  // Ranges [first, second) of the input which don't affect the execution path
+  std::vector<std::pair<u32, u32>> taint;
+  std::vector<u8> work_buf;
+
+  // Comparisons logged with the original input. Only the rows of keys which
+  // are hit are copied, since the whole map is 64MiB.
+  std::vector<coverage::CmpHeader> orig_headers;
+  std::vector<u32> orig_rows;
+  std::vector<coverage::CmpOperands> orig_log;
+};
+
+using InputToState = InputToStateTemplate<AFLState>;
+
 template <class State>
 struct HavocBaseTemplate
     : public hierarflow::HierarFlowRoutine<AFLMutInputType<State>,
@@ -52,7 +52,8 @@ enum StageIndex {
   STAGE_EXTRAS_UI = 13,
   STAGE_EXTRAS_AO = 14,
   STAGE_HAVOC = 15,
-  STAGE_SPLICE = 16
+  STAGE_SPLICE = 16,
+  STAGE_ITS = 17
 };
 
 // The following constants are provided as constexpr getters.
@@ -248,6 +249,19 @@ constexpr const char* GetDefaultOutfile(void) {
   return ".cur_input";
 }
 
+/* Checkpoint of the fuzzer state, written into out_dir for resuming: */
+template <class Tag>
+constexpr const char* GetCheckpointFile(void) {
+  return "checkpoint";
+}
+
+/* Algorithm name recorded in checkpoints. A fuzzer refuses to resume from a
+   checkpoint with another name, so each derived Tag has its own: */
+template <class Tag>
+constexpr const char* GetCheckpointAlgorithm(void) {
+  return "afl";
+}
+
 template <class State>
 constexpr const char* GetClangEnvVar(State&) {
   return "__AFL_CLANG_MODE";
@@ -318,6 +332,13 @@ constexpr u32 GetMaxFile(void) {
   return 1 * 1024 * 1024;
 }
 
+/* The same, for the input-to-state stage. Colorization takes up to twice as
+   many execs as the input has bytes: */
+template <class State>
+constexpr u32 GetCmpLogMaxFile(State&) {
+  return 64 * 1024;
+}
+
 /* The same, for the test case minimizer: */
 template <class State>
 constexpr u32 GetTminMaxFile(State&) {
@@ -398,6 +419,18 @@ constexpr u32 GetEffMaxPerc(State&) {
   return 90;
 }
 
+/* Maximum number of mutants, and their total size in bytes, which are
+   executed at once in deterministic stages: */
+template <class State>
+constexpr u32 GetDetBatchSize(State&) {
+  return 64;
+}
+
+template <class State>
+constexpr u32 GetDetBatchBytes(State&) {
+  return 1024 * 1024;
+}
+
 /* UI refresh frequency (Hz): */
 template <class State>
 constexpr u32 GetUiTargetHz(State&) {
@@ -415,6 +448,12 @@ constexpr u32 GetPlotUpdateSec(void) {
   return 60;
 }
 
+/* Checkpoint update interval (sec), see AFLStateTemplate::WriteCheckpoint: */
+template <class Tag>
+constexpr u32 GetCheckpointUpdateSec(void) {
+  return 300;
+}
+
 /* Smoothing divisor for CPU load and exec speed stats (1 - no smoothing). */
 template <class State>
 constexpr u32 GetAvgSmoothing(State&) {
@@ -438,6 +477,12 @@ constexpr u32 GetTrimEndSteps(State&) {
   return 1024;
 }
 
+/* Number of trimming candidates executed at once: */
+template <class State>
+constexpr u32 GetTrimBatchSize(State&) {
+  return 16;
+}
+
 template <class State>
 constexpr std::uint32_t GetSyncInterval(State&) {
   return 30u * 60u;
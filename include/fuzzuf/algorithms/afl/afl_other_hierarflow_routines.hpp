@@ -21,6 +21,7 @@
 
 #include "fuzzuf/algorithms/afl/afl_mutator.hpp"
 #include "fuzzuf/algorithms/afl/afl_state.hpp"
+#include "fuzzuf/algorithms/afl/afl_trim_engine.hpp"
 #include "fuzzuf/feedback/exit_status_feedback.hpp"
 #include "fuzzuf/feedback/inplace_memory_feedback.hpp"
 #include "fuzzuf/hierarflow/hierarflow_intermediates.hpp"
@@ -150,6 +151,24 @@ struct CalcScoreTemplate
 
 using CalcScore = CalcScoreTemplate<AFLState>;
 
+template <class State>
+struct ApplyInputToStateTemplate
+    : public hierarflow::HierarFlowRoutine<AFLMidInputType<State>,
+                                           AFLMidOutputType<State>> {
+ public:
+  ApplyInputToStateTemplate(State &state,
+                            AFLMidCalleeRef<State> abandon_entry);
+
+  AFLMidCalleeRef<State> operator()(
+      std::shared_ptr<typename State::OwnTestcase>);
+
+ private:
+  State &state;
+  AFLMidCalleeRef<State> abandon_entry;
+};
+
+using ApplyInputToState = ApplyInputToStateTemplate<AFLState>;
+
 template <class State>
 struct ApplyDetMutsTemplate
     : public hierarflow::HierarFlowRoutine<AFLMidInputType<State>,
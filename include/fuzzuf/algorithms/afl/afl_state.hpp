@@ -19,20 +19,26 @@
 #ifndef FUZZUF_INCLUDE_ALGORITHMS_AFL_AFL_STATE_HPP
 #define FUZZUF_INCLUDE_ALGORITHMS_AFL_AFL_STATE_HPP
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "fuzzuf/algorithms/afl/afl_dict_data.hpp"
+#include "fuzzuf/algorithms/afl/afl_executor_pool.hpp"
+#include "fuzzuf/algorithms/afl/afl_favored_cover.hpp"
 #include "fuzzuf/algorithms/afl/afl_macro.hpp"
 #include "fuzzuf/algorithms/afl/afl_option.hpp"
 #include "fuzzuf/algorithms/afl/afl_setting.hpp"
 #include "fuzzuf/algorithms/afl/afl_testcase.hpp"
+#include "fuzzuf/coverage/cmplog_attacher.hpp"
 #include "fuzzuf/exec_input/exec_input_set.hpp"
 #include "fuzzuf/executor/afl_executor_interface.hpp"
 #include "fuzzuf/feedback/exit_status_feedback.hpp"
 #include "fuzzuf/feedback/inplace_memory_feedback.hpp"
 #include "fuzzuf/optimizer/havoc_optimizer.hpp"
+#include "fuzzuf/utils/async_writer.hpp"
+#include "fuzzuf/utils/checkpoint.hpp"
 #include "fuzzuf/utils/common.hpp"
 #include "fuzzuf/utils/filesystem.hpp"
 
@@ -71,6 +77,29 @@ struct AFLStateTemplate {
       const u8 *buf, u32 len, feedback::ExitStatusFeedback &exit_status,
       u32 tmout = 0);
 
+  // While record is not null, RunExecutorWithClassifyCounts returns the
+  // executions in record one by one instead of running the executor, and
+  // GetExecutionClockUs advances by their execution time.
+  void ReplayExecutions(const ExecutionRecord *record);
+  u64 GetExecutionClockUs(void) const;
+
+  // Executes inputs with a single RunBatch call of the executor, and calls
+  // callback(i) each time the input i has been executed. The first
+  // RunExecutorWithClassifyCounts called in the callback returns the feedback
+  // of that execution instead of running the PUT again. If the callback runs
+  // the PUT by itself, e.g. to calibrate a new queue entry, the rest of the
+  // batch is left unexecuted, since the executor no longer holds the input
+  // file it prepared for the batch. Returns the number of inputs the callback
+  // was called for. aborted is set if the callback returned true.
+  std::size_t RunBatchWithClassifyCounts(
+      executor::BatchInputRange inputs,
+      const std::function<bool(std::size_t)> &callback, bool &aborted);
+
+  // Does the executions CalibrateCaseWithFeedDestroyed will do for a new
+  // testcase, so that the calibration can be replayed from the record.
+  void RecordCalibration(ExecutionRecorder &recorder, const u8 *buf, u32 len,
+                         bool from_queue) const;
+
   feedback::PUTExitReasonType CalibrateCaseWithFeedDestroyed(
       Testcase &testcase, const u8 *buf, u32 len,
       feedback::InplaceMemoryFeedback &inp_feed,
@@ -88,6 +117,20 @@ struct AFLStateTemplate {
 
   void UpdateBitmapScore(Testcase &testcase,
                          const feedback::InplaceMemoryFeedback &inp_feed);
+
+  // Makes testcase the top_rated entry of each edge hit in trace_bits for
+  // which is_better(top_rated[edge]) returns true, or which has no entry.
+  template <class IsBetter>
+  void UpdateTopRated(Testcase &testcase, const u8 *trace_bits, u32 map_size,
+                      IsBetter &&is_better);
+
+  // Brings the favored flags, queued_favored and pending_favored up to date
+  // with top_rated, as cull_queue() does.
+  void UpdateFavored(void);
+
+  // Called when tc_ref or favored of testcase has changed, so that derived
+  // states can keep what they compute from them up to date.
+  virtual void OnTestcaseChanged(Testcase &testcase);
   
   void ComputeMathCache();
   void ReloadCentralityFile();
@@ -107,6 +150,11 @@ struct AFLStateTemplate {
   void MarkAsVariable(Testcase &testcase);
   void MarkAsRedundant(Testcase &testcase, bool val);
 
+  // Runs job, which writes to the queue directory, on queue_writer if any.
+  // FlushQueue waits until all the jobs and queue entries are written.
+  void PostQueueJob(utils::AsyncWriter::Job &&job);
+  void FlushQueue(void);
+
   void WriteStatsFile(double bitmap_cvg, double stability, double eps);
   void SaveAuto(void);
   void WriteBitmap(void);
@@ -120,6 +168,17 @@ struct AFLStateTemplate {
   void PerformDryRun(void);
   virtual void ShowStats(void);
 
+  // Checkpoints let a fuzzer started with "-i -" resume from out_dir without
+  // reading and calibrating the queue again.
+  void WriteCheckpoint(bool in_background);
+  void MaybeWriteCheckpoint(void);
+  void LoadCheckpoint(void);
+
+  // Derived states save and restore their own members through these. They
+  // are called after the members of this class have been saved or restored.
+  virtual void SaveCheckpointExtension(utils::CheckpointWriter &writer) const;
+  virtual void LoadCheckpointExtension(utils::CheckpointReader &reader);
+
   void ReceiveStopSignal(void);
 
   bool ShouldConstructAutoDict(void);
@@ -132,6 +191,24 @@ struct AFLStateTemplate {
   std::shared_ptr<executor::AFLExecutorInterface> executor;
   exec_input::ExecInputSet input_set;
 
+  // these will be required in the input-to-state stage.
+  // cmplog_executor runs the PUT built with CmpLog, which writes comparison
+  // operands to cmplog_map. Both are null unless such a PUT is given.
+  std::shared_ptr<executor::AFLExecutorInterface> cmplog_executor;
+  std::shared_ptr<coverage::CmpLogAttacher> cmplog_map;
+
+  // Calibrates the initial seeds on several executors in parallel. Null if
+  // there is no executor other than the one above, or once the dry run ends.
+  std::unique_ptr<AFLExecutorPool> executor_pool;
+  const ExecutionRecord *replay_record = nullptr;
+  std::size_t replay_cursor = 0;
+  std::vector<u8> replay_trace;
+  u64 replay_clock_us = 0;
+
+  // Set while the input given to RunExecutorWithClassifyCounts has already
+  // been executed by RunBatchWithClassifyCounts
+  bool batch_executed = false;
+
   // TODO: what if this product works on environments other than *NIX?
   int rand_fd = -1;
 
@@ -170,6 +247,15 @@ struct AFLStateTemplate {
   // FILE used in MaybeUpdatePlotFile
   FILE *plot_file;
 
+  // Writes fuzzer_stats, plot_data, fuzz_bitmap and auto extras in the
+  // background, so that they never block the fuzz loop
+  std::unique_ptr<utils::AsyncWriter> reporter;
+
+  // Writes the queue entries and their marker files behind the fuzz loop.
+  // Null if they are written synchronously.
+  std::unique_ptr<utils::AsyncWriter> queue_writer;
+  bool fsync_queue = false;
+
   // log each border edge weight
   FILE* edge_weight_file;
 
@@ -390,6 +476,10 @@ struct AFLStateTemplate {
   std::vector<utils::NullableRef<Testcase>> top_rated =
       std::vector<utils::NullableRef<Testcase>>(option::GetMapSize<Tag>());
 
+  /* Favored set derived from top_rated */
+  FavoredCover<Testcase> favored_cover =
+      FavoredCover<Testcase>(option::GetMapSize<Tag>());
+
   using AFLDictData = afl::dictionary::AFLDictData;
   /* Extra tokens to fuzz with        */
   std::vector<AFLDictData> extras;
@@ -404,6 +494,18 @@ struct AFLStateTemplate {
   bool enable_sequential_id = false;
  private:
   bool should_construct_auto_dict;
+
+  u64 last_checkpoint_ms = 0;        /* Time of the last checkpoint (ms) */
+  pid_t checkpoint_writer = -1;      /* Process writing a checkpoint     */
+
+  static constexpr u32 CHECKPOINT_VERSION = 2;
+
+  // Calls visit with each scalar member saved in checkpoints
+  template <class Visitor>
+  void VisitCheckpointCounters(Visitor &&visit);
+
+  std::vector<u32> hit_edges;        /* Scratch space of UpdateTopRated  */
+  std::size_t culled_queue_size = 0; /* Entries seen by UpdateFavored    */
 };
 
 using AFLState = AFLStateTemplate<AFLTestcase>;
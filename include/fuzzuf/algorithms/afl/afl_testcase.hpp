@@ -17,11 +17,11 @@
  */
 #pragma once
 
-#include <bitset>
 #include <memory>
 
 #include "fuzzuf/algorithms/afl/afl_option.hpp"
 #include "fuzzuf/exec_input/on_disk_exec_input.hpp"
+#include "fuzzuf/utils/compact_bitmap.hpp"
 
 namespace fuzzuf::algorithm::afl {
 
@@ -59,7 +59,7 @@ struct AFLTestcase {
   u64 depth = 0;    /* Path depth                       */
 
   /* Trace bytes, if kept             */
-  std::unique_ptr<std::bitset<option::GetMapSize<Tag>()>> trace_mini;
+  std::unique_ptr<utils::CompactBitmap> trace_mini;
 
   u32 tc_ref = 0; /* Trace bytes ref count            */
   std::vector< u32 > border_edge;  /* list of border_edge IDX */
@@ -0,0 +1,113 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file afl_trim_engine.hpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+
+#ifndef FUZZUF_INCLUDE_ALGORITHM_AFL_AFL_TRIM_ENGINE_HPP
+#define FUZZUF_INCLUDE_ALGORITHM_AFL_AFL_TRIM_ENGINE_HPP
+
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "fuzzuf/executor/executor.hpp"
+#include "fuzzuf/utils/common.hpp"
+
+namespace fuzzuf::algorithm::afl {
+
+/**
+ * @class AFLTrimEngine
+ * @brief Removes chunks of a testcase as long as the trace checksum stays the
+ * same, in the way of the AFL trimmer.
+ * @details Like AFL, the chunk length starts from 1/start_steps of the input
+ * and is halved pass by pass down to 1/end_steps, never below min_bytes.
+ * On top of that:
+ *  - After a chunk is removed, a chunk twice as long is tried at the same
+ *    position, so that a long removable region costs a logarithmic number of
+ *    executions rather than a linear one.
+ *  - The checksum of each candidate is cached by the hash of its content, so
+ *    that a candidate identical to an already tested one, which is common in
+ *    inputs with repeated bytes, is not executed again.
+ *  - The candidates following the current one are made in advance assuming
+ *    the current one is rejected, and executed with a single Runner call.
+ *    The rest of them are thrown away as soon as one is accepted.
+ */
+class AFLTrimEngine {
+ public:
+  // Called with the index of each executed input in the batch and the
+  // checksum of its trace. Returning true stops the batch.
+  using OnExecuted = std::function<bool(std::size_t, u32)>;
+
+  // Executes inputs in order and calls on_executed for each, until it
+  // returns true. Returns false if the trimming must be given up, e.g. when
+  // the fuzzer is stopping.
+  using Runner = std::function<bool(executor::BatchInputRange inputs,
+                                    const OnExecuted &on_executed)>;
+
+  // Called at the start of each pass with the chunk length and the number of
+  // chunks
+  using OnPass = std::function<void(u32, u32)>;
+
+  AFLTrimEngine(const u8 *buf, u32 len, u32 exec_cksum, u32 min_bytes,
+                u32 start_steps, u32 end_steps, u32 batch_size);
+
+  // Returns false if runner gave up. What was removed until then is kept.
+  bool Run(const Runner &runner, const OnPass &on_pass);
+
+  const std::vector<u8> &GetInput() const { return input; }
+  bool IsTrimmed() const { return trimmed; }
+  u64 GetCacheHits() const { return cache_hits; }
+
+ private:
+  struct Candidate {
+    u32 pos;
+    u32 len;
+    u64 hash;
+    bool cached;  // Not executed, since its checksum is or will be cached
+  };
+
+  void UpdateEndLen();
+  u64 HashWithGap(u32 pos, u32 len) const;
+
+  // Applies the result of the candidate. Returns true if it was accepted
+  bool Consume(const Candidate &candidate, u32 cksum);
+
+  std::vector<u8> input;
+  u32 exec_cksum;
+  u32 min_bytes;
+  u32 end_steps;
+  u32 batch_size;
+
+  u32 max_chunk;
+  u32 remove_len;
+  u32 end_len;
+  u32 remove_pos = 0;
+  u32 chunk = 0;
+  bool trimmed = false;
+
+  std::unordered_map<u64, u32> cache;
+  u64 cache_hits = 0;
+};
+
+}  // namespace fuzzuf::algorithm::afl
+
+#endif
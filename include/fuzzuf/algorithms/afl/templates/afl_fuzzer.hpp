@@ -32,13 +32,19 @@ AFLFuzzerTemplate<State>::AFLFuzzerTemplate(std::unique_ptr<State>&& state_ref)
   state->FixUpBanner(state->setting->argv[0]);
   state->CheckIfTty();
 
-  state->ReadTestcases();
-  state->PivotInputs();
-  state->PerformDryRun();
+  if (state->in_place_resume) {
+    state->LoadCheckpoint();
+  } else {
+    state->ReadTestcases();
+    state->PivotInputs();
+    state->PerformDryRun();
+  }
 }
 
 template <class State>
-AFLFuzzerTemplate<State>::~AFLFuzzerTemplate() {}
+AFLFuzzerTemplate<State>::~AFLFuzzerTemplate() {
+  state->WriteCheckpoint(false);
+}
 
 template <class State>
 hierarflow::HierarFlowNode<void(void), void(void)> BuildAFLFuzzLoop(
@@ -64,12 +70,15 @@ hierarflow::HierarFlowNode<void(void), void(void)> BuildAFLFuzzLoop(
       CreateNode<RetryCalibrateTemplate<State>>(state, *abandon_node);
   auto trim_case = CreateNode<TrimCaseTemplate<State>>(state, *abandon_node);
   auto calc_score = CreateNode<CalcScoreTemplate<State>>(state, *abandon_node);
+  auto apply_input_to_state =
+      CreateNode<ApplyInputToStateTemplate<State>>(state, *abandon_node);
   auto apply_det_muts =
       CreateNode<ApplyDetMutsTemplate<State>>(state, *abandon_node);
   auto apply_rand_muts =
       CreateNode<ApplyRandMutsTemplate<State>>(state, *abandon_node);
 
   // actual mutations
+  auto input_to_state = CreateNode<InputToStateTemplate<State>>(state);
   auto bit_flip1 = CreateNode<BitFlip1WithAutoDictBuildTemplate<State>>(state);
   auto bit_flip_other = CreateNode<BitFlipOtherTemplate<State>>(state);
   auto byte_flip1 = CreateNode<ByteFlip1WithEffMapBuildTemplate<State>>(state);
@@ -97,6 +106,8 @@ hierarflow::HierarFlowNode<void(void), void(void)> BuildAFLFuzzLoop(
 
   select_seed << (consider_skip_mut || retry_calibrate || trim_case ||
                   calc_score ||
+                  apply_input_to_state << input_to_state << execute.HardLink()
+                                       << normal_update.HardLink() ||
                   apply_det_muts
                       << (bit_flip1 << execute
                                     << (normal_update || construct_auto_dict) ||
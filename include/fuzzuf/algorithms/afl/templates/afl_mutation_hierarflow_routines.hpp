@@ -17,6 +17,8 @@
  */
 #pragma once
 
+#include <algorithm>
+
 #include "fuzzuf/algorithms/afl/afl_mutator.hpp"
 #include "fuzzuf/algorithms/afl/afl_util.hpp"
 #include "fuzzuf/exec_input/exec_input.hpp"
@@ -52,6 +54,10 @@ AFLMutCalleeRef<State> BitFlip1WithAutoDictBuildTemplate<State>::operator()(
   state.a_collect.clear();
   state.SetShouldConstructAutoDict(false);
 
+  DeterministicBatch<State> batch(state, [this](const u8 *buf, u32 len) {
+    return this->CallSuccessors(buf, len);
+  });
+
   for (state.stage_cur = 0; state.stage_cur < state.stage_max;
        state.stage_cur++) {
     state.stage_cur_byte = state.stage_cur >> 3;
@@ -65,11 +71,17 @@ AFLMutCalleeRef<State> BitFlip1WithAutoDictBuildTemplate<State>::operator()(
     }
 
     mutator.FlipBit(state.stage_cur, 1);
-    if (this->CallSuccessors(mutator.GetBuf(), mutator.GetLen())) {
+    bool should_abort = batch.Add(mutator.GetBuf(), mutator.GetLen());
+    mutator.FlipBit(state.stage_cur, 1);
+    if (should_abort) {
       this->SetResponseValue(true);
       return this->GoToParent();
     }
-    mutator.FlipBit(state.stage_cur, 1);
+  }
+
+  if (batch.Flush()) {
+    this->SetResponseValue(true);
+    return this->GoToParent();
   }
 
   u64 new_hit_cnt = state.queued_paths + state.unique_crashes;
@@ -93,6 +105,10 @@ AFLMutCalleeRef<State> BitFlipOtherTemplate<State>::operator()(
 
   int stage_idxs[] = {option::STAGE_FLIP2, option::STAGE_FLIP4};
 
+  DeterministicBatch<State> batch(state, [this](const u8 *buf, u32 len) {
+    return this->CallSuccessors(buf, len);
+  });
+
   for (u32 bit_width = 2, idx = 0; bit_width <= 4; bit_width *= 2, idx++) {
     u64 orig_hit_cnt = state.queued_paths + state.unique_crashes;
 
@@ -105,11 +121,17 @@ AFLMutCalleeRef<State> BitFlipOtherTemplate<State>::operator()(
       state.stage_cur_byte = state.stage_cur >> 3;
 
       mutator.FlipBit(state.stage_cur, bit_width);
-      if (this->CallSuccessors(mutator.GetBuf(), mutator.GetLen())) {
+      bool should_abort = batch.Add(mutator.GetBuf(), mutator.GetLen());
+      mutator.FlipBit(state.stage_cur, bit_width);
+      if (should_abort) {
         this->SetResponseValue(true);
         return this->GoToParent();
       }
-      mutator.FlipBit(state.stage_cur, bit_width);
+    }
+
+    if (batch.Flush()) {
+      this->SetResponseValue(true);
+      return this->GoToParent();
     }
 
     u64 new_hit_cnt = state.queued_paths + state.unique_crashes;
@@ -152,19 +174,29 @@ AFLMutCalleeRef<State> ByteFlip1WithEffMapBuildTemplate<State>::operator()(
   state.stage_cur = 0;
   state.stage_max = num_mutable_pos;
 
+  DeterministicBatch<State> batch(state, [this](const u8 *buf, u32 len) {
+    return this->CallSuccessors(buf, len);
+  });
+
   for (u32 i = 0; i < num_mutable_pos; i++) {
     state.stage_cur_byte = i;
 
     mutator.FlipByte(state.stage_cur, 1);
-    if (this->CallSuccessors(mutator.GetBuf(), mutator.GetLen())) {
+    bool should_abort = batch.Add(mutator.GetBuf(), mutator.GetLen());
+    mutator.FlipByte(state.stage_cur, 1);
+    if (should_abort) {
       this->SetResponseValue(true);
       return this->GoToParent();
     }
-    mutator.FlipByte(state.stage_cur, 1);
 
     state.stage_cur++;
   }
 
+  if (batch.Flush()) {
+    this->SetResponseValue(true);
+    return this->GoToParent();
+  }
+
   if (state.eff_cnt != EFF_ALEN<Tag>(mutator.GetLen()) &&
       state.eff_cnt * 100 / EFF_ALEN<Tag>(mutator.GetLen()) >
           option::GetEffMaxPerc(state)) {
@@ -199,6 +231,10 @@ AFLMutCalleeRef<State> ByteFlipOtherTemplate<State>::operator()(
 
   int stage_idxs[] = {option::STAGE_FLIP16, option::STAGE_FLIP32};
 
+  DeterministicBatch<State> batch(state, [this](const u8 *buf, u32 len) {
+    return this->CallSuccessors(buf, len);
+  });
+
   for (u32 byte_width = 2, idx = 0; byte_width <= 4; byte_width *= 2, idx++) {
     // if the input is too short, then it's impossible
     if (mutator.GetLen() < byte_width) return this->GoToDefaultNext();
@@ -225,15 +261,21 @@ AFLMutCalleeRef<State> ByteFlipOtherTemplate<State>::operator()(
       state.stage_cur_byte = i;
 
       mutator.FlipByte(i, byte_width);
-      if (this->CallSuccessors(mutator.GetBuf(), mutator.GetLen())) {
+      bool should_abort = batch.Add(mutator.GetBuf(), mutator.GetLen());
+      mutator.FlipByte(i, byte_width);
+      if (should_abort) {
         this->SetResponseValue(true);
         return this->GoToParent();
       }
-      mutator.FlipByte(i, byte_width);
 
       state.stage_cur++;
     }
 
+    if (batch.Flush()) {
+      this->SetResponseValue(true);
+      return this->GoToParent();
+    }
+
     u64 new_hit_cnt = state.queued_paths + state.unique_crashes;
     state.stage_finds[stage_idxs[idx]] += new_hit_cnt - orig_hit_cnt;
     state.stage_cycles[stage_idxs[idx]] += state.stage_max;
@@ -328,6 +370,9 @@ AFLMutCalleeRef<State> UserDictInsertTemplate<State>::operator()(
 
   std::unique_ptr<u8[]> ex_tmp(
       new u8[mutator.GetLen() + option::GetMaxDictFile(state)]);
+  DeterministicBatch<State> batch(state, [this](const u8 *buf, u32 len) {
+    return this->CallSuccessors(buf, len);
+  });
   for (u32 i = 0; i <= mutator.GetLen(); i++) {
     state.stage_cur_byte = i;
 
@@ -351,8 +396,8 @@ AFLMutCalleeRef<State> UserDictInsertTemplate<State>::operator()(
       std::memcpy(ex_tmp.get() + i + state.extras[j].data.size(),
                   mutator.GetBuf() + i, mutator.GetLen() - i);
 
-      if (this->CallSuccessors(
-              ex_tmp.get(), mutator.GetLen() + state.extras[j].data.size())) {
+      if (batch.Add(ex_tmp.get(),
+                    mutator.GetLen() + state.extras[j].data.size())) {
         this->SetResponseValue(true);
         return this->GoToParent();
       }
@@ -366,6 +411,11 @@ AFLMutCalleeRef<State> UserDictInsertTemplate<State>::operator()(
     }
   }
 
+  if (batch.Flush()) {
+    this->SetResponseValue(true);
+    return this->GoToParent();
+  }
+
   u64 new_hit_cnt = state.queued_paths + state.unique_crashes;
 
   state.stage_finds[option::STAGE_EXTRAS_UI] += new_hit_cnt - orig_hit_cnt;
@@ -374,6 +424,338 @@ AFLMutCalleeRef<State> UserDictInsertTemplate<State>::operator()(
   return this->GoToDefaultNext();
 }
 
+template <class State>
+InputToStateTemplate<State>::InputToStateTemplate(State &state)
+    : state(state) {}
+
+namespace detail {
+
+inline u64 LoadCmpOperand(const u8 *p, u32 width, bool big_endian) {
+  u64 val = 0;
+  for (u32 i = 0; i < width; i++) {
+    val |= (u64)p[big_endian ? width - 1 - i : i] << (8 * i);
+  }
+  return val;
+}
+
+inline void StoreCmpOperand(u8 *p, u32 width, bool big_endian, u64 val) {
+  for (u32 i = 0; i < width; i++) {
+    p[big_endian ? width - 1 - i : i] = (u8)(val >> (8 * i));
+  }
+}
+
+// Randomizes the byte while keeping its character class, so that the
+// colorized input is still likely to be parsed in the same way
+inline u8 ColorizeByte(u8 c, int rand_fd) {
+  using afl::util::UR;
+
+  if ('0' <= c && c <= '9') return '0' + (c - '0' + 1 + UR(9, rand_fd)) % 10;
+  if ('a' <= c && c <= 'z') return 'a' + (c - 'a' + 1 + UR(25, rand_fd)) % 26;
+  if ('A' <= c && c <= 'Z') return 'A' + (c - 'A' + 1 + UR(25, rand_fd)) % 26;
+  return c ^ (u8)(1 + UR(255, rand_fd));
+}
+
+}  // namespace detail
+
+// Executes the CmpLog build of the PUT, and returns false if it didn't exit
+// normally
+template <class State>
+bool InputToStateTemplate<State>::RunCmpLog(const u8 *buf, u32 len) {
+  state.cmplog_map->ResetHeaders();
+  state.cmplog_executor->Run(buf, len);
+  state.total_execs++;
+
+  auto exit_status = state.cmplog_executor->GetExitStatusFeedback();
+  return exit_status.exit_reason == feedback::PUTExitReasonType::FAULT_NONE;
+}
+
+template <class State>
+void InputToStateTemplate<State>::SaveOrigCmpMap(void) {
+  using coverage::CMP_MAP_H;
+  using coverage::CMP_MAP_W;
+
+  const auto *cmp_map = state.cmplog_map->GetCmpMap();
+
+  orig_headers.assign(cmp_map->headers, cmp_map->headers + CMP_MAP_W);
+  orig_rows.assign(CMP_MAP_W, 0);
+  orig_log.clear();
+  for (u32 key = 0; key < CMP_MAP_W; key++) {
+    if (!orig_headers[key].hits) continue;
+
+    orig_rows[key] = orig_log.size() / CMP_MAP_H;
+    orig_log.insert(orig_log.end(), cmp_map->log[key],
+                    cmp_map->log[key] + CMP_MAP_H);
+  }
+}
+
+// Splits the input into ranges until each range either keeps the execution
+// path when randomized, or is a single byte which doesn't. Returns true if the
+// fuzzer should stop.
+template <class State>
+bool InputToStateTemplate<State>::Colorize(const u8 *buf, u32 len) {
+  state.stage_name = "colorization";
+  state.stage_short = "colorization";
+  state.stage_cur = 0;
+  state.stage_max = len * 2;
+  state.stage_cur_byte = -1;
+
+  std::vector<u8> randomized(len);
+  for (u32 i = 0; i < len; i++) {
+    randomized[i] = detail::ColorizeByte(buf[i], state.rand_fd);
+  }
+
+  colored.assign(buf, buf + len);
+  taint.clear();
+
+  std::vector<std::pair<u32, u32>> ranges{{0, len}};
+  while (!ranges.empty()) {
+    auto [first, last] = ranges.back();
+    ranges.pop_back();
+
+    std::memcpy(&colored[first], &randomized[first], last - first);
+
+    feedback::ExitStatusFeedback exit_status;
+    u32 cksum;
+    {
+      auto inp_feed = state.RunExecutorWithClassifyCounts(colored.data(), len,
+                                                          exit_status);
+      cksum = inp_feed.CalcCksum32();
+    }
+    state.stage_cur++;
+
+    if (state.stop_soon) return true;
+
+    if (exit_status.exit_reason == feedback::PUTExitReasonType::FAULT_NONE &&
+        cksum == state.queue_cur_exec_cksum) {
+      taint.emplace_back(first, last);
+      continue;
+    }
+
+    std::memcpy(&colored[first], buf + first, last - first);
+    if (last - first > 1) {
+      u32 mid = first + (last - first) / 2;
+      ranges.emplace_back(mid, last);
+      ranges.emplace_back(first, mid);
+    }
+  }
+
+  return false;
+}
+
+// Executes the original input whose bytes at pos are replaced with repl
+template <class State>
+bool InputToStateTemplate<State>::TryCandidate(u32 pos, const u8 *repl,
+                                               u32 repl_len, const u8 *buf,
+                                               u32 len) {
+  std::memcpy(&work_buf[pos], repl, repl_len);
+  state.stage_cur_byte = pos;
+  bool should_abort = this->CallSuccessors(work_buf.data(), len);
+  std::memcpy(&work_buf[pos], buf + pos, repl_len);
+  return should_abort;
+}
+
+// Searches for the operands in the input, and replaces them with the other
+// operands. Each operand is looked for in little endian and big endian, and
+// also in narrower widths if the operand was zero-extended.
+template <class State>
+bool InputToStateTemplate<State>::TryInsReplacement(
+    const coverage::CmpHeader &header, const coverage::CmpOperands &ops,
+    const coverage::CmpOperands &orig_ops, const u8 *buf, u32 len) {
+  using coverage::CMP_ATTR_IS_FP;
+  using coverage::CMP_ATTR_IS_GREATER;
+  using coverage::CMP_ATTR_IS_LESSER;
+
+  const u32 size = header.shape + 1;
+  // 128-bit operands and floating point values are not supported for now
+  if (size > sizeof(u64) || (header.attribute & CMP_ATTR_IS_FP)) return false;
+  // The comparison is already satisfied
+  if (orig_ops.v0 == orig_ops.v1) return false;
+
+  for (int side = 0; side < 2; side++) {
+    const u64 pattern = side ? ops.v1 : ops.v0;
+    const u64 orig_pattern = side ? orig_ops.v1 : orig_ops.v0;
+    const u64 other = side ? ops.v0 : ops.v1;
+    const u64 orig_other = side ? orig_ops.v0 : orig_ops.v1;
+
+    // If both operands come from the input, we can't tell which value makes
+    // the comparison hold
+    if (other != orig_other) continue;
+
+    // For inequalities, try the values just beside the other operand too
+    u64 repls[3] = {orig_other, orig_other + 1, orig_other - 1};
+    const u32 repl_cnt =
+        header.attribute & (CMP_ATTR_IS_GREATER | CMP_ATTR_IS_LESSER) ? 3 : 1;
+
+    for (u32 width = sizeof(u64); width >= 1; width /= 2) {
+      if (width > size) continue;
+
+      const u64 mask = width == sizeof(u64) ? ~0ULL : (1ULL << (8 * width)) - 1;
+      if (width < size && ((pattern | orig_pattern | orig_other) & ~mask))
+        continue;
+
+      for (const auto &[first, last] : taint) {
+        for (u32 pos = first; pos < last && pos + width <= len; pos++) {
+          for (int big_endian = 0; big_endian < (width > 1 ? 2 : 1);
+               big_endian++) {
+            if (detail::LoadCmpOperand(&colored[pos], width, big_endian) !=
+                    (pattern & mask) ||
+                detail::LoadCmpOperand(buf + pos, width, big_endian) !=
+                    (orig_pattern & mask))
+              continue;
+
+            state.stage_val_type =
+                big_endian ? option::STAGE_VAL_BE : option::STAGE_VAL_LE;
+            for (u32 i = 0; i < repl_cnt; i++) {
+              u8 repl[sizeof(u64)];
+              detail::StoreCmpOperand(repl, width, big_endian, repls[i]);
+              if (TryCandidate(pos, repl, width, buf, len)) return true;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+// Same as TryInsReplacement, but for the byte strings passed to comparison
+// routines
+template <class State>
+bool InputToStateTemplate<State>::TryRtnReplacement(
+    const coverage::CmpFnOperands &ops, const coverage::CmpFnOperands &orig_ops,
+    const u8 *buf, u32 len) {
+  for (int side = 0; side < 2; side++) {
+    const u8 *pattern = side ? ops.v1 : ops.v0;
+    const u8 *orig_pattern = side ? orig_ops.v1 : orig_ops.v0;
+    const u8 *repl = side ? orig_ops.v0 : orig_ops.v1;
+    const u32 pattern_len =
+        std::min<u32>({side ? ops.v1_len : ops.v0_len,
+                       side ? orig_ops.v1_len : orig_ops.v0_len,
+                       sizeof(ops.v0)});
+    const u32 repl_len =
+        std::min<u32>(side ? orig_ops.v0_len : orig_ops.v1_len, sizeof(ops.v0));
+
+    if (pattern_len == 0 || repl_len == 0) continue;
+    if (pattern_len == repl_len && !std::memcmp(orig_pattern, repl, repl_len))
+      continue;
+
+    for (const auto &[first, last] : taint) {
+      for (u32 pos = first; pos < last && pos + pattern_len <= len; pos++) {
+        if (std::memcmp(&colored[pos], pattern, pattern_len) ||
+            std::memcmp(buf + pos, orig_pattern, pattern_len))
+          continue;
+
+        const u32 write_len = std::min(repl_len, len - pos);
+        state.stage_val_type = option::STAGE_VAL_NONE;
+        if (TryCandidate(pos, repl, write_len, buf, len)) return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+template <class State>
+AFLMutCalleeRef<State> InputToStateTemplate<State>::operator()(
+    AFLMutatorTemplate<State> &mutator) {
+  FUZZUF_ALGORITHM_AFL_ENTER_HIERARFLOW_NODE
+  /*****************************
+   * INPUT-TO-STATE (REDQUEEN) *
+   *****************************/
+
+  using coverage::CMP_MAP_H;
+  using coverage::CMP_MAP_RTN_H;
+  using coverage::CMP_MAP_W;
+  using coverage::CMP_TYPE_INS;
+  using coverage::CMP_TYPE_RTN;
+  using coverage::CmpFnOperands;
+
+  const u8 *buf = mutator.GetBuf();
+  const u32 len = mutator.GetLen();
+  if (len == 0) return this->GoToDefaultNext();
+
+  u64 orig_hit_cnt = state.queued_paths + state.unique_crashes;
+
+  // If the PUT doesn't exit normally, the log may be incomplete
+  if (!RunCmpLog(buf, len)) return this->GoToDefaultNext();
+  SaveOrigCmpMap();
+
+  if (Colorize(buf, len)) {
+    this->SetResponseValue(true);
+    return this->GoToParent();
+  }
+
+  if (taint.empty() || !RunCmpLog(colored.data(), len)) {
+    // Nothing could be colorized. Search the whole input for the operands
+    // which are logged with the original input.
+    colored.assign(buf, buf + len);
+    taint.assign(1, {0, len});
+    if (!RunCmpLog(buf, len)) return this->GoToDefaultNext();
+  }
+
+  state.stage_name = "input-to-state";
+  state.stage_short = "its";
+  state.stage_cur = 0;
+  state.stage_max = 0;
+
+  const auto *cmp_map = state.cmplog_map->GetCmpMap();
+  for (u32 key = 0; key < CMP_MAP_W; key++) {
+    state.stage_max += cmp_map->headers[key].hits ? 1 : 0;
+  }
+
+  work_buf.assign(buf, buf + len);
+
+  for (u32 key = 0; key < CMP_MAP_W; key++) {
+    const auto &header = cmp_map->headers[key];
+    const auto &orig_header = orig_headers[key];
+    if (!header.hits) continue;
+
+    state.stage_cur++;
+    if (!orig_header.hits || orig_header.type != header.type) continue;
+
+    const auto *orig_row = &orig_log[orig_rows[key] * CMP_MAP_H];
+    const u32 hits = std::min(header.hits, orig_header.hits);
+
+    if (header.type == CMP_TYPE_INS) {
+      const auto *row = cmp_map->log[key];
+      for (u32 i = 0; i < std::min(hits, CMP_MAP_H); i++) {
+        // Skip operands which are already tried
+        bool tried = false;
+        for (u32 j = 0; j < i && !tried; j++) {
+          tried = row[j].v0 == row[i].v0 && row[j].v1 == row[i].v1 &&
+                  orig_row[j].v0 == orig_row[i].v0 &&
+                  orig_row[j].v1 == orig_row[i].v1;
+        }
+        if (tried) continue;
+
+        if (TryInsReplacement(header, row[i], orig_row[i], buf, len)) {
+          this->SetResponseValue(true);
+          return this->GoToParent();
+        }
+      }
+    } else if (header.type == CMP_TYPE_RTN) {
+      const auto *row =
+          reinterpret_cast<const CmpFnOperands *>(cmp_map->log[key]);
+      const auto *orig_fn_row =
+          reinterpret_cast<const CmpFnOperands *>(orig_row);
+      for (u32 i = 0; i < std::min(hits, CMP_MAP_RTN_H); i++) {
+        if (TryRtnReplacement(row[i], orig_fn_row[i], buf, len)) {
+          this->SetResponseValue(true);
+          return this->GoToParent();
+        }
+      }
+    }
+  }
+
+  u64 new_hit_cnt = state.queued_paths + state.unique_crashes;
+
+  state.stage_finds[option::STAGE_ITS] += new_hit_cnt - orig_hit_cnt;
+  state.stage_cycles[option::STAGE_ITS] += state.stage_max;
+
+  return this->GoToDefaultNext();
+}
+
 template <class State>
 HavocBaseTemplate<State>::HavocBaseTemplate(State &state) : state(state) {}
 
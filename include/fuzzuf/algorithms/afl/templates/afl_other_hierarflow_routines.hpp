@@ -37,6 +37,10 @@ utils::NullableRef<hierarflow::HierarFlowCallee<void(void)>>
 CullQueueTemplate<State>::operator()(void) {
   FUZZUF_ALGORITHM_AFL_ENTER_HIERARFLOW_NODE
   using Tag = typename State::Tag;
+
+  // Every queue entry is settled here, so this is a consistent point to save
+  state.MaybeWriteCheckpoint();
+
   if constexpr ( !option::EnableKScheduler< Tag >() ) {
     if (state.setting->dumb_mode || !state.score_changed) {
       return this->GoToDefaultNext();
@@ -63,12 +67,10 @@ CullQueueTemplate<State>::operator()(void) {
   // arrary cnt
   int arr_cnt = 0;
 
-  std::bitset<option::GetMapSize<Tag>()> has_top_rated;
-
-  state.queued_favored = 0;
-  state.pending_favored = 0;
-  
   if constexpr ( option::EnableKScheduler<Tag>() ) {
+    state.queued_favored = 0;
+    state.pending_favored = 0;
+
     // check if there is a not_fuzzed seed
     bool found_not_fuzzed_seed = false;
     bool found_not_fuzzed2_seed = false;
@@ -154,30 +156,16 @@ CullQueueTemplate<State>::operator()(void) {
       fflush(state.edge_log_file);
       state.last_edge_log_time = fuzzuf::utils::GetCurTimeMs()/1000;
     }
-  }
-  else {
+
+    // KScheduler doesn't maintain top_rated, so no entry is favored
     for (const auto &testcase : state.case_queue) {
-      testcase->favored = false;
+      state.MarkAsRedundant(*testcase, !testcase->favored);
     }
   }
-  
-  for (u32 i = 0; i < option::GetMapSize<Tag>(); i++) {
-    if (state.top_rated[i] && !has_top_rated[i]) {
-      auto &top_testcase = state.top_rated[i].value().get();
-
-      has_top_rated |= *(top_testcase.trace_mini);
-
-      top_testcase.favored = true;
-      state.queued_favored++;
-
-      if (!top_testcase.WasFuzzed()) state.pending_favored++;
-    }
+  else {
+    state.UpdateFavored();
   }
 
-  for (const auto &testcase : state.case_queue) {
-    state.MarkAsRedundant(*testcase, !testcase->favored);
-  }
-  
   if constexpr ( option::EnableKScheduler< Tag >() ) {
     // get the testcase indexed by state.current_entry and start mutations
     auto &testcase = state.case_queue[state.current_entry];
@@ -393,7 +381,8 @@ TrimCaseTemplate<State>::TrimCaseTemplate(State &state,
 
 /* Trim all new test cases to save cycles when doing deterministic checks. The
    trimmer uses power-of-two increments somewhere between 1/16 and 1/1024 of
-   file size, to keep the stage short and sweet. */
+   file size, to keep the stage short and sweet. See AFLTrimEngine for how
+   the executions are saved. */
 
 template <class State>
 static feedback::PUTExitReasonType DoTrimCase(
@@ -408,110 +397,96 @@ static feedback::PUTExitReasonType DoTrimCase(
 
   state.bytes_trim_in += input.GetLen();
 
-  /* Select initial chunk len, starting with large steps. */
-  u32 len_p2 = fuzzuf::utils::NextP2(input.GetLen());
-
-  u32 remove_len = std::max(len_p2 / option::GetTrimStartSteps(state),
-                            option::GetTrimMinBytes(state));
-
-  /* Continue until the number of steps gets too high or the stepover
-     gets too small. */
-
-  // end_len is re-calculated everytime len_p2 is changed
-  u32 end_len = std::max(len_p2 / option::GetTrimEndSteps(state),
-                         option::GetTrimMinBytes(state));
+  AFLTrimEngine engine(input.GetBuf(), input.GetLen(), testcase.exec_cksum,
+                       option::GetTrimMinBytes(state),
+                       option::GetTrimStartSteps(state),
+                       option::GetTrimEndSteps(state),
+                       option::GetTrimBatchSize(state));
 
   feedback::PersistentMemoryFeedback pers_feed;
   u32 trim_exec = 0;
-  bool needs_write = false;
+  bool has_clean_trace = false;
   feedback::PUTExitReasonType fault = feedback::PUTExitReasonType::FAULT_NONE;
-  while (remove_len >= end_len) {
-    u32 remove_pos = remove_len;
 
+  auto on_pass = [&state](u32 remove_len, u32 steps) {
     state.stage_name = fuzzuf::utils::StrPrintf(
         "trim %s/%s", afl::util::DescribeInteger(remove_len).c_str(),
         afl::util::DescribeInteger(remove_len).c_str());
 
     state.stage_cur = 0;
-    state.stage_max = input.GetLen() / remove_len;
-
-    while (remove_pos < input.GetLen()) {
-      u32 trim_avail = std::min(remove_len, input.GetLen() - remove_pos);
-
-      // FIXME: we can't represent this in fuzzuf without preparing another buf
-      // write_with_gap(in_buf, q->len, remove_pos, trim_avail);
-
-      u32 test_len = input.GetLen() - trim_avail;
-      std::unique_ptr<u8[]> test_buf(new u8[test_len]);
-      u32 move_tail = input.GetLen() - remove_pos - trim_avail;
-
-      std::memcpy(test_buf.get(), input.GetBuf(), remove_pos);
-      std::memmove(test_buf.get() + remove_pos,
-                   input.GetBuf() + remove_pos + trim_avail, move_tail);
-
-      feedback::ExitStatusFeedback exit_status;
-
-      feedback::InplaceMemoryFeedback inp_feed =
-          state.RunExecutorWithClassifyCounts(test_buf.get(), test_len,
-                                              exit_status);
-      fault = exit_status.exit_reason;
-      state.trim_execs++;
-
-      if (state.stop_soon || fault == feedback::PUTExitReasonType::FAULT_ERROR)
-        goto abort_trimming;  // FIXME: goto
-
-      /* Note that we don't keep track of crashes or hangs here; maybe TODO? */
-
-      u32 cksum = inp_feed.CalcCksum32();
-
-      /* If the deletion had no impact on the trace, make it permanent. This
-         isn't perfect for variable-path inputs, but we're just making a
-         best-effort pass, so it's not a big deal if we end up with false
-         negatives every now and then. */
-
-      if (cksum == testcase.exec_cksum) {
-        input.OverwriteKeepingLoaded(std::move(test_buf), test_len);
-
-        len_p2 = fuzzuf::utils::NextP2(input.GetLen());
-        end_len = std::max(len_p2 / option::GetTrimEndSteps(state),
-                           option::GetTrimMinBytes(state));
-
-        /* Let's save a clean trace, which will be needed by
-           update_bitmap_score once we're done with the trimming stuff. */
-
-        if (!needs_write) {
-          needs_write = true;
-          pers_feed = inp_feed.ConvertToPersistent();
-        }
-      } else {
-        remove_pos += remove_len;
-      }
-
-      /* Since this can be slow, update the screen every now and then. */
-
-      if (trim_exec % state.stats_update_freq == 0) state.ShowStats();
-      trim_exec++;
-      state.stage_cur++;
+    state.stage_max = steps;
+  };
+
+  auto runner = [&](executor::BatchInputRange inputs,
+                    const AFLTrimEngine::OnExecuted &on_executed) {
+    bool gave_up = false;
+    bool stopped = false;
+    std::size_t done = 0;
+    while (!stopped && done < inputs.size()) {
+      const std::size_t head = done;
+      done += state.RunBatchWithClassifyCounts(
+          executor::BatchInputRange(inputs.begin() + head, inputs.end()),
+          [&](std::size_t i) {
+            const auto &test_input = inputs[head + i];
+            feedback::ExitStatusFeedback exit_status;
+
+            feedback::InplaceMemoryFeedback inp_feed =
+                state.RunExecutorWithClassifyCounts(
+                    test_input.buf, test_input.len, exit_status);
+            fault = exit_status.exit_reason;
+            state.trim_execs++;
+
+            if (state.stop_soon ||
+                fault == feedback::PUTExitReasonType::FAULT_ERROR) {
+              gave_up = true;
+              return true;
+            }
+
+            /* Note that we don't keep track of crashes or hangs here; maybe
+               TODO? */
+
+            u32 cksum = inp_feed.CalcCksum32();
+
+            /* Let's save a clean trace, which will be needed by
+               update_bitmap_score once we're done with the trimming stuff. */
+
+            if (cksum == testcase.exec_cksum && !has_clean_trace) {
+              has_clean_trace = true;
+              pers_feed = inp_feed.ConvertToPersistent();
+            }
+
+            /* Since this can be slow, update the screen every now and then. */
+
+            if (trim_exec % state.stats_update_freq == 0) state.ShowStats();
+            trim_exec++;
+            state.stage_cur++;
+
+            return on_executed(head + i, cksum);
+          },
+          stopped);
     }
+    return !gave_up;
+  };
 
-    remove_len >>= 1;
-  }
+  bool completed = engine.Run(runner, on_pass);
 
   /* If we have made changes to in_buf, we also need to update the on-disk
      version of the test case. */
 
-  if (needs_write) {
-    // already saved on disk by "input.OverwriteKeepingLoaded()"
+  if (engine.IsTrimmed()) {
+    const auto &trimmed = engine.GetInput();
+    input.OverwriteKeepingLoaded(trimmed.data(), trimmed.size());
 
     using Tag = typename State::Tag;
     if constexpr ( !option::EnableKScheduler<Tag>() ) {
-      state.UpdateBitmapScoreWithRawTrace(
-        testcase, pers_feed.mem.get(),
-        option::GetMapSize<typename State::Tag>());
+      if (completed && has_clean_trace) {
+        state.UpdateBitmapScoreWithRawTrace(
+          testcase, pers_feed.mem.get(),
+          option::GetMapSize<typename State::Tag>());
+      }
     }
   }
 
-abort_trimming:
   state.bytes_trim_out += input.GetLen();
   return fault;
 }
@@ -585,6 +560,43 @@ AFLMidCalleeRef<State> CalcScoreTemplate<State>::operator()(
   return this->GoToDefaultNext();
 }
 
+template <class State>
+ApplyInputToStateTemplate<State>::ApplyInputToStateTemplate(
+    State &state, AFLMidCalleeRef<State> abandon_entry)
+    : state(state), abandon_entry(abandon_entry) {}
+
+template <class State>
+AFLMidCalleeRef<State> ApplyInputToStateTemplate<State>::operator()(
+    std::shared_ptr<typename State::OwnTestcase> testcase) {
+  FUZZUF_ALGORITHM_AFL_ENTER_HIERARFLOW_NODE
+  /* Like AFL++ with -c, run the input-to-state stage once per entry, before
+     the deterministic stages, which AFL++ skips by default. */
+
+  if (!state.cmplog_executor || testcase->WasFuzzed()) {
+    return this->GoToDefaultNext();
+  }
+
+  testcase->input->LoadByMmap();  // no need to Unload
+  if (testcase->input->GetLen() > option::GetCmpLogMaxFile(state)) {
+    return this->GoToDefaultNext();
+  }
+
+  auto mutator = AFLMutatorTemplate<State>(*testcase->input, state);
+
+  state.stage_val_type = option::STAGE_VAL_NONE;
+
+  // colorization compares the execution path with this checksum
+  state.queue_cur_exec_cksum = testcase->exec_cksum;
+
+  auto should_abandon_entry = this->CallSuccessors(mutator);
+  if (should_abandon_entry) {
+    this->SetResponseValue(true);
+    return abandon_entry;
+  }
+
+  return this->GoToDefaultNext();
+}
+
 template <class State>
 ApplyDetMutsTemplate<State>::ApplyDetMutsTemplate(
     State &state, AFLMidCalleeRef<State> abandon_entry)
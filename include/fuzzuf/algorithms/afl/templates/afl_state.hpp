@@ -23,8 +23,12 @@
 #include <memory>
 #include <string>
 #include <vector>
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/types.h>
+#include <sys/wait.h>
+
+#include <unordered_map>
 
 #include "fuzzuf/algorithms/afl/afl_dict_data.hpp"
 #include "fuzzuf/algorithms/afl/afl_macro.hpp"
@@ -64,6 +68,17 @@ AFLStateTemplate<Testcase>::AFLStateTemplate(
       havoc_optimizer(std::move(_havoc_optimizer)),
       should_construct_auto_dict(false) {
 
+  reporter.reset(new utils::AsyncWriter());
+
+  /* Queue entries and their marker files are written behind the fuzz loop
+     unless AFL_QUEUE_SYNC is set. AFL_QUEUE_FSYNC makes every entry reach
+     the disk before it is considered written. */
+  if (!getenv("AFL_QUEUE_SYNC")) queue_writer.reset(new utils::AsyncWriter());
+  fsync_queue = getenv("AFL_QUEUE_FSYNC") != nullptr;
+
+  /* "-i -" resumes from the checkpoint left in out_dir, as afl-fuzz does. */
+  in_place_resume = setting->in_dir == "-";
+
   LoadCentralityFile();
 
   if (in_bitmap.empty())
@@ -75,13 +90,16 @@ AFLStateTemplate<Testcase>::AFLStateTemplate(
   /* Gnuplot output file. */
 
   auto plot_fn = setting->out_dir / "plot_data";
-  plot_file = fopen(plot_fn.c_str(), "w");
+  plot_file = fopen(plot_fn.c_str(), in_place_resume ? "a" : "w");
   if (!plot_file) ERROR("Unable to create '%s'", plot_fn.c_str());
 
-  fprintf(plot_file,
-          "# relative_time, cycles_done, cur_path, paths_total, "
-          "pending_total, pending_favs, map_size, unique_crashes, "
-          "unique_hangs, max_depth, execs_per_sec, total_execs, edges_found\n");
+  if (!in_place_resume) {
+    fprintf(plot_file,
+            "# relative_time, cycles_done, cur_path, paths_total, "
+            "pending_total, pending_favs, map_size, unique_crashes, "
+            "unique_hangs, max_depth, execs_per_sec, total_execs, "
+            "edges_found\n");
+  }
 
   if constexpr ( option::EnableKScheduler<Tag>() ) {
     {
@@ -109,6 +127,10 @@ AFLStateTemplate<Testcase>::~AFLStateTemplate() {
     rand_fd = -1;
   }
 
+  /* Let the reporter finish writing before its files are closed */
+  reporter.reset();
+  queue_writer.reset();
+
   fclose(plot_file);
   if constexpr ( option::EnableKScheduler<Tag>() ) {
     fclose(edge_weight_file); 
@@ -124,14 +146,34 @@ AFLStateTemplate<Testcase>::RunExecutorWithClassifyCounts(
     u32 tmout) {
   total_execs++;
 
-  if (tmout == 0) {
-    executor->Run(buf, len);
+  feedback::InplaceMemoryFeedback inp_feed;
+  if (batch_executed) {
+    batch_executed = false;
+
+    inp_feed = executor->GetAFLFeedback();
+    exit_status = executor->GetExitStatusFeedback();
+  } else if (replay_record &&
+             replay_cursor < replay_record->executions.size()) {
+    // The trace is copied since ClassifyCounts below modifies it, and the
+    // same trace may be replayed again
+    const auto &execution = replay_record->executions[replay_cursor++];
+    const auto &trace = replay_record->traces[execution.trace_id];
+    replay_trace.assign(trace.begin(), trace.end());
+    replay_clock_us += execution.exec_us;
+
+    inp_feed = feedback::InplaceMemoryFeedback(
+        replay_trace.data(), replay_trace.size(), nullptr);
+    exit_status = execution.exit_status;
   } else {
-    executor->Run(buf, len, tmout);
-  }
+    if (tmout == 0) {
+      executor->Run(buf, len);
+    } else {
+      executor->Run(buf, len, tmout);
+    }
 
-  auto inp_feed = executor->GetAFLFeedback();
-  exit_status = executor->GetExitStatusFeedback();
+    inp_feed = executor->GetAFLFeedback();
+    exit_status = executor->GetExitStatusFeedback();
+  }
 
   if constexpr (sizeof(size_t) == 8) {
     inp_feed.ModifyMemoryWithFunc([this](u8* trace_bits, u32 /* map_size */) {
@@ -172,6 +214,75 @@ AFLStateTemplate<Testcase>::RunExecutorWithClassifyCounts(
   return feedback::InplaceMemoryFeedback(std::move(inp_feed));
 }
 
+template <class Testcase>
+std::size_t AFLStateTemplate<Testcase>::RunBatchWithClassifyCounts(
+    executor::BatchInputRange inputs,
+    const std::function<bool(std::size_t)> &callback, bool &aborted) {
+  aborted = false;
+  std::size_t called = 0;
+  executor->RunBatch(inputs, [&](std::size_t i) {
+    u64 prev_total_execs = total_execs;
+    batch_executed = true;
+    aborted = callback(i);
+    batch_executed = false;
+    called = i + 1;
+    return aborted || total_execs != prev_total_execs + 1;
+  });
+  return called;
+}
+
+template <class Testcase>
+void AFLStateTemplate<Testcase>::ReplayExecutions(
+    const ExecutionRecord* record) {
+  replay_record = record;
+  replay_cursor = 0;
+}
+
+template <class Testcase>
+u64 AFLStateTemplate<Testcase>::GetExecutionClockUs(void) const {
+  if (replay_record) return replay_clock_us;
+  return fuzzuf::utils::GetCurTimeUs();
+}
+
+// This runs on the threads of executor_pool, so it must not modify the state.
+// The executions are done with the same timeout and in the same number as
+// CalibrateCaseWithFeedDestroyed does, except that the number is extended
+// whenever a trace differs from the first one, since whether the difference
+// is in bytes not yet in var_bytes is only known when it is replayed. Extra
+// executions are just left unreplayed.
+template <class Testcase>
+void AFLStateTemplate<Testcase>::RecordCalibration(ExecutionRecorder& recorder,
+                                                   const u8* buf, u32 len,
+                                                   bool from_queue) const {
+  u32 use_tmout;
+  if (!from_queue || resuming_fuzz) {
+    use_tmout = std::max(
+        setting->exec_timelimit_ms + option::GetCalTmoutAdd(*this),
+        setting->exec_timelimit_ms * option::GetCalTmoutPerc(*this) / 100);
+  } else {
+    use_tmout = setting->exec_timelimit_ms;
+  }
+
+  if constexpr (option::EnableKScheduler<Tag>()) {
+    // The execution to compute cnt_free_cksum
+    recorder.Run(buf, len, use_tmout);
+  }
+
+  u32 cycles = fast_cal ? 3 : option::GetCalCycles(*this);
+  u32 first_cksum = 0;
+  for (u32 i = 0; i < cycles; i++) {
+    const auto& execution = recorder.Run(buf, len, use_tmout);
+    if (execution.exit_status.exit_reason != crash_mode) break;
+
+    u32 cksum = recorder.GetCksum(execution);
+    if (i == 0) {
+      first_cksum = cksum;
+    } else if (cksum != first_cksum) {
+      cycles = option::GetCalCyclesLong(*this);
+    }
+  }
+}
+
 #if __GNUC__ < 8
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-but-set-parameter"
@@ -314,7 +425,7 @@ AFLStateTemplate<Testcase>::CalibrateCaseWithFeedDestroyed(
   }
 
   bool var_detected = false;
-  u64 start_us = fuzzuf::utils::GetCurTimeUs();
+  u64 start_us = GetExecutionClockUs();
   u64 stop_us;
   for (stage_cur = 0; stage_cur < stage_max; stage_cur++) {
     if (!first_run && stage_cur % stats_update_freq == 0) {
@@ -390,7 +501,7 @@ AFLStateTemplate<Testcase>::CalibrateCaseWithFeedDestroyed(
     }
   }
 
-  stop_us = fuzzuf::utils::GetCurTimeUs();
+  stop_us = GetExecutionClockUs();
 
   total_cal_us += stop_us - start_us;
   total_cal_cycles += stage_max;
@@ -472,7 +583,7 @@ std::shared_ptr<Testcase> AFLStateTemplate<Testcase>::AddToQueue(
     const std::string& fn, const u8* buf, u32 len, bool passed_det) {
   auto input = input_set.CreateOnDisk(fn);
   if (buf) {
-    input->OverwriteThenUnload(buf, len);
+    input->OverwriteInBackground(buf, len, queue_writer.get(), fsync_queue);
   }
 
   std::shared_ptr<Testcase> testcase(new Testcase(std::move(input)));
@@ -590,42 +701,86 @@ void AFLStateTemplate<Testcase>::UpdateBitmapScoreWithRawTrace(
   }
   else {
     u64 fav_factor = testcase.exec_us * testcase.input->GetLen();
- 
-    for (u32 i = 0; i < map_size; i++) {
-      if (trace_bits[i]) {
-        if (top_rated[i]) {
-          auto& top_testcase = top_rated[i].value().get();
-          u64 factor = top_testcase.exec_us * top_testcase.input->GetLen();
-          if (fav_factor > factor) continue;
- 
-          /* Looks like we're going to win. Decrease ref count for the
-             previous winner, discard its trace_bits[] if necessary. */
-          --top_testcase.tc_ref;
-          if (top_testcase.tc_ref == 0) {
-            top_testcase.trace_mini.reset();
-          }
-        }
- 
-        /* Insert ourselves as the new winner. */
- 
-        top_rated[i] = std::ref(testcase);
-        testcase.tc_ref++;
- 
-        if (!testcase.trace_mini) {
-          testcase.trace_mini.reset(new std::bitset<option::GetMapSize<Tag>()>());
- 
-          auto& trace_mini = *testcase.trace_mini;
-          for (u32 j = 0; j < count; j++) {
-            trace_mini[j] = trace_bits[j] != 0;
-          }
-        }
- 
-        score_changed = true;
+
+    UpdateTopRated(testcase, trace_bits, map_size,
+                   [fav_factor](const Testcase &top_testcase) {
+                     u64 factor =
+                         top_testcase.exec_us * top_testcase.input->GetLen();
+                     return fav_factor <= factor;
+                   });
+  }
+}
+
+template <class Testcase>
+template <class IsBetter>
+void AFLStateTemplate<Testcase>::UpdateTopRated(Testcase &testcase,
+                                                const u8 *trace_bits,
+                                                u32 map_size,
+                                                IsBetter &&is_better) {
+  fuzzuf::utils::CollectNonZeroBytes(trace_bits, map_size, hit_edges);
+
+  bool won = false;
+  for (u32 i : hit_edges) {
+    if (top_rated[i]) {
+      auto &top_testcase = top_rated[i].value().get();
+      if (!is_better(top_testcase)) continue;
+
+      /* Looks like we're going to win. Decrease ref count for the
+         previous winner, discard its trace_bits[] if necessary. */
+      --top_testcase.tc_ref;
+      if (top_testcase.tc_ref == 0) {
+        top_testcase.trace_mini.reset();
       }
+      OnTestcaseChanged(top_testcase);
+    }
+
+    /* Insert ourselves as the new winner. */
+
+    top_rated[i] = std::ref(testcase);
+    testcase.tc_ref++;
+
+    if (!testcase.trace_mini) {
+      testcase.trace_mini.reset(new utils::CompactBitmap(hit_edges));
     }
+
+    favored_cover.MarkChanged(i);
+    score_changed = true;
+    won = true;
   }
+
+  if (won) OnTestcaseChanged(testcase);
 }
 
+template <class Testcase>
+void AFLStateTemplate<Testcase>::UpdateFavored(void) {
+  favored_cover.Update(top_rated, [this](Testcase &testcase) {
+    if (testcase.favored)
+      queued_favored++;
+    else
+      queued_favored--;
+
+    if (!testcase.WasFuzzed()) {
+      if (testcase.favored)
+        pending_favored++;
+      else
+        pending_favored--;
+    }
+
+    MarkAsRedundant(testcase, !testcase.favored);
+    OnTestcaseChanged(testcase);
+  });
+
+  /* Entries added since the last call are not favored unless the cover
+     above has just chosen them. */
+  for (; culled_queue_size < case_queue.size(); culled_queue_size++) {
+    auto &testcase = *case_queue[culled_queue_size];
+    MarkAsRedundant(testcase, !testcase.favored);
+  }
+}
+
+template <class Testcase>
+void AFLStateTemplate<Testcase>::OnTestcaseChanged(Testcase & /* testcase */) {}
+
 template <class Testcase>
 void AFLStateTemplate<Testcase>::UpdateBitmapScore(
     Testcase& testcase, const feedback::InplaceMemoryFeedback& inp_feed) {
@@ -1302,8 +1457,10 @@ void AFLStateTemplate<Testcase>::MarkAsDetDone(Testcase& testcase) {
   fn = fuzzuf::utils::StrPrintf("%s/queue/.state/deterministic_done/%s",
                                 setting->out_dir.c_str(), fn.c_str());
 
-  int fd = fuzzuf::utils::OpenFile(fn, O_WRONLY | O_CREAT | O_EXCL, 0600);
-  fuzzuf::utils::CloseFile(fd);
+  PostQueueJob([fn] {
+    int fd = fuzzuf::utils::OpenFile(fn, O_WRONLY | O_CREAT | O_EXCL, 0600);
+    fuzzuf::utils::CloseFile(fd);
+  });
 
   testcase.passed_det = true;
 }
@@ -1317,10 +1474,12 @@ void AFLStateTemplate<Testcase>::MarkAsVariable(Testcase& testcase) {
   fn = fuzzuf::utils::StrPrintf("%s/queue/.state/variable_behavior/%s",
                                 setting->out_dir.c_str(), fn.c_str());
 
-  if (symlink(ldest.c_str(), fn.c_str()) == -1) {
-    int fd = fuzzuf::utils::OpenFile(fn, O_WRONLY | O_CREAT | O_EXCL, 0600);
-    fuzzuf::utils::CloseFile(fd);
-  }
+  PostQueueJob([fn, ldest] {
+    if (symlink(ldest.c_str(), fn.c_str()) == -1) {
+      int fd = fuzzuf::utils::OpenFile(fn, O_WRONLY | O_CREAT | O_EXCL, 0600);
+      fuzzuf::utils::CloseFile(fd);
+    }
+  });
 
   testcase.var_behavior = true;
 }
@@ -1337,12 +1496,30 @@ void AFLStateTemplate<Testcase>::MarkAsRedundant(Testcase& testcase, bool val) {
   fn = fuzzuf::utils::StrPrintf("%s/queue/.state/redundant_edges/%s",
                                 setting->out_dir.c_str(), fn.c_str());
 
-  if (val) {
-    int fd = fuzzuf::utils::OpenFile(fn, O_WRONLY | O_CREAT | O_EXCL, 0600);
-    fuzzuf::utils::CloseFile(fd);
-  } else {
-    if (unlink(fn.c_str())) ERROR("Unable to remove '%s'", fn.c_str());
-  }
+  PostQueueJob([fn, val] {
+    if (val) {
+      int fd = fuzzuf::utils::OpenFile(fn, O_WRONLY | O_CREAT | O_EXCL, 0600);
+      fuzzuf::utils::CloseFile(fd);
+    } else {
+      if (unlink(fn.c_str()))
+        throw fuzzuf::utils::FileError("Unable to remove " + fn);
+    }
+  });
+}
+
+template <class Testcase>
+void AFLStateTemplate<Testcase>::PostQueueJob(utils::AsyncWriter::Job&& job) {
+  // Waits for a free slot when the ring is full, so that job never overtakes
+  // the pending ones. A failure of the writer is rethrown here or by Flush.
+  if (queue_writer)
+    queue_writer->PostOrWait(std::move(job));
+  else
+    job();
+}
+
+template <class Testcase>
+void AFLStateTemplate<Testcase>::FlushQueue(void) {
+  if (queue_writer) queue_writer->Flush();
 }
 
 /* Get the number of runnable processes, with some simple smoothing. */
@@ -1392,19 +1569,13 @@ static double GetRunnableProcesses(State& state) {
   return res;
 }
 
-/* Update stats file for unattended monitoring. */
+/* Update stats file for unattended monitoring. The file is formatted here
+   and written by the reporter thread, so that a slow disk doesn't stall the
+   fuzz loop. */
 
 template <class Testcase>
 void AFLStateTemplate<Testcase>::WriteStatsFile(double bitmap_cvg,
                                                 double stability, double eps) {
-  auto fn = setting->out_dir / "fuzzer_stats";
-  int fd =
-      fuzzuf::utils::OpenFile(fn.string(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
-  if (fd < 0) ERROR("Unable to create '%s'", fn.c_str());
-
-  FILE* f = fdopen(fd, "w");
-  if (!f) ERROR("fdopen() failed");
-
   /* Keep last values in case we're called from another context
      where exec/sec stats and such are not readily available. */
 
@@ -1418,8 +1589,7 @@ void AFLStateTemplate<Testcase>::WriteStatsFile(double bitmap_cvg,
     last_eps = eps;
   }
 
-  fprintf(
-      f,
+  std::string stats = fuzzuf::utils::StrPrintf(
       "start_time        : %llu\n"
       "last_update       : %llu\n"
       "fuzzer_pid        : %u\n"
@@ -1466,46 +1636,52 @@ void AFLStateTemplate<Testcase>::WriteStatsFile(double bitmap_cvg,
           ? ""
           : "default",
       orig_cmdline.c_str(), slowest_exec_ms);
-  /* ignore errors */
 
-  /* Get rss value from the children
-     We must have killed the forkserver process and called waitpid
-     before calling getrusage */
+  auto fn = setting->out_dir / "fuzzer_stats";
+  reporter->Post([fn, stats = std::move(stats)]() mutable {
+    /* Get rss value from the children
+       We must have killed the forkserver process and called waitpid
+       before calling getrusage */
 
-  struct rusage usage;
+    struct rusage usage;
 
-  if (getrusage(RUSAGE_CHILDREN, &usage)) {
-    WARNF("getrusage failed");
-  } else if (usage.ru_maxrss == 0) {
-    fprintf(f, "peak_rss_mb       : not available while afl is running\n");
-  } else {
+    if (getrusage(RUSAGE_CHILDREN, &usage)) {
+      WARNF("getrusage failed");
+    } else if (usage.ru_maxrss == 0) {
+      stats += "peak_rss_mb       : not available while afl is running\n";
+    } else {
 #ifdef __APPLE__
-    fprintf(f, "peak_rss_mb       : %zu\n", usage.ru_maxrss >> 20);
+      stats += fuzzuf::utils::StrPrintf("peak_rss_mb       : %zu\n",
+                                        usage.ru_maxrss >> 20);
 #else
-    fprintf(f, "peak_rss_mb       : %zu\n", usage.ru_maxrss >> 10);
+      stats += fuzzuf::utils::StrPrintf("peak_rss_mb       : %zu\n",
+                                        usage.ru_maxrss >> 10);
 #endif /* ^__APPLE__ */
-  }
+    }
 
-  fclose(f);
+    if (!fuzzuf::utils::WriteFileAtomically(fn, stats.data(), stats.size()))
+      WARNF("Unable to write '%s'", fn.c_str());
+  });
 }
 
 template <class Testcase>
 void AFLStateTemplate<Testcase>::SaveAuto(void) {
   if (!auto_changed) return;
-  auto_changed = false;
 
   u32 lim = std::min<u32>(option::GetUseAutoExtras(*this), a_extras.size());
-  for (u32 i = 0; i < lim; i++) {
-    auto fn = setting->out_dir / "queue/.state/auto_extras" /
-              fuzzuf::utils::StrPrintf("auto_%06u", i);
-
-    int fd = fuzzuf::utils::OpenFile(fn.string(), O_WRONLY | O_CREAT | O_TRUNC,
-                                     0600);
-    if (fd < 0) ERROR("Unable to create '%s'", fn.c_str());
-
-    fuzzuf::utils::WriteFile(fd, &a_extras[i].data[0], a_extras[i].data.size());
-    fuzzuf::utils::CloseFile(fd);
-  }
+  std::vector<std::vector<u8>> tokens;
+  for (u32 i = 0; i < lim; i++) tokens.push_back(a_extras[i].data);
+
+  /* The tokens are saved again next time if the reporter is too busy */
+  auto dir = setting->out_dir / "queue/.state/auto_extras";
+  auto_changed = !reporter->Post([dir, tokens = std::move(tokens)] {
+    for (u32 i = 0; i < tokens.size(); i++) {
+      auto fn = dir / fuzzuf::utils::StrPrintf("auto_%06u", i);
+      if (!fuzzuf::utils::WriteFileAtomically(fn, tokens[i].data(),
+                                              tokens[i].size()))
+        WARNF("Unable to create '%s'", fn.c_str());
+    }
+  });
 }
 
 /* Write bitmap to file. The bitmap is useful mostly for the secret
@@ -1515,16 +1691,13 @@ void AFLStateTemplate<Testcase>::SaveAuto(void) {
 template <class Testcase>
 void AFLStateTemplate<Testcase>::WriteBitmap(void) {
   if (!bitmap_changed) return;
-  bitmap_changed = false;
 
+  /* The bitmap is written again next time if the reporter is too busy */
   auto fn = setting->out_dir / "fuzz_bitmap";
-
-  int fd =
-      fuzzuf::utils::OpenFile(fn.string(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
-  if (fd < 0) ERROR("Unable to create '%s'", fn.c_str());
-
-  fuzzuf::utils::WriteFile(fd, virgin_bits.data(), option::GetMapSize<Tag>());
-  fuzzuf::utils::CloseFile(fd);
+  bitmap_changed = !reporter->Post([fn, bitmap = virgin_bits] {
+    if (!fuzzuf::utils::WriteFileAtomically(fn, bitmap.data(), bitmap.size()))
+      WARNF("Unable to create '%s'", fn.c_str());
+  });
 }
 
 /* Read bitmap from file. This is for the -B option again. */
@@ -1548,28 +1721,34 @@ void AFLStateTemplate<Testcase>::MaybeUpdatePlotFile(double bitmap_cvg,
       prev_uh == unique_hangs && prev_md == max_depth)
     return;
 
-  prev_qp = queued_paths;
-  prev_pf = pending_favored;
-  prev_pnf = pending_not_fuzzed;
-  prev_ce = current_entry;
-  prev_qc = queue_cycle;
-  prev_uc = unique_crashes;
-  prev_uh = unique_hangs;
-  prev_md = max_depth;
-
   /* Fields in the file:
 
      relative_time, cycles_done, cur_path, paths_total, paths_not_fuzzed,
      favored_not_fuzzed, unique_crashes, unique_hangs, max_depth,
      execs_per_sec, total_execs, edges_found */
 
-  fprintf(plot_file,
+  std::string line = fuzzuf::utils::StrPrintf(
           "%llu, %llu, %u, %u, %u, %u, %0.02f%%, %llu, %llu, %u, %0.02f, %llu, %llu\n",
           (utils::GetCurTimeMs() - start_time) / 1000, queue_cycle - 1, current_entry,
           queued_paths, pending_not_fuzzed, pending_favored, bitmap_cvg,
-          unique_crashes, unique_hangs, max_depth, eps, total_execs, edges_found); /* ignore errors */
+          unique_crashes, unique_hangs, max_depth, eps, total_execs, edges_found);
+
+  /* plot_file is written only by the reporter thread after construction.
+     If the reporter is too busy, the line is written next time instead. */
+  if (!reporter->Post([plot_file = plot_file, line = std::move(line)] {
+        fputs(line.c_str(), plot_file); /* ignore errors */
+        fflush(plot_file);
+      }))
+    return;
 
-  fflush(plot_file);
+  prev_qp = queued_paths;
+  prev_pf = pending_favored;
+  prev_pnf = pending_not_fuzzed;
+  prev_ce = current_entry;
+  prev_qc = queue_cycle;
+  prev_uc = unique_crashes;
+  prev_uh = unique_hangs;
+  prev_md = max_depth;
 }
 
 template <class Testcase>
@@ -1865,6 +2044,27 @@ void AFLStateTemplate<Testcase>::PerformDryRun() {
   u32 cal_failures = 0;
   char* skip_crashes = getenv("AFL_SKIP_CRASHES");
 
+  // Calibrate the seeds on executor_pool ahead of the loop below, which
+  // replays the results in the order of case_queue. Hence virgin_bits and
+  // the testcases end up the same as when the seeds are run one by one.
+  if (executor_pool) {
+    std::vector<fs::path> paths;
+    for (const auto& testcase : case_queue) {
+      paths.emplace_back(testcase->input->GetPath());
+    }
+
+    executor_pool->Start(
+        paths.size(), [this, paths = std::move(paths)](
+                          std::size_t i, ExecutionRecorder& recorder) {
+          std::vector<u8> buf;
+          int fd = fuzzuf::utils::OpenFile(paths[i].string(), O_RDONLY);
+          fuzzuf::utils::ReadFileAll(fd, buf);
+          fuzzuf::utils::CloseFile(fd);
+
+          RecordCalibration(recorder, buf.data(), buf.size(), true);
+        });
+  }
+
   for (const auto& testcase : case_queue) {
     auto& input = *testcase->input;
 
@@ -1872,6 +2072,12 @@ void AFLStateTemplate<Testcase>::PerformDryRun() {
 
     ACTF("Attempting dry run with '%s'...", fn.c_str());
 
+    ExecutionRecord record;
+    if (executor_pool) {
+      record = executor_pool->Take();
+      ReplayExecutions(&record);
+    }
+
     input.Load();
 
     // There should be no active instance of InplaceMemoryFeedback at this
@@ -1883,8 +2089,12 @@ void AFLStateTemplate<Testcase>::PerformDryRun() {
         true, false);
 
     input.Unload();
+    ReplayExecutions(nullptr);
 
-    if (stop_soon) return;
+    if (stop_soon) {
+      executor_pool.reset();
+      return;
+    }
 
     if (res == crash_mode || res == feedback::PUTExitReasonType::FAULT_NOBITS) {
       MSG(cGRA "    len = %u, map size = %u, exec speed = %llu us\n" cRST,
@@ -2056,6 +2266,10 @@ void AFLStateTemplate<Testcase>::PerformDryRun() {
       WARNF("Instrumentation output varies across runs.");
   }
 
+  // The pool is used only for the dry run. Destroying it terminates its fork
+  // servers and gives their CPU cores back to other fuzzuf instances.
+  executor_pool.reset();
+
   if (cal_failures) {
     if (cal_failures == queued_paths)
       EXIT("All test cases time out%s, giving up!",
@@ -2072,6 +2286,275 @@ void AFLStateTemplate<Testcase>::PerformDryRun() {
   OKF("All test cases processed.");
 }
 
+/* Checkpoints hold what PerformDryRun and the fuzzing so far have computed,
+   so that a fuzzer started with "-i -" can go on from where the previous run
+   left off. The queue entries themselves are not copied, but read from
+   out_dir/queue when resuming. */
+
+template <class Testcase>
+template <class Visitor>
+void AFLStateTemplate<Testcase>::VisitCheckpointCounters(Visitor&& visit) {
+  visit(queued_variable);
+  visit(queued_at_start);
+  visit(queued_discovered);
+  visit(queued_imported);
+  visit(queued_with_cov);
+  visit(pending_not_fuzzed);
+  visit(cur_skipped_paths);
+  visit(max_depth);
+  visit(useless_at_start);
+  visit(var_byte_count);
+  visit(current_entry);
+  visit(havoc_div);
+  visit(total_crashes);
+  visit(unique_crashes);
+  visit(total_tmouts);
+  visit(unique_tmouts);
+  visit(unique_hangs);
+  visit(total_execs);
+  visit(slowest_exec_ms);
+  visit(last_path_time);
+  visit(last_crash_time);
+  visit(last_hang_time);
+  visit(last_crash_execs);
+  visit(queue_cycle);
+  visit(cycles_wo_finds);
+  visit(trim_execs);
+  visit(bytes_trim_in);
+  visit(bytes_trim_out);
+  visit(blocks_eff_total);
+  visit(blocks_eff_select);
+  visit(total_cal_us);
+  visit(total_cal_cycles);
+  visit(total_bitmap_size);
+  visit(total_bitmap_entries);
+  visit(run_over10m);
+}
+
+template <class Testcase>
+void AFLStateTemplate<Testcase>::WriteCheckpoint(bool in_background) {
+  // The per-entry data of K-Scheduler is not saved
+  if constexpr (option::EnableKScheduler<Tag>()) return;
+
+  /* Never let two writers race on the temporary file. A background write
+     still in progress just makes this one skipped. */
+  if (checkpoint_writer > 0) {
+    int status;
+    if (waitpid(checkpoint_writer, &status, in_background ? WNOHANG : 0) == 0)
+      return;
+    checkpoint_writer = -1;
+  }
+
+  /* The checkpoint refers to the queue entries by path */
+  FlushQueue();
+
+  utils::CheckpointWriter writer(CHECKPOINT_VERSION);
+  writer.WriteString(option::GetCheckpointAlgorithm<Tag>());
+  writer.Write(option::GetMapSize<Tag>());
+
+  writer.WriteVector(virgin_bits);
+  writer.WriteVector(virgin_tmout);
+  writer.WriteVector(virgin_crash);
+  writer.WriteVector(var_bytes);
+
+  std::unordered_map<const Testcase*, u32> index_of;
+  std::vector<u32> edges;
+
+  writer.Write(u32(case_queue.size()));
+  for (const auto& testcase : case_queue) {
+    index_of.emplace(testcase.get(), index_of.size());
+
+    writer.WriteString(testcase->input->GetPath().filename().string());
+    /* GetLen() is stale for entries not loaded since they were written, so
+       the size on disk is recorded. It is checked again on resume. The files
+       are stat-ed by the writer, which runs in the background. */
+    writer.WriteFileSize(testcase->input->GetPath());
+    writer.Write(testcase->cal_failed);
+    writer.Write(testcase->trim_done);
+    writer.Write(testcase->was_fuzzed);
+    writer.Write(testcase->was_fuzzed2);
+    writer.Write(testcase->passed_det);
+    writer.Write(testcase->has_new_cov);
+    writer.Write(testcase->var_behavior);
+    writer.Write(testcase->fs_redundant);
+    writer.Write(testcase->bitmap_size);
+    writer.Write(testcase->fuzz_level);
+    writer.Write(testcase->exec_cksum);
+    writer.Write(testcase->exec_us);
+    writer.Write(testcase->handicap);
+    writer.Write(testcase->depth);
+
+    edges.clear();
+    if (testcase->trace_mini) {
+      testcase->trace_mini->ForEach([&edges](u32 i) { edges.push_back(i); });
+    }
+    writer.WriteVector(edges);
+  }
+
+  std::vector<u32> top_edges;
+  std::vector<u32> top_indices;
+  for (u32 i = 0; i < option::GetMapSize<Tag>(); i++) {
+    if (!top_rated[i]) continue;
+    top_edges.push_back(i);
+    top_indices.push_back(index_of.at(&top_rated[i].value().get()));
+  }
+  writer.WriteVector(top_edges);
+  writer.WriteVector(top_indices);
+
+  VisitCheckpointCounters([&writer](auto& v) { writer.Write(v); });
+  writer.WriteVector(stage_finds);
+  writer.WriteVector(stage_cycles);
+
+  writer.Write(u32(a_extras.size()));
+  for (const auto& extra : a_extras) {
+    writer.WriteVector(extra.data);
+    writer.Write(extra.hit_cnt);
+  }
+
+  SaveCheckpointExtension(writer);
+
+  auto path = setting->out_dir / option::GetCheckpointFile<Tag>();
+  if (in_background) {
+    checkpoint_writer =
+        utils::WriteCheckpointFileInBackground(path, writer);
+    if (checkpoint_writer < 0) WARNF("Unable to fork a checkpoint writer");
+  } else {
+    try {
+      utils::WriteCheckpointFile(path, writer);
+    } catch (const exceptions::unable_to_create_file& e) {
+      WARNF("%s", e.what());
+    }
+  }
+}
+
+template <class Testcase>
+void AFLStateTemplate<Testcase>::MaybeWriteCheckpoint(void) {
+  u64 cur_ms = fuzzuf::utils::GetCurTimeMs();
+  if (!last_checkpoint_ms) last_checkpoint_ms = cur_ms;
+  if (cur_ms - last_checkpoint_ms < option::GetCheckpointUpdateSec<Tag>() * 1000)
+    return;
+
+  last_checkpoint_ms = cur_ms;
+  WriteCheckpoint(true);
+}
+
+template <class Testcase>
+void AFLStateTemplate<Testcase>::LoadCheckpoint(void) {
+  if constexpr (option::EnableKScheduler<Tag>()) {
+    EXIT("Resuming is not supported with K-Scheduler");
+  }
+
+  fs::path path = setting->out_dir / option::GetCheckpointFile<Tag>();
+  ACTF("Resuming from '%s'...", path.c_str());
+
+  try {
+    utils::CheckpointReader reader = utils::ReadCheckpointFile(path);
+    auto invalid = [](const std::string& message) {
+      return exceptions::invalid_file(message, __FILE__, __LINE__);
+    };
+
+    if (reader.GetVersion() != CHECKPOINT_VERSION)
+      throw invalid("Unsupported checkpoint version");
+    if (reader.ReadString() != option::GetCheckpointAlgorithm<Tag>() ||
+        reader.Read<u32>() != option::GetMapSize<Tag>())
+      throw invalid("Checkpoint was written by another fuzzer");
+
+    virgin_bits = reader.ReadVector<u8>();
+    virgin_tmout = reader.ReadVector<u8>();
+    virgin_crash = reader.ReadVector<u8>();
+    var_bytes = reader.ReadVector<u8>();
+    for (auto* map : {&virgin_bits, &virgin_tmout, &virgin_crash, &var_bytes}) {
+      if (map->size() != option::GetMapSize<Tag>())
+        throw invalid("Checkpoint has a broken bitmap");
+    }
+
+    u32 queue_size = reader.Read<u32>();
+    for (u32 i = 0; i < queue_size; i++) {
+      auto fn = setting->out_dir / "queue" / reader.ReadString();
+      auto len = reader.Read<u32>();
+      if (!fs::exists(fn)) throw invalid("Queue entry is missing: " + fn.string());
+      if (fs::file_size(fn) != len)
+        throw invalid("Queue entry has been modified: " + fn.string());
+
+      auto cal_failed = reader.Read<u8>();
+      auto trim_done = reader.Read<bool>();
+      auto was_fuzzed = reader.Read<bool>();
+      auto was_fuzzed2 = reader.Read<bool>();
+      auto passed_det = reader.Read<bool>();
+
+      auto testcase = AddToQueue(fn.string(), nullptr, len, passed_det);
+      testcase->cal_failed = cal_failed;
+      testcase->trim_done = trim_done;
+      testcase->was_fuzzed = was_fuzzed;
+      testcase->was_fuzzed2 = was_fuzzed2;
+      testcase->has_new_cov = reader.Read<bool>();
+      testcase->var_behavior = reader.Read<bool>();
+      testcase->fs_redundant = reader.Read<bool>();
+      testcase->bitmap_size = reader.Read<u32>();
+      testcase->fuzz_level = reader.Read<u32>();
+      testcase->exec_cksum = reader.Read<u32>();
+      testcase->exec_us = reader.Read<u64>();
+      testcase->handicap = reader.Read<u64>();
+      testcase->depth = reader.Read<u64>();
+
+      auto edges = reader.ReadVector<u32>();
+      if (!edges.empty()) {
+        testcase->trace_mini.reset(new utils::CompactBitmap(edges));
+      }
+    }
+
+    auto top_edges = reader.ReadVector<u32>();
+    auto top_indices = reader.ReadVector<u32>();
+    if (top_edges.size() != top_indices.size())
+      throw invalid("Checkpoint has broken top_rated");
+    for (std::size_t i = 0; i < top_edges.size(); i++) {
+      u32 edge = top_edges[i];
+      if (edge >= option::GetMapSize<Tag>() || top_indices[i] >= queue_size ||
+          !case_queue[top_indices[i]]->trace_mini)
+        throw invalid("Checkpoint has broken top_rated");
+
+      auto& testcase = *case_queue[top_indices[i]];
+      top_rated[edge] = std::ref(testcase);
+      testcase.tc_ref++;
+      favored_cover.MarkChanged(edge);
+    }
+
+    VisitCheckpointCounters([&reader](auto& v) {
+      v = reader.Read<std::remove_reference_t<decltype(v)>>();
+    });
+    stage_finds = reader.ReadVector<u64>();
+    stage_cycles = reader.ReadVector<u64>();
+
+    u32 a_extras_size = reader.Read<u32>();
+    a_extras.clear();
+    for (u32 i = 0; i < a_extras_size; i++) {
+      auto data = reader.ReadVector<u8>();
+      a_extras.emplace_back(data, reader.Read<u32>());
+    }
+
+    LoadCheckpointExtension(reader);
+
+    if (!reader.AtEnd()) throw invalid("Checkpoint has trailing data");
+  } catch (const exceptions::invalid_file& e) {
+    EXIT("Unable to resume from '%s': %s", path.c_str(), e.what());
+  }
+
+  /* The favored flags are recomputed by the next cull_queue(). */
+  score_changed = true;
+  resuming_fuzz = true;
+
+  OKF("Resumed %u queue entries, %llu execs so far.", queued_paths,
+      total_execs);
+}
+
+template <class Testcase>
+void AFLStateTemplate<Testcase>::SaveCheckpointExtension(
+    utils::CheckpointWriter& /* writer */) const {}
+
+template <class Testcase>
+void AFLStateTemplate<Testcase>::LoadCheckpointExtension(
+    utils::CheckpointReader& /* reader */) {}
+
 /* Check terminal dimensions after resize. */
 
 static bool CheckTermSize() {
@@ -2561,6 +3044,7 @@ template <class Testcase>
 void AFLStateTemplate<Testcase>::ReceiveStopSignal(void) {
   stop_soon = 1;
   executor->ReceiveStopSignal();
+  if (executor_pool) executor_pool->ReceiveStopSignal();
 }
 
 template <class Testcase>
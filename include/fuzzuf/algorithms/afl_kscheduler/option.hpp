@@ -74,6 +74,11 @@ constexpr bool EnableKSchedulerSortByEnergy<AFLKSchedulerTag>(void) {
   return true;
 }
 
+template <>
+constexpr const char* GetCheckpointAlgorithm<AFLKSchedulerTag>(void) {
+  return "afl_kscheduler";
+}
+
 template <>
 struct perf_type<AFLKSchedulerTag> {
   using type = double;
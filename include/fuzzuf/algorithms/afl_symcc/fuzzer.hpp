@@ -73,6 +73,8 @@ struct AFLFuzzerTemplate final : public afl::AFLFuzzerTemplate<State> {
    * @return input value
    */
   auto GetInput() const {
+    // The queue entry may still be waiting to be written
+    afl::AFLFuzzerTemplate<State>::state->FlushQueue();
     const auto fn =
         afl::AFLFuzzerTemplate<State>::state
             ->case_queue
@@ -44,3 +44,13 @@ constexpr u32 GetMaxFactor(State& state) {
 }
 
 }  // namespace fuzzuf::algorithm::aflfast::option
+
+namespace fuzzuf::algorithm::afl::option {
+
+template <>
+constexpr const char*
+GetCheckpointAlgorithm<aflfast::option::AFLFastTag>(void) {
+  return "aflfast";
+}
+
+}  // namespace fuzzuf::algorithm::afl::option
@@ -51,6 +51,9 @@ struct AFLFastState : public afl::AFLStateTemplate<AFLFastTestcase> {
 
   void ShowStats(void);
 
+  void SaveCheckpointExtension(utils::CheckpointWriter &writer) const override;
+  void LoadCheckpointExtension(utils::CheckpointReader &reader) override;
+
   std::shared_ptr<const AFLFastSetting> setting;
 };
 
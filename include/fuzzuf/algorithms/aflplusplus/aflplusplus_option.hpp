@@ -39,6 +39,12 @@ constexpr u32 GetHavocStackPow2<aflplusplus::option::AFLplusplusTag>(void) {
   return 6;
 }
 
+template <>
+constexpr const char*
+GetCheckpointAlgorithm<aflplusplus::option::AFLplusplusTag>(void) {
+  return "aflplusplus";
+}
+
 }  // namespace fuzzuf::algorithm::afl::option
 
 #endif
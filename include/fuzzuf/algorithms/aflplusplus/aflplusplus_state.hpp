@@ -23,6 +23,7 @@
 #include "fuzzuf/algorithms/afl/afl_state.hpp"
 #include "fuzzuf/algorithms/aflplusplus/aflplusplus_setting.hpp"
 #include "fuzzuf/algorithms/aflplusplus/aflplusplus_testcase.hpp"
+#include "fuzzuf/algorithms/aflplusplus/aflplusplus_util.hpp"
 #include "fuzzuf/executor/afl_executor_interface.hpp"
 #include "fuzzuf/feedback/exit_status_feedback.hpp"
 #include "fuzzuf/feedback/inplace_memory_feedback.hpp"
@@ -31,8 +32,6 @@
 
 namespace fuzzuf::algorithm::aflplusplus {
 
-using fuzzuf::utils::random::WalkerDiscreteDistribution;
-
 struct AFLplusplusState : public afl::AFLStateTemplate<AFLplusplusTestcase> {
   explicit AFLplusplusState(
       std::shared_ptr<const AFLplusplusSetting> setting,
@@ -50,12 +49,14 @@ struct AFLplusplusState : public afl::AFLStateTemplate<AFLplusplusTestcase> {
                          feedback::ExitStatusFeedback &exit_status) override;
   u32 DoCalcScore(AFLplusplusTestcase &testcase) override;
   void ShowStats(void) override;
+  void OnTestcaseChanged(AFLplusplusTestcase &testcase) override;
+  void SaveCheckpointExtension(utils::CheckpointWriter &writer) const override;
+  void LoadCheckpointExtension(utils::CheckpointReader &reader) override;
 
   std::shared_ptr<const AFLplusplusSetting> setting;
   std::shared_ptr<u32[]> n_fuzz;
 
-  u32 prev_queued_items;
-  std::unique_ptr<WalkerDiscreteDistribution<u32>> alias_probability;
+  util::SeedWeights seed_weights;
 };
 
 }  // namespace fuzzuf::algorithm::aflplusplus
@@ -20,6 +20,8 @@
 #define FUZZUF_INCLUDE_ALGORITHMS_AFLPLUSPLUS_AFLPLUSPLUS_UTIL_HPP
 
 #include <algorithm>
+#include <cmath>
+#include <iterator>
 #include <numeric>
 #include <vector>
 
@@ -32,6 +34,20 @@ namespace fuzzuf::algorithm::aflplusplus::util {
 // to avoid buggy situations like "1.0/0.0"
 const double epsilon = 1e-8;
 
+/* Weights of queue entries for the weighted random seed selection */
+struct SeedWeights {
+  utils::random::FenwickDiscreteDistribution<u32> distribution;
+
+  // The averages over the queue when it was rebuilt last time
+  double avg_exec_us = 0.0;
+  double avg_bitmap_size = 0.0;
+  double avg_top_size = 0.0;
+  u32 rebuilt_size = 0;
+
+  // Entries to be weighed again
+  std::vector<u32> changed;
+};
+
 /*
  * These utility functions are supposed to be
  * used with *AFLplusplusState-like* State instances.
@@ -62,8 +78,9 @@ double ComputeWeight(const State &state,
   return weight;
 }
 
+/* The averages over the queue which ComputeWeight takes */
 template <class State>
-void ComputeWeightVector(State &state, std::vector<double> &vw) {
+void ComputeAverages(const State &state, SeedWeights &weights) {
   u32 queued_items = state.case_queue.size();
 
   double avg_exec_us = 0.0, avg_bitmap_size = 0.0, avg_top_size = 0.0;
@@ -72,27 +89,87 @@ void ComputeWeightVector(State &state, std::vector<double> &vw) {
     avg_bitmap_size += std::log(tc->bitmap_size + 1);
     avg_top_size += tc->tc_ref;
   }
-  avg_exec_us /= queued_items;
-  avg_bitmap_size /= queued_items;
-  avg_top_size /= queued_items;
-
-  std::transform(state.case_queue.begin(), state.case_queue.end(),
-                 std::back_inserter(vw), [&](auto &tc) {
-                   return ComputeWeight(state, *tc, avg_exec_us,
-                                        avg_bitmap_size, avg_top_size);
-                 });
+  weights.avg_exec_us = avg_exec_us / queued_items;
+  weights.avg_bitmap_size = avg_bitmap_size / queued_items;
+  weights.avg_top_size = avg_top_size / queued_items;
+}
+
+template <class State>
+double ComputeSeedWeight(const State &state,
+                         const typename State::OwnTestcase &testcase,
+                         const SeedWeights &weights) {
+  double w = ComputeWeight(state, testcase, weights.avg_exec_us,
+                           weights.avg_bitmap_size, weights.avg_top_size);
+  if (-epsilon <= w && w < 0) w = 0;
+  return w;
+}
+
+template <class State>
+void ComputeWeightVector(State &state, std::vector<double> &vw) {
+  SeedWeights weights;
+  ComputeAverages(state, weights);
+
+  std::transform(
+      state.case_queue.begin(), state.case_queue.end(), std::back_inserter(vw),
+      [&](auto &tc) {
+        return ComputeWeight(state, *tc, weights.avg_exec_us,
+                             weights.avg_bitmap_size, weights.avg_top_size);
+      });
 }
 
-/* create the alias table that allows weighted random selection - expensive */
+/* Bring state.seed_weights up to date with the queue. Rebuilding the table
+   from scratch is expensive, so it is done only when the queue has grown by
+   1/REBUILD_DIVISOR since the last rebuild. In between, new entries and the
+   entries reported by OnTestcaseChanged are weighed against the averages of
+   the last rebuild. */
 template <class State>
-void CreateAliasTable(State &state) {
-  std::vector<double> vw;
-  ComputeWeightVector(state, vw);
-  for (double &w : vw) {
-    if (-epsilon <= w && w < 0) w = 0;
+void UpdateSeedWeights(State &state) {
+  constexpr u32 REBUILD_DIVISOR = 8;
+
+  auto &weights = state.seed_weights;
+  u32 queued_items = state.case_queue.size();
+
+  if (queued_items > weights.rebuilt_size &&
+      queued_items - weights.rebuilt_size >=
+          weights.rebuilt_size / REBUILD_DIVISOR) {
+    ComputeAverages(state, weights);
+
+    std::vector<double> vw;
+    vw.reserve(queued_items);
+    for (auto &tc : state.case_queue) {
+      vw.push_back(ComputeSeedWeight(state, *tc, weights));
+    }
+
+    weights.distribution =
+        utils::random::FenwickDiscreteDistribution<u32>(vw);
+    weights.rebuilt_size = queued_items;
+    weights.changed.clear();
+    return;
   }
-  using utils::random::WalkerDiscreteDistribution;
-  state.alias_probability.reset(new WalkerDiscreteDistribution<u32>(vw));
+
+  for (u32 i : weights.changed) {
+    if (i < weights.distribution.Size()) {
+      weights.distribution.Set(
+          i, ComputeSeedWeight(state, *state.case_queue[i], weights));
+    }
+  }
+  weights.changed.clear();
+
+  for (u32 i = weights.distribution.Size(); i < queued_items; i++) {
+    weights.distribution.Push(
+        ComputeSeedWeight(state, *state.case_queue[i], weights));
+  }
+}
+
+/* Choose the next queue entry by weighted random. The entry chosen will be
+   fuzzed, which changes its weight, so it is weighed again next time. */
+template <class State>
+u32 SelectSeed(State &state) {
+  UpdateSeedWeights(state);
+
+  u32 entry = state.seed_weights.distribution();
+  state.seed_weights.changed.push_back(entry);
+  return entry;
 }
 
 }  // namespace fuzzuf::algorithm::aflplusplus::util
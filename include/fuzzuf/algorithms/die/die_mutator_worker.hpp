@@ -0,0 +1,117 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file die_mutator_worker.hpp
+ * @brief Persistent node process running esfuzz and typer of DIE
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#pragma once
+
+#include <optional>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+#include "fuzzuf/utils/common.hpp"
+
+namespace fuzzuf::algorithm::die {
+
+/**
+ * @class DIEMutatorWorker
+ * @brief Client of mutator_worker.js, which keeps node and the modules of DIE
+ * loaded across mutations instead of spawning node for each of them.
+ * @details The worker is started on the first request. If it doesn't answer
+ * in time or the pipe breaks, it is killed and started again on the next
+ * request, and the request fails so that the caller can fall back to running
+ * the script by itself.
+ */
+class DIEMutatorWorker {
+ public:
+  /* A mutated script and its type file */
+  struct Mutant {
+    std::vector<u8> js;
+    std::vector<u8> type;
+  };
+
+  explicit DIEMutatorWorker(const std::string& cmd_node,
+                            const std::string& worker_path,
+                            const std::string& die_ts_dir,
+                            u32 timeout_ms = 30000);
+  ~DIEMutatorWorker();
+
+  DIEMutatorWorker(const DIEMutatorWorker&) = delete;
+  DIEMutatorWorker& operator=(const DIEMutatorWorker&) = delete;
+
+  /**
+   * @fn
+   * @brief Run esfuzz.js in the worker
+   * @param (path_js) Input JS file
+   * @param (out_dir) Directory where esfuzz writes the mutants
+   * @param (count) Number of mutants to generate
+   * @param (seed) Seed used in esfuzz
+   * @param (mutants) Mutants esfuzz wrote successfully are appended to this,
+   * even if esfuzz failed afterwards
+   * @return Exit status of esfuzz.js, or std::nullopt if the worker is
+   * unavailable or didn't answer. If the status is not 0, the worker is
+   * restarted on the next request, since the failure may have left the
+   * modules it keeps loaded in a bad state.
+   */
+  std::optional<int> Mutate(const std::string& path_js,
+                            const std::string& out_dir, int count, u32 seed,
+                            std::vector<Mutant>& mutants);
+
+  /**
+   * @fn
+   * @brief Run typer.js in the worker to instrument a JS file
+   * @param (path_js) Input JS file
+   * @param (path_jsi) Path of the instrumented JS file
+   * @return Exit status of typer.js, or std::nullopt if the worker is
+   * unavailable or didn't answer
+   */
+  std::optional<int> Instrument(const std::string& path_js,
+                                const std::string& path_jsi);
+
+  /**
+   * @fn
+   * @brief Kill the worker. It is started again on the next request.
+   */
+  void Reset();
+
+  /* True if the worker exited before answering any request, which means
+     node or the scripts are not usable as a worker */
+  bool IsBroken() const { return broken; }
+
+ private:
+  bool Start();
+  std::optional<u32> Request(const std::vector<std::string>& fields,
+                             std::vector<std::vector<u8>>* buffers);
+  bool ReadExact(void* buf, u32 len, u64 deadline_ms);
+
+  std::string cmd_node;
+  std::string worker_path;
+  std::string die_ts_dir;
+  u32 timeout_ms;
+
+  pid_t pid = -1;
+  int request_fd = -1;
+  int response_fd = -1;
+  bool answered = false;
+  bool broken = false;
+};
+
+}  // namespace fuzzuf::algorithm::die
@@ -33,3 +33,12 @@ constexpr u32 GetMaxFile(void) {
 }
 
 }  // namespace fuzzuf::algorithm::die::option
+
+namespace fuzzuf::algorithm::afl::option {
+
+template <>
+constexpr const char* GetCheckpointAlgorithm<die::option::DIETag>(void) {
+  return "die";
+}
+
+}  // namespace fuzzuf::algorithm::afl::option
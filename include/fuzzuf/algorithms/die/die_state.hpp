@@ -25,6 +25,7 @@
 #include <memory>
 
 #include "fuzzuf/algorithms/afl/afl_state.hpp"
+#include "fuzzuf/algorithms/die/die_mutator_worker.hpp"
 #include "fuzzuf/algorithms/die/die_option.hpp"
 #include "fuzzuf/algorithms/die/die_setting.hpp"
 #include "fuzzuf/algorithms/die/die_testcase.hpp"
@@ -71,6 +72,10 @@ struct DIEState : public afl::AFLStateTemplate<DIETestcase> {
 
   /* Setting from CLI */
   std::shared_ptr<const DIESetting> setting;
+
+  /* Worker running esfuzz and typer without spawning node each time.
+     nullptr if mutator_worker.js is not found next to typer.py. */
+  std::unique_ptr<DIEMutatorWorker> mutator_worker;
 };
 
 }  // namespace fuzzuf::algorithm::die
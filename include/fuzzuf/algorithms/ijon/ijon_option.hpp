@@ -64,6 +64,11 @@ constexpr u32 GetHavocBlkXl<ijon::option::IJONTag>(void) {
   return 512;
 }
 
+template <>
+constexpr const char* GetCheckpointAlgorithm<ijon::option::IJONTag>(void) {
+  return "ijon";
+}
+
 template <>
 constexpr u32 GetSpliceCycles<ijon::IJONState>(ijon::IJONState&) {
   return 8;
@@ -22,18 +22,23 @@
 #ifndef FUZZUF_INCLUDE_ALGORITHM_LIBFUZZER_FUZZER_HPP
 #define FUZZUF_INCLUDE_ALGORITHM_LIBFUZZER_FUZZER_HPP
 
+#include <atomic>
 #include <chrono>
 #include <cstddef>
 #include <functional>
+#include <memory>
 #include <random>
+#include <thread>
 #include <vector>
 
 #include "fuzzuf/algorithms/libfuzzer/cli_compat/variables.hpp"
+#include "fuzzuf/algorithms/libfuzzer/corpus_exchange.hpp"
 #include "fuzzuf/algorithms/libfuzzer/dictionary.hpp"
 #include "fuzzuf/algorithms/libfuzzer/mutation_history.hpp"
 #include "fuzzuf/algorithms/libfuzzer/state/common_types.hpp"
 #include "fuzzuf/algorithms/libfuzzer/state/corpus.hpp"
 #include "fuzzuf/algorithms/libfuzzer/state/state.hpp"
+#include "fuzzuf/algorithms/libfuzzer/state/testcase_id.hpp"
 #include "fuzzuf/cli/fuzzer_args.hpp"
 #include "fuzzuf/fuzzer/fuzzer.hpp"
 #include "fuzzuf/utils/node_tracer.hpp"
@@ -54,9 +59,9 @@ class LibFuzzer : public fuzzer::Fuzzer {
  public:
   LibFuzzer(cli::FuzzerArgs &, const cli::GlobalFuzzerOptions &,
             std::function<void(std::string &&)> &&);
-  virtual ~LibFuzzer() {}
+  virtual ~LibFuzzer();
   virtual void OneLoop();
-  virtual void ReceiveStopSignal(void) {}
+  virtual void ReceiveStopSignal(void);
   bool ShouldEnd() override { return end_; }
   const FuzzerCreateInfo &get_create_info() const { return create_info; }
   const auto &GetVariables() const { return vars; }
@@ -72,6 +77,25 @@ class LibFuzzer : public fuzzer::Fuzzer {
   std::function<void(std::string &&)> sink;
   utils::DumpTracer node_tracer;
   utils::ElapsedTimeTracer ett;
+
+  // With -workers=N, the flow above is the worker 0, and the other N - 1
+  // workers run the same flow on their own threads with their own executors.
+  // The workers share their corpus through corpus_exchange.
+  struct Worker;
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::vector<std::thread> worker_threads;
+  std::atomic<bool> stop_workers = false;
+  CorpusExchange corpus_exchange;
+  std::function<void()> import_inputs;
+  std::vector<CorpusExchange::Input> imported_inputs;
+  testcase_id_t next_id_to_publish = 0u;
+
+  void RunWorker(Worker &worker);
+  void StopWorkers();
+
+  // Minimize the inputs in input_dirs into the first one, instead of fuzzing
+  void Merge(const std::vector<std::string> &input_dirs,
+             const std::vector<fs::path> &targets, std::size_t worker_count);
 };
 }  // namespace fuzzuf::algorithm::libfuzzer
 
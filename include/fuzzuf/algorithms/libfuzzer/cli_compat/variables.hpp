@@ -29,6 +29,7 @@
 #include <random>
 #include <vector>
 
+#include "fuzzuf/algorithms/libfuzzer/cmp_trace.hpp"
 #include "fuzzuf/algorithms/libfuzzer/dictionary.hpp"
 #include "fuzzuf/algorithms/libfuzzer/mutation_history.hpp"
 #include "fuzzuf/algorithms/libfuzzer/state/common_types.hpp"
@@ -56,6 +57,7 @@ struct Variables {
   std::size_t executor_index = 0u;
   std::vector<fuzzuf::utils::mapped_file_t> symcc_out;
   unsigned int stuck_count = 0u;
+  CmpTrace cmp_trace;
 };
 namespace sp = utils::struct_path;
 struct Order {
@@ -116,6 +118,7 @@ struct Order {
   constexpr static auto symcc_freq =
       create_info /
       sp::mem<FuzzerCreateInfo, unsigned int, &FuzzerCreateInfo::symcc_freq>;
+  constexpr static auto cmp_trace = arg0 / sp::mem<V, CmpTrace, &V::cmp_trace>;
 };
 }  // namespace fuzzuf::algorithm::libfuzzer
 
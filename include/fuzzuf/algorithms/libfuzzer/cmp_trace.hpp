@@ -0,0 +1,154 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file cmp_trace.hpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#ifndef FUZZUF_INCLUDE_ALGORITHM_LIBFUZZER_CMP_TRACE_HPP
+#define FUZZUF_INCLUDE_ALGORITHM_LIBFUZZER_CMP_TRACE_HPP
+#include <array>
+#include <boost/container/static_vector.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "fuzzuf/algorithms/libfuzzer/dictionary.hpp"
+#include "fuzzuf/coverage/cmplog_attacher.hpp"
+
+namespace fuzzuf::algorithm::libfuzzer {
+
+/**
+ * @class ValueProfileMap
+ * @brief Set of value profile features found in one execution
+ *
+ * Corresponding code of original libFuzzer implementation
+ * https://github.com/llvm/llvm-project/blob/llvmorg-12.0.1/compiler-rt/lib/fuzzer/FuzzerValueBitMap.h#L20
+ */
+struct ValueProfileMap {
+  static constexpr std::size_t MAP_SIZE_IN_BITS = 1u << 16;
+  static constexpr std::size_t MAP_PRIME_MOD = 65371u;
+
+  void Reset() { bits.fill(0u); }
+
+  void AddValue(std::size_t value) {
+    const std::size_t index = value % MAP_SIZE_IN_BITS;
+    bits[index / 64u] |= std::uint64_t(1u) << (index % 64u);
+  }
+
+  void AddValueModPrime(std::size_t value) { AddValue(value % MAP_PRIME_MOD); }
+
+  /**
+   * Call cb for each value in the set, in ascending order
+   * @tparam Callback Callable with one std::uint32_t argument
+   * @param cb Callable with one std::uint32_t argument
+   */
+  template <typename Callback>
+  void ForEach(Callback cb) const {
+    for (std::size_t i = 0u; i != bits.size(); ++i) {
+      for (std::uint64_t word = bits[i]; word; word &= word - 1u)
+        cb(std::uint32_t(i * 64u + __builtin_ctzll(word)));
+    }
+  }
+
+  std::array<std::uint64_t, MAP_SIZE_IN_BITS / 64u> bits{};
+};
+
+/**
+ * @class RecentCompare
+ * @brief Operands of a comparison that didn't match, as little endian bytes
+ */
+struct RecentCompare {
+  using Operand = boost::container::static_vector<
+      std::uint8_t, sizeof(coverage::CmpFnOperands::v0)>;
+  Operand arg1;
+  Operand arg2;
+  // If true, the operands are integers and may be byte swapped or off by one
+  // when they are written to the input
+  bool integer = false;
+};
+
+/**
+ * @class TableOfRecentCompares
+ * @brief Fixed size table of the operands of the comparisons the target made
+ * recently. New entries overwrite old ones at the index given by the caller.
+ *
+ * Corresponding code of original libFuzzer implementation
+ * https://github.com/llvm/llvm-project/blob/llvmorg-12.0.1/compiler-rt/lib/fuzzer/FuzzerTracePC.h#L33
+ */
+struct TableOfRecentCompares {
+  static constexpr std::size_t SIZE = 1u << 5;
+
+  void Insert(std::size_t index, const std::uint8_t *arg1,
+              const std::uint8_t *arg2, std::size_t size, bool integer);
+
+  const RecentCompare &Get(std::size_t index) const {
+    return table[index % SIZE];
+  }
+
+  std::array<RecentCompare, SIZE> table;
+};
+
+/**
+ * @class CmpTrace
+ * @brief Feedback of the comparisons the target made, read from the CmpLog
+ * shared memory after each execution.
+ */
+struct CmpTrace {
+  static constexpr std::size_t DICTIONARY_ENTRIES_SIZE = 16u;
+
+  // Comparison log shared with the target. nullptr if neither value profile
+  // nor CMP tracing is enabled.
+  std::shared_ptr<coverage::CmpLogAttacher> cmp_log;
+  ValueProfileMap value_profile;
+  TableOfRecentCompares torc;
+  // Dictionary entries made from torc. The mutation history refers them by
+  // pointer until the persistent auto dictionary is updated, so that they
+  // are kept in a ring buffer like libFuzzer's CmpDictionaryEntriesDeque.
+  std::array<dictionary::StaticDictionaryEntry, DICTIONARY_ENTRIES_SIZE>
+      dictionary_entries;
+  std::size_t dictionary_entries_index = 0u;
+};
+
+/**
+ * Add the value profile features of the comparisons in the log to the map.
+ * For each instruction, the Hamming distance and the number of leading equal
+ * bits of the operands are recorded. For each call of a comparison routine,
+ * the length of the matching prefix is recorded.
+ *
+ * Corresponding code of original libFuzzer implementation
+ * https://github.com/llvm/llvm-project/blob/llvmorg-12.0.1/compiler-rt/lib/fuzzer/FuzzerTracePC.cpp#L363
+ * and
+ * https://github.com/llvm/llvm-project/blob/llvmorg-12.0.1/compiler-rt/lib/fuzzer/FuzzerTracePC.cpp#L331
+ *
+ * @param map Comparison log written by the target
+ * @param dest Value profile map to update
+ */
+void UpdateValueProfile(const coverage::CmpMap &map, ValueProfileMap &dest);
+
+/**
+ * Insert the operands of the comparisons in the log which didn't match to the
+ * table. Comparisons of single bytes and floating point values are ignored.
+ * @param map Comparison log written by the target
+ * @param dest Table to update
+ */
+void UpdateTableOfRecentCompares(const coverage::CmpMap &map,
+                                 TableOfRecentCompares &dest);
+
+}  // namespace fuzzuf::algorithm::libfuzzer
+
+#endif
@@ -123,7 +123,10 @@ struct Config {
    */
   bool reduce_inputs = false;
 
-  /// not implemented
+  /**
+   * If true, value profile features are calculated from the comparisons the
+   * target made. The target must be instrumented with AFL++'s CmpLog.
+   */
   bool use_value_profile_mask = false;
 
   /**
@@ -168,6 +171,7 @@ struct FuzzerCreateInfo {
   FUZZUF_SETTER(cpu_core_count)
   FUZZUF_SETTER(cpu_aff)
   FUZZUF_SETTER(use_afl_coverage)
+  FUZZUF_SETTER(use_cmp)
   FUZZUF_SETTER(sparse_energy_updates)
   FUZZUF_SETTER(crashed_only)
   FUZZUF_SETTER(max_input_length)
@@ -194,6 +198,7 @@ struct FuzzerCreateInfo {
   FUZZUF_SETTER(shuffle)
   FUZZUF_SETTER(prefer_small)
   FUZZUF_SETTER(check_input_sha1)
+  FUZZUF_SETTER(parallel_targets)
 
   /**
    * Load initial inputs from this directory
@@ -310,6 +315,12 @@ struct FuzzerCreateInfo {
    */
   bool use_afl_coverage = true;
 
+  /**
+   * If true, the operands of the comparisons the target made are used as
+   * dictionary words. The target must be instrumented with AFL++'s CmpLog.
+   */
+  bool use_cmp = false;
+
   /**
    * On entropic mode, even if distribution updating is not required, it is
    * updated with a probability of 1/n.
@@ -423,6 +434,15 @@ struct FuzzerCreateInfo {
 
   std::size_t target_offset = 0u;
   std::size_t target_count = 0u;
+
+  /**
+   * true: run the targets on the same input concurrently, one thread per
+   * target. Each target must use its own working files. Ignored unless
+   * forksrv is true.
+   * false: run the targets one after another.
+   */
+  bool parallel_targets = false;
+
   std::size_t symcc_target_offset = 0u;
   std::size_t symcc_target_count = 0u;
 
@@ -0,0 +1,86 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file corpus_exchange.hpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#ifndef FUZZUF_INCLUDE_ALGORITHM_LIBFUZZER_CORPUS_EXCHANGE_HPP
+#define FUZZUF_INCLUDE_ALGORITHM_LIBFUZZER_CORPUS_EXCHANGE_HPP
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace fuzzuf::algorithm::libfuzzer {
+
+/**
+ * @class CorpusExchange
+ * @brief In-memory log of the inputs added to the corpus of each worker, used
+ * to share them among the workers running on separate threads.
+ * @details Inputs are only appended, and each worker reads the log from where
+ * it stopped last time, skipping its own inputs. The inputs read by every
+ * worker are dropped from the log. The inputs are shared by shared_ptr, so
+ * reading them doesn't copy them.
+ */
+class CorpusExchange {
+ public:
+  using Input = std::shared_ptr<const std::vector<std::uint8_t>>;
+
+  /**
+   * Set the number of workers reading the log
+   * Must be called before the workers start.
+   */
+  void SetWorkerCount(std::size_t count);
+
+  void Publish(std::size_t worker, std::vector<std::uint8_t> &&input);
+
+  /**
+   * Append the inputs published by the workers other than worker since the
+   * last call, to dest
+   * @param worker Index of the worker calling this
+   * @param dest Inputs are appended to this value
+   */
+  void Fetch(std::size_t worker, std::vector<Input> &dest);
+
+  /**
+   * Stop keeping the inputs for worker, which never calls Fetch again
+   * @param worker Index of the worker calling this
+   */
+  void Leave(std::size_t worker);
+
+  // Number of inputs kept in the log, which some workers haven't read yet
+  std::size_t GetLogSize() const;
+
+ private:
+  // Drop the inputs read by every worker. mutex must be locked.
+  void Trim();
+
+  mutable std::mutex mutex;
+  std::deque<std::pair<std::size_t, Input>> log;
+  // Number of inputs dropped from the front of log
+  std::size_t trimmed = 0u;
+  // Position in the whole log each worker has read until
+  std::vector<std::size_t> cursors;
+};
+
+}  // namespace fuzzuf::algorithm::libfuzzer
+
+#endif
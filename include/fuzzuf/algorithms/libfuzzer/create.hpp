@@ -67,6 +67,7 @@ auto createMutator(const FuzzerCreateInfo &create_info) {
       std::move(manual_dictionary));
   auto persistent_auto_dict =
       hf::CreateNode<standard_order::DynamicDict<F, Ord>>();
+  auto cmp_dict = hf::CreateNode<standard_order::CmpDict<F, Ord>>();
   auto to_ascii_ = create_info.only_ascii
                        ? hf::CreateNode<standard_order::ToASCII<F, Ord>>()
                        : hf::CreateNode<Proxy<F>>();
@@ -86,6 +87,9 @@ auto createMutator(const FuzzerCreateInfo &create_info) {
                         copy_part_ || manual_dict || persistent_auto_dict) ||
              to_ascii_);
   }
+  // Appended last, so that the mutators are chosen in the same way as before
+  // unless use_cmp is enabled
+  if (create_info.use_cmp) random <= cmp_dict;
 
   return root;
 }
@@ -211,6 +215,44 @@ auto createInitialize(const FuzzerCreateInfo &create_info,
   return nop3;
 }
 
+/**
+ * Build following flow using HierarFlow
+ * * Execute target using the input found by another worker and retrive
+ * execution result
+ * * Calculate features using execution result
+ * * Add to corpus if the execution result is valuable ( or always if
+ * force_add_to_corpus is true )
+ * * Update the distribution to select inputs
+ * The input is stored on the memory only, since the worker which found it has
+ * already written it to the storage if needed.
+ * @tparam F Input function type of HierarFlow node
+ * @tparam Ord Type to specify how to retrive values from the arguments.
+ * @tparam Sink Type of the callable with one string argument
+ * @param create_info Parameters on building the fuzzer
+ * @param force_add_to_corpus If true, the execution result is added to the
+ * corpus regardless of features. This is used to take over the initial corpus
+ * of another worker.
+ * @param sink Callback function with one string argument to output messages.
+ * @return root node of the HierarFlow
+ */
+template <typename F, typename Ord, typename Sink>
+auto createImport(const FuzzerCreateInfo &create_info,
+                  bool force_add_to_corpus, const Sink &sink) {
+  namespace hf = fuzzuf::hierarflow;
+
+  auto update_distribution = hf::CreateNode<
+      standard_order::UpdateDistribution<F, MakeVersion(12u, 0u, 0u), Ord>>(
+      create_info.sparse_energy_updates, create_info.max_mutation_factor, sink);
+
+  auto nop = hf::CreateNode<Proxy<F>>();
+
+  nop << (createExecuteAndFeedback<F, Ord>(create_info, force_add_to_corpus,
+                                           true, false, false, sink) ||
+          update_distribution);
+
+  return nop;
+}
+
 /**
  * Build following flow using HierarFlow
  * * Select one input ( or two if crossover is enabled) and mutate it
@@ -24,6 +24,7 @@
 #include <algorithm>
 #include <type_traits>
 
+#include "fuzzuf/algorithms/libfuzzer/cmp_trace.hpp"
 #include "fuzzuf/algorithms/libfuzzer/feature/add_feature.hpp"
 #include "fuzzuf/algorithms/libfuzzer/feature/collect_features.hpp"
 #include "fuzzuf/algorithms/libfuzzer/feature/update_feature_frequency.hpp"
@@ -35,6 +36,44 @@
 
 namespace fuzzuf::algorithm::libfuzzer::executor {
 
+namespace detail {
+
+/**
+ * Apply the features enumerated by for_each_feature to the state, the corpus
+ * and the execution result
+ * @param for_each_feature Callable that takes a callable with one integer
+ * argument, and calls it for each feature of the execution in ascending order
+ */
+template <typename State, typename Corpus, typename Range, typename InputInfo,
+          typename ForEachFeature>
+void CollectFeatures(State &state, Corpus &corpus, Range &range,
+                     InputInfo &exec_result, ForEachFeature for_each_feature) {
+  utils::type_traits::RemoveCvrT<decltype(exec_result.unique_feature_set)>
+      unique_feature_set_temp;
+  std::size_t found_unique_features_of_input_info = 0u;
+  size_t previous_updates_count = state.updated_features_count;
+  const auto size = utils::range::rangeSize(range);
+  for_each_feature([&](auto f) -> void {
+    if (feature::AddFeature(state, corpus, f, static_cast<std::uint32_t>(size),
+                            state.create_info.config.shrink))
+      unique_feature_set_temp.push_back(f);
+
+    if (state.create_info.config.entropic.enabled)
+      feature::UpdateFeatureFrequency(state, exec_result, f);
+
+    if (state.create_info.config.reduce_inputs && !exec_result.never_reduce)
+      if (std::binary_search(exec_result.unique_feature_set.begin(),
+                             exec_result.unique_feature_set.end(), f))
+        ++found_unique_features_of_input_info;
+  });
+  exec_result.found_unique_features = found_unique_features_of_input_info;
+  exec_result.features_count =
+      state.updated_features_count - previous_updates_count;
+  exec_result.unique_feature_set = unique_feature_set_temp;
+}
+
+}  // namespace detail
+
 /**
  * Calculate features of specified execution result.
  * "Feature" is a outstanding feature of the execution which has unique ID. In
@@ -65,28 +104,61 @@ auto CollectFeatures(State &state, Corpus &corpus, Range &range,
                         is_input_info_v<InputInfo> &&
                         utils::range::is_range_of_v<Range, std::uint8_t> &&
                         utils::range::has_data_v<Range>> {
-  utils::type_traits::RemoveCvrT<decltype(exec_result.unique_feature_set)>
-      unique_feature_set_temp;
-  std::size_t found_unique_features_of_input_info = 0u;
-  size_t previous_updates_count = state.updated_features_count;
-  const auto size = utils::range::rangeSize(range);
-  feature::CollectFeatures(state, cov, module_offset, [&](auto f) -> void {
-    if (feature::AddFeature(state, corpus, f, static_cast<std::uint32_t>(size),
-                            state.create_info.config.shrink))
-      unique_feature_set_temp.push_back(f);
-
-    if (state.create_info.config.entropic.enabled)
-      feature::UpdateFeatureFrequency(state, exec_result, f);
+  detail::CollectFeatures(state, corpus, range, exec_result, [&](auto cb) {
+    feature::CollectFeatures(state, cov, module_offset, cb);
+  });
+}
 
-    if (state.create_info.config.reduce_inputs && !exec_result.never_reduce)
-      if (std::binary_search(exec_result.unique_feature_set.begin(),
-                             exec_result.unique_feature_set.end(), f))
-        ++found_unique_features_of_input_info;
+/**
+ * Calculate features of specified execution result, including the value
+ * profile features from the comparison log if enabled.
+ * The value profile features follow the features of the coverage. After the
+ * features are calculated, the table of recent compares is updated if
+ * use_cmp is enabled, and the comparison log is cleared for the next
+ * execution.
+ * @tparam State LibFuzzer state object type
+ * @tparam Corpus FullCorpus type to add new execution result
+ * @tparam Range Contiguous Range of std::uint8_t to pass input
+ * @tparam InputInfo Type to provide execution result
+ * @tparam Cov Range of std::uint8_t to pass coverage
+ * @param state LibFuzzer state object
+ * @param corpus FullCorpus to add new execution result
+ * @param range Input value that was passed to the executor
+ * @param exec_result Execution result that was produced by the executor
+ * @param cov Coverage retrived from the executor
+ * @param cmp_trace Comparison log and the tables made from it
+ * @param module_offset Offset value of feature. if module_offset is 3000 and
+ * cov[ 2 ] is non zero value, the feature 3002 is activated.
+ */
+template <typename State, typename Corpus, typename Range, typename InputInfo,
+          typename Cov>
+auto CollectFeatures(State &state, Corpus &corpus, Range &range,
+                     InputInfo &exec_result, Cov &cov, CmpTrace &cmp_trace,
+                     std::uint32_t module_offset)
+    -> std::enable_if_t<is_state_v<State> && is_full_corpus_v<Corpus> &&
+                        is_input_info_v<InputInfo> &&
+                        utils::range::is_range_of_v<Range, std::uint8_t> &&
+                        utils::range::has_data_v<Range>> {
+  const auto &config = state.create_info.config;
+  if (!cmp_trace.cmp_log) {
+    CollectFeatures(state, corpus, range, exec_result, cov, module_offset);
+    return;
+  }
+  const auto &map = *cmp_trace.cmp_log->GetCmpMap();
+  detail::CollectFeatures(state, corpus, range, exec_result, [&](auto cb) {
+    const std::size_t cov_size =
+        feature::CollectFeatures(state, cov, module_offset, cb);
+    if (!config.use_value_profile_mask) return;
+    const std::uint32_t first_feature =
+        (module_offset + cov_size) * (config.use_counters ? 8u : 1u);
+    cmp_trace.value_profile.Reset();
+    UpdateValueProfile(map, cmp_trace.value_profile);
+    cmp_trace.value_profile.ForEach(
+        [&](std::uint32_t index) { cb(first_feature + index); });
   });
-  exec_result.found_unique_features = found_unique_features_of_input_info;
-  exec_result.features_count =
-      state.updated_features_count - previous_updates_count;
-  exec_result.unique_feature_set = unique_feature_set_temp;
+  if (state.create_info.use_cmp)
+    UpdateTableOfRecentCompares(map, cmp_trace.torc);
+  cmp_trace.cmp_log->ResetHeaders();
 }
 
 }  // namespace fuzzuf::algorithm::libfuzzer::executor
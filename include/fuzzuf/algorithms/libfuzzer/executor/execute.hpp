@@ -83,9 +83,14 @@ auto Execute(Range &range, Output &output, Cov &cov, InputInfo &exec_result,
           cov.assign(head, std::next(head, size));
         });
   }
-  output = executor[executor_index].MoveStdOut();
-  auto err = executor[executor_index].MoveStdErr();
-  output.insert(output.end(), err.begin(), err.end());
+  executor[executor_index].GetStdOut().ShowMemoryToFunc(
+      [&](const u8 *head, u32 size) {
+        output.assign(head, std::next(head, size));
+      });
+  executor[executor_index].GetStdErr().ShowMemoryToFunc(
+      [&](const u8 *head, u32 size) {
+        output.insert(output.end(), head, std::next(head, size));
+      });
 }
 
 /**
@@ -129,9 +134,14 @@ auto Execute(Range &range, Output &output, output_files_t &files,
   for (auto &f : files_) {
     files.push_back(std::move(f.second));
   }
-  output = executor[executor_index].MoveStdOut();
-  auto err = executor[executor_index].MoveStdErr();
-  output.insert(output.end(), err.begin(), err.end());
+  executor[executor_index].GetStdOut().ShowMemoryToFunc(
+      [&](const u8 *head, u32 size) {
+        output.assign(head, std::next(head, size));
+      });
+  executor[executor_index].GetStdErr().ShowMemoryToFunc(
+      [&](const u8 *head, u32 size) {
+        output.insert(output.end(), head, std::next(head, size));
+      });
 }
 
 }  // namespace fuzzuf::algorithm::libfuzzer::executor
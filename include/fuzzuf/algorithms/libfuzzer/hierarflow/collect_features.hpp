@@ -40,8 +40,8 @@ namespace fuzzuf::algorithm::libfuzzer {
  * a feature. "Features" is a vector of feature. libFuzzer calculate weight of
  * the execution result that affects by features. If ChooseRandomSeed is using
  * non-uniform distribution, input of higher weighted execution result is
- * selected more frequentry. The node takes 5 paths for state, corpus, input,
- * execution result and coverage.
+ * selected more frequentry. The node takes 6 paths for state, corpus, input,
+ * execution result, coverage and comparison trace.
  * @tparam F Function type to define what arguments passes through this node.
  * @tparam Path Struct path to define which value to to use.
  */
@@ -86,7 +86,7 @@ namespace standard_order {
 template <typename T>
 using CollectFeaturesStdArgOrderT =
     decltype(T::state && T::corpus && T::input && T::exec_result &&
-             T::coverage);
+             T::coverage && T::cmp_trace);
 template <typename F, typename Ord>
 using CollectFeatures =
     libfuzzer::CollectFeatures<F, CollectFeaturesStdArgOrderT<Ord>>;
@@ -98,6 +98,26 @@ template <typename F, typename Ord>
 using DynamicDict = libfuzzer::DynamicDict<F, DynamicDictStdArgOrderT<Ord>>;
 }  // namespace standard_order
 
+/**
+ * @class CmpDict
+ * @brief Insert or Overwrite a word made from the table of recent compares to
+ * the input specified by the Path. This node takes 6 paths, 4 for standard
+ * mutator parameters( rng, input, max length and mutation history ), 1 for
+ * dictionary history and 1 for comparison trace.
+ * @tparam F Function type to define what arguments passes through this node.
+ * @tparam Path Struct path to define which value to to use.
+ */
+FUZZUF_ALGORITHM_LIBFUZZER_HIERARFLOW_SIMPLE_FUNCTION(CmpDict,
+                                                      mutator::CmpTable)
+namespace standard_order {
+template <typename T>
+using CmpDictStdArgOrderT =
+    decltype(T::rng && T::input && T::max_length && T::mutation_history &&
+             T::dict_history && T::cmp_trace);
+template <typename F, typename Ord>
+using CmpDict = libfuzzer::CmpDict<F, CmpDictStdArgOrderT<Ord>>;
+}  // namespace standard_order
+
 /**
  * @class UpdateDictionary
  * @brief Add dictionary history entries to the dictionary specified by the
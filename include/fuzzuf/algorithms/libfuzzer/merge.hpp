@@ -0,0 +1,111 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file merge.hpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#ifndef FUZZUF_INCLUDE_ALGORITHM_LIBFUZZER_MERGE_HPP
+#define FUZZUF_INCLUDE_ALGORITHM_LIBFUZZER_MERGE_HPP
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "fuzzuf/utils/filesystem.hpp"
+
+namespace fuzzuf::algorithm::libfuzzer {
+
+/**
+ * @struct MergeInput
+ * @brief An input to be merged, and the features found by executing it
+ */
+struct MergeInput {
+  fs::path path;
+  std::size_t size = 0u;
+  // True if the input has been executed
+  bool done = false;
+  // Sorted unique features. Empty if the execution failed.
+  std::vector<std::uint32_t> features;
+};
+
+/**
+ * List the regular files under the directories in the order of the path
+ * @param dirs Directories. The first one is the corpus to merge into.
+ * @param first_corpus_size Receives the number of the files in the first
+ * directory, which come first in the list.
+ * @return Inputs, none of which is done
+ */
+auto ListMergeInputs(const std::vector<std::string> &dirs,
+                     std::size_t &first_corpus_size)
+    -> std::vector<MergeInput>;
+
+/**
+ * Write the header of the merge control file
+ * The format follows the one of the original libFuzzer, without COV lines.
+ *   <number of inputs>
+ *   <number of inputs in the first corpus>
+ *   <path of each input, one per line>
+ *   STARTED <index> <size>      ( before executing the input )
+ *   FT <index> <features...>    ( after executing the input )
+ */
+void WriteMergeControlHeader(std::ostream &dest,
+                             const std::vector<MergeInput> &inputs,
+                             std::size_t first_corpus_size);
+
+/**
+ * Load the results recorded in the merge control file to resume the merge
+ * An input with STARTED but without FT is executed again, since it was
+ * running when the merge was stopped. If it was started twice, it is
+ * considered to have stopped the merge, and skipped.
+ * @return false if the file is not for the inputs. inputs are not modified
+ * in that case.
+ */
+bool LoadMergeControlFile(std::istream &src, std::vector<MergeInput> &inputs,
+                          std::size_t first_corpus_size);
+
+/**
+ * Execute the inputs which are not done yet on worker_count threads, and
+ * record the features in the control file
+ * @param run Called with the index of the worker, the input value and the
+ * vector to receive the features. Returns false if the execution failed.
+ * @param stop Stops the merge if it becomes true
+ * @return Number of the inputs executed
+ */
+std::size_t CollectMergeFeatures(
+    std::vector<MergeInput> &inputs, std::size_t worker_count,
+    const std::function<bool(std::size_t, const std::vector<std::uint8_t> &,
+                             std::vector<std::uint32_t> &)> &run,
+    std::ostream &control, const std::atomic<bool> &stop);
+
+/**
+ * Select the inputs to add to the first corpus by greedy set cover
+ * The features of the first corpus are considered covered. Then the input
+ * covering the most features not covered yet is selected, preferring smaller
+ * inputs, until no input adds a feature.
+ * @return Indices of the selected inputs, in the selected order
+ */
+auto SelectMergeInputs(const std::vector<MergeInput> &inputs,
+                       std::size_t first_corpus_size)
+    -> std::vector<std::size_t>;
+
+}  // namespace fuzzuf::algorithm::libfuzzer
+
+#endif
@@ -21,10 +21,14 @@
  */
 #ifndef FUZZUF_INCLUDE_ALGORITHM_LIBFUZZER_MUTATION_DICTIONARY_HPP
 #define FUZZUF_INCLUDE_ALGORITHM_LIBFUZZER_MUTATION_DICTIONARY_HPP
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <iterator>
 #include <type_traits>
 
+#include "fuzzuf/algorithms/libfuzzer/cmp_trace.hpp"
+#include "fuzzuf/algorithms/libfuzzer/dictionary.hpp"
 #include "fuzzuf/algorithms/libfuzzer/mutation/utils.hpp"
 #include "fuzzuf/algorithms/libfuzzer/mutation_history.hpp"
 #include "fuzzuf/algorithms/libfuzzer/random.hpp"
@@ -64,6 +68,88 @@ auto Dictionary(RNG &rng, Range &data, std::size_t max_size,
   return detail::AddWordFromDictionary(rng, dict, data, max_size, dict_entry);
 }
 
+/**
+ * Make a word from a comparison in the table of recent compares, and insert
+ * it at the random position of data or overwrite data with it. If data
+ * contains one operand of the comparison, the word is the other operand and
+ * is likely to be written where the former is found.
+ * Integer operands are byte swapped or incremented or decremented at random,
+ * since the target may compare them after such conversions.
+ *
+ * Corresponding code of original libFuzzer implementation
+ * https://github.com/llvm/llvm-project/blob/llvmorg-12.0.1/compiler-rt/lib/fuzzer/FuzzerMutate.cpp#L190
+ * and
+ * https://github.com/llvm/llvm-project/blob/llvmorg-12.0.1/compiler-rt/lib/fuzzer/FuzzerMutate.cpp#L230
+ *
+ * @tparam RNG Type of random number generator
+ * @tparam Range Container of the value
+ * @param rng Random number generator
+ * @param data Value to modify
+ * @param max_size Max length of value
+ * @param history Mutation history
+ * @param dict_entry History of selected words. The word is appended so that
+ * it is added to the persistent auto dictionary if the input is valuable.
+ * @param cmp_trace Comparison trace that has the table of recent compares
+ * @return length of post modification value
+ */
+template <typename RNG, typename Range>
+auto CmpTable(RNG &rng, Range &data, std::size_t max_size,
+              MutationHistory &history,
+              dictionary::DictionaryHistory<dictionary::StaticDictionary>
+                  &dict_entry,
+              CmpTrace &cmp_trace)
+    -> std::enable_if_t<utils::range::is_range_of_v<Range, std::uint8_t>,
+                        std::size_t> {
+  static const char name[] = "CMP";
+  history.push_back(MutationHistoryEntry{name});
+  const auto &compare =
+      cmp_trace.torc.Get(random_value(rng, TableOfRecentCompares::SIZE));
+  if (compare.arg1.empty()) return 0u;
+
+  const bool handle_first = random_value<bool>(rng);
+  auto existing = handle_first ? compare.arg1 : compare.arg2;
+  auto desired = handle_first ? compare.arg2 : compare.arg1;
+  if (compare.integer) {
+    if (random_value<bool>(rng)) {
+      std::reverse(existing.begin(), existing.end());
+      std::reverse(desired.begin(), desired.end());
+    }
+    std::uint64_t value = 0u;
+    for (auto iter = desired.rbegin(); iter != desired.rend(); ++iter)
+      value = (value << 8) | *iter;
+    value += std::uint64_t(random_value(rng, 3u)) - 1u;
+    for (auto &byte : desired) {
+      byte = value & 0xFFu;
+      value >>= 8;
+    }
+  }
+
+  constexpr std::size_t max_positions = 8u;
+  std::array<std::size_t, max_positions> positions;
+  std::size_t positions_count = 0u;
+  for (auto iter = data.begin(); positions_count != max_positions; ++iter) {
+    iter = std::search(iter, data.end(), existing.begin(), existing.end());
+    if (iter == data.end()) break;
+    positions[positions_count++] = std::distance(data.begin(), iter);
+  }
+
+  const dictionary::StaticDictionaryEntry::word_t word(desired.begin(),
+                                                       desired.end());
+  auto entry = positions_count
+                   ? dictionary::StaticDictionaryEntry(
+                         word, positions[random_value(rng, positions_count)])
+                   : dictionary::StaticDictionaryEntry(word);
+  const std::size_t final_size =
+      detail::ApplyDictionaryEntry(rng, data, entry, max_size);
+  if (!final_size) return 0u;
+  auto &stored = cmp_trace.dictionary_entries
+                     [cmp_trace.dictionary_entries_index++ %
+                      CmpTrace::DICTIONARY_ENTRIES_SIZE];
+  stored = entry;
+  dict_entry.push_back(&stored);
+  return final_size;
+}
+
 /**
  * Append selected words history to specified dictionary
  * This operation is needed to update persistent auto dict.
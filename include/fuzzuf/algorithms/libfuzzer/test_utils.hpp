@@ -26,6 +26,7 @@
 #include <cstdint>
 #include <vector>
 
+#include "fuzzuf/algorithms/libfuzzer/cmp_trace.hpp"
 #include "fuzzuf/algorithms/libfuzzer/dictionary.hpp"
 #include "fuzzuf/algorithms/libfuzzer/hierarflow.hpp"
 #include "fuzzuf/algorithms/libfuzzer/mutation_history.hpp"
@@ -83,6 +84,7 @@ struct Variables {
   std::size_t executor_index = 0u;
   std::vector<fuzzuf::utils::mapped_file_t> symcc_out;
   unsigned int stuck_count = 0u;
+  CmpTrace cmp_trace;
 };
 
 // Function type that has arguments required to run all functionalities.
@@ -140,6 +142,7 @@ struct Order {
   constexpr static auto symcc_freq =
       create_info /
       sp::mem<FuzzerCreateInfo, unsigned int, &FuzzerCreateInfo::symcc_freq>;
+  constexpr static auto cmp_trace = arg0 / sp::mem<V, CmpTrace, &V::cmp_trace>;
 };
 using MutationPaths = decltype(Order::rng && Order::input &&
                                Order::max_length && Order::mutation_history);
@@ -52,4 +52,13 @@ constexpr double GetLimitTimeBound(void) {
 
 }  // namespace fuzzuf::algorithm::mopt::option
 
+namespace fuzzuf::algorithm::afl::option {
+
+template <>
+constexpr const char* GetCheckpointAlgorithm<mopt::option::MOptTag>(void) {
+  return "mopt";
+}
+
+}  // namespace fuzzuf::algorithm::afl::option
+
 #endif
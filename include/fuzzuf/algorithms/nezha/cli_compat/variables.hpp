@@ -38,6 +38,7 @@ struct Variables {
   known_status_t known_status;
   outputs_t outputs;
   known_outputs_t known_outputs;
+  target_results_t target_results;
 };
 
 namespace sp = utils::struct_path;
@@ -63,6 +64,8 @@ struct Order
   constexpr static auto outputs = ne / sp::mem<V, outputs_t, &V::outputs>;
   constexpr static auto known_outputs =
       ne / sp::mem<V, known_outputs_t, &V::known_outputs>;
+  constexpr static auto target_results =
+      ne / sp::mem<V, target_results_t, &V::target_results>;
   constexpr static auto single_status =
       exec_result / sp::mem<libfuzzer::InputInfo, feedback::PUTExitReasonType,
                             &libfuzzer::InputInfo::status>;
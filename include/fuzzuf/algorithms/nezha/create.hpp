@@ -31,9 +31,23 @@
 
 namespace fuzzuf::algorithm::nezha {
 
+/**
+ * Return true if the targets are run concurrently on each input. The
+ * executors without fork server time out executions with a process-wide
+ * signal, so that they are always run one by one.
+ * @param create_info Parameters on building the fuzzer
+ * @return true if the targets are run concurrently
+ */
+inline bool RunTargetsInParallel(const FuzzerCreateInfo &create_info) {
+  return create_info.parallel_targets && create_info.forksrv &&
+         create_info.target_count > 1u;
+}
+
 /**
  * Build following flow using HierarFlow
- * * Execute specified target and retrive execution result
+ * * Execute specified target and retrive execution result. If the targets
+ * are run concurrently, the execution result is taken from the results of
+ * ExecuteTargets instead.
  * * Calculate features using execution result
  * * Add to corpus if the execution result is valuable
  * * Append value that represent whether the execution result was added to
@@ -69,7 +83,10 @@ auto CreateRunSingleTarget(const FuzzerCreateInfo &create_info, bool use_output,
   auto create_local_coverage =
       hf::CreateNode<lf::Clear<F, decltype(Ord::coverage)>>();
 
-  auto execute = hf::CreateNode<lf::standard_order::Execute<F, Ord>>();
+  auto execute =
+      RunTargetsInParallel(create_info)
+          ? hf::CreateNode<standard_order::LoadTargetResult<F, Ord>>()
+          : hf::CreateNode<lf::standard_order::Execute<F, Ord>>();
   auto collect_features =
       hf::CreateNode<standard_order::CollectFeatures<F, Ord>>(
           i * (create_info.use_afl_coverage ? create_info.afl_shm_size
@@ -115,6 +132,7 @@ auto CreateRunSingleTarget(const FuzzerCreateInfo &create_info, bool use_output,
 
 /**
  * Build following flow using HierarFlow
+ * * If the targets are run concurrently, run all targets and wait for them
  * * For each target executables, run everything defined at
  * CreateRunSingleTarget
  * @tparam F Input function type of HierarFlow node
@@ -146,6 +164,13 @@ auto CreateRunTargets(const FuzzerCreateInfo &create_info, bool use_output,
 
   auto run = hf::CreateNode<lf::Proxy<F>>();
 
+  if (RunTargetsInParallel(create_info)) {
+    // Features, traces and statuses are gathered after all targets have
+    // finished, in the same order as running the targets one by one
+    run << hf::CreateNode<standard_order::ExecuteTargets<F, Ord>>(
+        create_info.target_offset, create_info.target_count);
+  }
+
   for (std::size_t i = create_info.target_offset;
        i != create_info.target_offset + create_info.target_count; ++i) {
     auto single = CreateRunSingleTarget<F, Ord>(
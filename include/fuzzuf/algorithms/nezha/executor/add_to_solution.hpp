@@ -57,8 +57,8 @@ auto AddToSolution(Range &range, libfuzzer::InputInfo &exec_result,
     -> std::enable_if_t<utils::range::is_range_of_v<Range, std::uint8_t> &&
                             utils::range::has_data_v<Range>,
                         bool> {
-  const auto new_outputs = outputs_hash.emplace(outputs).second;
-  const auto new_coverage = trace_hash.emplace(trace).second;
+  const auto new_outputs = outputs_hash.insert(outputs).second;
+  const auto new_coverage = trace_hash.insert(trace).second;
   if (new_outputs || new_coverage) {
     std::string name = "diff_";
     std::unordered_set<std::uint64_t> unique;
@@ -105,8 +105,8 @@ auto AddToSolution(Range &range, libfuzzer::InputInfo &exec_result,
     -> std::enable_if_t<utils::range::is_range_of_v<Range, std::uint8_t> &&
                             utils::range::has_data_v<Range>,
                         bool> {
-  const auto new_status = status_hash.emplace(status).second;
-  const auto new_coverage = trace_hash.emplace(trace).second;
+  const auto new_status = status_hash.insert(status).second;
+  const auto new_coverage = trace_hash.insert(trace).second;
   if (new_status || new_coverage) {
     std::string name = "diff_";
     bool has_zero = false;
@@ -0,0 +1,148 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file execute_targets.hpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#ifndef FUZZUF_INCLUDE_ALGORITHM_NEZHA_EXECUTOR_EXECUTE_TARGETS_HPP
+#define FUZZUF_INCLUDE_ALGORITHM_NEZHA_EXECUTOR_EXECUTE_TARGETS_HPP
+#include <chrono>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "fuzzuf/algorithms/libfuzzer/state/input_info.hpp"
+#include "fuzzuf/algorithms/nezha/parallel_runner.hpp"
+#include "fuzzuf/algorithms/nezha/state.hpp"
+#include "fuzzuf/utils/common.hpp"
+#include "fuzzuf/utils/range_traits.hpp"
+
+namespace fuzzuf::algorithm::nezha::executor {
+
+/**
+ * Run one target with input, and keep coverage, outputs and execution result
+ * to result.
+ *
+ * @tparam Range Contiguous Range of std::uint8_t to pass input
+ * @tparam Executor Executor type
+ * @param range Input value that was passed to the executor
+ * @param result Reference to the value to receive the execution result
+ * @param executor Executor to run target
+ * @param afl_coverage If True, coverage is retrived using GetAFLFeedback().
+ * Otherwise coverage is retrived using GetBBFeedback().
+ */
+template <typename Range, typename Executor>
+void ExecuteTarget(Range &range, TargetResult &result, Executor &executor,
+                   bool afl_coverage) {
+  const auto begin = std::chrono::high_resolution_clock::now();
+  executor.Run(range.data(), fuzzuf::utils::range::rangeSize(range));
+  const auto end = std::chrono::high_resolution_clock::now();
+  result.time_of_unit =
+      std::chrono::duration_cast<std::chrono::microseconds>(end - begin);
+  result.status = executor.GetExitStatusFeedback().exit_reason;
+  result.signal = executor.GetExitStatusFeedback().signal;
+  auto &cov = result.coverage;
+  if (afl_coverage) {
+    executor.GetAFLFeedback().ShowMemoryToFunc([&](const u8 *head, u32 size) {
+      cov.assign(head, std::next(head, size));
+    });
+  } else {
+    executor.GetBBFeedback().ShowMemoryToFunc([&](const u8 *head, u32 size) {
+      cov.assign(head, std::next(head, size));
+    });
+  }
+  // Copy the outputs into the existing buffer, which is reused across
+  // executions
+  executor.GetStdOut().ShowMemoryToFunc([&](const u8 *head, u32 size) {
+    result.output.assign(head, std::next(head, size));
+  });
+  executor.GetStdErr().ShowMemoryToFunc([&](const u8 *head, u32 size) {
+    result.output.insert(result.output.end(), head, std::next(head, size));
+  });
+}
+
+/**
+ * Run target_count targets from target_offset with same input concurrently,
+ * and wait for all of them. The execution result of each target is stored
+ * to the element of results at the index of the executor.
+ *
+ * @tparam Range Contiguous Range of std::uint8_t to pass input
+ * @tparam Executors Container of executors
+ * @param range Input value that was passed to the executors
+ * @param results Reference to the values to receive the execution results
+ * @param executors Executors to run targets. Each executor must not share
+ * anything such as the file to write input to with the others.
+ * @param afl_coverage If True, coverage is retrived using GetAFLFeedback().
+ * Otherwise coverage is retrived using GetBBFeedback().
+ * @param runner Threads to run the targets
+ * @param target_offset Index of the first executor to run
+ * @param target_count Number of executors to run
+ */
+template <typename Range, typename Executors>
+auto ExecuteTargets(Range &range, target_results_t &results,
+                    Executors &executors, bool afl_coverage,
+                    ParallelRunner &runner, std::size_t target_offset,
+                    std::size_t target_count)
+    -> std::enable_if_t<utils::range::is_range_of_v<Range, std::uint8_t> &&
+                        utils::range::has_data_v<Range>> {
+  if (results.size() < target_offset + target_count)
+    results.resize(target_offset + target_count);
+  runner.Run(target_count, [&](std::size_t i) {
+    ExecuteTarget(range, results[target_offset + i],
+                  executors[target_offset + i], afl_coverage);
+  });
+}
+
+/**
+ * Move the execution result of the target which was kept by ExecuteTargets to
+ * output, coverage and exec_result, as if the target was run by
+ * libfuzzer::executor::Execute.
+ *
+ * @tparam Output Container of std::uint8_t to receive standard output
+ * @tparam Cov Container of std::uint8_t to receive coverage
+ * @tparam InputInfo Type of execution result
+ * @param output Reference to container to receive standard output
+ * @param cov Reference to container to receive coverage
+ * @param exec_result Reference to execution result to output detail of the
+ * execution
+ * @param results Execution results kept by ExecuteTargets
+ * @param executor_index Index of the executor that ran the target
+ */
+template <typename Output, typename Cov, typename InputInfo>
+auto LoadTargetResult(Output &output, Cov &cov, InputInfo &exec_result,
+                      target_results_t &results, std::size_t executor_index)
+    -> std::enable_if_t<libfuzzer::is_input_info_v<InputInfo> &&
+                        utils::range::is_range_of_v<Output, std::uint8_t> &&
+                        utils::range::is_range_of_v<Cov, std::uint8_t>> {
+  auto &result = results[executor_index];
+  exec_result.enabled = true;
+  exec_result.time_of_unit = result.time_of_unit;
+  exec_result.status = result.status;
+  exec_result.signal = result.signal;
+  exec_result.added_to_corpus = false;
+  exec_result.found_unique_features = 0u;
+  // Swap rather than move, so that the buffers are reused by the next
+  // execution
+  std::swap(cov, result.coverage);
+  std::swap(output, result.output);
+}
+
+}  // namespace fuzzuf::algorithm::nezha::executor
+
+#endif
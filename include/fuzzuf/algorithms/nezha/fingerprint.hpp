@@ -0,0 +1,158 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file fingerprint.hpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#ifndef FUZZUF_INCLUDE_ALGORITHM_NEZHA_FINGERPRINT_HPP
+#define FUZZUF_INCLUDE_ALGORITHM_NEZHA_FINGERPRINT_HPP
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace fuzzuf::algorithm::nezha {
+
+/**
+ * @class Fingerprint
+ * @brief 128bit hash value that represents a tuple of execution results
+ */
+struct Fingerprint {
+  std::uint64_t low = 0u;
+  std::uint64_t high = 0u;
+  bool operator==(const Fingerprint &r) const {
+    return low == r.low && high == r.high;
+  }
+  bool operator!=(const Fingerprint &r) const { return !(*this == r); }
+};
+
+/**
+ * @class fingerprint_hash
+ * @brief callable object to use Fingerprint as a key of unordered containers
+ */
+struct fingerprint_hash {
+  std::size_t operator()(const Fingerprint &value) const {
+    return std::size_t(value.low);
+  }
+};
+
+/**
+ * Calculate XXH3 128bit hash value of the bytes
+ * @param data Pointer to the bytes
+ * @param size Length of the bytes
+ * @return Fingerprint of the bytes
+ */
+Fingerprint MakeFingerprint(const void *data, std::size_t size);
+
+/**
+ * Calculate fingerprint of the vector of bool. The values are packed into
+ * bits, and the length is hashed too, so that the vectors of different length
+ * have different fingerprints.
+ * @param value Vector of bool
+ * @return Fingerprint of the vector
+ */
+Fingerprint MakeFingerprint(const std::vector<bool> &value);
+
+/**
+ * Calculate fingerprint of the vector of trivially copyable values from the
+ * bytes of the values
+ * @tparam T Type of the values
+ * @param value Vector of the values
+ * @return Fingerprint of the vector
+ */
+template <typename T>
+auto MakeFingerprint(const std::vector<T> &value)
+    -> std::enable_if_t<std::is_trivially_copyable_v<T>, Fingerprint> {
+  return MakeFingerprint(value.data(), value.size() * sizeof(T));
+}
+
+/**
+ * @class FingerprintSet
+ * @brief Set of the tuples of execution results, which only keeps the
+ * fingerprints of the tuples.
+ * @details Each tuple costs 16 bytes regardless of its length, and is hashed
+ * only once on insertion. A novel tuple whose fingerprint collides with a
+ * known one is treated as known. If verify is true, the tuples are kept too
+ * and compared on the same fingerprint, so that the result is exact at the
+ * cost of the memory.
+ * @tparam T Type of the tuple
+ */
+template <typename T>
+class FingerprintSet {
+ public:
+  explicit FingerprintSet(bool verify_ = false) : verify(verify_) {}
+
+  /**
+   * Insert the tuple to the set
+   * @param value Tuple
+   * @return Pair of the fingerprint of the tuple and a bool which is true if
+   * the tuple was not in the set
+   */
+  std::pair<Fingerprint, bool> insert(const T &value) {
+    const auto fingerprint = MakeFingerprint(value);
+    if (!verify) {
+      const bool inserted = fingerprints.insert(fingerprint).second;
+      if (inserted) ++count;
+      return std::make_pair(fingerprint, inserted);
+    }
+    auto &candidates = values[fingerprint];
+    if (std::find(candidates.begin(), candidates.end(), value) !=
+        candidates.end())
+      return std::make_pair(fingerprint, false);
+    candidates.push_back(value);
+    if (candidates.size() != 1u) ++collision_count;
+    ++count;
+    return std::make_pair(fingerprint, true);
+  }
+
+  /**
+   * Return true if the tuple is in the set
+   * @param value Tuple
+   * @return true if the tuple is in the set
+   */
+  bool contains(const T &value) const {
+    const auto fingerprint = MakeFingerprint(value);
+    if (!verify) return fingerprints.find(fingerprint) != fingerprints.end();
+    const auto found = values.find(fingerprint);
+    return found != values.end() &&
+           std::find(found->second.begin(), found->second.end(), value) !=
+               found->second.end();
+  }
+
+  std::size_t size() const { return count; }
+  bool empty() const { return count == 0u; }
+  bool verifying() const { return verify; }
+  // Number of the novel tuples which had a fingerprint of a known tuple.
+  // Always 0 unless verify is true.
+  std::size_t collisions() const { return collision_count; }
+
+ private:
+  bool verify;
+  std::size_t count = 0u;
+  std::size_t collision_count = 0u;
+  std::unordered_set<Fingerprint, fingerprint_hash> fingerprints;
+  std::unordered_map<Fingerprint, std::vector<T>, fingerprint_hash> values;
+};
+
+}  // namespace fuzzuf::algorithm::nezha
+
+#endif
@@ -23,5 +23,6 @@
 #define FUZZUF_INCLUDE_ALGORITHM_NEZHA_HIERARFLOW_HPP
 #include "fuzzuf/algorithms/nezha/hierarflow/add_to_solution.hpp"
 #include "fuzzuf/algorithms/nezha/hierarflow/collect_features.hpp"
+#include "fuzzuf/algorithms/nezha/hierarflow/execute_targets.hpp"
 #include "fuzzuf/algorithms/nezha/hierarflow/gather.hpp"
 #endif
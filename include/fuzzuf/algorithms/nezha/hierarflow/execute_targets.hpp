@@ -0,0 +1,117 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file execute_targets.hpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#ifndef FUZZUF_INCLUDE_ALGORITHM_NEZHA_HIERARFLOW_EXECUTE_TARGETS_HPP
+#define FUZZUF_INCLUDE_ALGORITHM_NEZHA_HIERARFLOW_EXECUTE_TARGETS_HPP
+#include <cstddef>
+#include <memory>
+
+#include "fuzzuf/algorithms/libfuzzer/hierarflow/simple_function.hpp"
+#include "fuzzuf/algorithms/libfuzzer/hierarflow/standard_end.hpp"
+#include "fuzzuf/algorithms/libfuzzer/hierarflow/standard_typedef.hpp"
+#include "fuzzuf/algorithms/libfuzzer/hierarflow/trace.hpp"
+#include "fuzzuf/algorithms/nezha/executor/execute_targets.hpp"
+#include "fuzzuf/algorithms/nezha/parallel_runner.hpp"
+#include "fuzzuf/hierarflow/hierarflow_routine.hpp"
+
+namespace fuzzuf::algorithm::nezha {
+
+/**
+ * @class ExecuteTargets
+ * @brief Run all targets with input specified by the Path concurrently, and
+ * store the execution result of each target to the value specified by the
+ * Path. The node takes 4 paths for input, execution results, executors and
+ * the flag to use AFL coverage.
+ * @tparam F Function type to define what arguments passes through this node.
+ * @tparam Path Struct path to define which value to to use.
+ */
+template <typename F, typename Path>
+struct ExecuteTargets {};
+template <typename R, typename... Args, typename Path>
+struct ExecuteTargets<R(Args...), Path>
+    : public hierarflow::HierarFlowRoutine<R(Args...), R(Args...)> {
+ public:
+  FUZZUF_ALGORITHM_LIBFUZZER_HIERARFLOW_STANDARD_TYPEDEFS
+  /**
+   * Constructor
+   * @param target_offset_ Index of the first executor to run
+   * @param target_count_ Number of executors to run
+   */
+  ExecuteTargets(std::size_t target_offset_, std::size_t target_count_)
+      : runner(std::make_shared<ParallelRunner>(
+            target_count_ ? target_count_ - 1u : 0u)),
+        target_offset(target_offset_),
+        target_count(target_count_) {}
+  /**
+   * This callable is called on HierarFlow execution
+   * @param args Arguments
+   * @return direction of next node
+   */
+  callee_ref_t operator()(Args... args) {
+    FUZZUF_ALGORITHM_LIBFUZZER_HIERARFLOW_CHECKPOINT("ExecuteTargets", enter)
+    Path()(
+        [&](auto &&...sorted) {
+          executor::ExecuteTargets(sorted..., *runner, target_offset,
+                                   target_count);
+        },
+        std::forward<Args>(args)...);
+    FUZZUF_ALGORITHM_LIBFUZZER_HIERARFLOW_STANDARD_END(ExecuteTargets)
+  }
+
+ private:
+  std::shared_ptr<ParallelRunner> runner;
+  std::size_t target_offset;
+  std::size_t target_count;
+};
+
+/**
+ * @class LoadTargetResult
+ * @brief Move the execution result of the target specified by the Path, which
+ * was stored by ExecuteTargets, to the values specified by the Path. The node
+ * takes 5 paths for output, coverage, execution result, execution results of
+ * all targets and executor index.
+ * @tparam F Function type to define what arguments passes through this node.
+ * @tparam Path Struct path to define which value to to use.
+ */
+FUZZUF_ALGORITHM_LIBFUZZER_HIERARFLOW_SIMPLE_FUNCTION(
+    LoadTargetResult, executor::LoadTargetResult)
+
+namespace standard_order {
+template <typename T>
+using ExecuteTargetsStdArgOrderT =
+    decltype(T::input && T::target_results && T::executors &&
+             T::use_afl_coverage);
+template <typename F, typename Ord>
+using ExecuteTargets =
+    nezha::ExecuteTargets<F, ExecuteTargetsStdArgOrderT<Ord>>;
+
+template <typename T>
+using LoadTargetResultStdArgOrderT =
+    decltype(T::output && T::coverage && T::exec_result && T::target_results &&
+             T::executor_index);
+template <typename F, typename Ord>
+using LoadTargetResult =
+    nezha::LoadTargetResult<F, LoadTargetResultStdArgOrderT<Ord>>;
+}  // namespace standard_order
+
+}  // namespace fuzzuf::algorithm::nezha
+
+#endif
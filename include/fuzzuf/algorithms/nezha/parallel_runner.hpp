@@ -0,0 +1,77 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file parallel_runner.hpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#ifndef FUZZUF_INCLUDE_ALGORITHM_NEZHA_PARALLEL_RUNNER_HPP
+#define FUZZUF_INCLUDE_ALGORITHM_NEZHA_PARALLEL_RUNNER_HPP
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fuzzuf::algorithm::nezha {
+
+/**
+ * @class ParallelRunner
+ * @brief Runs a batch of independent jobs on a fixed set of threads and waits
+ * for all of them, so that Nezha can run every target on the same input at
+ * once.
+ * @details The threads are kept across batches, since a batch is run for
+ * every input. The thread calling Run() takes jobs too, so that n jobs are
+ * run in parallel by n - 1 threads.
+ */
+class ParallelRunner {
+ public:
+  using Job = std::function<void(std::size_t)>;
+
+  explicit ParallelRunner(std::size_t thread_count);
+  ~ParallelRunner();
+
+  ParallelRunner(const ParallelRunner &) = delete;
+  ParallelRunner &operator=(const ParallelRunner &) = delete;
+
+  // Runs job(i) for each i in [0, n), and returns after all of them have
+  // finished. Rethrows the first exception thrown by the jobs.
+  void Run(std::size_t n, const Job &job);
+
+ private:
+  void Work();
+  // Runs the jobs not taken yet until none is left. lock must be held.
+  void TakeJobs(std::unique_lock<std::mutex> &lock);
+
+  std::vector<std::thread> workers;
+
+  std::mutex mutex;
+  std::condition_variable job_posted;
+  std::condition_variable job_done;
+  const Job *job = nullptr;
+  std::size_t job_count = 0;
+  std::size_t next_job = 0;
+  std::size_t done_count = 0;
+  bool stopping = false;
+  std::exception_ptr error;
+};
+
+}  // namespace fuzzuf::algorithm::nezha
+
+#endif
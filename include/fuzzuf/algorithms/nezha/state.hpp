@@ -22,8 +22,13 @@
 #ifndef FUZZUF_INCLUDE_ALGORITHM_NEZHA_STATE_HPP
 #define FUZZUF_INCLUDE_ALGORITHM_NEZHA_STATE_HPP
 #include <boost/functional/hash.hpp>
+#include <chrono>
+#include <cstdint>
 #include <unordered_set>
+#include <vector>
 
+#include "fuzzuf/algorithms/libfuzzer/state/common_types.hpp"
+#include "fuzzuf/algorithms/nezha/fingerprint.hpp"
 #include "fuzzuf/feedback/put_exit_reason_type.hpp"
 #include "fuzzuf/utils/range_traits.hpp"
 
@@ -69,21 +74,35 @@ struct output_hash {
 // Vector to store bools which indicate the execution result of each targets had
 // been added to corpus or not
 using trace_t = std::vector<bool>;
-// unordered set to check if a trace_t value is novel
-using known_traces_t =
-    std::unordered_set<trace_t, output_hash, output_equal_to>;
+// set to check if a trace_t value is novel
+using known_traces_t = FingerprintSet<trace_t>;
 
 // Vector to store status code of each execution
 using status_t = std::vector<feedback::PUTExitReasonType>;
-// unordered set to check if a status_t value is novel
-using known_status_t =
-    std::unordered_set<status_t, output_hash, output_equal_to>;
+// set to check if a status_t value is novel
+using known_status_t = FingerprintSet<status_t>;
 
 // Vector to store hash value of standard output produced by each target
 using outputs_t = std::vector<std::size_t>;
-// unordered set to check if a outputs_t value is novel
-using known_outputs_t =
-    std::unordered_set<outputs_t, output_hash, output_equal_to>;
+// set to check if a outputs_t value is novel
+using known_outputs_t = FingerprintSet<outputs_t>;
+
+/**
+ * @class TargetResult
+ * @brief Execution result of one target, kept until the results of all
+ * targets that ran on the same input concurrently are examined one by one
+ */
+struct TargetResult {
+  libfuzzer::output_t output;
+  libfuzzer::coverage_t coverage;
+  feedback::PUTExitReasonType status = feedback::PUTExitReasonType::FAULT_NONE;
+  unsigned int signal = 0;
+  std::chrono::microseconds time_of_unit{0};
+};
+
+// Vector to store execution result of each target. The index is same as the
+// index of the executor.
+using target_results_t = std::vector<TargetResult>;
 
 }  // namespace fuzzuf::algorithm::nezha
 
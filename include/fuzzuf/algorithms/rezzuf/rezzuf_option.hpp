@@ -34,6 +34,11 @@ constexpr u32 GetHavocStackPow2<rezzuf::option::RezzufTag>(void) {
   return 6;
 }
 
+template <>
+constexpr const char* GetCheckpointAlgorithm<rezzuf::option::RezzufTag>(void) {
+  return "rezzuf";
+}
+
 }  // namespace fuzzuf::algorithm::afl::option
 
 #endif
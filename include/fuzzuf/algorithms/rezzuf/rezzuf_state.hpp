@@ -22,6 +22,7 @@
 #include <memory>
 
 #include "fuzzuf/algorithms/afl/afl_state.hpp"
+#include "fuzzuf/algorithms/aflplusplus/aflplusplus_util.hpp"
 #include "fuzzuf/algorithms/rezzuf/rezzuf_setting.hpp"
 #include "fuzzuf/algorithms/rezzuf/rezzuf_testcase.hpp"
 #include "fuzzuf/executor/afl_executor_interface.hpp"
@@ -32,8 +33,6 @@
 
 namespace fuzzuf::algorithm::rezzuf {
 
-using fuzzuf::utils::random::WalkerDiscreteDistribution;
-
 struct RezzufState : public afl::AFLStateTemplate<RezzufTestcase> {
   explicit RezzufState(
       std::shared_ptr<const RezzufSetting> setting,
@@ -51,12 +50,12 @@ struct RezzufState : public afl::AFLStateTemplate<RezzufTestcase> {
                          feedback::ExitStatusFeedback &exit_status) override;
   u32 DoCalcScore(RezzufTestcase &testcase) override;
   void ShowStats(void) override;
+  void OnTestcaseChanged(RezzufTestcase &testcase) override;
 
   std::shared_ptr<const RezzufSetting> setting;
   std::shared_ptr<u32[]> n_fuzz;
 
-  u32 prev_queued_items;
-  std::unique_ptr<WalkerDiscreteDistribution<u32>> alias_probability;
+  aflplusplus::util::SeedWeights seed_weights;
 };
 
 }  // namespace fuzzuf::algorithm::rezzuf
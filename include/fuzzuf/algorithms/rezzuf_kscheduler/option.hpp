@@ -95,6 +95,11 @@ constexpr bool EnableSequentialID<RezzufKSchedulerTag>(void) {
   return true;
 }
 
+template <>
+constexpr const char* GetCheckpointAlgorithm<RezzufKSchedulerTag>(void) {
+  return "rezzuf_kscheduler";
+}
+
 
 
 }  // namespace fuzzuf::algorithm::afl::option
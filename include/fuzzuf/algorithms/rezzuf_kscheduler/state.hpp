@@ -23,6 +23,7 @@
 
 #include "fuzzuf/utils/random.hpp"
 #include "fuzzuf/algorithms/afl/afl_state.hpp"
+#include "fuzzuf/algorithms/aflplusplus/aflplusplus_util.hpp"
 #include "fuzzuf/algorithms/rezzuf_kscheduler/option.hpp"
 #include "fuzzuf/algorithms/rezzuf_kscheduler/testcase.hpp"
 #include "fuzzuf/algorithms/rezzuf/rezzuf_setting.hpp"
@@ -48,12 +49,12 @@ struct State : public afl::AFLStateTemplate<Testcase> {
                          feedback::ExitStatusFeedback &exit_status) override;
   double DoCalcScore(Testcase &testcase) override;
   void ShowStats(void) override;
+  void OnTestcaseChanged(Testcase &testcase) override;
 
   std::shared_ptr<const rezzuf::RezzufSetting> setting;
   std::shared_ptr<u32[]> n_fuzz;
 
-  u32 prev_queued_items;
-  std::unique_ptr<fuzzuf::utils::random::WalkerDiscreteDistribution<u32>> alias_probability;
+  aflplusplus::util::SeedWeights seed_weights;
 };
 
 }
@@ -0,0 +1,80 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file VUzzerFeedbackFormat.hpp
+ * @brief Binary formats of the feedback files written by bbcounts2 and
+ * polyexecutor
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace fuzzuf::algorithm::vuzzer::feedback_format {
+
+/* All values are little endian. tools/bbcounts2 and tools/polyexecutor have
+ * their own copies of these definitions, which must be kept in sync.
+ *
+ * The tools may write the same contents to the shared memory region defined
+ * in fuzzuf/feedback/shm_feedback.hpp instead of the files. The tag of the
+ * record is the magic of the format. */
+
+/* Capacity of the shared memory region of each executor. The pages are
+ * allocated only when the tools touch them. */
+constexpr std::uint32_t SHM_FEEDBACK_CAPACITY = 64u << 20;
+
+/* BB coverage file
+ * BBCovHeader, followed by record_count BBCovRecords sorted by address */
+constexpr char BB_COV_MAGIC[4] = {'V', 'Z', 'B', 'B'};
+
+struct BBCovHeader {
+  char magic[4];
+  std::uint32_t record_count;
+};
+
+struct BBCovRecord {
+  std::uint64_t addr;
+  std::uint32_t count;
+  std::uint32_t reserved;
+};
+
+/* Taint file
+ * TaintHeader, followed by record_count records. Each record is a
+ * TaintRecordHeader followed by value_count values of std::uint32_t. */
+constexpr char TAINT_MAGIC[4] = {'V', 'Z', 'T', 'N'};
+
+constexpr std::uint32_t TAINT_TYPE_CMP = 0;
+constexpr std::uint32_t TAINT_TYPE_LEA = 1;
+
+struct TaintHeader {
+  char magic[4];
+  std::uint32_t record_count;
+};
+
+struct TaintRecordHeader {
+  std::uint32_t type;
+  std::uint32_t offset;  // The first offset touched by the operation
+  std::uint32_t value_count;
+};
+
+static_assert(sizeof(BBCovHeader) == 8);
+static_assert(sizeof(BBCovRecord) == 16);
+static_assert(sizeof(TaintHeader) == 8);
+static_assert(sizeof(TaintRecordHeader) == 12);
+
+}  // namespace fuzzuf::algorithm::vuzzer::feedback_format
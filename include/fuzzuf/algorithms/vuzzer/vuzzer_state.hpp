@@ -24,9 +24,12 @@
 
 #include <algorithm>
 #include <boost/dynamic_bitset.hpp>
+#include <functional>
 #include <memory>
 #include <random>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "fuzzuf/algorithms/afl/afl_dict_data.hpp"
@@ -46,6 +49,9 @@ using dict_t = std::vector<AFLDictData>;
 
 namespace fuzzuf::algorithm::vuzzer {
 
+/* Pairs of BB address and execution count, sorted by address */
+using bb_cov_t = std::vector<std::pair<u64, u32>>;
+
 struct VUzzerState {
   using Tag = typename VUzzerTestcase::Tag;
 
@@ -67,6 +73,23 @@ struct VUzzerState {
       const u8 *buf, u32 len, feedback::ExitStatusFeedback &exit_status,
       u32 tmout = 0);
 
+  using RunCallback = std::function<void(
+      const std::shared_ptr<VUzzerTestcase> &, feedback::FileFeedback &,
+      feedback::ExitStatusFeedback &)>;
+
+  void AddExecutors(
+      std::shared_ptr<fuzzuf::executor::PinToolExecutor> executor,
+      const fs::path &bb_cov_path,
+      std::shared_ptr<fuzzuf::executor::PolyTrackerExecutor> texecutor);
+
+  void RunExecutors(
+      const std::vector<std::shared_ptr<VUzzerTestcase>> &testcases,
+      const RunCallback &callback);
+
+  void RunTaintExecutors(
+      const std::vector<std::shared_ptr<VUzzerTestcase>> &testcases,
+      const RunCallback &callback);
+
   void ReceiveStopSignal(void);
   void ReadTestcases(void);
   std::shared_ptr<VUzzerTestcase> AddToQueue(
@@ -81,6 +104,13 @@ struct VUzzerState {
   std::shared_ptr<fuzzuf::executor::PinToolExecutor> executor;
   std::shared_ptr<fuzzuf::executor::PolyTrackerExecutor> taint_executor;
 
+  /* Executors which run PUTs at once. The first ones are executor and
+   * taint_executor. */
+  std::vector<std::shared_ptr<fuzzuf::executor::PinToolExecutor>> executors;
+  std::vector<fs::path> bb_cov_paths;  // BB cov file written by executors[i]
+  std::vector<std::shared_ptr<fuzzuf::executor::PolyTrackerExecutor>>
+      taint_executors;
+
   exec_input::ExecInputSet input_set;
 
   u32 queued_paths = 0;   /* Total number of queued testcases */
@@ -130,7 +160,7 @@ struct VUzzerState {
   std::set<u64> good_bbs;
 
   /* BB weights */
-  std::map<u64, u32> bb_weights;  // config.ALLBB
+  std::unordered_map<u64, u32> bb_weights;  // config.ALLBB
 
   /* Crash hashes */
   std::set<std::string> crash_hashes;
@@ -44,7 +44,7 @@ using VUzzerUpdOutputType = void(void);
 struct UpdateFitness
     : public hierarflow::HierarFlowRoutine<
           VUzzerUpdInputType,
-          void(const std::shared_ptr<VUzzerTestcase> &, std::map<u64, u32> &)> {
+          void(const std::shared_ptr<VUzzerTestcase> &, bb_cov_t &)> {
  public:
   UpdateFitness(VUzzerState &state);
 
@@ -69,14 +69,14 @@ struct UpdateTaint : public hierarflow::HierarFlowRoutine<VUzzerUpdInputType,
 
 struct TrimQueue
     : public hierarflow::HierarFlowRoutine<
-          void(const std::shared_ptr<VUzzerTestcase> &, std::map<u64, u32> &),
+          void(const std::shared_ptr<VUzzerTestcase> &, bb_cov_t &),
           VUzzerUpdOutputType> {
  public:
   TrimQueue(VUzzerState &state);
 
   utils::NullableRef<hierarflow::HierarFlowCallee<
-      void(const std::shared_ptr<VUzzerTestcase> &, std::map<u64, u32> &)>>
-  operator()(const std::shared_ptr<VUzzerTestcase> &, std::map<u64, u32> &);
+      void(const std::shared_ptr<VUzzerTestcase> &, bb_cov_t &)>>
+  operator()(const std::shared_ptr<VUzzerTestcase> &, bb_cov_t &);
 
  private:
   VUzzerState &state;
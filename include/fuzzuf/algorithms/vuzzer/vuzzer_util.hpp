@@ -31,13 +31,13 @@ namespace fuzzuf::algorithm::vuzzer::util {
 
 void ParseBBWeights(VUzzerState& state, const fs::path& path);
 
-void ParseBBCov(feedback::FileFeedback& inp_feed, std::map<u64, u32>& bb_cov);
+void ParseBBCov(feedback::FileFeedback& inp_feed, bb_cov_t& bb_cov);
 
 void ParseTaintInfo(VUzzerState& state,
                     const std::shared_ptr<VUzzerTestcase>& testcase,
                     feedback::FileFeedback& inp_feed);
 
-void DictToBitsWithKeys(std::map<u64, u32>& dict, std::vector<u64>& keys,
+void DictToBitsWithKeys(const bb_cov_t& dict, std::vector<u64>& keys,
                         boost::dynamic_bitset<>& bits);
 
 std::unique_ptr<std::vector<u8>> GenerateRandomBytesFromDict(
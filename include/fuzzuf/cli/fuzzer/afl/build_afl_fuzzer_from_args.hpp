@@ -25,6 +25,7 @@
 #include "fuzzuf/algorithms/afl/afl_setting.hpp"
 #include "fuzzuf/algorithms/afl/afl_state.hpp"
 #include "fuzzuf/cli/fuzzer/afl/check_parallel_mode_args.hpp"
+#include "fuzzuf/cli/fuzzer/afl/create_calibration_executor_pool.hpp"
 #include "fuzzuf/cli/fuzzer_args.hpp"
 #include "fuzzuf/cli/global_fuzzer_options.hpp"
 #include "fuzzuf/cli/put_args.hpp"
@@ -56,6 +57,7 @@ struct AFLFuzzerOptions {
   u32 pass_rate = 5u; // Optional
   u32 adjust_rate = 1u; // Optional
   bool skip_deterministic = false;
+  u32 calibration_jobs = 1u;  // Optional
   // Default values
   AFLFuzzerOptions() : forksrv(true), frida_mode(false){};
 };
@@ -102,7 +104,12 @@ std::unique_ptr<TFuzzer> BuildAFLFuzzerFromArgs(
       )(
       "adjust_rate,j", po::value<u32>(&afl_options.adjust_rate),
       "adjust rate of K-Scheduler"
-      );
+      )(
+      "calibration_jobs",
+      po::value<u32>(&afl_options.calibration_jobs)
+          ->default_value(afl_options.calibration_jobs),
+      "Number of executors to calibrate the initial seeds in parallel. "
+      "Requires the native executor in fork server mode. default is 1.");
 
   po::variables_map vm;
   po::store(
@@ -185,6 +192,11 @@ std::unique_ptr<TFuzzer> BuildFuzzer(
       /* dumb_mode */ false,  // FIXME: add dumb_mode
       global_options.cpuid_to_bind);
 
+  // The state binds the CPU core, but the fork servers launched by the
+  // executors below inherit the affinity, so the core is bound beforehand.
+  // The state gets the same core.
+  fuzzuf::utils::BindCpu(fuzzuf::utils::GetCpuCore(), setting->cpuid_to_bind);
+
   // NativeLinuxExecutor needs the directory specified by "out_dir" to be
   // already set up so we need to create the directory first, and then
   // initialize Executor
@@ -200,8 +212,10 @@ std::unique_ptr<TFuzzer> BuildFuzzer(
           setting->argv, setting->exec_timelimit_ms, setting->exec_memlimit,
           setting->forksrv, setting->out_dir / GetDefaultOutfile<AFLTag>(),
           GetMapSize<AFLTag>(),  // afl_shm_size
-          0                      // bb_shm_size
-      );
+          0,                     // bb_shm_size
+          false,                 // recorded_outputs
+          std::vector<std::string>{}, std::vector<fs::path>{},
+          global_options.standby_fork_server, global_options.shm_backend);
       executor = std::make_shared<TExecutor>(std::move(nle));
       break;
     }
@@ -247,6 +261,9 @@ std::unique_ptr<TFuzzer> BuildFuzzer(
       EXIT("Unsupported executor: '%s'", global_options.executor.c_str());
   }
 
+  auto executor_pool = CreateCalibrationExecutorPool<TExecutor, AFLTag>(
+      afl_options.calibration_jobs, *setting, global_options);
+
   using algorithm::afl::AFLHavocCaseDistrib;
   using algorithm::afl::AFLHavocOptimizer;
   using algorithm::afl::option::GetHavocStackPow2;
@@ -261,6 +278,7 @@ std::unique_ptr<TFuzzer> BuildFuzzer(
   auto state =
       std::make_unique<AFLState>(setting, executor, std::move(havoc_optimizer));
   state->skip_deterministic = afl_options.skip_deterministic;
+  state->executor_pool = std::move(executor_pool);
 
   // Load dictionary
   for (const auto &d : afl_options.dict_file) {
@@ -0,0 +1,100 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef FUZZUF_INCLUDE_CLI_FUZZER_AFL_CREATE_CALIBRATION_EXECUTOR_POOL_HPP
+#define FUZZUF_INCLUDE_CLI_FUZZER_AFL_CREATE_CALIBRATION_EXECUTOR_POOL_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fuzzuf/algorithms/afl/afl_executor_pool.hpp"
+#include "fuzzuf/algorithms/afl/afl_option.hpp"
+#include "fuzzuf/algorithms/afl/afl_setting.hpp"
+#include "fuzzuf/cli/global_fuzzer_options.hpp"
+#include "fuzzuf/executor/afl_executor_interface.hpp"
+#include "fuzzuf/executor/native_linux_executor.hpp"
+#include "fuzzuf/logger/logger.hpp"
+#include "fuzzuf/utils/common.hpp"
+#include "fuzzuf/utils/cpu_affinity.hpp"
+
+namespace fuzzuf::cli::fuzzer::afl {
+
+/**
+ * @brief Create AFLExecutorPool, whose executors calibrate the initial seeds
+ * in parallel with the main executor.
+ * @details Only NativeLinuxExecutor in fork server mode is supported. Without
+ * the fork server, it times out executions with a process-wide SIGALRM,
+ * which can't tell the executors apart. LinuxForkServerExecutor has no way to
+ * move its fork server to another CPU core.
+ * If the fuzzer is bound to a CPU core, which BindCpu must have decided
+ * beforehand, each executor locks another free core and runs its PUT
+ * processes there. It shares the core of the fuzzer only if no core is free.
+ * The pool releases the cores when it is destroyed.
+ * @param calibration_jobs Number of executors including the main one.
+ * @return A pool of calibration_jobs - 1 executors, or nullptr if they are not
+ * needed or not supported.
+ */
+template <class TExecutor, class Tag>
+std::unique_ptr<algorithm::afl::AFLExecutorPool> CreateCalibrationExecutorPool(
+    u32 calibration_jobs, const algorithm::afl::AFLSetting &setting,
+    const GlobalFuzzerOptions &global_options) {
+  if (calibration_jobs <= 1) return nullptr;
+
+  if (global_options.executor != ExecutorKind::NATIVE || !setting.forksrv) {
+    WARNF("calibration_jobs is ignored without the native fork server");
+    return nullptr;
+  }
+
+  std::vector<std::shared_ptr<executor::AFLExecutorInterface>> executors;
+  std::vector<int> locked_cpus;
+
+  using algorithm::afl::option::GetDefaultOutfile;
+  using algorithm::afl::option::GetMapSize;
+
+  for (u32 i = 1; i < calibration_jobs; i++) {
+    int put_cpuid = utils::CPUID_DO_NOT_BIND;
+    if (utils::GetBoundCpu() != utils::CPUID_DO_NOT_BIND) {
+      put_cpuid = utils::LockVacantCpu(utils::GetCpuCore());
+      if (put_cpuid == utils::CPUID_DO_NOT_BIND)
+        WARNF("No free CPU core for the calibration job #%u", i);
+      else
+        locked_cpus.push_back(put_cpuid);
+    }
+
+    // Every executor needs its own file to write inputs to
+    auto nle = std::make_shared<executor::NativeLinuxExecutor>(
+        setting.argv, setting.exec_timelimit_ms, setting.exec_memlimit,
+        setting.forksrv,
+        setting.out_dir / (std::string(GetDefaultOutfile<Tag>()) + "." +
+                           std::to_string(i)),
+        GetMapSize<Tag>(),  // afl_shm_size
+        0,                  // bb_shm_size
+        false,              // recorded_outputs
+        std::vector<std::string>{}, std::vector<fs::path>{},
+        global_options.standby_fork_server, global_options.shm_backend,
+        put_cpuid);
+    executors.emplace_back(std::make_shared<TExecutor>(std::move(nle)));
+  }
+  return std::make_unique<algorithm::afl::AFLExecutorPool>(
+      std::move(executors), std::move(locked_cpus));
+}
+
+}  // namespace fuzzuf::cli::fuzzer::afl
+
+#endif
@@ -25,6 +25,7 @@
 #include "fuzzuf/algorithms/aflfast/aflfast_other_hierarflow_routines.hpp"
 #include "fuzzuf/algorithms/aflfast/aflfast_setting.hpp"
 #include "fuzzuf/algorithms/aflfast/aflfast_state.hpp"
+#include "fuzzuf/cli/fuzzer/afl/create_calibration_executor_pool.hpp"
 #include "fuzzuf/cli/fuzzer/aflfast/check_parallel_mode_args.hpp"
 #include "fuzzuf/cli/fuzzer_args.hpp"
 #include "fuzzuf/cli/global_fuzzer_options.hpp"
@@ -53,6 +54,7 @@ struct AFLFastFuzzerOptions {
   std::string instance_id;             // Optional
   utils::ParallelModeT parallel_mode =
       utils::ParallelModeT::SINGLE;  // Optional
+  u32 calibration_jobs = 1u;         // Optional
 
   // Default values
   AFLFastFuzzerOptions() : forksrv(true), frida_mode(false){};
@@ -99,7 +101,12 @@ std::unique_ptr<TFuzzer> BuildAFLFastFuzzerFromArgs(
           "distributed mode (see docs/algorithms/afl/parallel_fuzzing.md)")(
           "parallel-random,S",
           po::value<std::string>(&aflfast_options.instance_id),
-          "distributed mode (see docs/algorithms/afl/parallel_fuzzing.md)");
+          "distributed mode (see docs/algorithms/afl/parallel_fuzzing.md)")(
+          "calibration_jobs",
+          po::value<u32>(&aflfast_options.calibration_jobs)
+              ->default_value(aflfast_options.calibration_jobs),
+          "Number of executors to calibrate the initial seeds in parallel. "
+          "Requires the native executor in fork server mode. default is 1.");
 
   po::variables_map vm;
   po::store(
@@ -169,6 +176,11 @@ std::unique_ptr<TFuzzer> BuildAFLFastFuzzerFromArgs(
       /* dumb_mode */ false,  // FIXME: add dumb_mode
       global_options.cpuid_to_bind, FAST);
 
+  // The state binds the CPU core, but the fork servers launched by the
+  // executors below inherit the affinity, so the core is bound beforehand.
+  // The state gets the same core.
+  fuzzuf::utils::BindCpu(fuzzuf::utils::GetCpuCore(), setting->cpuid_to_bind);
+
   // NativeLinuxExecutor needs the directory specified by "out_dir" to be
   // already set up so we need to create the directory first, and then
   // initialize Executor
@@ -185,8 +197,10 @@ std::unique_ptr<TFuzzer> BuildAFLFastFuzzerFromArgs(
           setting->argv, setting->exec_timelimit_ms, setting->exec_memlimit,
           setting->forksrv, setting->out_dir / GetDefaultOutfile<AFLFastTag>(),
           GetMapSize<AFLFastTag>(),  // afl_shm_size
-          0                          // bb_shm_size
-      );
+          0,                         // bb_shm_size
+          false,                     // recorded_outputs
+          std::vector<std::string>{}, std::vector<fs::path>{},
+          global_options.standby_fork_server, global_options.shm_backend);
       executor = std::make_shared<TExecutor>(std::move(nle));
       break;
     }
@@ -218,6 +232,10 @@ std::unique_ptr<TFuzzer> BuildAFLFastFuzzerFromArgs(
       EXIT("Unsupported executor: '%s'", global_options.executor.c_str());
   }
 
+  auto executor_pool =
+      afl::CreateCalibrationExecutorPool<TExecutor, AFLFastTag>(
+          aflfast_options.calibration_jobs, *setting, global_options);
+
   using algorithm::afl::AFLHavocCaseDistrib;
   using algorithm::afl::AFLHavocOptimizer;
   using algorithm::afl::option::GetHavocStackPow2;
@@ -233,6 +251,7 @@ std::unique_ptr<TFuzzer> BuildAFLFastFuzzerFromArgs(
   using fuzzuf::algorithm::aflfast::AFLFastState;
   auto state = std::make_unique<AFLFastState>(setting, executor,
                                               std::move(havoc_optimizer));
+  state->executor_pool = std::move(executor_pool);
 
   // Load dictionary
   for (const auto &d : aflfast_options.dict_file) {
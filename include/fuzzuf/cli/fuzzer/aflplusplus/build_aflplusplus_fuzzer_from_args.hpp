@@ -27,10 +27,12 @@
 #include "fuzzuf/algorithms/aflplusplus/aflplusplus_other_hierarflow_routines.hpp"
 #include "fuzzuf/algorithms/aflplusplus/aflplusplus_setting.hpp"
 #include "fuzzuf/algorithms/aflplusplus/aflplusplus_state.hpp"
+#include "fuzzuf/cli/fuzzer/afl/create_calibration_executor_pool.hpp"
 #include "fuzzuf/cli/fuzzer/aflplusplus/check_parallel_mode_args.hpp"
 #include "fuzzuf/cli/fuzzer_args.hpp"
 #include "fuzzuf/cli/global_fuzzer_options.hpp"
 #include "fuzzuf/cli/put_args.hpp"
+#include "fuzzuf/coverage/cmplog_attacher.hpp"
 #include "fuzzuf/exceptions.hpp"
 #include "fuzzuf/executor/linux_fork_server_executor.hpp"
 #include "fuzzuf/executor/native_linux_executor.hpp"
@@ -57,8 +59,10 @@ struct AFLplusplusFuzzerOptions {
   bool use_slopt = false;                    
   std::string schedule = "fast";              
   std::string instance_id;           
+  std::string cmplog_binary;
   utils::ParallelModeT parallel_mode =
       utils::ParallelModeT::SINGLE;
+  u32 calibration_jobs = 1u;
 };
 
 // Fuzzer specific help
@@ -114,7 +118,16 @@ std::unique_ptr<TFuzzer> BuildAFLplusplusFuzzerFromArgs(
           "distributed mode (see docs/algorithms/afl/parallel_fuzzing.md)")(
           "parallel-random,S",
           po::value<std::string>(&aflplusplus_options.instance_id),
-          "distributed mode (see docs/algorithms/afl/parallel_fuzzing.md)");
+          "distributed mode (see docs/algorithms/afl/parallel_fuzzing.md)")(
+          "cmplog,c",
+          po::value<std::string>(&aflplusplus_options.cmplog_binary),
+          "Enable the input-to-state stage with the PUT built with CmpLog "
+          "(e.g. AFL_LLVM_CMPLOG=1). The arguments are the same as the PUT.")(
+          "calibration_jobs",
+          po::value<u32>(&aflplusplus_options.calibration_jobs)
+              ->default_value(aflplusplus_options.calibration_jobs),
+          "Number of executors to calibrate the initial seeds in parallel. "
+          "Requires the native executor in fork server mode. default is 1.");
 
   po::variables_map vm;
   po::store(
@@ -205,6 +218,11 @@ std::unique_ptr<TFuzzer> BuildAFLplusplusFuzzerFromArgs(
       /* dumb_mode */ false,  // FIXME: add dumb_mode
       global_options.cpuid_to_bind, schedule, aflplusplus_options.schedule);
 
+  // The state binds the CPU core, but the fork servers launched by the
+  // executors below inherit the affinity, so the core is bound beforehand.
+  // The state gets the same core.
+  fuzzuf::utils::BindCpu(fuzzuf::utils::GetCpuCore(), setting->cpuid_to_bind);
+
   // NativeLinuxExecutor needs the directory specified by "out_dir" to be
   // already set up so we need to create the directory first, and then
   // initialize Executor
@@ -222,8 +240,10 @@ std::unique_ptr<TFuzzer> BuildAFLplusplusFuzzerFromArgs(
           setting->forksrv,
           setting->out_dir / GetDefaultOutfile<AFLplusplusTag>(),
           GetMapSize<AFLplusplusTag>(),  // afl_shm_size
-          0                              // bb_shm_size
-      );
+          0,                             // bb_shm_size
+          false,                         // recorded_outputs
+          std::vector<std::string>{}, std::vector<fs::path>{},
+          global_options.standby_fork_server, global_options.shm_backend);
       executor = std::make_shared<TExecutor>(std::move(nle));
       break;
     }
@@ -270,6 +290,36 @@ std::unique_ptr<TFuzzer> BuildAFLplusplusFuzzerFromArgs(
       EXIT("Unsupported executor: '%s'", global_options.executor.c_str());
   }
 
+  auto executor_pool =
+      afl::CreateCalibrationExecutorPool<TExecutor, AFLplusplusTag>(
+          aflplusplus_options.calibration_jobs, *setting, global_options);
+
+  // The CmpLog build of the PUT is always run natively, since the other
+  // executors can't pass the comparison log
+  std::shared_ptr<coverage::CmpLogAttacher> cmplog_map;
+  std::shared_ptr<TExecutor> cmplog_executor;
+  if (!aflplusplus_options.cmplog_binary.empty()) {
+    cmplog_map = std::make_shared<coverage::CmpLogAttacher>(
+        global_options.shm_backend);
+    cmplog_map->Setup();
+
+    auto cmplog_argv = setting->argv;
+    cmplog_argv[0] = aflplusplus_options.cmplog_binary;
+
+    auto nle = std::make_shared<fuzzuf::executor::NativeLinuxExecutor>(
+        cmplog_argv, setting->exec_timelimit_ms, setting->exec_memlimit,
+        setting->forksrv,
+        setting->out_dir / (std::string(GetDefaultOutfile<AFLplusplusTag>()) +
+                            "_cmplog"),
+        GetMapSize<AFLplusplusTag>(),  // afl_shm_size
+        0,                             // bb_shm_size
+        false,                         // recorded_outputs
+        std::vector<std::string>{cmplog_map->GetEnvironmentVariable()},
+        std::vector<fs::path>{}, global_options.standby_fork_server,
+        global_options.shm_backend);
+    cmplog_executor = std::make_shared<TExecutor>(std::move(nle));
+  }
+
   std::unique_ptr<optimizer::HavocOptimizer> havoc_optimizer;
 
   if (aflplusplus_options.use_slopt) {
@@ -297,6 +347,9 @@ std::unique_ptr<TFuzzer> BuildAFLplusplusFuzzerFromArgs(
                                                   std::move(havoc_optimizer));
 
   state->skip_deterministic = !vm.count("det");
+  state->cmplog_executor = cmplog_executor;
+  state->cmplog_map = cmplog_map;
+  state->executor_pool = std::move(executor_pool);
 
   // Load dictionary
   for (const auto &d : aflplusplus_options.dict_file) {
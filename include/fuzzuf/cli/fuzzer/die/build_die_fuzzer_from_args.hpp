@@ -177,6 +177,11 @@ std::unique_ptr<TFuzzer> BuildDIEFuzzerFromArgs(
       die_options.cmd_py, die_options.cmd_node, die_options.d8_path,
       die_options.d8_flags, die_options.typer_path, die_options.mut_cnt);
 
+  // The state binds the CPU core, but the fork servers launched by the
+  // executors below inherit the affinity, so the core is bound beforehand.
+  // The state gets the same core.
+  fuzzuf::utils::BindCpu(fuzzuf::utils::GetCpuCore(), setting->cpuid_to_bind);
+
   /* NativeLinuxExecutor requires output directory */
   fuzzuf::utils::SetupDirs(setting->out_dir.string());
 
@@ -191,8 +196,10 @@ std::unique_ptr<TFuzzer> BuildDIEFuzzerFromArgs(
           setting->argv, setting->exec_timelimit_ms, setting->exec_memlimit,
           setting->forksrv, setting->out_dir / GetDefaultOutfile<DIETag>(),
           GetMapSize<DIETag>(),  // afl_shm_size
-          0                      // bb_shm_size
-      );
+          0,                     // bb_shm_size
+          false,                 // recorded_outputs
+          std::vector<std::string>{}, std::vector<fs::path>{},
+          global_options.standby_fork_server, global_options.shm_backend);
       executor = std::make_shared<TExecutor>(std::move(nle));
       break;
     }
@@ -140,6 +140,11 @@ std::unique_ptr<TFuzzer> BuildIJONFuzzerFromArgs(
       /* dumb_mode */ false,  // FIXME: add dumb_mode
       global_options.cpuid_to_bind);
 
+  // The state binds the CPU core, but the fork servers launched by the
+  // executors below inherit the affinity, so the core is bound beforehand.
+  // The state gets the same core.
+  fuzzuf::utils::BindCpu(fuzzuf::utils::GetCpuCore(), setting->cpuid_to_bind);
+
   // NativeLinuxExecutor needs the directory specified by "out_dir" to be
   // already set up so we need to create the directory first, and then
   // initialize Executor
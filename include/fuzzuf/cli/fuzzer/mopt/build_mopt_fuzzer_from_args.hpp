@@ -31,6 +31,7 @@
 #include "fuzzuf/cli/fuzzer_args.hpp"
 #include "fuzzuf/cli/global_fuzzer_options.hpp"
 #include "fuzzuf/cli/put_args.hpp"
+#include "fuzzuf/coverage/cmplog_attacher.hpp"
 #include "fuzzuf/exceptions.hpp"
 #include "fuzzuf/executor/linux_fork_server_executor.hpp"
 #include "fuzzuf/executor/native_linux_executor.hpp"
@@ -52,6 +53,7 @@ struct MOptFuzzerOptions {
   bool frida_mode;                     // Optional
   u64 mopt_limit_time;
   u64 mopt_most_time;
+  std::string cmplog_binary;  // Optional
   std::string instance_id;  // Optional
   utils::ParallelModeT parallel_mode =
       utils::ParallelModeT::SINGLE;  // Optional
@@ -109,6 +111,9 @@ std::unique_ptr<TFuzzer> BuildMOptFuzzerFromArgs(
           "MOpt-AFL will enter the pacemaker fuzzing mode (it may take three "
           "or four days for MOpt-AFL to enter the pacemaker fuzzing mode when "
           "'-L 30').")(
+          "cmplog,c", po::value<std::string>(&mopt_options.cmplog_binary),
+          "Enable the input-to-state stage with the PUT built with CmpLog "
+          "(e.g. AFL_LLVM_CMPLOG=1). The arguments are the same as the PUT.")(
           "parallel-deterministic,M",
           po::value<std::string>(&mopt_options.instance_id),
           "distributed mode (see docs/algorithms/afl/parallel_fuzzing.md)")(
@@ -184,6 +189,11 @@ std::unique_ptr<TFuzzer> BuildMOptFuzzerFromArgs(
       global_options.cpuid_to_bind, mopt_options.mopt_limit_time,
       mopt_options.mopt_most_time);
 
+  // The state binds the CPU core, but the fork servers launched by the
+  // executors below inherit the affinity, so the core is bound beforehand.
+  // The state gets the same core.
+  fuzzuf::utils::BindCpu(fuzzuf::utils::GetCpuCore(), setting->cpuid_to_bind);
+
   // NativeLinuxExecutor needs the directory specified by "out_dir" to be
   // already set up so we need to create the directory first, and then
   // initialize Executor
@@ -200,8 +210,10 @@ std::unique_ptr<TFuzzer> BuildMOptFuzzerFromArgs(
           setting->argv, setting->exec_timelimit_ms, setting->exec_memlimit,
           setting->forksrv, setting->out_dir / GetDefaultOutfile<MOptTag>(),
           GetMapSize<MOptTag>(),  // afl_shm_size
-          0                       // bb_shm_size
-      );
+          0,                      // bb_shm_size
+          false,                  // recorded_outputs
+          std::vector<std::string>{}, std::vector<fs::path>{},
+          global_options.standby_fork_server, global_options.shm_backend);
       executor = std::make_shared<TExecutor>(std::move(nle));
       break;
     }
@@ -234,6 +246,32 @@ std::unique_ptr<TFuzzer> BuildMOptFuzzerFromArgs(
       EXIT("Unsupported executor: '%s'", global_options.executor.c_str());
   }
 
+  // The CmpLog build of the PUT is always run natively, since the other
+  // executors can't pass the comparison log
+  std::shared_ptr<coverage::CmpLogAttacher> cmplog_map;
+  std::shared_ptr<TExecutor> cmplog_executor;
+  if (!mopt_options.cmplog_binary.empty()) {
+    cmplog_map =
+        std::make_shared<coverage::CmpLogAttacher>(global_options.shm_backend);
+    cmplog_map->Setup();
+
+    auto cmplog_argv = setting->argv;
+    cmplog_argv[0] = mopt_options.cmplog_binary;
+
+    auto nle = std::make_shared<fuzzuf::executor::NativeLinuxExecutor>(
+        cmplog_argv, setting->exec_timelimit_ms, setting->exec_memlimit,
+        setting->forksrv,
+        setting->out_dir /
+            (std::string(GetDefaultOutfile<MOptTag>()) + "_cmplog"),
+        GetMapSize<MOptTag>(),  // afl_shm_size
+        0,                      // bb_shm_size
+        false,                  // recorded_outputs
+        std::vector<std::string>{cmplog_map->GetEnvironmentVariable()},
+        std::vector<fs::path>{}, global_options.standby_fork_server,
+        global_options.shm_backend);
+    cmplog_executor = std::make_shared<TExecutor>(std::move(nle));
+  }
+
   using algorithm::afl::AFLHavocOptimizer;
   using algorithm::afl::option::GetHavocStackPow2;
 
@@ -245,6 +283,8 @@ std::unique_ptr<TFuzzer> BuildMOptFuzzerFromArgs(
   using fuzzuf::algorithm::mopt::MOptState;
   auto state = std::make_unique<MOptState>(
       setting, executor, std::move(havoc_optimizer), mutop_optimizer);
+  state->cmplog_executor = cmplog_executor;
+  state->cmplog_map = cmplog_map;
 
   // Load dictionary
   for (const auto &d : mopt_options.dict_file) {
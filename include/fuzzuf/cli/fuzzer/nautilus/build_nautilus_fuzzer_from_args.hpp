@@ -198,8 +198,10 @@ std::unique_ptr<TFuzzer> BuildNautilusFuzzerFromArgs(
           setting->forksrv,
           setting->path_to_workdir / GetDefaultOutfile<NautilusTag>(),
           setting->bitmap_size,  // afl_shm_size used as bitmap_size
-          0                      // bb_shm_size is not used
-      );
+          0,                     // bb_shm_size is not used
+          false,                 // recorded_outputs
+          std::vector<std::string>{}, std::vector<fs::path>{},
+          global_options.standby_fork_server, global_options.shm_backend);
       executor = std::make_shared<TExecutor>(std::move(nle));
       break;
     }
@@ -192,6 +192,11 @@ std::unique_ptr<TFuzzer> BuildRezzufFuzzerFromArgs(
       /* dumb_mode */ false,  // FIXME: add dumb_mode
       global_options.cpuid_to_bind, schedule, rezzuf_options.schedule);
 
+  // The state binds the CPU core, but the fork servers launched by the
+  // executors below inherit the affinity, so the core is bound beforehand.
+  // The state gets the same core.
+  fuzzuf::utils::BindCpu(fuzzuf::utils::GetCpuCore(), setting->cpuid_to_bind);
+
   // NativeLinuxExecutor needs the directory specified by "out_dir" to be
   // already set up so we need to create the directory first, and then
   // initialize Executor
@@ -208,8 +213,10 @@ std::unique_ptr<TFuzzer> BuildRezzufFuzzerFromArgs(
           setting->argv, setting->exec_timelimit_ms, setting->exec_memlimit,
           setting->forksrv, setting->out_dir / GetDefaultOutfile<RezzufTag>(),
           GetMapSize<RezzufTag>(),  // afl_shm_size
-          0                         // bb_shm_size
-      );
+          0,                        // bb_shm_size
+          false,                    // recorded_outputs
+          std::vector<std::string>{}, std::vector<fs::path>{},
+          global_options.standby_fork_server, global_options.shm_backend);
       executor = std::make_shared<TExecutor>(std::move(nle));
       break;
     }
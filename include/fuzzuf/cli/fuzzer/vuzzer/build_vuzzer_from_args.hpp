@@ -28,6 +28,7 @@
 
 #include "config.h"
 #include "fuzzuf/algorithms/vuzzer/vuzzer.hpp"
+#include "fuzzuf/algorithms/vuzzer/vuzzer_feedback_format.hpp"
 #include "fuzzuf/algorithms/vuzzer/vuzzer_setting.hpp"
 #include "fuzzuf/algorithms/vuzzer/vuzzer_state.hpp"
 #include "fuzzuf/cli/fuzzer_args.hpp"
@@ -36,6 +37,7 @@
 #include "fuzzuf/exceptions.hpp"
 #include "fuzzuf/executor/pintool_executor.hpp"
 #include "fuzzuf/executor/polytracker_executor.hpp"
+#include "fuzzuf/utils/cpu_affinity.hpp"
 #include "fuzzuf/utils/optparser.hpp"
 #include "fuzzuf/utils/workspace.hpp"
 
@@ -61,6 +63,7 @@ struct VUzzerOptions {
   std::string taint_db;                // Optional
   std::string taint_out;               // Optional
   std::vector<std::string> dict_file;  // Optional
+  u32 parallel_execs;                  // Optional
 
   // Default values
   VUzzerOptions()
@@ -69,7 +72,8 @@ struct VUzzerOptions {
         weight("./weight"),
         inst_bin("./instrumented.bin"),
         taint_db("/mnt/polytracker/polytracker.db"),
-        taint_out("/tmp/taint.out"){};
+        taint_out("/tmp/taint.out"),
+        parallel_execs(1){};
 };
 
 // Used only for CLI
@@ -101,6 +105,8 @@ std::unique_ptr<TFuzzer> BuildVUzzerFromArgs(
       "Set path to taint db. Default is `/mnt/polytracker/polytracker.db`.")(
       "taint_out", po::value<std::string>(&vuzzer_options.taint_out),
       "Set path to output for taint analysis. Default is `/tmp/taint.out`.")(
+      "parallel_execs", po::value<u32>(&vuzzer_options.parallel_execs),
+      "Set the number of PUT executions run at once. Default is 1.")(
       "pargs", po::value<std::vector<std::string>>(&pargs),
       "Specify PUT and args for PUT.");
 
@@ -164,7 +170,7 @@ std::unique_ptr<TFuzzer> BuildVUzzerFromArgs(
       new fuzzuf::executor::PinToolExecutor(
           FUZZUF_PIN_EXECUTABLE,
           {TEST_BINARY_DIR "/../tools/bbcounts2/bbcounts2.so", "-o", "bb.out",
-           "-libc", "0"},
+           "-libc", "0", "-binary", "1"},
           setting->argv, setting->exec_timelimit_ms, setting->exec_memlimit,
           setting->out_dir / GetDefaultOutfile()));
 
@@ -177,11 +183,59 @@ std::unique_ptr<TFuzzer> BuildVUzzerFromArgs(
           setting->exec_timelimit_ms, setting->exec_memlimit,
           setting->out_dir / GetDefaultOutfile()));
 
+  // Let bbcounts2 and polyexecutor pass the feedback through shared memory
+  namespace feedback_format = fuzzuf::algorithm::vuzzer::feedback_format;
+  executor->EnableShmFeedback(feedback_format::SHM_FEEDBACK_CAPACITY);
+  taint_executor->EnableShmFeedback(feedback_format::SHM_FEEDBACK_CAPACITY);
+
   // Create VUzzerState
   using fuzzuf::algorithm::vuzzer::VUzzerState;
 
   auto state = std::make_unique<VUzzerState>(setting, executor, taint_executor);
 
+  // Create executors for parallel executions. Each of them writes its input
+  // and feedback files to its own directory.
+  if (vuzzer_options.parallel_execs > 1) {
+    if (fuzzuf::utils::GetBoundCpu() != fuzzuf::utils::CPUID_DO_NOT_BIND)
+      std::cerr << "[!] PUTs share one CPU core. Specify `--bind_cpuid=-2` "
+                   "to run them on separate cores."
+                << std::endl;
+
+    executor->EnableConcurrentRun();
+    taint_executor->EnableConcurrentRun();
+    for (u32 i = 1; i < vuzzer_options.parallel_execs; i++) {
+      const auto worker_dir = fs::absolute(setting->out_dir) / "workers" /
+                              std::to_string(i);
+      fs::create_directories(worker_dir);
+
+      std::shared_ptr<fuzzuf::executor::PinToolExecutor> worker_executor(
+          new fuzzuf::executor::PinToolExecutor(
+              FUZZUF_PIN_EXECUTABLE,
+              {TEST_BINARY_DIR "/../tools/bbcounts2/bbcounts2.so", "-o",
+               (worker_dir / "bb.out").string(), "-libc", "0", "-binary",
+               "1"},
+              setting->argv, setting->exec_timelimit_ms,
+              setting->exec_memlimit, worker_dir / GetDefaultOutfile()));
+
+      std::shared_ptr<fuzzuf::executor::PolyTrackerExecutor>
+          worker_taint_executor(new fuzzuf::executor::PolyTrackerExecutor(
+              TEST_BINARY_DIR "/../tools/polyexecutor/polyexecutor.py",
+              setting->path_to_inst_bin, worker_dir / "polytracker.db",
+              worker_dir / "taint.out", setting->argv,
+              setting->exec_timelimit_ms, setting->exec_memlimit,
+              worker_dir / GetDefaultOutfile()));
+
+      worker_executor->EnableConcurrentRun();
+      worker_taint_executor->EnableConcurrentRun();
+      worker_executor->EnableShmFeedback(
+          feedback_format::SHM_FEEDBACK_CAPACITY);
+      worker_taint_executor->EnableShmFeedback(
+          feedback_format::SHM_FEEDBACK_CAPACITY);
+      state->AddExecutors(worker_executor, worker_dir / "bb.out",
+                          worker_taint_executor);
+    }
+  }
+
   // Load dictionary
   for (const auto &d : vuzzer_options.dict_file) {
     using fuzzuf::algorithm::afl::dictionary::AFLDictData;
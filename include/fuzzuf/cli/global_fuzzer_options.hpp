@@ -20,8 +20,10 @@
 #include <optional>
 #include <string>
 
+#include "fuzzuf/coverage/shm_cov_attacher.hpp"
 #include "fuzzuf/logger/logger.hpp"
 #include "fuzzuf/utils/common.hpp"
+#include "fuzzuf/utils/cpu_affinity.hpp"
 #include "fuzzuf/utils/filesystem.hpp"
 
 namespace fuzzuf::cli {
@@ -76,6 +78,11 @@ struct GlobalFuzzerOptions {
   std::string out_dir;  // Required
   fuzzuf::cli::ExecutorKind executor;    // Optional
   int cpuid_to_bind;                     // Optional
+  bool cpuid_to_bind_specified;          // Set if given by the command line
+  bool bind_put_to_smt_sibling;          // Optional
+  fs::path cpu_lock_dir;                 // Optional
+  bool standby_fork_server;              // Optional
+  coverage::ShmBackend shm_backend;      // Optional
   std::optional<fs::path> proxy_path;    // Optional
   std::optional<u32> exec_timelimit_ms;  // Optional
   std::optional<u32> exec_memlimit;      // Optional
@@ -90,6 +97,11 @@ struct GlobalFuzzerOptions {
         out_dir("/tmp/fuzzuf-out_dir"),  // FIXME: Assuming Linux
         executor(fuzzuf::cli::ExecutorKind::NATIVE),
         cpuid_to_bind(utils::CPUID_BIND_WHICHEVER),
+        cpuid_to_bind_specified(false),
+        bind_put_to_smt_sibling(false),
+        cpu_lock_dir(utils::DEFAULT_CPU_LOCK_DIR),
+        standby_fork_server(false),
+        shm_backend(coverage::ShmBackend::SYSV),
         proxy_path(std::nullopt),
         exec_timelimit_ms(std::nullopt),  // Specify no limits
         exec_memlimit(std::nullopt),
@@ -36,7 +36,8 @@ class AFLEdgeCovAttacher : public ShmCovAttacher {
  public:
   static constexpr const char* SHM_ENV_VAR = "__AFL_SHM_ID";
 
-  AFLEdgeCovAttacher(u32 map_size) : ShmCovAttacher(map_size) {}
+  AFLEdgeCovAttacher(u32 map_size, ShmBackend backend = ShmBackend::SYSV)
+      : ShmCovAttacher(map_size, backend) {}
   void SetupEnvironmentVariable(void) {
     ShmCovAttacher::SetupEnvironmentVariable(SHM_ENV_VAR);
   }
@@ -0,0 +1,127 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+/**
+ * @file cmplog_attacher.hpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+
+#ifndef FUZZUF_INCLUDE_COVERAGE_CMPLOG_ATTACHER_HPP
+#define FUZZUF_INCLUDE_COVERAGE_CMPLOG_ATTACHER_HPP
+
+#include <cstring>
+#include <string>
+
+#include "fuzzuf/coverage/shm_cov_attacher.hpp"
+
+namespace fuzzuf::coverage {
+
+// The layout of the comparison log below follows include/cmplog.h of
+// AFL++ 4.00c, so that PUTs built with AFL_LLVM_CMPLOG=1 (or
+// afl-clang-lto's CmpLog mode) write to it as is.
+
+constexpr u32 CMP_MAP_W = 65536;
+constexpr u32 CMP_MAP_H = 32;
+// Routine entries are twice as large as instruction entries
+constexpr u32 CMP_MAP_RTN_H = CMP_MAP_H / 2;
+
+// Values of CmpHeader::type
+constexpr u32 CMP_TYPE_INS = 1;
+constexpr u32 CMP_TYPE_RTN = 2;
+
+// Bits of CmpHeader::attribute
+constexpr u32 CMP_ATTR_IS_EQUAL = 1;
+constexpr u32 CMP_ATTR_IS_GREATER = 2;
+constexpr u32 CMP_ATTR_IS_LESSER = 4;
+constexpr u32 CMP_ATTR_IS_FP = 8;
+
+struct CmpHeader {
+  u64 hits : 24;
+  u64 id : 24;
+  u64 shape : 5;  // Size of the operands in bytes minus one
+  u64 type : 2;
+  u64 attribute : 4;
+  u64 overflow : 1;
+  u64 reserved : 4;
+};
+
+// Operands of a comparison instruction
+struct CmpOperands {
+  u64 v0;
+  u64 v1;
+  u64 v0_128;
+  u64 v1_128;
+};
+
+// Operands of a call to a comparison routine (e.g. strcmp, memcmp)
+struct CmpFnOperands {
+  u8 v0[31];
+  u8 v0_len;
+  u8 v1[31];
+  u8 v1_len;
+};
+
+struct CmpMap {
+  CmpHeader headers[CMP_MAP_W];
+  CmpOperands log[CMP_MAP_W][CMP_MAP_H];
+};
+
+static_assert(sizeof(CmpHeader) == 8, "CmpHeader must be 8 bytes");
+static_assert(sizeof(CmpOperands) * CMP_MAP_H ==
+                  sizeof(CmpFnOperands) * CMP_MAP_RTN_H,
+              "CmpFnOperands must fill a row of CmpMap::log");
+
+/**
+ * @class CmpLogAttacher
+ * @brief Comparison log of PUTs instrumented with AFL++'s CmpLog.
+ */
+class CmpLogAttacher : public ShmCovAttacher {
+ public:
+  static constexpr const char *SHM_ENV_VAR = "__AFL_CMPLOG_SHM_ID";
+
+  CmpLogAttacher(ShmBackend backend = ShmBackend::SYSV)
+      : ShmCovAttacher(sizeof(CmpMap), backend) {}
+
+  void SetupEnvironmentVariable(void) {
+    ShmCovAttacher::SetupEnvironmentVariable(SHM_ENV_VAR);
+  }
+
+  // Returns "__AFL_CMPLOG_SHM_ID=<id>", which can be passed to an executor as
+  // an executor specific environment variable. Unlike
+  // SetupEnvironmentVariable, this doesn't leak the variable to other
+  // executors, which run PUTs without CmpLog.
+  std::string GetEnvironmentVariable(void) {
+    std::string id = GetShmID() != INVALID_SHMID ? std::to_string(GetShmID())
+                                                 : GetShmName();
+    return std::string(SHM_ENV_VAR) + "=" + id;
+  }
+
+  CmpMap *GetCmpMap(void) { return reinterpret_cast<CmpMap *>(trace_bits); }
+
+  // The runtime only reads entries below hits, so clearing the headers is
+  // enough before each execution. This is far cheaper than Reset(), which
+  // clears the whole 64MiB map.
+  void ResetHeaders(void) {
+    std::memset(trace_bits, 0, sizeof(CmpMap::headers));
+    MEM_BARRIER();
+  }
+};
+
+}  // namespace fuzzuf::coverage
+
+#endif  // FUZZUF_INCLUDE_COVERAGE_CMPLOG_ATTACHER_HPP
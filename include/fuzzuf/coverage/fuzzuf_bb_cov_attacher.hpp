@@ -38,7 +38,8 @@ class FuzzufBBCovAttacher : public ShmCovAttacher {
   // __FUZZUF_SHM_ID
   static constexpr const char* SHM_ENV_VAR = "__WYVERN_SHM_ID";
 
-  FuzzufBBCovAttacher(u32 map_size) : ShmCovAttacher(map_size) {}
+  FuzzufBBCovAttacher(u32 map_size, ShmBackend backend = ShmBackend::SYSV)
+      : ShmCovAttacher(map_size, backend) {}
   void SetupEnvironmentVariable(void) {
     ShmCovAttacher::SetupEnvironmentVariable(SHM_ENV_VAR);
   }
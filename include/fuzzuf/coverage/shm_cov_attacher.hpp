@@ -24,12 +24,40 @@
 #ifndef FUZZUF_INCLUDE_COVERAGE_SHM_COV_ATTACHER_HPP
 #define FUZZUF_INCLUDE_COVERAGE_SHM_COV_ATTACHER_HPP
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cassert>
+#include <string>
+#include <utility>
+
 #include "fuzzuf/feedback/inplace_memory_feedback.hpp"
 #include "fuzzuf/logger/logger.hpp"
 #include "fuzzuf/utils/common.hpp"
 
 namespace fuzzuf::coverage {
 
+/**
+ * @enum ShmBackend
+ * @brief Kind of shared memory used to share the coverage with the PUT.
+ */
+enum class ShmBackend {
+  // System V shared memory. The PUT receives the shmid, and attaches it with
+  // shmat(). This is what AFL-compatible instrumentations expect by default.
+  SYSV,
+  // POSIX shared memory. The PUT receives the name, and maps it with
+  // shm_open() and mmap(), like AFL++ runtimes built with USEMMAP. Not
+  // subject to SHMMAX and SHMALL.
+  POSIX,
+  // Same as POSIX, but the map is rounded up to the huge page size and
+  // transparent huge pages are requested with madvise(), so that large maps
+  // don't suffer TLB misses. Requires shmem_enabled of transparent huge pages
+  // to be "advise" or "always" to take effect.
+  POSIX_HUGE,
+};
+
 /**
  * @class ShmCovAttacher
  * @brief Base class that attaches coverage stored in shared memory.
@@ -40,8 +68,13 @@ class ShmCovAttacher {
 
   u8 *trace_bits;
 
-  ShmCovAttacher(u32 map_size)
-      : trace_bits(nullptr), map_size(map_size), shmid(INVALID_SHMID) {}
+  ShmCovAttacher(u32 map_size, ShmBackend backend = ShmBackend::SYSV)
+      : trace_bits(nullptr),
+        map_size(map_size),
+        backend(backend),
+        shmid(INVALID_SHMID),
+        shm_fd(-1),
+        mapped_size(0) {}
 
   ~ShmCovAttacher() { Erase(); }
 
@@ -53,11 +86,24 @@ class ShmCovAttacher {
 
   void Setup(void) {
     if (map_size == 0) return;
+    if (backend != ShmBackend::SYSV) {
+      SetupPosixShm();
+      return;
+    }
+
     shmid = shmget(IPC_PRIVATE, map_size, IPC_CREAT | IPC_EXCL | 0600);
     if (shmid < 0) ERROR("shmget() failed");
 
     trace_bits = (u8 *)shmat(shmid, nullptr, 0);
     if (trace_bits == (u8 *)-1) ERROR("shmat() failed");
+
+#ifdef __linux__
+    // Linux allows attaching a segment marked to be destroyed, and destroys
+    // it when the last process detaches. Marking it now prevents the segment
+    // from leaking even if fuzzuf crashes.
+    if (shmctl(shmid, IPC_RMID, 0) == -1) ERROR("shmctl() failed");
+    shmid_removed = true;
+#endif
   }
 
   void Reset(void) {
@@ -71,29 +117,63 @@ class ShmCovAttacher {
 
   void Erase(void) {
     if (map_size == 0) return;
+    if (backend != ShmBackend::SYSV) {
+      ErasePosixShm();
+      return;
+    }
+
     if (trace_bits != nullptr) {
       if (shmdt(trace_bits) == -1) ERROR("shmdt() failed");
       trace_bits = nullptr;
     }
     if (shmid != INVALID_SHMID) {
-      if (shmctl(shmid, IPC_RMID, 0) == -1) ERROR("shmctl() failed");
+      if (!shmid_removed && shmctl(shmid, IPC_RMID, 0) == -1)
+        ERROR("shmctl() failed");
       shmid = INVALID_SHMID;
+      shmid_removed = false;
     }
   }
 
   void SetupEnvironmentVariable(const char *shm_env_var) {
-    if (map_size > 0 && shmid != INVALID_SHMID) {
-      std::string shmstr = std::to_string(shmid);
-      setenv(shm_env_var, shmstr.c_str(), 1);
+    auto value = GetEnvironmentVariableValue();
+    if (!value.empty()) {
+      setenv(shm_env_var, value.c_str(), 1);
     } else {
       unsetenv(shm_env_var);
     }
   }
 
+  // Returns what the PUT receives to attach the shared memory, or an empty
+  // string if there is nothing to attach
+  std::string GetEnvironmentVariableValue(void) const {
+    if (map_size > 0 && shmid != INVALID_SHMID) return std::to_string(shmid);
+    if (map_size > 0 && !shm_name.empty()) return shm_name;
+    return std::string();
+  }
+
+  // Exchanges the shared memories of two attachers with the same map size and
+  // backend. Feedbacks of either attacher must not be held.
+  void Swap(ShmCovAttacher &other) {
+    assert(map_size == other.map_size && backend == other.backend);
+    std::swap(trace_bits, other.trace_bits);
+    std::swap(shmid, other.shmid);
+    std::swap(shmid_removed, other.shmid_removed);
+    std::swap(shm_name, other.shm_name);
+    std::swap(shm_fd, other.shm_fd);
+    std::swap(mapped_size, other.mapped_size);
+  }
+
   virtual u32 GetMapSize(void) { return map_size; }
 
+  // Returns INVALID_SHMID unless the backend is ShmBackend::SYSV
   virtual int GetShmID(void) { return shmid; }
 
+  ShmBackend GetBackend(void) const { return backend; }
+
+  // Returns the name passed to shm_open(), or an empty string unless the
+  // backend is ShmBackend::POSIX or ShmBackend::POSIX_HUGE
+  const std::string &GetShmName(void) const { return shm_name; }
+
   feedback::InplaceMemoryFeedback GetFeedback(void) {
     return feedback::InplaceMemoryFeedback(trace_bits, map_size, lock);
   }
@@ -108,7 +188,58 @@ class ShmCovAttacher {
   std::shared_ptr<u8> lock;
 
  private:
+  static constexpr std::size_t HUGE_PAGE_SIZE = 2u * 1024u * 1024u;
+
+  void SetupPosixShm(void) {
+    static std::atomic<u32> shm_count(0);
+    shm_name = "/fuzzuf_cov_" + std::to_string(getpid()) + "_" +
+               std::to_string(shm_count++);
+
+    shm_fd = shm_open(shm_name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC,
+                      0600);
+    if (shm_fd < 0) ERROR("shm_open() failed");
+
+    mapped_size = map_size;
+    if (backend == ShmBackend::POSIX_HUGE)
+      mapped_size = (mapped_size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE *
+                    HUGE_PAGE_SIZE;
+    if (ftruncate(shm_fd, mapped_size) < 0) ERROR("ftruncate() failed");
+
+    void *addr = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      shm_fd, 0);
+    if (addr == MAP_FAILED) ERROR("mmap() failed");
+    trace_bits = static_cast<u8 *>(addr);
+
+#ifdef MADV_HUGEPAGE
+    if (backend == ShmBackend::POSIX_HUGE)
+      madvise(addr, mapped_size, MADV_HUGEPAGE); /* Ignore errors */
+#endif
+  }
+
+  void ErasePosixShm(void) {
+    if (trace_bits != nullptr) {
+      if (munmap(trace_bits, mapped_size) == -1) ERROR("munmap() failed");
+      trace_bits = nullptr;
+    }
+    if (shm_fd != -1) {
+      close(shm_fd);
+      shm_fd = -1;
+    }
+    if (!shm_name.empty()) {
+      shm_unlink(shm_name.c_str());
+      shm_name.clear();
+    }
+  }
+
+  const ShmBackend backend;
+
   int shmid;
+  bool shmid_removed = false;
+
+  // Only used if backend is ShmBackend::POSIX or ShmBackend::POSIX_HUGE
+  std::string shm_name;
+  int shm_fd;
+  std::size_t mapped_size;
 };
 
 }  // namespace fuzzuf::coverage
@@ -17,6 +17,7 @@
  */
 #pragma once
 
+#include <atomic>
 #include <memory>
 
 #include "fuzzuf/utils/common.hpp"
@@ -65,7 +66,8 @@ class ExecInput {
   ExecInput(std::unique_ptr<u8[]>&&, u32);
 
  private:
-  static u64 id_counter;
+  // Atomic, since fuzzers running on several threads create inputs
+  static std::atomic<u64> id_counter;
 };
 
 }  // namespace fuzzuf::exec_input
@@ -21,6 +21,7 @@
 
 #include "fuzzuf/exec_input/exec_input.hpp"
 #include "fuzzuf/exec_input/exec_input_set.hpp"
+#include "fuzzuf/utils/async_writer.hpp"
 #include "fuzzuf/utils/common.hpp"
 #include "fuzzuf/utils/filesystem.hpp"
 
@@ -49,6 +50,15 @@ class OnDiskExecInput : public ExecInput {
   void OverwriteThenUnload(const u8* buf, u32 len);
   void OverwriteThenUnload(std::unique_ptr<u8[]>&& buf, u32 len);
 
+  // Same as OverwriteThenUnload, except that the file is written on the
+  // thread of writer. Until it is written, Load() reads the content from
+  // memory, and the other methods touching the file wait for it. The file is
+  // written right away if writer is null. If sync_data is true, the file is
+  // also flushed to the disk with fdatasync. A failed write is rethrown by
+  // the methods waiting for it, or by the next use of writer.
+  void OverwriteInBackground(const u8* buf, u32 len, utils::AsyncWriter* writer,
+                             bool sync_data);
+
   void LoadByMmap(void);
   bool Link(const fs::path& dest_path);
   void Copy(const fs::path& dest_path);
@@ -63,8 +73,12 @@ class OnDiskExecInput : public ExecInput {
   friend class ExecInputSet;
   OnDiskExecInput(const fs::path&, bool hardlinked = false);
 
+  struct PendingWrite;
+  void WaitForPendingWrite(void);
+
   fs::path path;
   bool hardlinked;
+  std::shared_ptr<PendingWrite> pending_write;
 };
 
 }  // namespace fuzzuf::exec_input
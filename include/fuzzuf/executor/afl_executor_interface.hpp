@@ -26,6 +26,7 @@
 
 #include <memory>
 
+#include "fuzzuf/executor/executor.hpp"
 #include "fuzzuf/feedback/exit_status_feedback.hpp"
 #include "fuzzuf/feedback/inplace_memory_feedback.hpp"
 #include "fuzzuf/utils/common.hpp"
@@ -43,6 +44,8 @@ namespace fuzzuf::executor {
  *
  * @note An AFL-capable executor must have the following functions:
  * - void Run(const u8 *buf, u32 len, u32 timeout_ms)
+ * - std::size_t RunBatch(BatchInputRange inputs, const BatchCallback &callback,
+ *   u32 timeout_ms)
  * - InplaceMemoryFeedback GetAFLFeedback()
  * - ExitStatusFeedback GetExitStatusFeedback()
  * - void ReceiveStopSignal()
@@ -71,6 +74,18 @@ class AFLExecutorInterface {
     _container->Run(buf, len, timeout_ms);
   }
 
+  /// @brief Executes the executor with each of given inputs in order.
+  /// @param inputs Fuzzing inputs to be executed.
+  /// @param callback A function called with the index of the input after each
+  /// execution. Feedbacks must be retrieved and released inside it. Returning
+  /// true aborts the rest of the batch.
+  /// @param timeout_ms Execution timeout in milliseconds.
+  /// @return The number of inputs actually executed.
+  std::size_t RunBatch(BatchInputRange inputs, const BatchCallback &callback,
+                       u32 timeout_ms = 0) {
+    return _container->RunBatch(inputs, callback, timeout_ms);
+  }
+
   /// @brief Gets AFL-compatible hashed edge coverage bitmap.
   /// @return AFL-compatible hashed edge coverage bitmap.
   feedback::InplaceMemoryFeedback GetAFLFeedback() {
@@ -91,6 +106,9 @@ class AFLExecutorInterface {
    public:
     virtual ~DynContainerBase() {}
     virtual void Run(const u8 *buf, u32 len, u32 timeout_ms = 0) = 0;
+    virtual std::size_t RunBatch(BatchInputRange inputs,
+                                 const BatchCallback &callback,
+                                 u32 timeout_ms = 0) = 0;
     virtual feedback::InplaceMemoryFeedback GetAFLFeedback() = 0;
     virtual feedback::ExitStatusFeedback GetExitStatusFeedback() = 0;
     virtual void ReceiveStopSignal() = 0;
@@ -108,6 +126,11 @@ class AFLExecutorInterface {
       _executor->Run(buf, len, timeout_ms);
     }
 
+    std::size_t RunBatch(BatchInputRange inputs, const BatchCallback &callback,
+                         u32 timeout_ms = 0) {
+      return _executor->RunBatch(inputs, callback, timeout_ms);
+    }
+
     feedback::InplaceMemoryFeedback GetAFLFeedback() {
       return _executor->GetAFLFeedback();
     }
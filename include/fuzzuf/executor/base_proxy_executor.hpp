@@ -20,6 +20,7 @@
 #include <sys/epoll.h>
 
 #include <cassert>
+#include <chrono>
 #include <cstddef>
 #include <memory>
 #include <string>
@@ -31,6 +32,7 @@
 #include "fuzzuf/feedback/exit_status_feedback.hpp"
 #include "fuzzuf/feedback/file_feedback.hpp"
 #include "fuzzuf/feedback/inplace_memory_feedback.hpp"
+#include "fuzzuf/feedback/shm_feedback.hpp"
 #include "fuzzuf/utils/common.hpp"
 #include "fuzzuf/utils/filesystem.hpp"
 
@@ -112,11 +114,28 @@ class BaseProxyExecutor : public Executor {
   // to achieve?)
   void Initilize();
   void Run(const u8 *buf, u32 len, u32 timeout_ms = 0);
+  std::size_t RunBatch(BatchInputRange inputs, const BatchCallback &callback,
+                       u32 timeout_ms = 0);
   void ReceiveStopSignal(void);
 
+  // Make the timeout of the non fork server mode checked by polling the PUT
+  // instead of SIGALRM, which is shared by the whole process, so that
+  // multiple instances can Run() at once on separate threads.
+  void EnableConcurrentRun();
+
+  // Create a shared memory region of capacity bytes, and pass its name to the
+  // proxy with feedback::SHM_FEEDBACK_ENV_VAR so that the proxy can write the
+  // feedback there instead of files. Proxies that don't support it are not
+  // affected.
+  void EnableShmFeedback(u32 capacity);
+
   feedback::InplaceMemoryFeedback GetStdOut();
   feedback::InplaceMemoryFeedback GetStdErr();
   feedback::FileFeedback GetFileFeedback(fs::path feed_path);
+  // Same as above, but if the proxy of the last execution wrote the feedback
+  // to the shared memory, returns the record tagged tag in memory instead
+  feedback::FileFeedback GetFileFeedback(fs::path feed_path,
+                                         const char (&tag)[4]);
   feedback::ExitStatusFeedback GetExitStatusFeedback();
 
   virtual bool IsFeedbackLocked();
@@ -142,8 +161,15 @@ class BaseProxyExecutor : public Executor {
  protected:
   bool record_stdout_and_err;
   bool has_shared_memories;
+  bool concurrent_run = false;
 
  private:
+  void ExecuteWrittenInput(u32 timeout_ms,
+                           fuzzuf::executor::ChildState &child_state);
+  void WaitChildUntil(std::chrono::steady_clock::time_point deadline,
+                      int &put_status);
+  void CreateChildEnvironment();
+
   feedback::PUTExitReasonType last_exit_reason;
   u8 last_signal;
   fuzzuf::executor::output_t stdout_buffer;
@@ -154,5 +180,12 @@ class BaseProxyExecutor : public Executor {
   epoll_event fork_server_stdout_event;
   epoll_event fork_server_stderr_event;
   epoll_event fork_server_read_event;
+  feedback::ShmFeedbackRegion shm_feedback;
+
+  // Environment passed to execve in the child, made by CreateChildEnvironment
+  // before each fork. Except for the variable naming shm_feedback, the
+  // elements point to the strings in environ.
+  std::vector<const char *> child_environment;
+  std::string shm_feedback_environment_variable;
 };
 }  // namespace fuzzuf::executor
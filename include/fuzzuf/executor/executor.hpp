@@ -17,6 +17,9 @@
  */
 #pragma once
 
+#include <boost/range/iterator_range.hpp>
+#include <cstddef>
+#include <functional>
 #include <memory>
 
 #include "fuzzuf/feedback/put_exit_reason_type.hpp"
@@ -31,6 +34,23 @@ struct ChildState {
 
 constexpr std::size_t output_block_size = 512u;
 
+// A view of one input passed to Executor::RunBatch. The memory pointed by buf
+// must be kept alive until RunBatch returns.
+struct BatchInput {
+  const u8 *buf;
+  u32 len;
+};
+
+using BatchInputRange = boost::iterator_range<const BatchInput *>;
+
+// Called by Executor::RunBatch each time one input of the batch has been
+// executed, with the index of the input in the batch. Feedbacks of the
+// execution (e.g. GetAFLFeedback()) are valid only until the callback returns,
+// and must be released before that. Returning true aborts the rest of the
+// batch in the same manner as HierarFlowRoutine::CallSuccessors. The callback
+// must not call Run or RunBatch of the executor running the batch.
+using BatchCallback = std::function<bool(std::size_t)>;
+
 // A base class that abstracts any kinds of execution environments and fuzz
 // executions. Inherit this class if you want to derive `FooBarExecutor` for a
 // new execution environment, FooBar. The following notes are applied to this
@@ -76,6 +96,17 @@ class Executor {
   // Read an input and actually execute the PUT
   virtual void Run(const u8 *buf, u32 len, u32 timeout_ms = 0) = 0;
 
+  // Execute the PUT for each input in inputs in order, calling callback after
+  // each execution. timeout_ms is applied to every input of the batch.
+  // Returns the number of inputs actually executed.
+  // Derivatives override this to hoist the per-call overhead of Run (timeout
+  // configuration, allocation of interprocess state, truncation of the input
+  // file etc.) out of the loop. This default implementation just calls Run
+  // repeatedly, and is used by executors having nothing to share between runs.
+  virtual std::size_t RunBatch(BatchInputRange inputs,
+                               const BatchCallback &callback,
+                               u32 timeout_ms = 0);
+
   void KillChildWithoutWait();
 
   // Called when fuzzuf needs to be stopped earlier, such as when SIGTERM is
@@ -86,6 +117,10 @@ class Executor {
   void WriteTestInputToFile(const u8 *buf, u32 len);
 
  protected:
+  // Overwrite the file written by WriteTestInputToFile with the next input of
+  // a batch. prev_len must be the length of the input written last time.
+  void OverwriteTestInputFile(const u8 *buf, u32 len, u32 prev_len);
+
   std::shared_ptr<u8> lock;
 };
 
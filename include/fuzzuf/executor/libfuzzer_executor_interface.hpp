@@ -45,9 +45,13 @@ namespace fuzzuf::executor {
  *
  * @note A libFuzzer-capable executor must have the following functions.
  * - void Run(const u8 *buf, u32 len, u32 timeout_ms)
+ * - std::size_t RunBatch(BatchInputRange inputs, const BatchCallback &callback,
+ *   u32 timeout_ms)
  * - InplaceMemoryFeedback GetAFLFeedback()
  * - InplaceMemoryFeedback GetBBFeedback()
  * - ExitStatusFeedback GetExitStatusFeedback()
+ * - InplaceMemoryFeedback GetStdOut()
+ * - InplaceMemoryFeedback GetStdErr()
  * - fuzzuf::executor::output_t MoveStdOut()
  * - fuzzuf::executor::output_t MoveStdErr()
  */
@@ -77,6 +81,18 @@ class LibFuzzerExecutorInterface {
     _container->Run(buf, len, timeout_ms);
   }
 
+  /// @brief Executes the executor with each of given inputs in order.
+  /// @param inputs Fuzzing inputs to be executed.
+  /// @param callback A function called with the index of the input after each
+  /// execution. Feedbacks must be retrieved and released inside it. Returning
+  /// true aborts the rest of the batch.
+  /// @param timeout_ms Execution timeout in milliseconds.
+  /// @return The number of inputs actually executed.
+  std::size_t RunBatch(BatchInputRange inputs, const BatchCallback &callback,
+                       u32 timeout_ms = 0) {
+    return _container->RunBatch(inputs, callback, timeout_ms);
+  }
+
   /// @brief Gets AFL-compatible hashed edge coverage bitmap.
   /// @return AFL-compatible hashed edge coverage bitmap.
   feedback::InplaceMemoryFeedback GetAFLFeedback() {
@@ -95,6 +111,18 @@ class LibFuzzerExecutorInterface {
     return _container->GetExitStatusFeedback();
   }
 
+  /// @brief Gets captured stdout output during the execution without copying.
+  /// @return Captured stdout output during the execution.
+  feedback::InplaceMemoryFeedback GetStdOut() {
+    return _container->GetStdOut();
+  }
+
+  /// @brief Gets captured stderr output during the execution without copying.
+  /// @return Captured stderr output during the execution.
+  feedback::InplaceMemoryFeedback GetStdErr() {
+    return _container->GetStdErr();
+  }
+
   /// @brief Moves captured stdout output during the execution.
   /// @return Captured stdout output during the execution.
   fuzzuf::executor::output_t MoveStdOut() { return _container->MoveStdOut(); }
@@ -112,9 +140,14 @@ class LibFuzzerExecutorInterface {
    public:
     virtual ~DynContainerBase() {}
     virtual void Run(const u8 *buf, u32 len, u32 timeout_ms = 0) = 0;
+    virtual std::size_t RunBatch(BatchInputRange inputs,
+                                 const BatchCallback &callback,
+                                 u32 timeout_ms = 0) = 0;
     virtual feedback::InplaceMemoryFeedback GetAFLFeedback() = 0;
     virtual feedback::InplaceMemoryFeedback GetBBFeedback() = 0;
     virtual feedback::ExitStatusFeedback GetExitStatusFeedback() = 0;
+    virtual feedback::InplaceMemoryFeedback GetStdOut() = 0;
+    virtual feedback::InplaceMemoryFeedback GetStdErr() = 0;
     virtual fuzzuf::executor::output_t MoveStdOut() = 0;
     virtual fuzzuf::executor::output_t MoveStdErr() = 0;
     virtual fuzzuf::utils::vfs::LocalFilesystem &Filesystem() const = 0;
@@ -132,6 +165,11 @@ class LibFuzzerExecutorInterface {
       _executor->Run(buf, len, timeout_ms);
     }
 
+    std::size_t RunBatch(BatchInputRange inputs, const BatchCallback &callback,
+                         u32 timeout_ms = 0) {
+      return _executor->RunBatch(inputs, callback, timeout_ms);
+    }
+
     feedback::InplaceMemoryFeedback GetAFLFeedback() {
       return _executor->GetAFLFeedback();
     }
@@ -144,6 +182,14 @@ class LibFuzzerExecutorInterface {
       return _executor->GetExitStatusFeedback();
     }
 
+    feedback::InplaceMemoryFeedback GetStdOut() {
+      return _executor->GetStdOut();
+    }
+
+    feedback::InplaceMemoryFeedback GetStdErr() {
+      return _executor->GetStdErr();
+    }
+
     fuzzuf::executor::output_t MoveStdOut() { return _executor->MoveStdOut(); }
 
     fuzzuf::executor::output_t MoveStdErr() { return _executor->MoveStdErr(); }
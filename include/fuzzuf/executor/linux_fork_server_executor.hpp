@@ -161,6 +161,8 @@ class LinuxForkServerExecutor : public Executor {
   // Declare in the base class and define in each derivative, if possible (how
   // to achieve?)
   void Run(const u8 *buf, u32 len, u32 timeout_ms = 0);
+  std::size_t RunBatch(BatchInputRange inputs, const BatchCallback &callback,
+                       u32 timeout_ms = 0);
   void ReceiveStopSignal(void);
 
   // Environment-specific methods
@@ -203,6 +205,8 @@ class LinuxForkServerExecutor : public Executor {
    * the child process of this executor.
    */
   void CreateJoinedEnvironmentVariables(std::vector<std::string> &&extra);
+  void SetTimeout(u32 timeout_ms);
+  void ExecuteWrittenInput();
 
   u32 last_timeout_ms;
   feedback::PUTExitReasonType last_exit_reason;
@@ -19,9 +19,11 @@
 
 #include <sys/epoll.h>
 
+#include <array>
 #include <cassert>
 #include <cstddef>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -29,6 +31,7 @@
 #include "fuzzuf/coverage/fuzzuf_bb_cov_attacher.hpp"
 #include "fuzzuf/exceptions.hpp"
 #include "fuzzuf/executor/executor.hpp"
+#include "fuzzuf/executor/output_ring_buffer.hpp"
 #include "fuzzuf/feedback/exit_status_feedback.hpp"
 #include "fuzzuf/feedback/inplace_memory_feedback.hpp"
 #include "fuzzuf/utils/common.hpp"
@@ -58,12 +61,20 @@ class NativeLinuxExecutor : public Executor {
 
   // Members holding settings handed over a constructor
   const bool forksrv;
+  const bool keep_standby_fork_server;
+  const int put_cpuid;
 
   const bool uses_asan = false;  // May become one of the available options in
                                  // the future, but currently not anticipated
 
   coverage::AFLEdgeCovAttacher afl_edge_coverage;
   coverage::FuzzufBBCovAttacher fuzzuf_bb_coverage;
+  // Coverage maps of the standby fork server, which are only set up if
+  // keep_standby_fork_server is true. They are exchanged with the maps above
+  // when the standby fork server is swapped in, so that its initialization
+  // never writes to the maps of the running executions.
+  coverage::AFLEdgeCovAttacher standby_afl_edge_coverage;
+  coverage::FuzzufBBCovAttacher standby_fuzzuf_bb_coverage;
 
   int forksrv_pid;
   int forksrv_read_fd;
@@ -82,17 +93,28 @@ class NativeLinuxExecutor : public Executor {
       const std::vector<std::string> &argv, u32 exec_timelimit_ms,
       u64 exec_memlimit, bool forksrv, const fs::path &path_to_write_input,
       u32 afl_shm_size, u32 bb_shm_size,
-      // FIXME: The below is a temporary flag to avoid a big performance issue.
-      // The issue appears when we save the outputs of stdout/stderr to buffers
-      // in every execution of a PUT, which isn't required in most fuzzers.
-      // This is just a temporary and ugly countermeasure.
-      // In the future, we should generalize this flag so that we can
-      // arbitrarily specify which fd should be recorded. For example, by
-      // passing std::vector<int>{1, 2} to this class, we would tell that we
-      // would like to record stdout and stderr.
-      bool record_stdout_and_err = false,
+      // fds of the PUT whose outputs are recorded, which are stdout and/or
+      // stderr for now, e.g. std::vector<int>{1, 2} for both of them. Passing
+      // true is the same as that. Each of them is kept in a pre-allocated
+      // buffer holding the last bytes written in the execution. Nothing is
+      // recorded by default, as most fuzzers don't need the outputs.
+      RecordedOutputs recorded_outputs = {},
       std::vector<std::string> &&environment_variables_ = {},
-      std::vector<fs::path> &&allowed_path_ = {});
+      std::vector<fs::path> &&allowed_path_ = {},
+      // If true, another fork server is launched in advance and initializes
+      // itself in parallel with the fuzzing, so that it can replace the active
+      // one immediately when the active one dies. Only meaningful in fork
+      // server mode. Useful for PUTs with heavy initialization.
+      bool keep_standby_fork_server = false,
+      // Shared memory used for the AFL edge coverage map. ShmBackend::POSIX
+      // and ShmBackend::POSIX_HUGE require the PUT to be instrumented with a
+      // runtime that maps __AFL_SHM_ID with shm_open(). The basic block
+      // coverage map always uses ShmBackend::SYSV.
+      coverage::ShmBackend shm_backend = coverage::ShmBackend::SYSV,
+      // CPU core the PUT processes are bound to. By default, they are bound
+      // as utils::BindCpu has decided for the fuzzer. Executors running in
+      // parallel are given cores of their own, see utils::LockVacantCpu.
+      int put_cpuid = utils::CPUID_DO_NOT_BIND);
   ~NativeLinuxExecutor();
 
   NativeLinuxExecutor(const NativeLinuxExecutor &) = delete;
@@ -105,6 +127,12 @@ class NativeLinuxExecutor : public Executor {
   // Declare in the base class and define in each derivative, if possible (how
   // to achieve?)
   void Run(const u8 *buf, u32 len, u32 timeout_ms = 0);
+  // Executes inputs in order and calls callback with the index of each input
+  // after its execution. The callback runs while the batch still holds this
+  // executor (the fork server and the coverage maps), so it must not call Run
+  // or RunBatch of the same executor.
+  std::size_t RunBatch(BatchInputRange inputs, const BatchCallback &callback,
+                       u32 timeout_ms = 0);
   void ReceiveStopSignal(void);
 
   // Environment-specific methods
@@ -115,6 +143,10 @@ class NativeLinuxExecutor : public Executor {
 
   feedback::InplaceMemoryFeedback GetAFLFeedback();
   feedback::InplaceMemoryFeedback GetBBFeedback();
+  // Views of the recorded outputs of the last execution, which are empty if
+  // the fd is not recorded. Only the last bytes are kept if the PUT writes
+  // more than the capacity.
+  feedback::InplaceMemoryFeedback GetOutput(int fd);
   feedback::InplaceMemoryFeedback GetStdOut();
   feedback::InplaceMemoryFeedback GetStdErr();
   feedback::ExitStatusFeedback GetExitStatusFeedback();
@@ -132,16 +164,39 @@ class NativeLinuxExecutor : public Executor {
   static void SetupSignalHandlers();
   static void AlarmHandler(int signum);
 
-  // InplaceMemoryFeedback made of GetStdOut before calling this function
-  // becomes invalid after Run()
+  // Copies of GetStdOut() and GetStdErr(), kept for the callers which need
+  // their own buffers. Prefer the views, which don't copy the outputs.
   fuzzuf::executor::output_t MoveStdOut();
-  // InplaceMemoryFeedback made of GetStdErr before calling this function
-  // becomes invalid after Run()
   fuzzuf::executor::output_t MoveStdErr();
 
   fuzzuf::utils::vfs::LocalFilesystem &Filesystem() { return filesystem; }
 
  private:
+  // Parent side of a fork server launched by LaunchForkServer
+  struct ForkServerHandle {
+    int pid = -1;
+    int read_fd = -1;
+    int write_fd = -1;
+    // Read ends of the pipes of the recorded outputs, in the same order as
+    // output_channels
+    std::vector<int> output_fds;
+  };
+
+  // A recorded fd of the PUT and the buffer receiving what is written to it
+  struct OutputChannel {
+    int fd;
+    OutputRingBuffer buffer;
+  };
+
+  ForkServerHandle LaunchForkServer(
+      const std::vector<const char *> &environment);
+  void ActivateForkServer(const ForkServerHandle &handle);
+  static void CloseForkServer(ForkServerHandle &handle);
+  void ReplenishStandbyForkServer();
+  bool SwapInStandbyForkServer();
+  bool RetryWithStandbyForkServer(u32 timeout_ms,
+                                  fuzzuf::executor::ChildState &child_state);
+
   /**
    * Take snapshot of environment variables.
    * This updates both environment_variables and raw_environment_variables.
@@ -149,18 +204,25 @@ class NativeLinuxExecutor : public Executor {
    * the child process of this executor.
    */
   void CreateJoinedEnvironmentVariables(std::vector<std::string> &&extra);
+  void CreateStandbyEnvironmentVariables();
+  void ExecuteWrittenInput(u32 timeout_ms,
+                           fuzzuf::executor::ChildState &child_state);
+  std::vector<std::array<int, 2u>> CreateOutputPipes();
+  void RedirectOutputs(const std::vector<std::array<int, 2u>> &pipes);
+  bool ReadOutput(int fd, const std::vector<int> &read_fds);
+  void DrainOutputs(const std::vector<int> &read_fds);
   feedback::PUTExitReasonType last_exit_reason;
   u8 last_signal;
-  fuzzuf::executor::output_t stdout_buffer;
-  fuzzuf::executor::output_t stderr_buffer;
-  int fork_server_stdout_fd = -1;
-  int fork_server_stderr_fd = -1;
+  std::vector<OutputChannel> output_channels;
+  std::vector<int> fork_server_output_fds;
   int fork_server_epoll_fd = -1;
-  epoll_event fork_server_stdout_event;
-  epoll_event fork_server_stderr_event;
   epoll_event fork_server_read_event;
 
-  bool record_stdout_and_err;
+  // A fork server waiting to replace the active one. Its handshake is read
+  // when it is swapped in, so that its initialization never blocks the fuzzing
+  // in the meantime.
+  std::optional<ForkServerHandle> standby_fork_server;
+  bool retrying_with_standby_fork_server = false;
 
   /**
    * Snapshot of environment variables.
@@ -182,6 +244,12 @@ class NativeLinuxExecutor : public Executor {
    * if environment_variables is modified.
    */
   std::vector<const char *> raw_environment_variables;
+
+  // Same as environment_variables and raw_environment_variables, except that
+  // the shared memories are the ones of the standby fork server. Exchanged
+  // with them when the standby fork server is swapped in.
+  std::vector<std::string> standby_environment_variables;
+  std::vector<const char *> raw_standby_environment_variables;
   fuzzuf::utils::vfs::LocalFilesystem filesystem;
 };
 
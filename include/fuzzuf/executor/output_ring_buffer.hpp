@@ -0,0 +1,113 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file output_ring_buffer.hpp
+ * @brief Size-capped buffer receiving what the PUT writes to a pipe
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "fuzzuf/utils/common.hpp"
+
+namespace fuzzuf::executor {
+
+/**
+ * @class OutputRingBuffer
+ * @brief Keeps the last Capacity() bytes read from a pipe.
+ * @details The memory is allocated once, and mapped twice back to back so that
+ * the kept bytes are always contiguous. Data() can be handed out as a view
+ * without copying or rotating it. Pipes are drained with splice() into the
+ * memory, and with read() if the fd can't be spliced.
+ */
+class OutputRingBuffer {
+ public:
+  // 1 MiB, which is enough for ordinary outputs and bounds the memory used for
+  // PUTs printing forever
+  static constexpr std::size_t DEFAULT_CAPACITY = 1u << 20;
+
+  /**
+   * @brief Allocate the buffer
+   * @param capacity Bytes to keep, rounded up to a multiple of the page size
+   */
+  explicit OutputRingBuffer(std::size_t capacity = DEFAULT_CAPACITY);
+  ~OutputRingBuffer();
+
+  OutputRingBuffer(const OutputRingBuffer &) = delete;
+  OutputRingBuffer &operator=(const OutputRingBuffer &) = delete;
+  OutputRingBuffer(OutputRingBuffer &&) noexcept;
+  OutputRingBuffer &operator=(OutputRingBuffer &&) noexcept;
+
+  // Forget the kept bytes. Nothing is freed or overwritten.
+  void Clear() {
+    head = 0;
+    size = 0;
+    total_size = 0;
+  }
+
+  /**
+   * @brief Receive the bytes available in fd. The oldest bytes are dropped
+   * if the buffer overflows.
+   * @param fd Non-blocking fd to read from, usually a pipe
+   * @return True if some bytes were received, false on EOF or if nothing is
+   * available now
+   */
+  bool ReadFrom(int fd);
+
+  // Kept bytes, which are valid until the next call of ReadFrom or Clear
+  u8 *Data() { return base + head; }
+  const u8 *Data() const { return base + head; }
+  std::size_t Size() const { return size; }
+  std::size_t Capacity() const { return capacity; }
+
+  // Bytes received since Clear(), including the dropped ones
+  u64 TotalSize() const { return total_size; }
+  bool IsTruncated() const { return total_size > size; }
+
+ private:
+  void Commit(std::size_t len);
+  void Release();
+
+  u8 *base = nullptr;
+  std::size_t capacity = 0;
+  int memfd = -1;
+  bool splice_unsupported = false;
+
+  std::size_t head = 0;
+  std::size_t size = 0;
+  u64 total_size = 0;
+};
+
+/**
+ * @struct RecordedOutputs
+ * @brief Which fds of the PUT are recorded by an executor, and how many bytes
+ * of each are kept per execution.
+ */
+struct RecordedOutputs {
+  // Records stdout and stderr if true, as the former flag of the executors did
+  RecordedOutputs(bool record_stdout_and_err = false);
+  RecordedOutputs(std::vector<int> fds,
+                  std::size_t capacity = OutputRingBuffer::DEFAULT_CAPACITY);
+
+  std::vector<int> fds;
+  std::size_t capacity;
+};
+
+}  // namespace fuzzuf::executor
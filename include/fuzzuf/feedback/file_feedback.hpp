@@ -48,12 +48,23 @@ class FileFeedback {
   // instead of passing a path like this?
   FileFeedback(fs::path feed_path, std::shared_ptr<u8> executor_lock);
 
+  // The feedback which the executor received in memory instead of the file.
+  // mem must be valid while executor_lock is held.
+  FileFeedback(fs::path feed_path, const u8* mem, u32 len,
+               std::shared_ptr<u8> executor_lock);
+
   // If you want to discard the active instance to start a new execution,
   // then use this like FileFeedback::DiscardActive(std::move(feed))
   static void DiscardActive(FileFeedback /* unused_arg */);
 
   fs::path feed_path;
 
+  // If true, the contents of the feedback are mem and len, and the file at
+  // feed_path may not exist or be stale
+  bool in_memory = false;
+  const u8* mem = nullptr;
+  u32 len = 0;
+
  private:
   std::shared_ptr<u8> executor_lock;
 };
@@ -0,0 +1,128 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file shm_feedback.hpp
+ * @brief Shared memory region proxies write feedback to instead of files
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace fuzzuf::feedback {
+
+/* Layout of the region. All values are in the native byte order.
+ *
+ * The region starts with ShmFeedbackHeader, followed by the records. Each
+ * record is a ShmFeedbackRecordHeader followed by length bytes of data, which
+ * are padded to SHM_FEEDBACK_RECORD_ALIGN bytes.
+ *
+ * The fuzzer clears flags, size and record_count before each execution. A
+ * proxy that supports the region
+ *   1. maps the POSIX shared memory named by SHM_FEEDBACK_ENV_VAR, and sets
+ *      SHM_FEEDBACK_ATTACHED to flags,
+ *   2. appends each record at offset sizeof(ShmFeedbackHeader) + size, which
+ *      it may fill in place, then adds its padded size to size and increments
+ *      record_count,
+ *   3. sets SHM_FEEDBACK_OVERFLOW to flags if a record doesn't fit in
+ *      capacity, and writes that feedback to the file as before instead.
+ * Proxies that don't know the region just write files, and the fuzzer reads
+ * them because SHM_FEEDBACK_ATTACHED is not set. */
+
+constexpr const char *SHM_FEEDBACK_ENV_VAR = "__FUZZUF_FEEDBACK_SHM";
+
+constexpr char SHM_FEEDBACK_MAGIC[4] = {'F', 'Z', 'F', 'B'};
+constexpr std::uint32_t SHM_FEEDBACK_VERSION = 1;
+
+constexpr std::uint32_t SHM_FEEDBACK_ATTACHED = 1u << 0;
+constexpr std::uint32_t SHM_FEEDBACK_OVERFLOW = 1u << 1;
+
+constexpr std::uint32_t SHM_FEEDBACK_RECORD_ALIGN = 8;
+
+struct ShmFeedbackHeader {
+  char magic[4];
+  std::uint32_t version;
+  std::uint32_t capacity;  // Bytes available for the records
+  std::uint32_t flags;
+  std::uint32_t size;  // Bytes of the records written so far
+  std::uint32_t record_count;
+};
+
+struct ShmFeedbackRecordHeader {
+  char tag[4];  // Kind of the data, such as the magic of its file format
+  std::uint32_t length;
+};
+
+static_assert(sizeof(ShmFeedbackHeader) == 24);
+static_assert(sizeof(ShmFeedbackRecordHeader) == 8);
+static_assert(sizeof(ShmFeedbackHeader) % SHM_FEEDBACK_RECORD_ALIGN == 0);
+static_assert(sizeof(ShmFeedbackRecordHeader) % SHM_FEEDBACK_RECORD_ALIGN ==
+              0);
+
+/**
+ * @class ShmFeedbackRegion
+ * @brief Owner side of the region, created by the executor and shared with
+ * the proxies it runs.
+ */
+class ShmFeedbackRegion {
+ public:
+  ShmFeedbackRegion() = default;
+  ~ShmFeedbackRegion() { Erase(); }
+
+  ShmFeedbackRegion(const ShmFeedbackRegion &) = delete;
+  ShmFeedbackRegion &operator=(const ShmFeedbackRegion &) = delete;
+
+  /**
+   * @brief Create the region
+   * @param capacity Bytes available for the records
+   */
+  void Setup(std::uint32_t capacity);
+  void Erase();
+
+  // Clear the records written by the last execution
+  void Reset();
+
+  bool IsSetUp() const { return header != nullptr; }
+
+  // Name passed to shm_open(), which is exported by SHM_FEEDBACK_ENV_VAR
+  const std::string &GetName() const { return name; }
+
+  // True if the proxy of the last execution wrote feedback to the region
+  bool IsAttached() const;
+
+  // True if some feedback of the last execution was written to files
+  bool IsOverflowed() const;
+
+  /**
+   * @brief Find the first record tagged tag written by the last execution
+   * @param tag Tag of the record
+   * @param len Set to the length of the record if found
+   * @return Data of the record, or nullptr if not found or broken
+   */
+  const std::uint8_t *Find(const char (&tag)[4], std::uint32_t &len) const;
+
+ private:
+  ShmFeedbackHeader *header = nullptr;
+  std::size_t mapped_size = 0;
+  int shm_fd = -1;
+  std::string name;
+};
+
+}  // namespace fuzzuf::feedback
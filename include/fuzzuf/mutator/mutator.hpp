@@ -22,6 +22,7 @@
 #include <cassert>
 #include <random>
 #include <variant>
+#include <vector>
 
 #include "fuzzuf/algorithms/afl/afl_dict_data.hpp"
 #include "fuzzuf/algorithms/afl/afl_option.hpp"
@@ -56,12 +57,43 @@ class Mutator {
   // const reference
   const fuzzuf::exec_input::ExecInput &input;
 
+  // outbuf, tmpbuf and splbuf are allocated with new[] and may be larger
+  // than the data they hold. *_capacity is the allocated size, so that
+  // insertions can be done in place while the capacity allows.
   u32 len;
+  u32 capacity;
   u8 *outbuf;
   u8 *tmpbuf;
   u32 temp_len;
+  u32 temp_capacity;
   u8 *splbuf;
   u32 spl_len;
+  u32 spl_capacity;
+
+  // Undo log of Havoc. Instead of copying the whole outbuf before stacking
+  // mutations, each mutation saves only the bytes it is about to destroy, and
+  // RestoreHavoc replays the log backwards.
+  struct UndoEntry {
+    enum Kind : u8 { OVERWRITE, INSERT, DELETE };
+    Kind kind;
+    u32 pos;
+    u32 len;
+    u32 saved;  // Offset of the saved bytes in undo_bytes
+  };
+  std::vector<UndoEntry> undo_log;
+  std::vector<u8> undo_bytes;
+  bool undo_logging;
+  // true if the original buffer has been restored into tmpbuf instead of
+  // being logged. This happens when the log grows larger than the input, or
+  // a custom case, which cannot be logged, is applied.
+  bool havoc_snapshot;
+  u32 havoc_base_len;
+
+  void LogForUndo(typename UndoEntry::Kind kind, u32 pos, u32 n);
+  void ApplyUndoLog(u8 *&buf, u32 &buf_len, u32 &buf_capacity) const;
+  void TakeHavocSnapshot();
+  static void InsertGap(u8 *&buf, u32 &buf_len, u32 &buf_capacity, u32 pos,
+                        u32 n);
 
   std::mt19937 mt_engine;  // TODO: Enabling Dependency Injection for an
                            // easiness of tests
@@ -94,6 +126,8 @@ class Mutator {
   void Replace(int pos, const u8 *buf, u32 len);
   void Insert(u32 pos, const u8 *buf, u32 extra_len);
   void Delete(u32 pos, u32 n);
+  // Open n uninitialized bytes at pos in place, and return the pointer to them
+  u8 *MakeGap(u32 pos, u32 n);
 
   template <typename T>
   T ReadMem(u32 pos);
@@ -147,6 +181,12 @@ class Mutator {
    * should return numbers more than or equal to HavocCase::NUM_CASE. For
    * example, if CaseDistrib returns HavocCase::NUM_CASE+1, then CustomCases
    * receives HavocCase::NUM_CASE+1 as one of its arguments.
+   *
+   * Havoc doesn't copy the input. The mutations are recorded to an undo log,
+   * and RestoreHavoc rolls them back. The buffer must not be modified other
+   * than through the member functions of Mutator until RestoreHavoc is
+   * called. Custom cases may reallocate outbuf with new[], but make Havoc fall
+   * back to restoring a full copy of the input.
    */
   template <typename CustomCases>
   void Havoc(const std::vector<AFLDictData> &extras,
@@ -156,6 +196,14 @@ class Mutator {
 
   void RestoreHavoc(void);
 
+  // true while the mutations are recorded for RestoreHavoc, i.e. after Havoc
+  // until RestoreHavoc or DiscardHavoc
+  bool IsUndoLogging(void) const { return undo_logging; }
+
+  // Keeps the mutations of Havoc as the input, and stops recording the later
+  // ones. RestoreHavoc does nothing until the next Havoc.
+  void DiscardHavoc(void);
+
   const fuzzuf::exec_input::ExecInput &GetSource();
 
   bool Splice(const fuzzuf::exec_input::ExecInput &target);
@@ -181,6 +229,8 @@ T Mutator<Tag>::ReadMem(u32 pos) {
 template <class Tag>
 template <typename T>
 u32 Mutator<Tag>::Overwrite(u32 pos, T chr) {
+  LogForUndo(UndoEntry::OVERWRITE, pos, sizeof(T));
+
   // Special case: we don't need to care about alignment on u8.
   if constexpr (std::is_same_v<u8, T>) {
     outbuf[pos] = chr;
@@ -280,25 +330,13 @@ void Mutator<Tag>::Havoc(const std::vector<AFLDictData> &extras,
   using afl::option::GetHavocBlkXl;
   using afl::option::GetMaxFile;
 
-  // FIXME: all the operations can be rewritten with vector<u8>
-
-  if (temp_len < len) {
-    delete[] tmpbuf;
-    tmpbuf = nullptr;
-  }
-
-  if (!tmpbuf) {
-    tmpbuf = new u8[len];
-  }
-
-  std::memcpy(tmpbuf, outbuf, len);
-  temp_len = len;
-
-  // swap outbuf and tmpbuf to use mutation function on tmpbuf
-  // also, if we want to restore the original buffer
-  // we can just swap them again
-  std::swap(outbuf, tmpbuf);
-  std::swap(len, temp_len);
+  // Start a new undo log. If the previous Havoc was not restored, its
+  // mutations are kept as a part of the input.
+  undo_log.clear();
+  undo_bytes.clear();
+  undo_logging = true;
+  havoc_snapshot = false;
+  havoc_base_len = len;
 
   // just an alias of afl::util::UR
   auto UR = [this](u32 limit) { return afl::util::UR(limit, rand_fd); };
@@ -567,13 +605,17 @@ void Mutator<Tag>::Havoc(const std::vector<AFLDictData> &extras,
         selected_case_histogram[r] += 1;
         break;
 
-      case XOR:
+      case XOR: {
         /* Just set a random byte to a random value. Because,
            why not. We use XOR with 1-255 to eliminate the
            possibility of a no-op. */
-        outbuf[UR(len)] ^= 1 + UR(255);
+        u8 val = 1 + UR(255);
+        u32 pos = UR(len);
+        LogForUndo(UndoEntry::OVERWRITE, pos, 1);
+        outbuf[pos] ^= val;
         selected_case_histogram[r] += 1;
         break;
+      }
 
       case DELETE_BYTES: {
         /* Delete bytes. We're making this a bit more likely
@@ -586,9 +628,7 @@ void Mutator<Tag>::Havoc(const std::vector<AFLDictData> &extras,
         u32 del_len = ChooseBlockLen(len - 1);
         u32 del_from = UR(len - del_len + 1);
 
-        std::memmove(outbuf + del_from, outbuf + del_from + del_len,
-                     len - del_from - del_len);
-        len -= del_len;
+        Delete(del_from, del_len);
 
         selected_case_histogram[r] += 1;
         break;
@@ -602,20 +642,21 @@ void Mutator<Tag>::Havoc(const std::vector<AFLDictData> &extras,
           u32 clone_from = UR(len - clone_len + 1);
           u32 clone_to = UR(len);
 
-          u8 *new_buf = new u8[len + clone_len];
-
-          /* Head */
-          std::memcpy(new_buf, outbuf, clone_to);
+          MakeGap(clone_to, clone_len);
 
           /* Inserted part */
-          std::memcpy(new_buf + clone_to, outbuf + clone_from, clone_len);
-
-          /* Tail */
-          std::memcpy(new_buf + clone_to + clone_len, outbuf + clone_to,
-                      len - clone_to);
-          delete[] outbuf;
-          outbuf = new_buf;
-          len += clone_len;
+          // The bytes at or after clone_to have been shifted by the gap
+          if (clone_from + clone_len <= clone_to) {
+            std::memcpy(outbuf + clone_to, outbuf + clone_from, clone_len);
+          } else if (clone_to <= clone_from) {
+            std::memcpy(outbuf + clone_to, outbuf + clone_from + clone_len,
+                        clone_len);
+          } else {
+            u32 head_len = clone_to - clone_from;
+            std::memcpy(outbuf + clone_to, outbuf + clone_from, head_len);
+            std::memcpy(outbuf + clone_to + head_len,
+                        outbuf + clone_to + clone_len, clone_len - head_len);
+          }
           selected_case_histogram[r] += 1;
         }
         break;
@@ -627,22 +668,10 @@ void Mutator<Tag>::Havoc(const std::vector<AFLDictData> &extras,
           u32 clone_len = ChooseBlockLen(GetHavocBlkXl<Tag>());
           u32 clone_to = UR(len);
 
-          u8 *new_buf = new u8[len + clone_len];
-
-          /* Head */
-          std::memcpy(new_buf, outbuf, clone_to);
-
           /* Inserted part */
           // FIXME: why not unroll UR(2) also and create a new case?
-          std::memset(new_buf + clone_to, UR(2) ? UR(256) : outbuf[UR(len)],
-                      clone_len);
-
-          /* Tail */
-          std::memcpy(new_buf + clone_to + clone_len, outbuf + clone_to,
-                      len - clone_to);
-          delete[] outbuf;
-          outbuf = new_buf;
-          len += clone_len;
+          u8 val = UR(2) ? UR(256) : outbuf[UR(len)];
+          std::memset(MakeGap(clone_to, clone_len), val, clone_len);
           selected_case_histogram[r] += 1;
         }
         break;
@@ -656,8 +685,10 @@ void Mutator<Tag>::Havoc(const std::vector<AFLDictData> &extras,
         u32 copy_from = UR(len - copy_len + 1);
         u32 copy_to = UR(len - copy_len + 1);
 
-        if (likely(copy_from != copy_to))
+        if (likely(copy_from != copy_to)) {
+          LogForUndo(UndoEntry::OVERWRITE, copy_to, copy_len);
           std::memmove(outbuf + copy_to, outbuf + copy_from, copy_len);
+        }
 
         selected_case_histogram[r] += 1;
         break;
@@ -672,8 +703,9 @@ void Mutator<Tag>::Havoc(const std::vector<AFLDictData> &extras,
         u32 copy_to = UR(len - copy_len + 1);
 
         // FIXME: why not unroll "UR(2)" also and create a new case?
-        std::memset(outbuf + copy_to, UR(2) ? UR(256) : outbuf[UR(len)],
-                    copy_len);
+        u8 val = UR(2) ? UR(256) : outbuf[UR(len)];
+        LogForUndo(UndoEntry::OVERWRITE, copy_to, copy_len);
+        std::memset(outbuf + copy_to, val, copy_len);
         selected_case_histogram[r] += 1;
         break;
       }
@@ -702,7 +734,7 @@ void Mutator<Tag>::Havoc(const std::vector<AFLDictData> &extras,
         if (extra_len > len) break;
 
         u32 insert_at = UR(len - extra_len + 1);
-        std::memcpy(outbuf + insert_at, &extra.data[0], extra_len);
+        Replace(insert_at, &extra.data[0], extra_len);
 
         selected_case_histogram[r] += 1;
         break;
@@ -731,29 +763,22 @@ void Mutator<Tag>::Havoc(const std::vector<AFLDictData> &extras,
         u32 extra_len = extra.data.size();
         if (len + extra_len >= GetMaxFile<Tag>()) break;
 
-        u8 *new_buf = new u8[len + extra_len];
-
-        /* Head */
-        std::memcpy(new_buf, outbuf, insert_at);
-
-        /* Inserted part */
-        std::memcpy(new_buf + insert_at, &extra.data[0], extra_len);
-
-        /* Tail */
-        std::memcpy(new_buf + insert_at + extra_len, outbuf + insert_at,
-                    len - insert_at);
-
-        delete[] outbuf;
-        outbuf = new_buf;
-        len += extra_len;
+        Insert(insert_at, &extra.data[0], extra_len);
 
         selected_case_histogram[r] += 1;
         break;
       }
 
-      default:
+      default: {
+        // Custom cases modify outbuf directly, so they cannot be logged
+        if (undo_logging) TakeHavocSnapshot();
+
+        const u8 *prev_outbuf = outbuf;
         custom_cases(r, outbuf, len, extras, a_extras);
+        // A custom case reallocating outbuf allocates just len bytes
+        if (outbuf != prev_outbuf) capacity = len;
         break;
+      }
     }
 
     optimizer::Store::GetInstance().Set(optimizer::keys::SizeOfMutatedSeed,
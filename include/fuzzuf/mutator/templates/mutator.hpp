@@ -17,6 +17,7 @@
  */
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <random>
 
@@ -88,11 +89,17 @@ template <class Tag>
 Mutator<Tag>::Mutator(const fuzzuf::exec_input::ExecInput& input)
     : input(input),
       len(input.GetLen()),
+      capacity(len),
       outbuf(new u8[len]),
       tmpbuf(nullptr),
       temp_len(0),
+      temp_capacity(0),
       splbuf(nullptr),
       spl_len(0),
+      spl_capacity(0),
+      undo_logging(false),
+      havoc_snapshot(false),
+      havoc_base_len(0),
       rand_fd(fuzzuf::utils::OpenFile("/dev/urandom", O_RDONLY | O_CLOEXEC)) {
   std::memcpy(outbuf, input.GetBuf(), len);
 }
@@ -112,11 +119,19 @@ template <class Tag>
 Mutator<Tag>::Mutator(Mutator&& src)
     : input(src.input),
       len(src.len),
+      capacity(src.capacity),
       outbuf(src.outbuf),
       tmpbuf(src.tmpbuf),
       temp_len(src.temp_len),
+      temp_capacity(src.temp_capacity),
       splbuf(src.splbuf),
       spl_len(src.spl_len),
+      spl_capacity(src.spl_capacity),
+      undo_log(std::move(src.undo_log)),
+      undo_bytes(std::move(src.undo_bytes)),
+      undo_logging(src.undo_logging),
+      havoc_snapshot(src.havoc_snapshot),
+      havoc_base_len(src.havoc_base_len),
       rand_fd(src.rand_fd) {
   src.outbuf = nullptr;
   src.tmpbuf = nullptr;
@@ -177,6 +192,7 @@ u32 Mutator<Tag>::OverwriteWithSet(u32 pos, const std::vector<char>& char_set) {
   std::vector<char> out;
   std::sample(char_set.begin(), char_set.end(), std::back_inserter(out), 1,
               mt_engine);
+  LogForUndo(UndoEntry::OVERWRITE, pos, 1);
   outbuf[pos] = out[0];
   return 1;
 }
@@ -185,6 +201,12 @@ template <class Tag>
 u32 Mutator<Tag>::FlipBit(u32 pos, int n) {
   /* Flip bits */
 
+  if (n > 0) {
+    u32 first_byte = pos >> 3;
+    u32 last_byte = (pos + n - 1) >> 3;
+    LogForUndo(UndoEntry::OVERWRITE, first_byte, last_byte - first_byte + 1);
+  }
+
   for (int i = 0; i < n;
        i++) {  // Suspected buffer overrun when pos + n - 1 > sizeof(outbuf)?
     u32 flip = pos + i;
@@ -201,6 +223,7 @@ u32 Mutator<Tag>::FlipByte(u32 pos, int n) {
   // why we don't *(T*)(outbuf + pos) ^= T(1 << n) - 1; ?
   // it can be unaligned memory access
   if (n == 1) {
+    LogForUndo(UndoEntry::OVERWRITE, pos, 1);
     outbuf[pos] ^= 0xff;
   } else if (n == 2) {
     u16 v = ReadMem<u16>(pos);
@@ -215,38 +238,155 @@ u32 Mutator<Tag>::FlipByte(u32 pos, int n) {
 
 template <class Tag>
 void Mutator<Tag>::Replace(int pos, const u8* buf, u32 len) {
+  LogForUndo(UndoEntry::OVERWRITE, pos, len);
   std::memcpy(outbuf + pos, buf, len);
 }
 
+/*
+ * Postcondition:
+ *  - buf_len is increased by n, and the bytes in [pos, buf_len) are moved
+ * backward by n. The bytes in [pos, pos + n) are left uninitialized.
+ *  - buf is reallocated only if buf_capacity is not enough. In this case, the
+ * capacity is at least doubled so that repeated insertions are amortized.
+ */
 template <class Tag>
-void Mutator<Tag>::Insert(u32 pos, const u8* buf, u32 extra_len) {
-  u8* new_buf = new u8[len + extra_len];
-
-  /* Head */
-  std::memcpy(new_buf, outbuf, pos);
-
-  /* Inserted part */
-  std::memcpy(new_buf + pos, buf, extra_len);
+void Mutator<Tag>::InsertGap(u8*& buf, u32& buf_len, u32& buf_capacity,
+                             u32 pos, u32 n) {
+  if (buf_len + n <= buf_capacity) {
+    std::memmove(buf + pos + n, buf + pos, buf_len - pos);
+  } else {
+    u32 new_capacity = std::max(buf_len + n, buf_capacity * 2);
+    u8* new_buf = new u8[new_capacity];
+
+    /* Head */
+    std::memcpy(new_buf, buf, pos);
+
+    /* Tail */
+    std::memcpy(new_buf + pos + n, buf + pos, buf_len - pos);
+
+    delete[] buf;
+    buf = new_buf;
+    buf_capacity = new_capacity;
+  }
+  buf_len += n;
+}
 
-  /* Tail */
-  std::memcpy(new_buf + pos + extra_len, outbuf + pos, len - pos);
+template <class Tag>
+u8* Mutator<Tag>::MakeGap(u32 pos, u32 n) {
+  LogForUndo(UndoEntry::INSERT, pos, n);
+  InsertGap(outbuf, len, capacity, pos, n);
+  return outbuf + pos;
+}
 
-  delete[] outbuf;
-  outbuf = new_buf;
-  len += extra_len;
+template <class Tag>
+void Mutator<Tag>::Insert(u32 pos, const u8* buf, u32 extra_len) {
+  std::memcpy(MakeGap(pos, extra_len), buf, extra_len);
 }
 
 template <class Tag>
 void Mutator<Tag>::Delete(u32 pos, u32 n) {
+  LogForUndo(UndoEntry::DELETE, pos, n);
   std::memmove(outbuf + pos, outbuf + pos + n, len - pos - n);
   len -= n;
 }
 
+/*
+ * Postcondition:
+ *  - If Havoc is in progress, the modification of n bytes at pos described by
+ * kind is recorded, so that RestoreHavoc can revert it. The bytes to be
+ * overwritten or deleted are saved. Otherwise, nothing happens.
+ *  - If the saved bytes would exceed the size of the input given to Havoc,
+ * the original input is restored into tmpbuf instead, since the log no longer
+ * saves any copy.
+ */
+template <class Tag>
+void Mutator<Tag>::LogForUndo(typename UndoEntry::Kind kind, u32 pos, u32 n) {
+  if (likely(!undo_logging)) return;
+
+  if (kind == UndoEntry::INSERT) {
+    undo_log.push_back({kind, pos, n, 0});
+    return;
+  }
+
+  if (undo_bytes.size() + n > havoc_base_len) {
+    TakeHavocSnapshot();
+    return;
+  }
+
+  undo_log.push_back({kind, pos, n, static_cast<u32>(undo_bytes.size())});
+  undo_bytes.insert(undo_bytes.end(), outbuf + pos, outbuf + pos + n);
+}
+
+// Revert the modifications recorded in undo_log on buf, from the newest one
+template <class Tag>
+void Mutator<Tag>::ApplyUndoLog(u8*& buf, u32& buf_len,
+                                u32& buf_capacity) const {
+  for (auto entry = undo_log.rbegin(); entry != undo_log.rend(); ++entry) {
+    switch (entry->kind) {
+      case UndoEntry::OVERWRITE:
+        std::memcpy(buf + entry->pos, undo_bytes.data() + entry->saved,
+                    entry->len);
+        break;
+      case UndoEntry::INSERT:
+        std::memmove(buf + entry->pos, buf + entry->pos + entry->len,
+                     buf_len - entry->pos - entry->len);
+        buf_len -= entry->len;
+        break;
+      case UndoEntry::DELETE:
+        InsertGap(buf, buf_len, buf_capacity, entry->pos, entry->len);
+        std::memcpy(buf + entry->pos, undo_bytes.data() + entry->saved,
+                    entry->len);
+        break;
+    }
+  }
+}
+
+/*
+ * Postcondition:
+ *  - tmpbuf holds the input given to Havoc, and outbuf is left as is.
+ *  - The undo log is discarded and no more modifications are logged until the
+ * next Havoc. RestoreHavoc swaps outbuf and tmpbuf instead.
+ */
+template <class Tag>
+void Mutator<Tag>::TakeHavocSnapshot() {
+  if (temp_capacity < len) {
+    delete[] tmpbuf;
+    tmpbuf = new u8[len];
+    temp_capacity = len;
+  }
+  std::memcpy(tmpbuf, outbuf, len);
+  temp_len = len;
+  ApplyUndoLog(tmpbuf, temp_len, temp_capacity);
+
+  undo_log.clear();
+  undo_bytes.clear();
+  undo_logging = false;
+  havoc_snapshot = true;
+}
+
 // FIXME: add a test which uses this with AFLMutationHierarFlowRoutines
 template <class Tag>
 void Mutator<Tag>::RestoreHavoc(void) {
-  std::swap(outbuf, tmpbuf);
-  std::swap(len, temp_len);
+  if (havoc_snapshot) {
+    std::swap(outbuf, tmpbuf);
+    std::swap(len, temp_len);
+    std::swap(capacity, temp_capacity);
+  } else {
+    ApplyUndoLog(outbuf, len, capacity);
+  }
+
+  undo_log.clear();
+  undo_bytes.clear();
+  undo_logging = false;
+  havoc_snapshot = false;
+}
+
+template <class Tag>
+void Mutator<Tag>::DiscardHavoc(void) {
+  undo_log.clear();
+  undo_bytes.clear();
+  undo_logging = false;
+  havoc_snapshot = false;
 }
 
 // return true if the splice occurred, and false otherwise
@@ -265,12 +405,11 @@ bool Mutator<Tag>::Splice(const fuzzuf::exec_input::ExecInput& target) {
 
   /* Do the thing. */
 
-  if (!splbuf) {
-    splbuf = new u8[target.GetLen()];
-  } else if (spl_len < target.GetLen()) {
-    // We reallocate a buffer only when its size is not enough
+  // We reallocate a buffer only when its size is not enough
+  if (spl_capacity < target.GetLen()) {
     delete[] splbuf;
     splbuf = new u8[target.GetLen()];
+    spl_capacity = target.GetLen();
   }
 
   spl_len = target.GetLen();
@@ -280,6 +419,7 @@ bool Mutator<Tag>::Splice(const fuzzuf::exec_input::ExecInput& target) {
 
   std::swap(outbuf, splbuf);
   std::swap(len, spl_len);
+  std::swap(capacity, spl_capacity);
   return true;
 }
 
@@ -288,6 +428,7 @@ template <class Tag>
 void Mutator<Tag>::RestoreSplice(void) {
   std::swap(outbuf, splbuf);
   std::swap(len, spl_len);
+  std::swap(capacity, spl_capacity);
 }
 
 }  // namespace fuzzuf::mutator
@@ -0,0 +1,102 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file async_writer.hpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#ifndef FUZZUF_INCLUDE_UTILS_ASYNC_WRITER_HPP
+#define FUZZUF_INCLUDE_UTILS_ASYNC_WRITER_HPP
+#include <semaphore.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <thread>
+
+#include "fuzzuf/utils/filesystem.hpp"
+
+namespace fuzzuf::utils {
+
+/**
+ * @class AsyncWriter
+ * @brief Runs jobs, such as writing status files, on a background thread.
+ * @details Jobs are passed through a fixed-size single-producer
+ * single-consumer ring, so Post neither takes a lock nor waits for the disk.
+ * Post must always be called from the same thread. Jobs run in the order
+ * they are posted, and the ones still pending run before the destructor
+ * returns.
+ * If a job throws, the exception is kept and rethrown on the posting thread
+ * by every following call of Post, PostOrWait and Flush. The jobs posted
+ * later still run.
+ */
+class AsyncWriter {
+ public:
+  using Job = std::function<void()>;
+  static constexpr std::size_t CAPACITY = 64;
+
+  AsyncWriter();
+  ~AsyncWriter();
+
+  AsyncWriter(const AsyncWriter &) = delete;
+  AsyncWriter &operator=(const AsyncWriter &) = delete;
+
+  /**
+   * Queue job to be run on the background thread.
+   * @return false if CAPACITY jobs are already pending. job is dropped then.
+   */
+  bool Post(Job &&job);
+
+  /**
+   * Queue job like Post, but wait for a free slot if the ring is full, so
+   * that job never runs ahead of the pending ones.
+   */
+  void PostOrWait(Job &&job);
+
+  /**
+   * Wait until all the jobs posted so far have finished.
+   */
+  void Flush();
+
+ private:
+  void Run();
+  void RethrowError();
+
+  std::array<Job, CAPACITY> jobs;
+  std::atomic<std::size_t> head = 0;  // Next job to run, advanced by Run
+  std::atomic<std::size_t> tail = 0;  // Next free slot, advanced by Post
+  std::atomic<bool> stopping = false;
+  // Set by Run only once, and read after failed becomes true
+  std::exception_ptr error;
+  std::atomic<bool> failed = false;
+  sem_t posted;  // Counts jobs posted, plus one for stopping
+  std::thread worker;
+};
+
+/**
+ * Replace the content of path with data. data is written to a temporary
+ * file first and renamed to path, so that readers of path never see a
+ * partially written file.
+ * @return false if the file couldn't be written.
+ */
+bool WriteFileAtomically(const fs::path &path, const void *data,
+                         std::size_t len);
+
+}  // namespace fuzzuf::utils
+#endif
@@ -0,0 +1,171 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file checkpoint.hpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#ifndef FUZZUF_INCLUDE_UTILS_CHECKPOINT_HPP
+#define FUZZUF_INCLUDE_UTILS_CHECKPOINT_HPP
+#include <sys/types.h>
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "fuzzuf/exceptions.hpp"
+#include "fuzzuf/utils/common.hpp"
+#include "fuzzuf/utils/filesystem.hpp"
+
+namespace fuzzuf::utils {
+
+/**
+ * @class CheckpointWriter
+ * @brief Serializes values into a flat little-endian byte sequence.
+ * @details Only trivially copyable values and vectors or strings of them are
+ * supported. The byte sequence starts with a magic number and the format
+ * version given by the caller, so that readers can reject checkpoints
+ * written by incompatible versions.
+ */
+class CheckpointWriter {
+ public:
+  static constexpr u64 MAGIC = 0x544E504B43465546;  // "FUFCKPNT"
+
+  explicit CheckpointWriter(u32 version) {
+    Write(MAGIC);
+    Write(version);
+  }
+
+  template <class T>
+  void Write(const T &value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    auto *p = reinterpret_cast<const u8 *>(&value);
+    data.insert(data.end(), p, p + sizeof(T));
+  }
+
+  template <class T>
+  void WriteVector(const std::vector<T> &values) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    Write(u64(values.size()));
+    auto *p = reinterpret_cast<const u8 *>(values.data());
+    data.insert(data.end(), p, p + values.size() * sizeof(T));
+  }
+
+  void WriteString(const std::string &value) {
+    WriteVector(std::vector<char>(value.begin(), value.end()));
+  }
+
+  // Reserves a u32 for the size of the file at path. The file isn't stat-ed
+  // until ResolveFileSizes, so that the caller of
+  // WriteCheckpointFileInBackground doesn't wait for it.
+  void WriteFileSize(const fs::path &path) {
+    file_sizes.push_back({data.size(), path.string()});
+    Write(u32(0));
+  }
+
+  // Fills the sizes reserved by WriteFileSize. Only async-signal-safe
+  // functions are called. Returns false if any of the files can't be stat-ed.
+  bool ResolveFileSizes();
+
+  const std::vector<u8> &GetData() const { return data; }
+
+ private:
+  struct FileSize {
+    std::size_t offset;
+    std::string path;
+  };
+
+  std::vector<u8> data;
+  std::vector<FileSize> file_sizes;
+};
+
+/**
+ * @class CheckpointReader
+ * @brief Deserializes values written by CheckpointWriter.
+ * @details Throws exceptions::invalid_file if the data is not a checkpoint or
+ * ends before the requested value.
+ */
+class CheckpointReader {
+ public:
+  explicit CheckpointReader(std::vector<u8> &&data);
+
+  u32 GetVersion() const { return version; }
+  bool AtEnd() const { return offset == data.size(); }
+
+  template <class T>
+  T Read() {
+    static_assert(std::is_trivially_copyable_v<T>);
+    T value;
+    Take(&value, sizeof(T));
+    return value;
+  }
+
+  template <class T>
+  std::vector<T> ReadVector() {
+    static_assert(std::is_trivially_copyable_v<T>);
+    u64 size = Read<u64>();
+    if (size > (data.size() - offset) / sizeof(T)) {
+      throw exceptions::invalid_file("Checkpoint is truncated", __FILE__,
+                                     __LINE__);
+    }
+    std::vector<T> values(size);
+    Take(values.data(), size * sizeof(T));
+    return values;
+  }
+
+  std::string ReadString() {
+    auto chars = ReadVector<char>();
+    return std::string(chars.begin(), chars.end());
+  }
+
+ private:
+  void Take(void *dest, std::size_t size);
+
+  std::vector<u8> data;
+  std::size_t offset = 0;
+  u32 version = 0;
+};
+
+/**
+ * Write a checkpoint to path, followed by its checksum. The file is written
+ * to a temporary file first and renamed to path, so that path always holds
+ * a complete checkpoint even if the process dies while writing. The file
+ * sizes reserved in writer are resolved first.
+ */
+void WriteCheckpointFile(const fs::path &path, CheckpointWriter &writer);
+
+/**
+ * Same as WriteCheckpointFile, except that the file sizes are resolved and
+ * the file is written by a forked child process, so that the caller doesn't
+ * wait for the file system. writer is left as is in the caller. The child
+ * only calls async-signal-safe functions, and exits with 1 if it fails. The
+ * caller must reap the returned process with waitpid.
+ * @return pid of the child, or -1 if fork failed.
+ */
+pid_t WriteCheckpointFileInBackground(const fs::path &path,
+                                      CheckpointWriter &writer);
+
+/**
+ * Read a checkpoint written by WriteCheckpointFile.
+ * Throws exceptions::invalid_file if the file can't be read or the checksum
+ * doesn't match.
+ */
+CheckpointReader ReadCheckpointFile(const fs::path &path);
+
+}  // namespace fuzzuf::utils
+#endif
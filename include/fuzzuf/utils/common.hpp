@@ -209,6 +209,7 @@ inline u32 Hash32(const void *key, u32 len, [[maybe_unused]] u32 seed) {
 u32 CountBits(const u8 *mem, u32 len);
 u32 CountBytes(const u8 *mem, u32 len);
 u32 CountNon255Bytes(const u8 *mem, u32 len);
+void CollectNonZeroBytes(const u8 *mem, u32 len, std::vector<u32> &indices);
 
 void MinimizeBits(u8 *dst, const u8 *src, u32 len);
 
@@ -0,0 +1,115 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file compact_bitmap.hpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#ifndef FUZZUF_INCLUDE_UTILS_COMPACT_BITMAP_HPP
+#define FUZZUF_INCLUDE_UTILS_COMPACT_BITMAP_HPP
+#include <cstddef>
+#include <vector>
+
+#include "fuzzuf/utils/common.hpp"
+
+namespace fuzzuf::utils {
+
+/**
+ * @class CompactBitmap
+ * @brief Set of u32 indices, stored like a roaring bitmap.
+ * @details The index space is split into chunks of 65536 indices, and only
+ * chunks containing at least one index are stored. A chunk holds a sorted
+ * array of the lower 16 bits while it has at most ARRAY_MAX indices, and a
+ * plain 8KiB bitmap otherwise. Therefore a set never takes much more memory
+ * than a std::bitset covering the same range, and a sparse set, such as the
+ * edges hit by a single execution, takes 2 bytes per index.
+ */
+class CompactBitmap {
+ public:
+  static constexpr u32 ARRAY_MAX = 4096;
+
+  CompactBitmap() = default;
+
+  /**
+   * Construct a set from indices sorted in ascending order without
+   * duplicates, e.g. the result of CollectNonZeroBytes.
+   */
+  explicit CompactBitmap(const std::vector<u32> &sorted_indices);
+
+  bool Test(u32 index) const;
+  bool Empty() const { return chunks.empty(); }
+  std::size_t Count() const;
+
+  // Returns true if this and other share at least one index
+  bool Intersects(const CompactBitmap &other) const;
+
+  CompactBitmap &operator|=(const CompactBitmap &other);
+  CompactBitmap &operator&=(const CompactBitmap &other);
+
+  bool operator==(const CompactBitmap &other) const;
+  bool operator!=(const CompactBitmap &other) const {
+    return !(*this == other);
+  }
+
+  /**
+   * Call func with each index in ascending order.
+   */
+  template <class Func>
+  void ForEach(Func &&func) const {
+    for (const auto &chunk : chunks) {
+      u32 base = u32(chunk.key) << 16;
+      if (chunk.words.empty()) {
+        for (u16 low : chunk.array) func(base | low);
+      } else {
+        for (u32 w = 0; w < WORDS; w++) {
+          for (u64 word = chunk.words[w]; word; word &= word - 1) {
+            func(base | (w << 6) | u32(__builtin_ctzll(word)));
+          }
+        }
+      }
+    }
+  }
+
+  // Bytes allocated for the indices, excluding this object itself
+  std::size_t GetMemoryUsage() const;
+
+ private:
+  static constexpr u32 WORDS = 65536 / 64;
+
+  struct Chunk {
+    u16 key = 0;             // Upper 16 bits of the indices
+    u32 count = 0;           // Number of indices in this chunk
+    std::vector<u16> array;  // Sorted lower 16 bits, if words is empty
+    std::vector<u64> words;  // Bitmap of the lower 16 bits, if not empty
+
+    bool Test(u16 low) const;
+    void ToWords();
+    void Normalize();
+  };
+
+  static void UniteChunk(Chunk &dest, const Chunk &src);
+  static void IntersectChunk(Chunk &dest, const Chunk &src);
+  static bool ChunksIntersect(const Chunk &l, const Chunk &r);
+
+  const Chunk *FindChunk(u16 key) const;
+
+  // Chunks in ascending order of key, never empty
+  std::vector<Chunk> chunks;
+};
+
+}  // namespace fuzzuf::utils
+#endif
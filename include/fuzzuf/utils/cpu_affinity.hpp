@@ -0,0 +1,105 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file cpu_affinity.hpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#ifndef FUZZUF_INCLUDE_UTILS_CPU_AFFINITY_HPP
+#define FUZZUF_INCLUDE_UTILS_CPU_AFFINITY_HPP
+#include <vector>
+
+#include "fuzzuf/utils/filesystem.hpp"
+
+namespace fuzzuf::utils {
+
+// Directory where the lock files of CPU cores are created by default.
+// The directory is shared among all fuzzuf instances on the same host.
+constexpr const char *DEFAULT_CPU_LOCK_DIR = "/tmp/fuzzuf-cpu-lock";
+
+/**
+ * Set the directory used by LockCpu. This must be called before the first
+ * BindCpu to take effect.
+ */
+void SetCpuLockDir(const fs::path &dir);
+
+/**
+ * Take the lock file of the CPU core exclusively, so that fuzzuf instances
+ * starting at the same time never pick the same core. The lock is held until
+ * the process exits, and is released by the kernel even if the process
+ * crashes.
+ * @param cpuid CPU core ID to lock.
+ * @return true if the lock is taken (or has already been taken by this
+ * process), false if another process holds it or the lock file can't be
+ * opened or locked. A warning is shown in the latter case.
+ */
+bool LockCpu(int cpuid);
+
+/**
+ * Lock another free CPU core in addition to the one BindCpu has bound the
+ * fuzzer to, so that an executor running in parallel with the main one can
+ * run its PUT processes there.
+ * @param cpu_core_count Number of CPU cores in the machine.
+ * @return The locked core ID, or CPUID_DO_NOT_BIND if no core is free.
+ */
+int LockVacantCpu(int cpu_core_count);
+
+/**
+ * Release a CPU core locked by LockVacantCpu, so that other fuzzuf instances
+ * can use it. The PUT processes bound to the core must have exited.
+ * @param cpuid CPU core ID returned by LockVacantCpu. Other values are
+ * ignored.
+ */
+void ReleaseVacantCpu(int cpuid);
+
+/**
+ * Get CPU core IDs sharing the same physical core with cpuid (SMT siblings),
+ * including cpuid itself.
+ * If the topology is unavailable, only cpuid is returned.
+ */
+std::vector<int> GetSmtSiblings(int cpuid);
+
+/**
+ * If true, BindCpu binds PUT processes launched by executors to an SMT sibling
+ * of the core the fuzzer is bound to. Otherwise, PUT processes share the core
+ * with the fuzzer. This must be called before the first BindCpu to take
+ * effect.
+ */
+void SetBindPutToSmtSibling(bool enable);
+
+/**
+ * Get the CPU core ID the fuzzer is bound to by BindCpu, or
+ * CPUID_DO_NOT_BIND if BindCpu has not bound the process yet.
+ */
+int GetBoundCpu();
+
+/**
+ * Apply the CPU affinity chosen for PUT processes by BindCpu to the calling
+ * process. Executors call this in the child process before exec, so this
+ * only calls sched_setaffinity and never allocates.
+ * Does nothing if BindCpu has not bound the process.
+ */
+void BindPutCpu();
+
+/**
+ * Same as BindPutCpu(), except that the calling process is bound to cpuid
+ * unless it is CPUID_DO_NOT_BIND. Also safe to call after fork.
+ */
+void BindPutCpu(int cpuid);
+
+}  // namespace fuzzuf::utils
+#endif
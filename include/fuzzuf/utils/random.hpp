@@ -26,12 +26,14 @@
 
 #include <algorithm>
 #include <array>
+#include <cmath>
 #include <limits>
 #include <numeric>
 #include <random>
 #include <stdexcept>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace fuzzuf::utils::random {
 
@@ -205,5 +207,145 @@ class WalkerDiscreteDistribution {
   std::vector<double> _threshold;
 };
 
+/**
+ * Discrete distribution whose weights can be changed or appended one by one.
+ * Unlike WalkerDiscreteDistribution, which must be built again from all the
+ * weights, every operation takes O(log n) because the weights are summed up
+ * in a Fenwick tree.
+ */
+template <class T = size_t>
+class FenwickDiscreteDistribution {
+ public:
+  FenwickDiscreteDistribution() {}
+
+  /**
+   * @fn
+   * @brief Construct discrete distribution from iterator
+   * @param (s) Begin iterator
+   * @param (e) End iterator
+   */
+  template <class InputIterator>
+  FenwickDiscreteDistribution(const InputIterator s, const InputIterator e) {
+    for (auto it = s; it != e; ++it) {
+      double p = static_cast<double>(*it);
+      CheckWeight(p);
+      _weight.push_back(p);
+      if (p > 0.0) _positive++;
+    }
+    Rebuild();
+  }
+
+  /**
+   * @fn
+   * @brief Construct discrete distribution from vector
+   * @param (probs) Array of probabilities (weights)
+   */
+  template <class Double>
+  FenwickDiscreteDistribution(const std::vector<Double>& probs)
+      : FenwickDiscreteDistribution(probs.cbegin(), probs.cend()) {}
+
+  size_t Size() const { return _weight.size(); }
+  double Get(size_t i) const { return _weight.at(i); }
+
+  /**
+   * @fn
+   * @brief Append an index with weight p
+   */
+  void Push(double p) {
+    CheckWeight(p);
+    _weight.push_back(p);
+
+    /* The new node covers (i - lowbit(i), i], whose sum except p is
+       already known from the other nodes */
+    size_t i = _weight.size();
+    _tree.push_back(p + PrefixSum(i - 1) - PrefixSum(i - (i & -i)));
+    _sum += p;
+    if (p > 0.0) _positive++;
+  }
+
+  /**
+   * @fn
+   * @brief Change the weight of index i to p
+   */
+  void Set(size_t i, double p) {
+    CheckWeight(p);
+    double delta = p - _weight.at(i);
+    if (_weight[i] > 0.0) _positive--;
+    if (p > 0.0) _positive++;
+    _weight[i] = p;
+
+    for (size_t j = i + 1; j <= _tree.size(); j += j & -j) _tree[j - 1] += delta;
+    _sum += delta;
+
+    /* Rounding errors of the updates may leave the sum positive after every
+       weight is set to 0, or not positive while some weights are. The tree is
+       rebuilt from the weights in that case. */
+    if (!_positive != !(_sum > 0.0)) Rebuild();
+  }
+
+  /**
+   * @fn
+   * @brief Randomly choose an index
+   * @return Array index chosen by weighted random
+   */
+  size_t operator()() const {
+    if (_weight.empty()) throw std::out_of_range("Array must not be empty");
+    if (!_positive || !(_sum > 0.0))
+      throw std::range_error("Sum of weights must be positive");
+
+    double r = Random<double>(0.0, _sum);
+
+    /* Descend the tree to the first index whose prefix sum exceeds r */
+    size_t pos = 0;
+    size_t step = size_t(1) << (63 - __builtin_clzll(_tree.size()));
+    for (; step; step >>= 1) {
+      if (pos + step <= _tree.size() && _tree[pos + step - 1] <= r) {
+        pos += step;
+        r -= _tree[pos - 1];
+      }
+    }
+
+    /* Rounding errors accumulated by Set may lead outside or to an index
+       which can't be chosen */
+    if (pos == _weight.size()) pos--;
+    if (_weight[pos] == 0.0) {
+      auto it = std::find_if(_weight.begin(), _weight.end(),
+                             [](double p) { return p > 0.0; });
+      pos = std::distance(_weight.begin(), it);
+    }
+    return pos;
+  }
+
+ private:
+  static void CheckWeight(double p) {
+    if (p < 0.0 || std::isnan(p))
+      throw std::range_error("Weight must not be negative or NaN");
+  }
+
+  // Build the tree and the sum from the weights in O(n) by passing each
+  // partial sum to its parent
+  void Rebuild() {
+    _tree = _weight;
+    for (size_t i = 1; i <= _tree.size(); i++) {
+      size_t parent = i + (i & -i);
+      if (parent <= _tree.size()) _tree[parent - 1] += _tree[i - 1];
+    }
+    _sum = std::accumulate(_weight.begin(), _weight.end(), 0.0);
+  }
+
+  // Sum of the weights of indices [0, i)
+  double PrefixSum(size_t i) const {
+    double sum = 0.0;
+    for (; i; i -= i & -i) sum += _tree[i - 1];
+    return sum;
+  }
+
+  std::vector<double> _weight;
+  std::vector<double> _tree;
+  double _sum = 0.0;
+  // Number of the positive weights, which is exact unlike _sum
+  size_t _positive = 0;
+};
+
 }  // namespace fuzzuf::utils::random
 #endif
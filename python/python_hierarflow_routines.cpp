@@ -131,9 +131,13 @@ utils::NullableRef<hierarflow::HierarFlowCallee<void(u32)>> PyHavoc::operator()(
   using algorithm::afl::dictionary::AFLDictData;
 
   optimizer::ConstantBatchHavocOptimizer havoc_optimizer(1 << stacking, mutop_optimizer);
+  // The mutations are kept as the input, so the undo log of Havoc is needed
+  // only if the caller was already recording one
+  const bool undo_logging = mutator.IsUndoLogging();
   mutator.Havoc({}, {}, havoc_optimizer,
                 [](u32, u8*&, u32&, const std::vector<AFLDictData>&,
                    const std::vector<AFLDictData>&) {});
+  if (!undo_logging) mutator.DiscardHavoc();
   CallSuccessors(mutator.GetBuf(), mutator.GetLen());
   return GoToParent();
 }
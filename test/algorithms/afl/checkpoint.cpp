@@ -0,0 +1,164 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+#define BOOST_TEST_MODULE algorithms.afl.checkpoint
+#define BOOST_TEST_DYN_LINK
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <boost/scope_exit.hpp>
+#include <boost/test/unit_test.hpp>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fuzzuf/algorithms/afl/afl_state.hpp"
+#include "fuzzuf/utils/common.hpp"
+#include "fuzzuf/utils/filesystem.hpp"
+#include "fuzzuf/utils/workspace.hpp"
+
+namespace {
+
+using fuzzuf::algorithm::afl::AFLSetting;
+using fuzzuf::algorithm::afl::AFLState;
+
+// Nothing is executed while a checkpoint is written or loaded, so the state
+// has neither an executor nor a havoc optimizer
+std::unique_ptr<AFLState> CreateState(const fs::path &in_dir,
+                                      const fs::path &out_dir) {
+  auto setting = std::make_shared<const AFLSetting>(
+      std::vector<std::string>{"/bin/true"}, in_dir.string(),
+      out_dir.string(), 1000, 0, true, false,
+      fuzzuf::utils::CPUID_DO_NOT_BIND);
+  return std::make_unique<AFLState>(setting, nullptr, nullptr);
+}
+
+// Exit status of a child process which loads the checkpoint in out_dir
+int LoadInChild(const fs::path &out_dir) {
+  pid_t pid = fork();
+  if (pid == 0) {
+    CreateState("-", out_dir)->LoadCheckpoint();
+    _exit(0);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+}  // namespace
+
+// 書き出したチェックポイントから、キューと統計が元の通りに復元される事を確認する
+BOOST_AUTO_TEST_CASE(SaveAndLoad) {
+  std::string root_dir_template("/tmp/fuzzuf_test.XXXXXX");
+  const auto raw_dirname = mkdtemp(root_dir_template.data());
+  BOOST_REQUIRE(raw_dirname != nullptr);
+  auto root_dir = fs::path(raw_dirname);
+  BOOST_SCOPE_EXIT(&root_dir) { fs::remove_all(root_dir); }
+  BOOST_SCOPE_EXIT_END
+
+  auto out_dir = root_dir / "output";
+  fuzzuf::utils::SetupDirs(out_dir.string());
+
+  {
+    auto state = CreateState(root_dir / "input", out_dir);
+
+    const u8 first[] = {'f', 'u', 'z', 'z'};
+    const u8 second[] = {'u', 'f'};
+    auto testcase0 = state->AddToQueue((out_dir / "queue/id:000000").string(),
+                                       first, sizeof(first), false);
+    auto testcase1 = state->AddToQueue((out_dir / "queue/id:000001").string(),
+                                       second, sizeof(second), true);
+
+    testcase0->fuzz_level = 3;
+    testcase0->exec_us = 120;
+    testcase0->trace_mini.reset(
+        new fuzzuf::utils::CompactBitmap(std::vector<u32>{3, 7}));
+    testcase1->was_fuzzed = true;
+    testcase1->trace_mini.reset(
+        new fuzzuf::utils::CompactBitmap(std::vector<u32>{7}));
+
+    state->top_rated[3] = std::ref(*testcase0);
+    testcase0->tc_ref++;
+    state->top_rated[7] = std::ref(*testcase1);
+    testcase1->tc_ref++;
+
+    state->virgin_bits[3] = 0x7f;
+    state->total_execs = 1234;
+    state->queue_cycle = 5;
+
+    state->WriteCheckpoint(false);
+  }
+
+  auto state = CreateState("-", out_dir);
+  state->LoadCheckpoint();
+
+  BOOST_REQUIRE_EQUAL(state->case_queue.size(), 2);
+  auto &testcase0 = *state->case_queue[0];
+  auto &testcase1 = *state->case_queue[1];
+  testcase0.input->LoadIfNotLoaded();
+  testcase1.input->LoadIfNotLoaded();
+  BOOST_CHECK_EQUAL(testcase0.input->GetLen(), 4);
+  BOOST_CHECK_EQUAL(testcase0.fuzz_level, 3);
+  BOOST_CHECK_EQUAL(testcase0.exec_us, 120);
+  BOOST_CHECK(!testcase0.passed_det);
+  BOOST_CHECK_EQUAL(testcase1.input->GetLen(), 2);
+  BOOST_CHECK(testcase1.was_fuzzed);
+  BOOST_CHECK(testcase1.passed_det);
+
+  BOOST_REQUIRE(testcase0.trace_mini);
+  BOOST_CHECK(testcase0.trace_mini->Test(3));
+  BOOST_CHECK(testcase0.trace_mini->Test(7));
+  BOOST_CHECK(!testcase0.trace_mini->Test(4));
+
+  BOOST_REQUIRE(state->top_rated[3]);
+  BOOST_CHECK(&state->top_rated[3].value().get() == &testcase0);
+  BOOST_REQUIRE(state->top_rated[7]);
+  BOOST_CHECK(&state->top_rated[7].value().get() == &testcase1);
+  BOOST_CHECK(!state->top_rated[4]);
+
+  BOOST_CHECK_EQUAL(state->virgin_bits[3], 0x7f);
+  BOOST_CHECK_EQUAL(state->virgin_bits[4], 0xff);
+  BOOST_CHECK_EQUAL(state->total_execs, 1234);
+  BOOST_CHECK_EQUAL(state->queue_cycle, 5);
+  BOOST_CHECK(state->resuming_fuzz);
+}
+
+// キューのファイルがチェックポイントの後に書き換えられていると、再開を拒む事を確認する
+BOOST_AUTO_TEST_CASE(RejectModifiedQueue) {
+  std::string root_dir_template("/tmp/fuzzuf_test.XXXXXX");
+  const auto raw_dirname = mkdtemp(root_dir_template.data());
+  BOOST_REQUIRE(raw_dirname != nullptr);
+  auto root_dir = fs::path(raw_dirname);
+  BOOST_SCOPE_EXIT(&root_dir) { fs::remove_all(root_dir); }
+  BOOST_SCOPE_EXIT_END
+
+  auto out_dir = root_dir / "output";
+  fuzzuf::utils::SetupDirs(out_dir.string());
+
+  auto queue_file = out_dir / "queue/id:000000";
+  {
+    auto state = CreateState(root_dir / "input", out_dir);
+    const u8 buf[] = {'f', 'u', 'z', 'z'};
+    state->AddToQueue(queue_file.string(), buf, sizeof(buf), false);
+    state->WriteCheckpoint(false);
+  }
+  BOOST_CHECK_EQUAL(LoadInChild(out_dir), 0);
+
+  std::ofstream(queue_file.string(), std::ios::app) << "uf";
+  BOOST_CHECK_NE(LoadInChild(out_dir), 0);
+}
@@ -0,0 +1,118 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+#define BOOST_TEST_MODULE algorithms.afl.deterministic_batch
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <functional>
+#include <vector>
+
+#include "fuzzuf/algorithms/afl/afl_mutation_hierarflow_routines.hpp"
+
+namespace {
+
+// Runs a batch as AFLStateTemplate does, except that nothing is executed.
+// The batch is cut when the callback "executes" the input at nested_at.
+struct FakeState {
+  bool ShouldConstructAutoDict(void) { return should_construct_auto_dict; }
+  void SetShouldConstructAutoDict(bool v) { should_construct_auto_dict = v; }
+
+  std::size_t RunBatchWithClassifyCounts(
+      fuzzuf::executor::BatchInputRange inputs,
+      const std::function<bool(std::size_t)> &callback, bool &aborted) {
+    batches.push_back(inputs.size());
+    aborted = false;
+    for (std::size_t i = 0; i < inputs.size(); i++) {
+      aborted = callback(i);
+      if (aborted || ++executed == nested_at) return i + 1;
+    }
+    return inputs.size();
+  }
+
+  s32 stage_cur = 0;
+  s32 stage_cur_byte = 0;
+  s32 stage_cur_val = 0;
+  fuzzuf::algorithm::afl::option::StageVal stage_val_type =
+      fuzzuf::algorithm::afl::option::STAGE_VAL_NONE;
+  bool should_construct_auto_dict = false;
+
+  std::size_t executed = 0;
+  std::size_t nested_at = 0;
+  std::vector<std::size_t> batches;
+};
+
+using DeterministicBatch =
+    fuzzuf::algorithm::afl::routine::mutation::DeterministicBatch<FakeState>;
+
+}  // namespace
+
+// 後続のノードが、変異を作った時点のステージ変数と共に変異を受け取る事を確認する
+BOOST_AUTO_TEST_CASE(RestoreStageVariables) {
+  FakeState state;
+  state.nested_at = 3;
+
+  std::vector<std::vector<u8>> received;
+  std::vector<s32> received_stage_cur;
+  DeterministicBatch batch(state, [&](const u8 *buf, u32 len) {
+    received.emplace_back(buf, buf + len);
+    received_stage_cur.push_back(state.stage_cur);
+    BOOST_CHECK_EQUAL(state.stage_cur_byte, state.stage_cur / 2);
+    BOOST_CHECK_EQUAL(state.ShouldConstructAutoDict(), state.stage_cur == 4);
+    return false;
+  });
+
+  u8 buf[] = {0, 0};
+  for (state.stage_cur = 0; state.stage_cur < 6; state.stage_cur++) {
+    state.stage_cur_byte = state.stage_cur / 2;
+    state.SetShouldConstructAutoDict(state.stage_cur == 4);
+    buf[1] = state.stage_cur;
+    BOOST_CHECK(!batch.Add(buf, state.stage_cur % 2 + 1));
+  }
+  BOOST_CHECK(!batch.Flush());
+
+  // The stage goes on from where it was
+  BOOST_CHECK_EQUAL(state.stage_cur, 6);
+  BOOST_CHECK_EQUAL(state.stage_cur_byte, 2);
+
+  BOOST_REQUIRE_EQUAL(received.size(), 6);
+  for (s32 i = 0; i < 6; i++) {
+    BOOST_CHECK_EQUAL(received_stage_cur[i], i);
+    BOOST_REQUIRE_EQUAL(received[i].size(), i % 2 + 1);
+    if (i % 2) BOOST_CHECK_EQUAL(received[i][1], i);
+  }
+
+  // The batch is restarted after the input which caused another execution
+  BOOST_REQUIRE_EQUAL(state.batches.size(), 2);
+  BOOST_CHECK_EQUAL(state.batches[0], 6);
+  BOOST_CHECK_EQUAL(state.batches[1], 3);
+}
+
+// 後続のノードが中断を要求すると、残りの変異が実行されない事を確認する
+BOOST_AUTO_TEST_CASE(Abort) {
+  FakeState state;
+
+  std::size_t called = 0;
+  DeterministicBatch batch(state, [&](const u8 *, u32) {
+    return ++called == 2;
+  });
+
+  const u8 buf[] = {0};
+  for (int i = 0; i < 4; i++) BOOST_CHECK(!batch.Add(buf, 1));
+  BOOST_CHECK(batch.Flush());
+  BOOST_CHECK_EQUAL(called, 2);
+  BOOST_CHECK(!batch.Flush());
+}
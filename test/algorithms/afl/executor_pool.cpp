@@ -0,0 +1,122 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+#define BOOST_TEST_MODULE algorithms.afl.executor_pool
+#define BOOST_TEST_DYN_LINK
+#include "fuzzuf/algorithms/afl/afl_executor_pool.hpp"
+
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Hits the edge given by the first byte of the input, and the edge 0 as well
+// on every other execution
+class FakeExecutor {
+ public:
+  void Run(const u8 *buf, u32 len, u32 /* timeout_ms */) {
+    if (len == 0) throw std::runtime_error("empty input");
+    std::this_thread::sleep_for(std::chrono::microseconds(buf[0] % 7 * 100));
+    trace.assign(16, 0);
+    trace[buf[0] % 16] = 1;
+    if (execs++ % 2) trace[0]++;
+  }
+
+  std::size_t RunBatch(fuzzuf::executor::BatchInputRange inputs,
+                       const fuzzuf::executor::BatchCallback &callback,
+                       u32 timeout_ms) {
+    std::size_t i = 0;
+    for (const auto &input : inputs) {
+      Run(input.buf, input.len, timeout_ms);
+      if (callback(i++)) break;
+    }
+    return i;
+  }
+
+  fuzzuf::feedback::InplaceMemoryFeedback GetAFLFeedback() {
+    return fuzzuf::feedback::InplaceMemoryFeedback(trace.data(), trace.size(),
+                                                   nullptr);
+  }
+
+  fuzzuf::feedback::ExitStatusFeedback GetExitStatusFeedback() {
+    return fuzzuf::feedback::ExitStatusFeedback();
+  }
+
+  void ReceiveStopSignal() {}
+
+ private:
+  std::vector<u8> trace;
+  u32 execs = 0;
+};
+
+}  // namespace
+
+// 実行の終わる順序によらず、ジョブの順に記録を受け取れる事を確認する
+BOOST_AUTO_TEST_CASE(TakeInJobOrder) {
+  std::vector<std::shared_ptr<fuzzuf::executor::AFLExecutorInterface>>
+      executors;
+  for (int i = 0; i < 4; i++) {
+    executors.emplace_back(new fuzzuf::executor::AFLExecutorInterface(
+        std::make_shared<FakeExecutor>()));
+  }
+  fuzzuf::algorithm::afl::AFLExecutorPool pool(std::move(executors));
+  BOOST_CHECK_EQUAL(pool.Size(), 4);
+
+  constexpr std::size_t N = 50;
+  std::vector<std::vector<u8>> inputs;
+  for (std::size_t i = 0; i < N; i++) inputs.push_back({u8(i * 5 + 1)});
+
+  pool.Start(N, [&inputs](std::size_t i,
+                          fuzzuf::algorithm::afl::ExecutionRecorder &recorder) {
+    for (int k = 0; k < 4; k++) recorder.Run(inputs[i].data(), 1, 0);
+  });
+
+  for (std::size_t i = 0; i < N; i++) {
+    auto record = pool.Take();
+    BOOST_REQUIRE_EQUAL(record.executions.size(), 4);
+    BOOST_CHECK_EQUAL(record.traces.size(), record.trace_cksums.size());
+    BOOST_CHECK_LE(record.traces.size(), 2);
+    for (const auto &execution : record.executions) {
+      const auto &trace = record.traces[execution.trace_id];
+      BOOST_CHECK(trace[inputs[i][0] % 16] != 0);
+    }
+  }
+  pool.Stop();
+}
+
+// ジョブの投げた例外が Take() から再送出される事を確認する
+BOOST_AUTO_TEST_CASE(RethrowJobError) {
+  std::vector<std::shared_ptr<fuzzuf::executor::AFLExecutorInterface>>
+      executors;
+  executors.emplace_back(new fuzzuf::executor::AFLExecutorInterface(
+      std::make_shared<FakeExecutor>()));
+  fuzzuf::algorithm::afl::AFLExecutorPool pool(std::move(executors));
+
+  const u8 input[] = {1};
+  pool.Start(3, [&input](std::size_t i,
+                         fuzzuf::algorithm::afl::ExecutionRecorder &recorder) {
+    recorder.Run(input, i == 1 ? 0 : 1, 0);
+  });
+
+  BOOST_CHECK_EQUAL(pool.Take().executions.size(), 1);
+  BOOST_CHECK_THROW(pool.Take(), std::runtime_error);
+  BOOST_CHECK_EQUAL(pool.Take().executions.size(), 1);
+}
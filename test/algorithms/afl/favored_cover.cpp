@@ -0,0 +1,97 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+#define BOOST_TEST_MODULE algorithms.afl.favored_cover
+#define BOOST_TEST_DYN_LINK
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "fuzzuf/algorithms/afl/afl_favored_cover.hpp"
+#include "fuzzuf/utils/compact_bitmap.hpp"
+
+namespace {
+
+constexpr u32 MAP_SIZE = 64;
+
+struct Testcase {
+  bool favored = false;
+  std::unique_ptr<fuzzuf::utils::CompactBitmap> trace_mini;
+};
+
+// The favored flags cull_queue() of AFL computes from scratch
+std::vector<bool> CullFromScratch(
+    const std::vector<std::unique_ptr<Testcase>> &queue,
+    const std::vector<fuzzuf::utils::NullableRef<Testcase>> &top_rated) {
+  std::vector<bool> favored(queue.size());
+  fuzzuf::utils::CompactBitmap has_top_rated;
+  for (u32 i = 0; i < MAP_SIZE; i++) {
+    if (top_rated[i] && !has_top_rated.Test(i)) {
+      auto &top_testcase = top_rated[i].value().get();
+      has_top_rated |= *top_testcase.trace_mini;
+      for (std::size_t j = 0; j < queue.size(); j++) {
+        if (queue[j].get() == &top_testcase) favored[j] = true;
+      }
+    }
+  }
+  return favored;
+}
+
+}  // namespace
+
+// 新しいテストケースが top_rated を奪うたびに差分更新した favored フラグが、
+// cull_queue() 相当の全体再計算の結果と一致し続ける事を確認する
+BOOST_AUTO_TEST_CASE(MatchesFullRecomputation) {
+  std::mt19937 rng(1);
+  std::vector<std::unique_ptr<Testcase>> queue;
+  std::vector<fuzzuf::utils::NullableRef<Testcase>> top_rated(MAP_SIZE);
+  fuzzuf::algorithm::afl::FavoredCover<Testcase> cover(MAP_SIZE);
+  int favored_count = 0;
+
+  for (int round = 0; round < 200; round++) {
+    queue.emplace_back(new Testcase);
+    auto &testcase = *queue.back();
+
+    // Each testcase hits a few edges and wins some of them
+    std::vector<u32> edges;
+    for (int k = 0; k < 6; k++) edges.push_back(rng() % MAP_SIZE);
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    testcase.trace_mini.reset(new fuzzuf::utils::CompactBitmap(edges));
+
+    for (u32 edge : edges) {
+      if (!top_rated[edge] || rng() % 2) {
+        top_rated[edge] = std::ref(testcase);
+        cover.MarkChanged(edge);
+      }
+    }
+
+    cover.Update(top_rated, [&favored_count](Testcase &t) {
+      favored_count += t.favored ? 1 : -1;
+    });
+
+    auto expected = CullFromScratch(queue, top_rated);
+    int expected_count = 0;
+    for (std::size_t j = 0; j < queue.size(); j++) {
+      BOOST_CHECK_EQUAL(queue[j]->favored, expected[j]);
+      expected_count += expected[j];
+    }
+    BOOST_CHECK_EQUAL(favored_count, expected_count);
+  }
+}
@@ -0,0 +1,91 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+#define BOOST_TEST_MODULE algorithms.afl.reporter
+#define BOOST_TEST_DYN_LINK
+#include <boost/scope_exit.hpp>
+#include <boost/test/unit_test.hpp>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fuzzuf/algorithms/afl/afl_state.hpp"
+#include "fuzzuf/utils/common.hpp"
+#include "fuzzuf/utils/filesystem.hpp"
+#include "fuzzuf/utils/workspace.hpp"
+
+namespace {
+
+using fuzzuf::algorithm::afl::AFLSetting;
+using fuzzuf::algorithm::afl::AFLState;
+
+// Fill the ring of the reporter with jobs waiting for release
+void BlockReporter(AFLState &state, std::shared_future<void> release) {
+  while (state.reporter->Post([release] { release.wait(); }))
+    ;
+}
+
+}  // namespace
+
+// レポーターが混んでいて書き込みが捨てられた時、次の呼び出しで書き直される事を確認する
+BOOST_AUTO_TEST_CASE(RetryAfterDroppedWrite) {
+  std::string root_dir_template("/tmp/fuzzuf_test.XXXXXX");
+  const auto raw_dirname = mkdtemp(root_dir_template.data());
+  BOOST_REQUIRE(raw_dirname != nullptr);
+  auto root_dir = fs::path(raw_dirname);
+  BOOST_SCOPE_EXIT(&root_dir) { fs::remove_all(root_dir); }
+  BOOST_SCOPE_EXIT_END
+
+  auto out_dir = root_dir / "output";
+  fuzzuf::utils::SetupDirs(out_dir.string());
+
+  auto setting = std::make_shared<const AFLSetting>(
+      std::vector<std::string>{"/bin/true"}, (root_dir / "input").string(),
+      out_dir.string(), 1000, 0, true, false,
+      fuzzuf::utils::CPUID_DO_NOT_BIND);
+  AFLState state(setting, nullptr, nullptr);
+
+  state.a_extras.emplace_back(std::vector<u8>{'f', 'u', 'z', 'z'});
+  state.auto_changed = true;
+  state.bitmap_changed = true;
+  state.queued_paths = 1;
+
+  std::promise<void> release;
+  BlockReporter(state, release.get_future().share());
+
+  state.SaveAuto();
+  state.WriteBitmap();
+  state.MaybeUpdatePlotFile(0.0, 0.0, 0);
+  BOOST_CHECK(state.auto_changed);
+  BOOST_CHECK(state.bitmap_changed);
+  BOOST_CHECK_NE(state.prev_qp, state.queued_paths);
+
+  release.set_value();
+  state.reporter->Flush();
+
+  state.SaveAuto();
+  state.WriteBitmap();
+  state.MaybeUpdatePlotFile(0.0, 0.0, 0);
+  BOOST_CHECK(!state.auto_changed);
+  BOOST_CHECK(!state.bitmap_changed);
+  BOOST_CHECK_EQUAL(state.prev_qp, state.queued_paths);
+
+  state.reporter->Flush();
+  BOOST_CHECK(fs::exists(out_dir / "queue/.state/auto_extras/auto_000000"));
+  BOOST_CHECK(fs::exists(out_dir / "fuzz_bitmap"));
+}
@@ -0,0 +1,100 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+#define BOOST_TEST_MODULE algorithms.afl.trim_engine
+#define BOOST_TEST_DYN_LINK
+#include "fuzzuf/algorithms/afl/afl_trim_engine.hpp"
+
+#include <boost/test/unit_test.hpp>
+#include <vector>
+
+namespace {
+
+// The "trace" of an input is the number of non-zero bytes in it
+u32 CountNonZero(const u8 *buf, u32 len) {
+  u32 count = 0;
+  for (u32 i = 0; i < len; i++) count += buf[i] != 0;
+  return count;
+}
+
+struct FakeRunner {
+  bool operator()(fuzzuf::executor::BatchInputRange inputs,
+                  const fuzzuf::algorithm::afl::AFLTrimEngine::OnExecuted
+                      &on_executed) {
+    batches++;
+    for (std::size_t i = 0; i < inputs.size(); i++) {
+      if (give_up_at && execs == give_up_at) return false;
+      execs++;
+      if (on_executed(i, CountNonZero(inputs[i].buf, inputs[i].len))) break;
+    }
+    return true;
+  }
+
+  u64 execs = 0;
+  u64 batches = 0;
+  u64 give_up_at = 0;
+};
+
+std::vector<u8> MakeInput() {
+  // Zeros can be removed freely, but the non-zero bytes are all needed
+  std::vector<u8> input(4096, 0);
+  for (u32 i = 0; i < input.size(); i += 512) input[i + 100] = 1;
+  return input;
+}
+
+}  // namespace
+
+// 実行結果を変えない部分だけが取り除かれる事と、同じ候補が二度実行されない事を確認する
+BOOST_AUTO_TEST_CASE(TrimWithCache) {
+  auto input = MakeInput();
+  u32 cksum = CountNonZero(input.data(), input.size());
+
+  fuzzuf::algorithm::afl::AFLTrimEngine engine(input.data(), input.size(),
+                                               cksum, 4, 16, 1024, 16);
+  FakeRunner runner;
+  u32 passes = 0;
+  BOOST_CHECK(engine.Run(std::ref(runner), [&passes](u32, u32) { passes++; }));
+
+  BOOST_CHECK(engine.IsTrimmed());
+  const auto &trimmed = engine.GetInput();
+  BOOST_CHECK_EQUAL(CountNonZero(trimmed.data(), trimmed.size()), cksum);
+  BOOST_CHECK_LT(trimmed.size(), input.size() / 8);
+  BOOST_CHECK_GT(passes, 0);
+
+  // Far fewer executions than removing chunks one by one, thanks to the
+  // cache and the growing chunks
+  BOOST_CHECK_GT(engine.GetCacheHits(), 0);
+  BOOST_CHECK_LT(runner.execs, 200);
+  BOOST_CHECK_LT(runner.batches, runner.execs);
+}
+
+// 実行を諦めた時点までに取り除いた部分が保たれる事を確認する
+BOOST_AUTO_TEST_CASE(GiveUp) {
+  auto input = MakeInput();
+  u32 cksum = CountNonZero(input.data(), input.size());
+
+  fuzzuf::algorithm::afl::AFLTrimEngine engine(input.data(), input.size(),
+                                               cksum, 4, 16, 1024, 16);
+  FakeRunner runner;
+  runner.give_up_at = 5;
+  BOOST_CHECK(!engine.Run(std::ref(runner), [](u32, u32) {}));
+  BOOST_CHECK_EQUAL(runner.execs, 5);
+
+  const auto &trimmed = engine.GetInput();
+  BOOST_CHECK_EQUAL(CountNonZero(trimmed.data(), trimmed.size()), cksum);
+  BOOST_CHECK_LE(trimmed.size(), input.size());
+}
@@ -0,0 +1,177 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file mutator_worker.cpp
+ * @brief Test code for DIEMutatorWorker with a stub of mutator_worker.js
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#define BOOST_TEST_MODULE die.mutator_worker
+#define BOOST_TEST_DYN_LINK
+
+#include "fuzzuf/algorithms/die/die_mutator_worker.hpp"
+
+#include <signal.h>
+
+#include <algorithm>
+#include <boost/scope_exit.hpp>
+#include <boost/test/unit_test.hpp>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "fuzzuf/utils/filesystem.hpp"
+#include "fuzzuf/utils/which.hpp"
+
+namespace {
+
+using fuzzuf::algorithm::die::DIEMutatorWorker;
+
+const std::string stub_path =
+    TEST_SOURCE_DIR "/algorithms/die/stub_mutator_worker.js";
+
+boost::test_tools::assertion_result NodeExists(
+    boost::unit_test::test_unit_id) {
+  return fs::exists(fuzzuf::utils::which(fs::path("node")));
+}
+
+std::string ReadAll(const fs::path &path) {
+  std::ifstream file(path);
+  return std::string((std::istreambuf_iterator<char>(file)),
+                     std::istreambuf_iterator<char>());
+}
+
+std::string ToString(const std::vector<u8> &buf) {
+  return std::string(buf.begin(), buf.end());
+}
+
+// Create a directory for the stub, which behaves as specified by mode
+fs::path CreateStubDir(const std::string &mode) {
+  std::string root_dir_template("/tmp/fuzzuf_test.XXXXXX");
+  const auto raw_dirname = mkdtemp(root_dir_template.data());
+  BOOST_REQUIRE(raw_dirname != nullptr);
+  std::ofstream(fs::path(raw_dirname) / "mode") << mode;
+  return fs::path(raw_dirname);
+}
+
+// Number of times the stub has been started
+std::size_t CountStarts(const fs::path &dir) {
+  auto starts = ReadAll(dir / "starts");
+  return std::count(starts.begin(), starts.end(), '\n');
+}
+
+// The stub may have exited when a request is written to it
+struct IgnoreSigpipe {
+  IgnoreSigpipe() { signal(SIGPIPE, SIG_IGN); }
+};
+
+}  // namespace
+
+BOOST_TEST_GLOBAL_FIXTURE(IgnoreSigpipe);
+
+// リクエストが正しく送られ、スクリプトの終了ステータスとバッファが返される事を確認する
+BOOST_AUTO_TEST_CASE(Protocol, *boost::unit_test::precondition(NodeExists)) {
+  auto dir = CreateStubDir("answer");
+  BOOST_SCOPE_EXIT(&dir) { fs::remove_all(dir); }
+  BOOST_SCOPE_EXIT_END
+
+  DIEMutatorWorker worker("node", stub_path, dir.string(), 5000);
+
+  std::vector<DIEMutatorWorker::Mutant> mutants;
+  auto status = worker.Mutate("in.js", dir.string(), 2, 0, mutants);
+  BOOST_REQUIRE(status.has_value());
+  BOOST_CHECK_EQUAL(*status, 0);
+  BOOST_REQUIRE_EQUAL(mutants.size(), 2);
+  BOOST_CHECK_EQUAL(ToString(mutants[0].js), "1:0");
+  BOOST_CHECK_EQUAL(ToString(mutants[0].type), "type:0");
+  BOOST_CHECK_EQUAL(ToString(mutants[1].js), "1:1");
+  BOOST_CHECK_EQUAL(ToString(mutants[1].type), "type:1");
+
+  auto status_instrument =
+      worker.Instrument("input.js", (dir / "input.jsi").string());
+  BOOST_REQUIRE(status_instrument.has_value());
+  BOOST_CHECK_EQUAL(*status_instrument, 7);
+  BOOST_CHECK_EQUAL(ReadAll(dir / "input.jsi"), "input.js");
+
+  // 同じワーカーが使い回される事を確認する
+  BOOST_CHECK_EQUAL(CountStarts(dir), 1);
+}
+
+// esfuzz が失敗した時、返されたミュータントは残しつつ、ワーカーが再起動される事を確認する
+BOOST_AUTO_TEST_CASE(RestartAfterFailedMutation,
+                     *boost::unit_test::precondition(NodeExists)) {
+  auto dir = CreateStubDir("answer");
+  BOOST_SCOPE_EXIT(&dir) { fs::remove_all(dir); }
+  BOOST_SCOPE_EXIT_END
+
+  DIEMutatorWorker worker("node", stub_path, dir.string(), 5000);
+
+  std::vector<DIEMutatorWorker::Mutant> mutants;
+  auto status = worker.Mutate("in.js", dir.string(), 1, 3, mutants);
+  BOOST_REQUIRE(status.has_value());
+  BOOST_CHECK_EQUAL(*status, 3);
+  BOOST_REQUIRE_EQUAL(mutants.size(), 1);
+  BOOST_CHECK_EQUAL(ToString(mutants[0].js), "1:0");
+
+  mutants.clear();
+  status = worker.Mutate("in.js", dir.string(), 1, 0, mutants);
+  BOOST_REQUIRE(status.has_value());
+  BOOST_CHECK_EQUAL(*status, 0);
+  BOOST_REQUIRE_EQUAL(mutants.size(), 1);
+  BOOST_CHECK_EQUAL(ToString(mutants[0].js), "2:0");
+  BOOST_CHECK(!worker.IsBroken());
+}
+
+// 応答が時間内に返らない時、リクエストが失敗し、次のリクエストでワーカーが再起動される事を確認する
+BOOST_AUTO_TEST_CASE(RestartAfterTimeout,
+                     *boost::unit_test::precondition(NodeExists)) {
+  auto dir = CreateStubDir("hang_once");
+  BOOST_SCOPE_EXIT(&dir) { fs::remove_all(dir); }
+  BOOST_SCOPE_EXIT_END
+
+  DIEMutatorWorker worker("node", stub_path, dir.string(), 1000);
+
+  std::vector<DIEMutatorWorker::Mutant> mutants;
+  BOOST_CHECK(!worker.Mutate("in.js", dir.string(), 1, 0, mutants));
+  BOOST_CHECK(mutants.empty());
+  BOOST_CHECK(!worker.IsBroken());
+
+  auto status = worker.Mutate("in.js", dir.string(), 1, 0, mutants);
+  BOOST_REQUIRE(status.has_value());
+  BOOST_CHECK_EQUAL(*status, 0);
+  BOOST_REQUIRE_EQUAL(mutants.size(), 1);
+  BOOST_CHECK_EQUAL(ToString(mutants[0].js), "2:0");
+}
+
+// 最初の応答の前にワーカーが終了した時、使えないものとして二度と起動されない事を確認する
+BOOST_AUTO_TEST_CASE(BrokenBeforeFirstAnswer,
+                     *boost::unit_test::precondition(NodeExists)) {
+  auto dir = CreateStubDir("exit");
+  BOOST_SCOPE_EXIT(&dir) { fs::remove_all(dir); }
+  BOOST_SCOPE_EXIT_END
+
+  DIEMutatorWorker worker("node", stub_path, dir.string(), 5000);
+
+  std::vector<DIEMutatorWorker::Mutant> mutants;
+  BOOST_CHECK(!worker.Mutate("in.js", dir.string(), 1, 0, mutants));
+  BOOST_CHECK(worker.IsBroken());
+
+  BOOST_CHECK(!worker.Instrument("in.js", (dir / "in.jsi").string()));
+  BOOST_CHECK_EQUAL(CountStarts(dir), 1);
+}
@@ -0,0 +1,110 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/*
+ * Stand-in for tools/algorithms/die/mutator_worker.js, which speaks the same
+ * protocol without DIE.
+ *
+ * Usage: node stub_mutator_worker.js dir
+ *
+ * The behaviour is read from dir/mode:
+ *   answer:    "mutate" returns count mutants "<start>:<i>" and their type
+ *              files "type:<i>", where start is the number of times the
+ *              worker has been started. The exit status is the seed.
+ *              "instrument" writes the input path to the output path and
+ *              returns 7.
+ *   hang_once: The first worker never answers, and the later ones answer.
+ *   exit:      The worker exits before reading any request.
+ * Each start is recorded as a line in dir/starts.
+ */
+'use strict';
+
+const fs = require('fs');
+const path = require('path');
+
+const REQUEST_FD = 3;
+const RESPONSE_FD = 4;
+
+const dir = process.argv[2];
+const mode = fs.readFileSync(path.join(dir, 'mode')).toString().trim();
+fs.appendFileSync(path.join(dir, 'starts'), 'start\n');
+const start =
+    fs.readFileSync(path.join(dir, 'starts')).toString().split('\n').length - 1;
+
+if (mode === 'exit') process.exit(1);
+
+function readExact(length) {
+  const buffer = Buffer.alloc(length);
+  let offset = 0;
+  while (offset < length) {
+    const n = fs.readSync(REQUEST_FD, buffer, offset, length - offset, null);
+    if (n === 0) process.exit(0);
+    offset += n;
+  }
+  return buffer;
+}
+
+function readU32() {
+  return readExact(4).readUInt32LE(0);
+}
+
+function readRequest() {
+  const fields = [];
+  for (let count = readU32(); count > 0; count--)
+    fields.push(readExact(readU32()).toString());
+  return fields;
+}
+
+function u32(value) {
+  const buffer = Buffer.alloc(4);
+  buffer.writeUInt32LE(value >>> 0, 0);
+  return buffer;
+}
+
+function writeResponse(status, buffers) {
+  const chunks = [u32(status), u32(buffers.length)];
+  for (const buffer of buffers) chunks.push(u32(buffer.length), buffer);
+
+  const response = Buffer.concat(chunks);
+  let offset = 0;
+  while (offset < response.length) {
+    offset += fs.writeSync(RESPONSE_FD, response, offset,
+                           response.length - offset);
+  }
+}
+
+for (;;) {
+  const [op, ...args] = readRequest();
+  if (mode === 'hang_once' && start === 1) {
+    // Keep the request unanswered until the fuzzer kills the worker
+    setInterval(() => {}, 1000);
+    break;
+  }
+
+  if (op === 'mutate') {
+    const [, , count, seed] = args;
+    const buffers = [];
+    for (let i = 0; i < parseInt(count, 10); i++)
+      buffers.push(Buffer.from(`${start}:${i}`), Buffer.from(`type:${i}`));
+    writeResponse(parseInt(seed, 10), buffers);
+  } else if (op === 'instrument') {
+    fs.writeFileSync(args[1], args[0]);
+    writeResponse(7, []);
+  } else {
+    writeResponse(1, []);
+  }
+}
@@ -0,0 +1,117 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+#define BOOST_TEST_MODULE algorithms.libfuzzer.cmp_trace
+#define BOOST_TEST_DYN_LINK
+#include "fuzzuf/algorithms/libfuzzer/cmp_trace.hpp"
+
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "fuzzuf/algorithms/libfuzzer/mutation.hpp"
+
+namespace lf = fuzzuf::algorithm::libfuzzer;
+namespace cov = fuzzuf::coverage;
+
+namespace {
+
+void SetInstruction(cov::CmpMap &map, std::size_t index, std::size_t size,
+                    const std::vector<std::pair<u64, u64>> &operands) {
+  map.headers[index].type = cov::CMP_TYPE_INS;
+  map.headers[index].shape = size - 1u;
+  map.headers[index].hits = operands.size();
+  for (std::size_t i = 0u; i != operands.size(); ++i) {
+    map.log[index][i].v0 = operands[i].first;
+    map.log[index][i].v1 = operands[i].second;
+  }
+}
+
+void SetRoutine(cov::CmpMap &map, std::size_t index, const std::string &v0,
+                const std::string &v1) {
+  map.headers[index].type = cov::CMP_TYPE_RTN;
+  map.headers[index].hits = 1u;
+  auto &operands = *reinterpret_cast<cov::CmpFnOperands *>(map.log[index]);
+  std::memcpy(operands.v0, v0.data(), v0.size());
+  operands.v0_len = v0.size();
+  std::memcpy(operands.v1, v1.data(), v1.size());
+  operands.v1_len = v1.size();
+}
+
+}  // namespace
+
+// 比較命令と比較関数の呼び出しからvalue profileのfeatureが得られる事を確認する
+BOOST_AUTO_TEST_CASE(ValueProfile) {
+  // Too large to be placed on the stack
+  auto map = std::make_unique<cov::CmpMap>();
+  SetInstruction(*map, 3u, 4u, {{1u, 1u}, {0x1234u, 0x1334u}});
+  SetRoutine(*map, 5u, "abcd", "abxd");
+
+  lf::ValueProfileMap value_profile;
+  lf::UpdateValueProfile(*map, value_profile);
+  std::vector<std::uint32_t> values;
+  value_profile.ForEach([&](std::uint32_t v) { values.push_back(v); });
+
+  // Hamming distances 0 and 1, leading equal bits 64 and 0, and the matching
+  // prefix of 2 bytes followed by a byte differing in 4 bits
+  const std::vector<std::uint32_t> expected{3u * 128u, 3u * 128u + 1u,
+                                            3u * 128u + 64u, 3u * 128u + 65u,
+                                            (5u | (2u << 12)) + 4u};
+  BOOST_CHECK_EQUAL_COLLECTIONS(values.begin(), values.end(), expected.begin(),
+                                expected.end());
+}
+
+// 一致しなかった比較の値がTORCに記録され、入力中の一方の値が他方に置き換えられる事を確認する
+BOOST_AUTO_TEST_CASE(CmpTable) {
+  auto map = std::make_unique<cov::CmpMap>();
+  // 'abcd' compared with '1234' as little endian integers
+  SetInstruction(*map, 7u, 4u, {{0x64636261u, 0x34333231u}, {5u, 5u}});
+
+  lf::CmpTrace cmp_trace;
+  lf::UpdateTableOfRecentCompares(*map, cmp_trace.torc);
+  std::size_t entries = 0u;
+  for (const auto &compare : cmp_trace.torc.table) {
+    if (compare.arg1.empty()) continue;
+    ++entries;
+    BOOST_CHECK(compare.integer);
+    BOOST_CHECK_EQUAL(std::string(compare.arg1.begin(), compare.arg1.end()),
+                      "abcd");
+    BOOST_CHECK_EQUAL(std::string(compare.arg2.begin(), compare.arg2.end()),
+                      "1234");
+  }
+  BOOST_CHECK_EQUAL(entries, 1u);
+
+  std::minstd_rand rng(1u);
+  bool replaced = false;
+  for (std::size_t i = 0u; i != 4096u && !replaced; ++i) {
+    std::vector<std::uint8_t> data{'x', 'x', 'a', 'b', 'c', 'd', 'x', 'x'};
+    lf::MutationHistory history;
+    lf::dictionary::DictionaryHistory<lf::dictionary::StaticDictionary>
+        dict_history;
+    const auto size = lf::mutator::CmpTable(rng, data, 64u, history,
+                                            dict_history, cmp_trace);
+    BOOST_CHECK_EQUAL(history.size(), 1u);
+    if (!size) continue;
+    BOOST_CHECK_EQUAL(size, data.size());
+    BOOST_CHECK_EQUAL(dict_history.size(), 1u);
+    replaced = std::string(data.begin(), data.end()) == "xx1234xx";
+  }
+  BOOST_CHECK(replaced);
+}
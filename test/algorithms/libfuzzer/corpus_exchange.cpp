@@ -0,0 +1,95 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+#define BOOST_TEST_MODULE algorithms.libfuzzer.corpus_exchange
+#define BOOST_TEST_DYN_LINK
+#include "fuzzuf/algorithms/libfuzzer/corpus_exchange.hpp"
+
+#include <boost/test/unit_test.hpp>
+#include <thread>
+#include <vector>
+
+// 他のワーカーが追加した入力だけが、前回の続きから取得できる事を確認する
+BOOST_AUTO_TEST_CASE(FetchOthers) {
+  fuzzuf::algorithm::libfuzzer::CorpusExchange exchange;
+  exchange.SetWorkerCount(2u);
+  exchange.Publish(0u, {1, 2, 3});
+  exchange.Publish(1u, {4});
+
+  std::vector<fuzzuf::algorithm::libfuzzer::CorpusExchange::Input> dest0;
+  std::vector<fuzzuf::algorithm::libfuzzer::CorpusExchange::Input> dest1;
+  exchange.Fetch(0u, dest0);
+  exchange.Fetch(1u, dest1);
+  BOOST_CHECK_EQUAL(dest0.size(), 1u);
+  BOOST_CHECK(*dest0[0] == std::vector<std::uint8_t>({4}));
+  BOOST_CHECK_EQUAL(dest1.size(), 1u);
+  BOOST_CHECK(*dest1[0] == std::vector<std::uint8_t>({1, 2, 3}));
+
+  exchange.Publish(1u, {5, 6});
+  exchange.Fetch(0u, dest0);
+  BOOST_CHECK_EQUAL(dest0.size(), 2u);
+  BOOST_CHECK(*dest0[1] == std::vector<std::uint8_t>({5, 6}));
+  exchange.Fetch(1u, dest1);
+  BOOST_CHECK_EQUAL(dest1.size(), 1u);
+}
+
+// 複数のスレッドから同時に追加しても入力が失われない事を確認する
+BOOST_AUTO_TEST_CASE(PublishConcurrently) {
+  fuzzuf::algorithm::libfuzzer::CorpusExchange exchange;
+  exchange.SetWorkerCount(5u);
+  std::vector<std::thread> threads;
+  for (std::size_t worker = 1u; worker <= 4u; ++worker) {
+    threads.emplace_back([&exchange, worker] {
+      for (std::uint8_t i = 0u; i < 100u; ++i) exchange.Publish(worker, {i});
+    });
+  }
+  for (auto &thread : threads) thread.join();
+
+  std::vector<fuzzuf::algorithm::libfuzzer::CorpusExchange::Input> dest;
+  exchange.Fetch(0u, dest);
+  BOOST_CHECK_EQUAL(dest.size(), 400u);
+}
+
+// 全てのワーカーが取得した入力だけがログから削除される事を確認する
+BOOST_AUTO_TEST_CASE(TrimRead) {
+  fuzzuf::algorithm::libfuzzer::CorpusExchange exchange;
+  exchange.SetWorkerCount(3u);
+  exchange.Publish(0u, {1});
+  exchange.Publish(1u, {2});
+
+  std::vector<fuzzuf::algorithm::libfuzzer::CorpusExchange::Input> dest;
+  exchange.Fetch(0u, dest);
+  exchange.Fetch(1u, dest);
+  BOOST_CHECK_EQUAL(exchange.GetLogSize(), 2u);
+
+  exchange.Fetch(2u, dest);
+  BOOST_CHECK_EQUAL(exchange.GetLogSize(), 0u);
+  BOOST_CHECK_EQUAL(dest.size(), 4u);
+
+  // 削除された後に追加された入力も、前回の続きから取得できる
+  exchange.Publish(2u, {3});
+  dest.clear();
+  exchange.Fetch(0u, dest);
+  BOOST_REQUIRE_EQUAL(dest.size(), 1u);
+  BOOST_CHECK(*dest[0] == std::vector<std::uint8_t>({3}));
+
+  // 終了したワーカーの分は残さない
+  exchange.Leave(1u);
+  BOOST_CHECK_EQUAL(exchange.GetLogSize(), 1u);
+  exchange.Leave(2u);
+  BOOST_CHECK_EQUAL(exchange.GetLogSize(), 0u);
+}
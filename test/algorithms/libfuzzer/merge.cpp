@@ -0,0 +1,138 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+#define BOOST_TEST_MODULE algorithms.libfuzzer.merge
+#define BOOST_TEST_DYN_LINK
+#include "fuzzuf/algorithms/libfuzzer/merge.hpp"
+
+#include <stdlib.h>
+
+#include <boost/scope_exit.hpp>
+#include <boost/test/unit_test.hpp>
+#include <fstream>
+#include <sstream>
+
+namespace lf = fuzzuf::algorithm::libfuzzer;
+
+namespace {
+
+lf::MergeInput MakeInput(std::size_t size,
+                         std::vector<std::uint32_t> &&features) {
+  lf::MergeInput input;
+  input.size = size;
+  input.done = true;
+  input.features = std::move(features);
+  return input;
+}
+
+// The features of an input are its bytes
+bool RunFake(std::size_t, const std::vector<std::uint8_t> &input,
+             std::vector<std::uint32_t> &features) {
+  features.assign(input.begin(), input.end());
+  return true;
+}
+
+}  // namespace
+
+// 初期コーパスに無いfeatureを最も多く持つ入力から、同数なら小さい入力から選ばれる事を確認する
+BOOST_AUTO_TEST_CASE(SelectBySetCover) {
+  std::vector<lf::MergeInput> inputs;
+  inputs.push_back(MakeInput(1u, {1u, 2u}));
+  inputs.push_back(MakeInput(10u, {2u, 3u, 4u}));
+  inputs.push_back(MakeInput(5u, {3u, 4u}));
+  inputs.push_back(MakeInput(1u, {5u}));
+  inputs.push_back(MakeInput(1u, {1u}));
+  inputs.push_back(MakeInput(1u, {}));
+
+  const auto selected = lf::SelectMergeInputs(inputs, 1u);
+  BOOST_CHECK_EQUAL(selected.size(), 2u);
+  BOOST_CHECK_EQUAL(selected[0], 2u);
+  BOOST_CHECK_EQUAL(selected[1], 3u);
+}
+
+// 中断されたマージが制御ファイルから再開でき、実行済みの入力が再実行されない事を確認する
+BOOST_AUTO_TEST_CASE(ResumeFromControlFile) {
+  std::string root_dir_template("/tmp/fuzzuf_test.XXXXXX");
+  const auto raw_dirname = mkdtemp(root_dir_template.data());
+  BOOST_REQUIRE(raw_dirname != nullptr);
+  auto root_dir = fs::path(raw_dirname);
+  BOOST_SCOPE_EXIT(&root_dir) { fs::remove_all(root_dir); }
+  BOOST_SCOPE_EXIT_END
+  const std::vector<std::string> dirs{(root_dir / "first").string(),
+                                      (root_dir / "second").string()};
+  fs::create_directory(dirs[0]);
+  fs::create_directory(dirs[1]);
+  std::ofstream(dirs[0] + "/a") << "\x01\x02";
+  std::ofstream(dirs[1] + "/b") << "\x02\x03";
+  std::ofstream(dirs[1] + "/c") << "\x04";
+  std::ofstream(dirs[1] + "/d") << "\x05";
+
+  std::size_t first_corpus_size = 0u;
+  auto inputs = lf::ListMergeInputs(dirs, first_corpus_size);
+  BOOST_CHECK_EQUAL(inputs.size(), 4u);
+  BOOST_CHECK_EQUAL(first_corpus_size, 1u);
+
+  std::stringstream control;
+  lf::WriteMergeControlHeader(control, inputs, first_corpus_size);
+  std::atomic<bool> stop = false;
+  std::size_t count = 0u;
+  const auto stop_after_two = [&](std::size_t worker, const auto &input,
+                                  auto &features) {
+    if (++count == 2u) stop = true;
+    return RunFake(worker, input, features);
+  };
+  BOOST_CHECK_EQUAL(
+      lf::CollectMergeFeatures(inputs, 1u, stop_after_two, control, stop), 2u);
+
+  // The merge was killed while executing d
+  control << "STARTED 3 1\n";
+
+  auto resumed = lf::ListMergeInputs(dirs, first_corpus_size);
+  BOOST_CHECK(lf::LoadMergeControlFile(control, resumed, first_corpus_size));
+  BOOST_CHECK(resumed[0].done);
+  BOOST_CHECK(resumed[1].done);
+  BOOST_CHECK(!resumed[2].done);
+  BOOST_CHECK(!resumed[3].done);
+  BOOST_CHECK(resumed[1].features == std::vector<std::uint32_t>({2u, 3u}));
+
+  stop = false;
+  std::stringstream resumed_control;
+  BOOST_CHECK_EQUAL(lf::CollectMergeFeatures(resumed, 4u, RunFake,
+                                             resumed_control, stop),
+                    2u);
+  const auto selected = lf::SelectMergeInputs(resumed, first_corpus_size);
+  BOOST_CHECK_EQUAL(selected.size(), 3u);
+
+  // A control file for other inputs is not loaded
+  std::stringstream other;
+  lf::WriteMergeControlHeader(other, inputs, 2u);
+  BOOST_CHECK(!lf::LoadMergeControlFile(other, resumed, first_corpus_size));
+}
+
+// 二度開始されて終わらなかった入力は飛ばされる事を確認する
+BOOST_AUTO_TEST_CASE(SkipInputStoppingMerge) {
+  std::vector<lf::MergeInput> inputs(2u);
+  inputs[0].path = "/a";
+  inputs[1].path = "/b";
+  std::stringstream control;
+  lf::WriteMergeControlHeader(control, inputs, 1u);
+  control << "STARTED 0 1\nFT 0 1\nSTARTED 1 1\nSTARTED 1 1\n";
+  BOOST_CHECK(lf::LoadMergeControlFile(control, inputs, 1u));
+  BOOST_CHECK(inputs[0].done);
+  BOOST_CHECK(inputs[1].done);
+  BOOST_CHECK(inputs[1].features.empty());
+}
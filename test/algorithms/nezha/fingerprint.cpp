@@ -0,0 +1,65 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+#define BOOST_TEST_MODULE algorithms.nezha.fingerprint
+#define BOOST_TEST_DYN_LINK
+#include "fuzzuf/algorithms/nezha/fingerprint.hpp"
+
+#include <boost/test/unit_test.hpp>
+#include <vector>
+
+#include "fuzzuf/algorithms/nezha/state.hpp"
+
+namespace ne = fuzzuf::algorithm::nezha;
+
+// 同じタプルは二度目以降新規と判定されず、長さだけが異なるタプルは区別される事を確認する
+BOOST_AUTO_TEST_CASE(Trace) {
+  ne::known_traces_t known;
+  BOOST_CHECK(known.insert(ne::trace_t{true, false}).second);
+  BOOST_CHECK(!known.insert(ne::trace_t{true, false}).second);
+  BOOST_CHECK(known.insert(ne::trace_t{true, false, false}).second);
+  BOOST_CHECK(known.insert(ne::trace_t{false, true}).second);
+  BOOST_CHECK(known.insert(ne::trace_t(65u, true)).second);
+  BOOST_CHECK(known.insert(ne::trace_t(64u, true)).second);
+  BOOST_CHECK(!known.insert(ne::trace_t(65u, true)).second);
+  BOOST_CHECK_EQUAL(known.size(), 5u);
+  BOOST_CHECK(known.contains(ne::trace_t{false, true}));
+  BOOST_CHECK(!known.contains(ne::trace_t{false, false}));
+}
+
+// 検証を有効にしても判定結果が変わらない事を確認する
+BOOST_AUTO_TEST_CASE(Verify) {
+  using fuzzuf::feedback::PUTExitReasonType;
+  ne::known_status_t status(true);
+  ne::known_outputs_t outputs(true);
+  BOOST_CHECK(status.verifying());
+  BOOST_CHECK(status
+                  .insert(ne::status_t{PUTExitReasonType::FAULT_NONE,
+                                       PUTExitReasonType::FAULT_CRASH})
+                  .second);
+  BOOST_CHECK(!status
+                   .insert(ne::status_t{PUTExitReasonType::FAULT_NONE,
+                                        PUTExitReasonType::FAULT_CRASH})
+                   .second);
+  BOOST_CHECK(outputs.insert(ne::outputs_t{1u, 2u}).second);
+  BOOST_CHECK(outputs.insert(ne::outputs_t{2u, 1u}).second);
+  BOOST_CHECK(!outputs.insert(ne::outputs_t{1u, 2u}).second);
+  BOOST_CHECK_EQUAL(status.size(), 1u);
+  BOOST_CHECK_EQUAL(outputs.size(), 2u);
+  BOOST_CHECK_EQUAL(outputs.collisions(), 0u);
+  BOOST_CHECK(outputs.contains(ne::outputs_t{2u, 1u}));
+}
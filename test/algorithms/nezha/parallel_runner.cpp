@@ -0,0 +1,69 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+#define BOOST_TEST_MODULE algorithms.nezha.parallel_runner
+#define BOOST_TEST_DYN_LINK
+#include "fuzzuf/algorithms/nezha/parallel_runner.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// 全てのジョブが同時に実行され、Runが全てのジョブの終了を待つ事を確認する
+BOOST_AUTO_TEST_CASE(RunConcurrently) {
+  constexpr std::size_t job_count = 4u;
+  fuzzuf::algorithm::nezha::ParallelRunner runner(job_count - 1u);
+
+  for (std::size_t round = 0u; round != 3u; ++round) {
+    std::atomic<std::size_t> arrived(0u);
+    std::vector<int> done(job_count, 0);
+    runner.Run(job_count, [&](std::size_t i) {
+      // Each job waits for the others, which never ends unless all jobs are
+      // running at the same time
+      ++arrived;
+      while (arrived.load() != job_count) std::this_thread::yield();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      done[i] = 1;
+    });
+    BOOST_CHECK_EQUAL(arrived.load(), job_count);
+    BOOST_CHECK_EQUAL(std::count(done.begin(), done.end(), 1),
+                      static_cast<long>(job_count));
+  }
+}
+
+// ジョブが投げた例外が全てのジョブの終了後にRunから再送出される事を確認する
+BOOST_AUTO_TEST_CASE(RethrowException) {
+  fuzzuf::algorithm::nezha::ParallelRunner runner(2u);
+
+  std::atomic<std::size_t> finished(0u);
+  BOOST_CHECK_THROW(runner.Run(3u,
+                               [&](std::size_t i) {
+                                 if (i == 1u) throw std::runtime_error("fail");
+                                 ++finished;
+                               }),
+                    std::runtime_error);
+  BOOST_CHECK_EQUAL(finished.load(), 2u);
+
+  // The runner is still usable after the exception
+  finished = 0u;
+  runner.Run(3u, [&](std::size_t) { ++finished; });
+  BOOST_CHECK_EQUAL(finished.load(), 3u);
+}
@@ -83,7 +83,7 @@ static void VUzzerLoop() {
       new fuzzuf::executor::PinToolExecutor(
           FUZZUF_PIN_EXECUTABLE,
           {TEST_BINARY_DIR "/../tools/bbcounts2/bbcounts2.so", "-o", "bb.out",
-           "-libc", "0"},
+           "-libc", "0", "-binary", "1"},
           setting->argv, setting->exec_timelimit_ms, setting->exec_memlimit,
           setting->out_dir / GetDefaultOutfile()));
 
@@ -0,0 +1,102 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+#define BOOST_TEST_MODULE algorithms.vuzzer.util
+#define BOOST_TEST_DYN_LINK
+#include "fuzzuf/algorithms/vuzzer/vuzzer_util.hpp"
+
+#include <boost/test/unit_test.hpp>
+#include <fstream>
+#include <string>
+
+#include "fuzzuf/algorithms/vuzzer/vuzzer_feedback_format.hpp"
+#include "fuzzuf/utils/filesystem.hpp"
+
+namespace {
+
+namespace vuzzer = fuzzuf::algorithm::vuzzer;
+
+vuzzer::bb_cov_t ParseContent(const std::string& content) {
+  const auto path = fs::temp_directory_path() / "fuzzuf_test_vuzzer_bb.out";
+  {
+    std::ofstream out(path.string(), std::ios::binary);
+    out << content;
+  }
+  fuzzuf::feedback::FileFeedback feed(path, nullptr);
+  vuzzer::bb_cov_t bb_cov;
+  vuzzer::util::ParseBBCov(feed, bb_cov);
+  fs::remove(path);
+  return bb_cov;
+}
+
+template <typename T>
+void Append(std::string& dest, const T& value) {
+  dest.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+}  // namespace
+
+// テキスト形式のカバレッジがアドレス順に並べられ、重複したアドレスは後の値で上書きされる事を確認する
+BOOST_AUTO_TEST_CASE(ParseTextBBCov) {
+  const auto bb_cov = ParseContent(
+      "0x401020 3\n"
+      "0x401000 12\n"
+      "0x401010 1\n"
+      "0x401000 15\n");
+  const vuzzer::bb_cov_t expected = {
+      {0x401000, 15}, {0x401010, 1}, {0x401020, 3}};
+  BOOST_CHECK(bb_cov == expected);
+}
+
+// バイナリ形式のカバレッジがテキスト形式と同じ結果になる事を確認する
+BOOST_AUTO_TEST_CASE(ParseBinaryBBCov) {
+  namespace ff = vuzzer::feedback_format;
+  std::string content;
+  Append(content, ff::BBCovHeader{{'V', 'Z', 'B', 'B'}, 3});
+  Append(content, ff::BBCovRecord{0x401000, 12, 0});
+  Append(content, ff::BBCovRecord{0x401010, 1, 0});
+  Append(content, ff::BBCovRecord{0x401020, 3, 0});
+
+  const vuzzer::bb_cov_t expected = {
+      {0x401000, 12}, {0x401010, 1}, {0x401020, 3}};
+  BOOST_CHECK(ParseContent(content) == expected);
+  BOOST_CHECK(ParseContent("0x401000 12\n0x401010 1\n0x401020 3\n") ==
+              expected);
+
+  // Truncated records are rejected
+  content.resize(content.size() - 1);
+  BOOST_CHECK_THROW(ParseContent(content), int);
+}
+
+// 共有メモリで受け取ったカバレッジがファイルを読まずに解析される事を確認する
+BOOST_AUTO_TEST_CASE(ParseInMemoryBBCov) {
+  namespace ff = vuzzer::feedback_format;
+  std::string content;
+  Append(content, ff::BBCovHeader{{'V', 'Z', 'B', 'B'}, 2});
+  Append(content, ff::BBCovRecord{0x401010, 1, 0});
+  Append(content, ff::BBCovRecord{0x401000, 12, 0});
+
+  // The file doesn't exist
+  fuzzuf::feedback::FileFeedback feed(
+      fs::temp_directory_path() / "fuzzuf_test_vuzzer_no_such_file",
+      reinterpret_cast<const u8*>(content.data()), content.size(), nullptr);
+  vuzzer::bb_cov_t bb_cov;
+  vuzzer::util::ParseBBCov(feed, bb_cov);
+
+  const vuzzer::bb_cov_t expected = {{0x401000, 12}, {0x401010, 1}};
+  BOOST_CHECK(bb_cov == expected);
+}
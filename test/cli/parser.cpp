@@ -42,6 +42,10 @@ BOOST_AUTO_TEST_CASE(ParseGlobalFuzzerOptions_AllOptions) {
                         "--out_dir=test-out",
                         "--executor=qemu",
                         "--bind_cpuid=1000",
+                        "--bind_put_to_smt_sibling",
+                        "--cpu_lock_dir=test-lock",
+                        "--standby_fork_server",
+                        "--shm_backend=posix_huge",
                         "--proxy_path=test-proxy",
                         "--exec_timelimit_ms=123",
                         "--exec_memlimit=456"};
@@ -60,6 +64,11 @@ BOOST_AUTO_TEST_CASE(ParseGlobalFuzzerOptions_AllOptions) {
   BOOST_CHECK_EQUAL(options.out_dir, "test-out");
   BOOST_CHECK_EQUAL(options.executor, fuzzuf::cli::ExecutorKind::QEMU);
   BOOST_CHECK_EQUAL(options.cpuid_to_bind, 1000);
+  BOOST_CHECK_EQUAL(options.cpuid_to_bind_specified, true);
+  BOOST_CHECK_EQUAL(options.bind_put_to_smt_sibling, true);
+  BOOST_CHECK_EQUAL(options.cpu_lock_dir, "test-lock");
+  BOOST_CHECK_EQUAL(options.standby_fork_server, true);
+  BOOST_CHECK(options.shm_backend == fuzzuf::coverage::ShmBackend::POSIX_HUGE);
   BOOST_CHECK_EQUAL(options.proxy_path.value(), "test-proxy");
   BOOST_CHECK_EQUAL(options.exec_timelimit_ms.value(), 123);
   BOOST_CHECK_EQUAL(options.exec_memlimit.value(), 456);
@@ -83,6 +92,11 @@ BOOST_AUTO_TEST_CASE(ParseGlobalFuzzerOptions_DefaultValues) {
   // Check `executor`, `bind_cpuid` and `proxy_path` default value.
   BOOST_CHECK_EQUAL(options.executor, fuzzuf::cli::ExecutorKind::NATIVE);
   BOOST_CHECK_EQUAL(options.cpuid_to_bind, fuzzuf::utils::CPUID_BIND_WHICHEVER);
+  BOOST_CHECK_EQUAL(options.cpuid_to_bind_specified, false);
+  BOOST_CHECK_EQUAL(options.bind_put_to_smt_sibling, false);
+  BOOST_CHECK_EQUAL(options.cpu_lock_dir, fuzzuf::utils::DEFAULT_CPU_LOCK_DIR);
+  BOOST_CHECK_EQUAL(options.standby_fork_server, false);
+  BOOST_CHECK(options.shm_backend == fuzzuf::coverage::ShmBackend::SYSV);
   BOOST_CHECK_EQUAL(options.proxy_path.value(), "");
 
   BOOST_CHECK_EQUAL(options.logger, fuzzuf::utils::Logger::Stdout);
@@ -269,5 +283,20 @@ BOOST_AUTO_TEST_CASE(ParseGlobalFuzzerOptions_WithUnregisteredOption_Case2) {
       "ParseGlobalFuzzerOptions_WithUnregisteredOption_Case2", args, options);
 }
 
+BOOST_AUTO_TEST_CASE(ParseGlobalFuzzerOptions_ShmBackendFailure) {
+  // Supply unknown shared memory `foo`.
+  fuzzuf::cli::GlobalFuzzerOptions options;
+#pragma GCC diagnostic ignored "-Wwrite-strings"
+  const char *argv[] = {"fuzzuf", "fuzzer", "--shm_backend=foo", "--"};
+  fuzzuf::cli::GlobalArgs args = {
+      .argc = Argc(argv),
+      .argv = argv,
+  };
+
+  // Check if the parser throws expected exception.
+  BOOST_CHECK_THROW(fuzzuf::cli::ParseGlobalOptionsForFuzzer(args, options),
+                    fuzzuf::exceptions::cli_error);
+}
+
 // NOTE:
 // もしAFL向けのオプションを追加したら、それの正常動作を確認するテストケースを追加してくださいね
@@ -0,0 +1,83 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+#define BOOST_TEST_MODULE exec_input.on_disk
+#define BOOST_TEST_DYN_LINK
+#include "fuzzuf/exec_input/on_disk_exec_input.hpp"
+
+#include <boost/scope_exit.hpp>
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+#include "fuzzuf/exec_input/exec_input_set.hpp"
+#include "fuzzuf/utils/async_writer.hpp"
+
+namespace {
+
+std::string ReadAll(const fs::path &path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+}
+
+}  // namespace
+
+// バックグラウンドで書き込まれる前後のどちらでも同じ内容を読める事と、
+// 後から同期的に上書きした内容が書き込み待ちの内容で戻されない事を確認する
+BOOST_AUTO_TEST_CASE(OverwriteInBackground) {
+  std::string root_dir_template("/tmp/fuzzuf_test.XXXXXX");
+  const auto raw_dirname = mkdtemp(root_dir_template.data());
+  BOOST_REQUIRE(raw_dirname != nullptr);
+  auto root_dir = fs::path(raw_dirname);
+  BOOST_SCOPE_EXIT(&root_dir) { fs::remove_all(root_dir); }
+  BOOST_SCOPE_EXIT_END
+
+  fuzzuf::exec_input::ExecInputSet input_set;
+  fuzzuf::utils::AsyncWriter writer;
+
+  // Keep the writer busy so that the entry stays pending for a while
+  writer.Post(
+      [] { std::this_thread::sleep_for(std::chrono::milliseconds(50)); });
+
+  auto input = input_set.CreateOnDisk(root_dir / "id:000000");
+  input->OverwriteInBackground(reinterpret_cast<const u8 *>("pending"), 7,
+                               &writer, false);
+  input->Load();
+  BOOST_CHECK_EQUAL(
+      std::string(reinterpret_cast<const char *>(input->GetBuf()),
+                  input->GetLen()),
+      "pending");
+
+  input->OverwriteKeepingLoaded(reinterpret_cast<const u8 *>("saved"), 5);
+  writer.Flush();
+  BOOST_CHECK_EQUAL(ReadAll(input->GetPath()), "saved");
+
+  auto sync_input = input_set.CreateOnDisk(root_dir / "id:000001");
+  sync_input->OverwriteInBackground(reinterpret_cast<const u8 *>("sync"), 4,
+                                    nullptr, true);
+  BOOST_CHECK_EQUAL(ReadAll(sync_input->GetPath()), "sync");
+
+  // A write failed on the thread of writer is reported to the caller
+  auto broken_input = input_set.CreateOnDisk(root_dir / "none" / "id:000002");
+  broken_input->OverwriteInBackground(reinterpret_cast<const u8 *>("lost"), 4,
+                                      &writer, false);
+  BOOST_CHECK_THROW(broken_input->LoadByMmap(), fuzzuf::utils::FileError);
+}
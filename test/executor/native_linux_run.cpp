@@ -17,13 +17,16 @@
  */
 #define BOOST_TEST_MODULE native_linux_executor.run
 #define BOOST_TEST_DYN_LINK
+#include <signal.h>
 #include <unistd.h>
 
 #include <boost/scope_exit.hpp>
 #include <boost/test/unit_test.hpp>
+#include <fstream>
 #include <iostream>
 
 #include "config.h"
+#include "fuzzuf/coverage/cmplog_attacher.hpp"
 #include "fuzzuf/executor/native_linux_executor.hpp"
 #include "fuzzuf/feedback/inplace_memory_feedback.hpp"
 #include "fuzzuf/feedback/put_exit_reason_type.hpp"
@@ -97,3 +100,260 @@ BOOST_AUTO_TEST_CASE(NativeLinuxExecutorVariableShm) {
     }
   }
 }
+
+// Check if NativeLinuxExecutor allocates the coverage maps with POSIX shared
+// memory when it is requested, and removes them on destruction.
+BOOST_AUTO_TEST_CASE(NativeLinuxExecutorPosixShm) {
+  std::string root_dir_template("/tmp/fuzzuf_test.XXXXXX");
+  auto *const raw_dirname = mkdtemp(root_dir_template.data());
+  BOOST_CHECK(raw_dirname != nullptr);
+
+  auto root_dir = fs::path(raw_dirname);
+  BOOST_SCOPE_EXIT(&root_dir) { fs::remove_all(root_dir); }
+  BOOST_SCOPE_EXIT_END
+
+  auto output_file_path = root_dir / "result";
+  auto path_to_write_seed = root_dir / "cur_input";
+
+  using fuzzuf::coverage::ShmBackend;
+  for (auto backend : {ShmBackend::POSIX, ShmBackend::POSIX_HUGE}) {
+    fs::path shm_path;
+    {
+      fuzzuf::executor::NativeLinuxExecutor executor(
+          {"/usr/bin/tee", output_file_path.native()}, 1000, 10000, false,
+          path_to_write_seed, 65536, 0, false, {}, {}, false, backend);
+
+      std::string input("Hello, World!");
+      executor.Run(reinterpret_cast<const u8 *>(input.c_str()), input.size());
+
+      BOOST_CHECK_EQUAL(executor.GetAFLShmID(),
+                        fuzzuf::coverage::ShmCovAttacher::INVALID_SHMID);
+      const auto &shm_name = executor.afl_edge_coverage.GetShmName();
+      BOOST_CHECK(!shm_name.empty());
+
+      shm_path = fs::path("/dev/shm" + shm_name);
+      BOOST_CHECK(fs::exists(shm_path));
+      BOOST_CHECK_EQUAL(fs::file_size(shm_path),
+                        backend == ShmBackend::POSIX ? 65536 : 2 * 1024 * 1024);
+    }
+    BOOST_CHECK(!fs::exists(shm_path));
+  }
+}
+
+// Check if the comparison log of CmpLog is passed only to the executor which
+// is given its environment variable, and ResetHeaders clears the headers.
+BOOST_AUTO_TEST_CASE(NativeLinuxExecutorCmpLogShm) {
+  std::string root_dir_template("/tmp/fuzzuf_test.XXXXXX");
+  auto *const raw_dirname = mkdtemp(root_dir_template.data());
+  BOOST_CHECK(raw_dirname != nullptr);
+
+  auto root_dir = fs::path(raw_dirname);
+  BOOST_SCOPE_EXIT(&root_dir) { fs::remove_all(root_dir); }
+  BOOST_SCOPE_EXIT_END
+
+  auto path_to_write_seed = root_dir / "cur_input";
+
+  fuzzuf::coverage::CmpLogAttacher cmplog_map;
+  cmplog_map.Setup();
+  BOOST_CHECK_EQUAL(cmplog_map.GetMapSize(), sizeof(fuzzuf::coverage::CmpMap));
+
+  const auto env = cmplog_map.GetEnvironmentVariable();
+  BOOST_CHECK_EQUAL(env, "__AFL_CMPLOG_SHM_ID=" +
+                             std::to_string(cmplog_map.GetShmID()));
+
+  auto get_stdout_of_env = [&](std::vector<std::string> &&env_vars) {
+    fuzzuf::executor::NativeLinuxExecutor executor(
+        {"/usr/bin/env"}, 1000, 10000, false, path_to_write_seed, 0, 0, true,
+        std::move(env_vars));
+    executor.Run(reinterpret_cast<const u8 *>(""), 0);
+    auto out = executor.MoveStdOut();
+    return std::string(out.begin(), out.end());
+  };
+  BOOST_CHECK(get_stdout_of_env({env}).find(env + "\n") != std::string::npos);
+  BOOST_CHECK(get_stdout_of_env({}).find("__AFL_CMPLOG_SHM_ID") ==
+              std::string::npos);
+
+  auto *cmp_map = cmplog_map.GetCmpMap();
+  cmp_map->headers[1].hits = 3;
+  cmp_map->headers[1].type = fuzzuf::coverage::CMP_TYPE_INS;
+  cmp_map->log[1][0].v0 = 0xdeadbeef;
+  cmplog_map.ResetHeaders();
+  BOOST_CHECK_EQUAL(cmp_map->headers[1].hits, 0u);
+  BOOST_CHECK_EQUAL(cmp_map->headers[1].type, 0u);
+}
+
+// Check if RunBatch executes every input in order and stops when the callback
+// requests
+BOOST_AUTO_TEST_CASE(NativeLinuxExecutorRunBatch) {
+  std::string root_dir_template("/tmp/fuzzuf_test.XXXXXX");
+  auto *const raw_dirname = mkdtemp(root_dir_template.data());
+  BOOST_CHECK(raw_dirname != nullptr);
+
+  auto root_dir = fs::path(raw_dirname);
+  BOOST_SCOPE_EXIT(&root_dir) { fs::remove_all(root_dir); }
+  BOOST_SCOPE_EXIT_END
+
+  auto output_file_path = root_dir / "result";
+  auto path_to_write_seed = root_dir / "cur_input";
+
+  fuzzuf::executor::NativeLinuxExecutor executor(
+      {"/usr/bin/tee", output_file_path.native()}, 1000, 10000, false,
+      path_to_write_seed, 0, 0);
+
+  // Inputs of different lengths to check that a longer input written before is
+  // truncated properly
+  std::vector<std::string> inputs{"Hello, World!", "Hello", "Hello, fuzzuf!",
+                                  "Bye"};
+  std::vector<fuzzuf::executor::BatchInput> batch;
+  for (const auto &input : inputs)
+    batch.push_back({reinterpret_cast<const u8 *>(input.data()),
+                     static_cast<u32>(input.size())});
+
+  std::vector<std::string> results;
+  auto executed = executor.RunBatch(
+      boost::make_iterator_range(batch.data(), batch.data() + batch.size()),
+      [&](std::size_t index) {
+        BOOST_CHECK_EQUAL(index, results.size());
+        BOOST_CHECK(executor.GetExitStatusFeedback().exit_reason ==
+                    fuzzuf::feedback::PUTExitReasonType::FAULT_NONE);
+        std::ifstream ifs(output_file_path.native());
+        results.emplace_back(std::istreambuf_iterator<char>(ifs),
+                             std::istreambuf_iterator<char>());
+        return false;
+      });
+  BOOST_CHECK_EQUAL(executed, inputs.size());
+  BOOST_CHECK_EQUAL_COLLECTIONS(results.begin(), results.end(), inputs.begin(),
+                                inputs.end());
+
+  // Returning true from the callback aborts the rest of the batch
+  executed = executor.RunBatch(
+      boost::make_iterator_range(batch.data(), batch.data() + batch.size()),
+      [](std::size_t index) { return index == 1u; });
+  BOOST_CHECK_EQUAL(executed, 2u);
+}
+
+// Check if only the selected fds are recorded, and only the last bytes are
+// kept when the PUT writes more than the capacity, in both modes
+BOOST_AUTO_TEST_CASE(NativeLinuxExecutorRecordedOutputs) {
+  std::string root_dir_template("/tmp/fuzzuf_test.XXXXXX");
+  auto *const raw_dirname = mkdtemp(root_dir_template.data());
+  BOOST_CHECK(raw_dirname != nullptr);
+
+  auto root_dir = fs::path(raw_dirname);
+  BOOST_SCOPE_EXIT(&root_dir) { fs::remove_all(root_dir); }
+  BOOST_SCOPE_EXIT_END
+
+  auto path_to_write_seed = root_dir / "cur_input";
+  const u32 page_size = sysconf(_SC_PAGESIZE);
+  const std::size_t capacity = page_size;
+
+  // The outputs of seq are longer than capacity, which makes the buffer wrap
+  // around several times
+  std::string expected_stdout;
+  for (int i = 1; i <= 3000; i++) expected_stdout += std::to_string(i) + "\n";
+  expected_stdout.erase(0, expected_stdout.size() - capacity);
+
+  auto to_string = [](fuzzuf::feedback::InplaceMemoryFeedback &&feedback) {
+    std::string str;
+    feedback.ShowMemoryToFunc([&](const u8 *head, u32 size) {
+      str.assign(reinterpret_cast<const char *>(head), size);
+    });
+    return str;
+  };
+
+  for (bool forksrv : {false, true}) {
+    // The fork server mode runs the command through command_wrapper, which
+    // needs the coverage maps
+    std::vector<std::string> argv{"/bin/sh", "-c",
+                                  "seq 1 3000; printf err >&2"};
+    if (forksrv) {
+      argv.insert(argv.begin(),
+                  TEST_BINARY_DIR "/put_binaries/command_wrapper");
+    }
+
+    {
+      fuzzuf::executor::NativeLinuxExecutor executor(
+          argv, 1000, 10000, forksrv, path_to_write_seed, page_size, page_size,
+          fuzzuf::executor::RecordedOutputs(std::vector<int>{STDOUT_FILENO},
+                                            capacity));
+      for (int i = 0; i < 2; i++) {
+        executor.Run(reinterpret_cast<const u8 *>(""), 0);
+        BOOST_CHECK(executor.GetExitStatusFeedback().exit_reason ==
+                    fuzzuf::feedback::PUTExitReasonType::FAULT_NONE);
+        BOOST_CHECK_EQUAL(to_string(executor.GetStdOut()), expected_stdout);
+        BOOST_CHECK_EQUAL(to_string(executor.GetStdErr()), "");
+      }
+    }
+
+    {
+      fuzzuf::executor::NativeLinuxExecutor executor(
+          argv, 1000, 10000, forksrv, path_to_write_seed, page_size, page_size,
+          std::vector<int>{STDERR_FILENO});
+      executor.Run(reinterpret_cast<const u8 *>(""), 0);
+      BOOST_CHECK_EQUAL(to_string(executor.GetStdOut()), "");
+      BOOST_CHECK_EQUAL(to_string(executor.GetStdErr()), "err");
+      auto err = executor.MoveStdErr();
+      BOOST_CHECK_EQUAL(std::string(err.begin(), err.end()), "err");
+    }
+  }
+
+  // Other fds than stdout and stderr are not supported
+  BOOST_CHECK_THROW(fuzzuf::executor::NativeLinuxExecutor(
+                        {"/bin/true"}, 1000, 10000, false, path_to_write_seed,
+                        0, 0, std::vector<int>{3}),
+                    fuzzuf::exceptions::invalid_argument);
+}
+
+// Check if the standby fork server takes over when the active one dies, both
+// before and during the execution of the PUT
+BOOST_AUTO_TEST_CASE(NativeLinuxExecutorStandbyForkServer) {
+  std::string root_dir_template("/tmp/fuzzuf_test.XXXXXX");
+  auto *const raw_dirname = mkdtemp(root_dir_template.data());
+  BOOST_CHECK(raw_dirname != nullptr);
+
+  auto root_dir = fs::path(raw_dirname);
+  BOOST_SCOPE_EXIT(&root_dir) { fs::remove_all(root_dir); }
+  BOOST_SCOPE_EXIT_END
+
+  auto path_to_write_seed = root_dir / "cur_input";
+  auto marker_path = root_dir / "killed";
+  const u32 page_size = sysconf(_SC_PAGESIZE);
+
+  // The PUT kills its parent, that is the fork server, only at the first
+  // execution after the marker is removed
+  fuzzuf::executor::NativeLinuxExecutor executor(
+      {TEST_BINARY_DIR "/put_binaries/command_wrapper", "/bin/sh", "-c",
+       "[ -e " + marker_path.native() + " ] || { touch " +
+           marker_path.native() + "; kill -9 $PPID; sleep 1; }"},
+      1000, 10000, true, path_to_write_seed, page_size, page_size, false, {},
+      {}, true);
+  std::ofstream(marker_path.native());
+
+  executor.Run(reinterpret_cast<const u8 *>(""), 0);
+  BOOST_CHECK(executor.GetExitStatusFeedback().exit_reason ==
+              fuzzuf::feedback::PUTExitReasonType::FAULT_NONE);
+
+  // The fork server dies before the request
+  auto first_pid = executor.forksrv_pid;
+  auto first_shm_id = executor.GetAFLShmID();
+  kill(first_pid, SIGKILL);
+  executor.Run(reinterpret_cast<const u8 *>(""), 0);
+  BOOST_CHECK(executor.GetExitStatusFeedback().exit_reason ==
+              fuzzuf::feedback::PUTExitReasonType::FAULT_NONE);
+  BOOST_CHECK_NE(executor.forksrv_pid, first_pid);
+  // The standby fork server brings its own coverage map
+  BOOST_CHECK_NE(executor.GetAFLShmID(), first_shm_id);
+
+  // The fork server dies during the execution, which is retried once with the
+  // standby one
+  auto second_pid = executor.forksrv_pid;
+  fs::remove(marker_path);
+  executor.Run(reinterpret_cast<const u8 *>(""), 0);
+  BOOST_CHECK(executor.GetExitStatusFeedback().exit_reason ==
+              fuzzuf::feedback::PUTExitReasonType::FAULT_NONE);
+  BOOST_CHECK_NE(executor.forksrv_pid, second_pid);
+  BOOST_CHECK(!executor.child_timed_out);
+  BOOST_CHECK(fs::exists(marker_path));
+  // The maps are exchanged again, so the first one is back
+  BOOST_CHECK_EQUAL(executor.GetAFLShmID(), first_shm_id);
+}
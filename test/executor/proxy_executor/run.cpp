@@ -20,7 +20,12 @@
 
 #include <boost/scope_exit.hpp>
 #include <boost/test/unit_test.hpp>
+#include <chrono>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "fuzzuf/algorithms/afl/afl_option.hpp"
 #include "fuzzuf/exceptions.hpp"
@@ -178,3 +183,124 @@ BOOST_AUTO_TEST_CASE(ProxyExecutorNativeRunTooMuchOutput,
                     fuzzuf::feedback::PUTExitReasonType::FAULT_TMOUT);
   BOOST_CHECK_EQUAL(executor.GetExitStatusFeedback().signal, SIGKILL);
 }
+
+// Check if ProxyExecutors in the non fork server mode time out the PUTs
+// independently when they run at once on separate threads.
+BOOST_AUTO_TEST_CASE(ProxyExecutorConcurrentRunTimeout,
+                     *boost::unit_test::timeout(5)) {
+  // Setup root directory
+  std::string root_dir_template("/tmp/fuzzuf_test.XXXXXX");
+
+  const auto raw_dirname = mkdtemp(root_dir_template.data());
+  if (!raw_dirname) throw -1;
+  BOOST_CHECK(raw_dirname != nullptr);
+
+  auto root_dir = fs::path(raw_dirname);
+  BOOST_SCOPE_EXIT(&root_dir) { fs::remove_all(root_dir); }
+  BOOST_SCOPE_EXIT_END
+
+  constexpr std::size_t executor_count = 4;
+  constexpr u32 timeout_ms = 500;
+  std::vector<std::unique_ptr<fuzzuf::executor::ProxyExecutor>> executors;
+  for (std::size_t i = 0; i != executor_count; ++i) {
+    auto path_to_write_seed = root_dir / ("cur_input" + std::to_string(i));
+    // Use command_wrapper as a proxy application to execute never_exit.
+    executors.emplace_back(new fuzzuf::executor::ProxyExecutor(
+        fs::path(TEST_BINARY_DIR "/put_binaries/command_wrapper"),
+        {TEST_BINARY_DIR "/executor/never_exit"},
+        {TEST_BINARY_DIR "/executor/never_exit"}, timeout_ms, 10000, false,
+        path_to_write_seed, 0, false));
+    executors.back()->SetCArgvAndDecideInputMode();
+    executors.back()->Initilize();
+    executors.back()->EnableConcurrentRun();
+  }
+
+  std::string input;
+  const auto begin = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (auto &executor : executors) {
+    threads.emplace_back([&executor, &input] {
+      executor->Run(reinterpret_cast<const u8 *>(input.c_str()), input.size());
+    });
+  }
+  for (auto &thread : threads) thread.join();
+  const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::steady_clock::now() - begin)
+                           .count();
+
+  // 全ての実行がタイムアウトし、それらが並行して待たれた事を確認する
+  for (auto &executor : executors) {
+    BOOST_CHECK_EQUAL(executor->GetExitStatusFeedback().exit_reason,
+                      fuzzuf::feedback::PUTExitReasonType::FAULT_TMOUT);
+    BOOST_CHECK_EQUAL(executor->GetExitStatusFeedback().signal, SIGKILL);
+  }
+  BOOST_CHECK_GE(elapsed, timeout_ms);
+  BOOST_CHECK_LT(elapsed, timeout_ms * 2);
+}
+
+// Check if the feedback the proxy wrote to the shared memory is returned in
+// memory, and the file is used if the proxy doesn't write it there.
+BOOST_AUTO_TEST_CASE(ProxyExecutorShmFeedback) {
+  // Setup root directory
+  std::string root_dir_template("/tmp/fuzzuf_test.XXXXXX");
+
+  const auto raw_dirname = mkdtemp(root_dir_template.data());
+  if (!raw_dirname) throw -1;
+  BOOST_CHECK(raw_dirname != nullptr);
+
+  auto root_dir = fs::path(raw_dirname);
+  BOOST_SCOPE_EXIT(&root_dir) { fs::remove_all(root_dir); }
+  BOOST_SCOPE_EXIT_END
+
+  auto feed_path = root_dir / "feedback";
+  auto create_executor = [&root_dir] {
+    // Use command_wrapper as a proxy application to execute
+    // write_shm_feedback, which writes the input to the shared memory.
+    auto executor = std::make_unique<fuzzuf::executor::ProxyExecutor>(
+        fs::path(TEST_BINARY_DIR "/put_binaries/command_wrapper"),
+        std::vector<std::string>{TEST_BINARY_DIR
+                                 "/executor/write_shm_feedback"},
+        std::vector<std::string>{TEST_BINARY_DIR
+                                 "/executor/write_shm_feedback",
+                                 "@@"},
+        1000, 10000, false, root_dir / "cur_input", 0, false);
+    executor->SetCArgvAndDecideInputMode();
+    executor->Initilize();
+    return executor;
+  };
+
+  const std::string input = "Hello, shared memory";
+  const auto input_buf = reinterpret_cast<const u8 *>(input.data());
+
+  // 共有メモリに書かれたフィードバックがメモリ上で返される事を確認する
+  {
+    auto executor = create_executor();
+    executor->EnableShmFeedback(4096);
+    for (int i = 0; i != 2; ++i) {
+      executor->Run(input_buf, input.size());
+      auto feed = executor->GetFileFeedback(feed_path, {'T', 'E', 'S', 'T'});
+      BOOST_CHECK(feed.in_memory);
+      BOOST_CHECK_EQUAL(
+          std::string(reinterpret_cast<const char *>(feed.mem), feed.len),
+          input);
+    }
+  }
+
+  // 共有メモリに収まらなかった場合はファイルが使われる事を確認する
+  {
+    auto executor = create_executor();
+    executor->EnableShmFeedback(16);
+    executor->Run(input_buf, input.size());
+    auto feed = executor->GetFileFeedback(feed_path, {'T', 'E', 'S', 'T'});
+    BOOST_CHECK(!feed.in_memory);
+    BOOST_CHECK_EQUAL(feed.feed_path, feed_path);
+  }
+
+  // 共有メモリを有効にしなければファイルが使われる事を確認する
+  {
+    auto executor = create_executor();
+    executor->Run(input_buf, input.size());
+    auto feed = executor->GetFileFeedback(feed_path, {'T', 'E', 'S', 'T'});
+    BOOST_CHECK(!feed.in_memory);
+  }
+}
@@ -0,0 +1,73 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "fuzzuf/feedback/shm_feedback.hpp"
+
+// Write the contents of the file given as the last argument to the region
+// passed by the fuzzer as a record tagged "TEST", like a proxy supporting the
+// region does
+int main(int argc, char **argv) {
+  using namespace fuzzuf::feedback;
+
+  if (argc < 2) std::abort();
+  std::ifstream f(argv[argc - 1], std::ios::binary);
+  const std::vector<char> data((std::istreambuf_iterator<char>(f)),
+                               std::istreambuf_iterator<char>());
+
+  const auto name = std::getenv(SHM_FEEDBACK_ENV_VAR);
+  if (!name) return 0;
+  const int fd = shm_open(name, O_RDWR, 0);
+  if (fd < 0) std::abort();
+  struct stat st {};
+  if (fstat(fd, &st) < 0) std::abort();
+  auto addr =
+      mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED) std::abort();
+  close(fd);
+
+  auto header = static_cast<ShmFeedbackHeader *>(addr);
+  if (std::memcmp(header->magic, SHM_FEEDBACK_MAGIC, 4) != 0) std::abort();
+  header->flags |= SHM_FEEDBACK_ATTACHED;
+
+  const std::size_t padded =
+      (data.size() + SHM_FEEDBACK_RECORD_ALIGN - 1) /
+      SHM_FEEDBACK_RECORD_ALIGN * SHM_FEEDBACK_RECORD_ALIGN;
+  if (header->size + sizeof(ShmFeedbackRecordHeader) + padded >
+      header->capacity) {
+    header->flags |= SHM_FEEDBACK_OVERFLOW;
+    return 0;
+  }
+
+  auto record = reinterpret_cast<ShmFeedbackRecordHeader *>(
+      reinterpret_cast<char *>(header + 1) + header->size);
+  std::memcpy(record->tag, "TEST", 4);
+  record->length = data.size();
+  std::memcpy(record + 1, data.data(), data.size());
+  header->size += sizeof(ShmFeedbackRecordHeader) + padded;
+  header->record_count++;
+}
@@ -117,3 +117,79 @@ BOOST_AUTO_TEST_CASE(MutatorHavoc) {
                                 mutator.GetBuf() + mutator.GetLen());
   BOOST_CHECK(seed == modified_seed);
 }
+
+// Check if Mutator::RestoreHavoc reverts every switch case of Havoc,
+// including the ones changing the length of the input and custom cases.
+BOOST_AUTO_TEST_CASE(MutatorRestoreHavoc) {
+  std::vector<u8> seed(100);
+  std::iota(seed.begin(), seed.end(), 1);
+
+  using fuzzuf::algorithm::afl::dictionary::AFLDictData;
+  std::vector<AFLDictData> extras(1, AFLDictData({100, 101, 102, 103}));
+  std::vector<AFLDictData> a_extras(1, AFLDictData({'H', 'e', 'l', 'l', 'o'}));
+
+  fuzzuf::exec_input::ExecInputSet input_set;
+  auto input = input_set.CreateOnMemory(&seed[0], seed.size());
+  auto mutator = fuzzuf::mutator::Mutator<TestTag>(*input);
+
+  // This custom case reallocates outbuf like the ones of AFL++ and IJON.
+  auto custom_cases = [](u32, u8*& outbuf, u32& len,
+                         const std::vector<AFLDictData>&,
+                         const std::vector<AFLDictData>&) {
+    u8* new_buf = new u8[len + 1];
+    std::memcpy(new_buf + 1, outbuf, len);
+    new_buf[0] = 0;
+    delete[] outbuf;
+    outbuf = new_buf;
+    len += 1;
+  };
+
+  for (u32 i = 0; i <= fuzzuf::mutator::NUM_CASE; i++) {
+    auto case_dist = ConstantMutopSelector(i);
+    // Batch size of 256 makes some cases log more bytes than the input has,
+    // which checks the fallback to restoring a full copy.
+    for (u32 batch : {1u, 4u, 256u}) {
+      auto havoc_optimizer =
+          fuzzuf::optimizer::ConstantBatchHavocOptimizer(batch, case_dist);
+      mutator.Havoc(extras, a_extras, havoc_optimizer, custom_cases);
+      mutator.RestoreHavoc();
+
+      std::vector<u8> restored_seed(mutator.GetBuf(),
+                                    mutator.GetBuf() + mutator.GetLen());
+      BOOST_CHECK(seed == restored_seed);
+    }
+  }
+}
+
+// Check if Mutator::DiscardHavoc keeps the mutations of Havoc as the input, and
+// stops logging them.
+BOOST_AUTO_TEST_CASE(MutatorDiscardHavoc) {
+  using fuzzuf::algorithm::afl::dictionary::AFLDictData;
+
+  std::vector<u8> seed(64);
+  std::iota(seed.begin(), seed.end(), 1);
+
+  fuzzuf::exec_input::ExecInputSet input_set;
+  auto input = input_set.CreateOnMemory(&seed[0], seed.size());
+  auto mutator = fuzzuf::mutator::Mutator<TestTag>(*input);
+  BOOST_CHECK(!mutator.IsUndoLogging());
+
+  auto case_dist = ConstantMutopSelector(fuzzuf::mutator::FLIP1);
+  auto havoc_optimizer =
+      fuzzuf::optimizer::ConstantBatchHavocOptimizer(4, case_dist);
+  mutator.Havoc({}, {}, havoc_optimizer,
+                [](u32, u8*&, u32&, const std::vector<AFLDictData>&,
+                   const std::vector<AFLDictData>&) {});
+  BOOST_CHECK(mutator.IsUndoLogging());
+
+  mutator.DiscardHavoc();
+  BOOST_CHECK(!mutator.IsUndoLogging());
+
+  std::vector<u8> mutated(mutator.GetBuf(),
+                          mutator.GetBuf() + mutator.GetLen());
+  BOOST_CHECK(seed != mutated);
+  mutator.RestoreHavoc();
+  std::vector<u8> restored(mutator.GetBuf(),
+                           mutator.GetBuf() + mutator.GetLen());
+  BOOST_CHECK(mutated == restored);
+}
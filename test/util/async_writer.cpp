@@ -0,0 +1,109 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+#define BOOST_TEST_MODULE util.async_writer
+#define BOOST_TEST_DYN_LINK
+#include "fuzzuf/utils/async_writer.hpp"
+
+#include <unistd.h>
+
+#include <boost/scope_exit.hpp>
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ジョブが投入された順に全て実行され、デストラクタが残りを実行し終えてから戻る事を確認する
+BOOST_AUTO_TEST_CASE(RunJobsInOrder) {
+  std::vector<int> done;
+  {
+    fuzzuf::utils::AsyncWriter writer;
+    int posted = 0;
+    for (int i = 0; i < 1000; i++) {
+      if (writer.Post([&done, i] { done.push_back(i); })) {
+        posted++;
+      } else {
+        writer.Flush();
+        BOOST_REQUIRE(writer.Post([&done, i] { done.push_back(i); }));
+        posted++;
+      }
+      if (i == 500) {
+        writer.Flush();
+        BOOST_CHECK_EQUAL(done.size(), posted);
+      }
+    }
+  }
+
+  BOOST_REQUIRE_EQUAL(done.size(), 1000);
+  for (int i = 0; i < 1000; i++) BOOST_CHECK_EQUAL(done[i], i);
+}
+
+// リングが一杯の時、PostOrWait が空きを待ち、ジョブの順序が保たれる事を確認する
+BOOST_AUTO_TEST_CASE(PostOrWaitKeepsOrder) {
+  std::vector<int> done;
+  {
+    fuzzuf::utils::AsyncWriter writer;
+    writer.PostOrWait(
+        [] { std::this_thread::sleep_for(std::chrono::milliseconds(50)); });
+    for (std::size_t i = 0; i < fuzzuf::utils::AsyncWriter::CAPACITY * 4;
+         i++) {
+      writer.PostOrWait([&done, i] { done.push_back(i); });
+    }
+  }
+
+  BOOST_REQUIRE_EQUAL(done.size(), fuzzuf::utils::AsyncWriter::CAPACITY * 4);
+  for (std::size_t i = 0; i < done.size(); i++) BOOST_CHECK_EQUAL(done[i], i);
+}
+
+// ジョブが投げた例外が投入側のスレッドで再送出され、後続のジョブも実行される事を確認する
+BOOST_AUTO_TEST_CASE(RethrowJobError) {
+  fuzzuf::utils::AsyncWriter writer;
+  bool later_done = false;
+  writer.PostOrWait([] { throw std::runtime_error("disk full"); });
+  writer.PostOrWait([&later_done] { later_done = true; });
+
+  BOOST_CHECK_THROW(writer.Flush(), std::runtime_error);
+  BOOST_CHECK(later_done);
+  BOOST_CHECK_THROW(writer.Post([] {}), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(WriteFileAtomically) {
+  std::string root_dir_template("/tmp/fuzzuf_test.XXXXXX");
+  const auto raw_dirname = mkdtemp(root_dir_template.data());
+  BOOST_REQUIRE(raw_dirname != nullptr);
+  auto root_dir = fs::path(raw_dirname);
+  BOOST_SCOPE_EXIT(&root_dir) { fs::remove_all(root_dir); }
+  BOOST_SCOPE_EXIT_END
+
+  auto path = root_dir / "fuzzer_stats";
+  for (std::string data : {"first version\n", "second\n"}) {
+    BOOST_CHECK(fuzzuf::utils::WriteFileAtomically(path, data.data(),
+                                                    data.size()));
+    std::ifstream file(path);
+    std::string content((std::istreambuf_iterator<char>(file)),
+                        std::istreambuf_iterator<char>());
+    BOOST_CHECK_EQUAL(content, data);
+  }
+  BOOST_CHECK(!fs::exists(path.string() + ".tmp"));
+
+  BOOST_CHECK(!fuzzuf::utils::WriteFileAtomically(root_dir / "none" / "file",
+                                                  "x", 1));
+}
@@ -0,0 +1,148 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+#define BOOST_TEST_MODULE util.checkpoint
+#define BOOST_TEST_DYN_LINK
+#include "fuzzuf/utils/checkpoint.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <boost/scope_exit.hpp>
+#include <boost/test/unit_test.hpp>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+fuzzuf::utils::CheckpointWriter MakeCheckpoint() {
+  fuzzuf::utils::CheckpointWriter writer(3);
+  writer.Write(u32(0xdeadbeef));
+  writer.WriteVector(std::vector<u64>{1, 2, 3});
+  writer.WriteString("queue/id:000000");
+  writer.Write(true);
+  return writer;
+}
+
+void CheckCheckpoint(fuzzuf::utils::CheckpointReader &reader) {
+  BOOST_CHECK_EQUAL(reader.GetVersion(), 3);
+  BOOST_CHECK_EQUAL(reader.Read<u32>(), 0xdeadbeef);
+  auto values = reader.ReadVector<u64>();
+  BOOST_CHECK_EQUAL(values.size(), 3);
+  BOOST_CHECK_EQUAL(values[2], 3);
+  BOOST_CHECK_EQUAL(reader.ReadString(), "queue/id:000000");
+  BOOST_CHECK_EQUAL(reader.Read<bool>(), true);
+  BOOST_CHECK(reader.AtEnd());
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(RoundTrip) {
+  std::string root_dir_template("/tmp/fuzzuf_test.XXXXXX");
+  const auto raw_dirname = mkdtemp(root_dir_template.data());
+  BOOST_REQUIRE(raw_dirname != nullptr);
+  auto root_dir = fs::path(raw_dirname);
+  BOOST_SCOPE_EXIT(&root_dir) { fs::remove_all(root_dir); }
+  BOOST_SCOPE_EXIT_END
+
+  auto path = root_dir / "checkpoint";
+  auto writer = MakeCheckpoint();
+
+  fuzzuf::utils::WriteCheckpointFile(path, writer);
+  auto reader = fuzzuf::utils::ReadCheckpointFile(path);
+  CheckCheckpoint(reader);
+  BOOST_CHECK_THROW(reader.Read<u8>(), fuzzuf::exceptions::invalid_file);
+
+  fs::remove(path);
+  pid_t pid = fuzzuf::utils::WriteCheckpointFileInBackground(path, writer);
+  BOOST_REQUIRE(pid > 0);
+  int status;
+  BOOST_REQUIRE_EQUAL(waitpid(pid, &status, 0), pid);
+  BOOST_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  auto background_reader = fuzzuf::utils::ReadCheckpointFile(path);
+  CheckCheckpoint(background_reader);
+}
+
+// 途中で切れたり書き換えられたりしたチェックポイントを読み込めない事を確認する
+BOOST_AUTO_TEST_CASE(RejectBrokenFile) {
+  std::string root_dir_template("/tmp/fuzzuf_test.XXXXXX");
+  const auto raw_dirname = mkdtemp(root_dir_template.data());
+  BOOST_REQUIRE(raw_dirname != nullptr);
+  auto root_dir = fs::path(raw_dirname);
+  BOOST_SCOPE_EXIT(&root_dir) { fs::remove_all(root_dir); }
+  BOOST_SCOPE_EXIT_END
+
+  auto path = root_dir / "checkpoint";
+  BOOST_CHECK_THROW(fuzzuf::utils::ReadCheckpointFile(path),
+                    fuzzuf::exceptions::invalid_file);
+
+  auto writer = MakeCheckpoint();
+  fuzzuf::utils::WriteCheckpointFile(path, writer);
+  {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(20);
+    file.put('\xff');
+  }
+  BOOST_CHECK_THROW(fuzzuf::utils::ReadCheckpointFile(path),
+                    fuzzuf::exceptions::invalid_file);
+
+  fs::resize_file(path, 4);
+  BOOST_CHECK_THROW(fuzzuf::utils::ReadCheckpointFile(path),
+                    fuzzuf::exceptions::invalid_file);
+
+  std::vector<u8> not_checkpoint(16, 0);
+  BOOST_CHECK_THROW(fuzzuf::utils::CheckpointReader(std::move(not_checkpoint)),
+                    fuzzuf::exceptions::invalid_file);
+}
+
+// ファイルサイズが書き込み時に埋められ、ファイルが無ければ書き込みが失敗する事を確認する
+BOOST_AUTO_TEST_CASE(FileSize) {
+  std::string root_dir_template("/tmp/fuzzuf_test.XXXXXX");
+  const auto raw_dirname = mkdtemp(root_dir_template.data());
+  BOOST_REQUIRE(raw_dirname != nullptr);
+  auto root_dir = fs::path(raw_dirname);
+  BOOST_SCOPE_EXIT(&root_dir) { fs::remove_all(root_dir); }
+  BOOST_SCOPE_EXIT_END
+
+  auto path = root_dir / "checkpoint";
+  auto entry = root_dir / "entry";
+  fuzzuf::utils::CheckpointWriter writer(3);
+  writer.WriteFileSize(entry);
+  std::ofstream(entry.native()) << "12345";
+
+  pid_t pid = fuzzuf::utils::WriteCheckpointFileInBackground(path, writer);
+  BOOST_REQUIRE(pid > 0);
+  int status;
+  BOOST_REQUIRE_EQUAL(waitpid(pid, &status, 0), pid);
+  BOOST_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  auto reader = fuzzuf::utils::ReadCheckpointFile(path);
+  BOOST_CHECK_EQUAL(reader.Read<u32>(), 5);
+  BOOST_CHECK(reader.AtEnd());
+
+  fs::remove(entry);
+  pid = fuzzuf::utils::WriteCheckpointFileInBackground(path, writer);
+  BOOST_REQUIRE(pid > 0);
+  BOOST_REQUIRE_EQUAL(waitpid(pid, &status, 0), pid);
+  BOOST_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 1);
+  BOOST_CHECK_THROW(fuzzuf::utils::WriteCheckpointFile(path, writer),
+                    fuzzuf::exceptions::unable_to_create_file);
+
+  // The checkpoint written before is kept
+  auto old_reader = fuzzuf::utils::ReadCheckpointFile(path);
+  BOOST_CHECK_EQUAL(old_reader.Read<u32>(), 5);
+}
@@ -0,0 +1,99 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+#define BOOST_TEST_MODULE util.compact_bitmap
+#define BOOST_TEST_DYN_LINK
+#include "fuzzuf/utils/compact_bitmap.hpp"
+
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <iterator>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace {
+
+// Random indices below limit, with density about 1/sparsity
+std::set<u32> RandomSet(std::mt19937 &rng, u32 limit, u32 sparsity) {
+  std::set<u32> set;
+  for (u32 i = 0; i < limit / sparsity; i++) set.insert(rng() % limit);
+  return set;
+}
+
+fuzzuf::utils::CompactBitmap ToBitmap(const std::set<u32> &set) {
+  return fuzzuf::utils::CompactBitmap(std::vector<u32>(set.begin(), set.end()));
+}
+
+std::vector<u32> ToVector(const fuzzuf::utils::CompactBitmap &bitmap) {
+  std::vector<u32> indices;
+  bitmap.ForEach([&indices](u32 i) { indices.push_back(i); });
+  return indices;
+}
+
+}  // namespace
+
+// 疎なチャンク(配列)と密なチャンク(ビットマップ)の全ての組み合わせで、
+// 和集合と積集合が std::set による計算結果と一致する事を確認する
+BOOST_AUTO_TEST_CASE(SetOperations) {
+  std::mt19937 rng(1);
+  // 1 << 18 indices span 4 chunks
+  constexpr u32 LIMIT = 1 << 18;
+
+  for (u32 l_sparsity : {2u, 64u, 4096u}) {
+    for (u32 r_sparsity : {2u, 64u, 4096u}) {
+      auto l_set = RandomSet(rng, LIMIT, l_sparsity);
+      auto r_set = RandomSet(rng, LIMIT, r_sparsity);
+      auto l = ToBitmap(l_set);
+      auto r = ToBitmap(r_set);
+
+      BOOST_CHECK_EQUAL(l.Count(), l_set.size());
+      BOOST_CHECK(ToVector(l) == std::vector<u32>(l_set.begin(), l_set.end()));
+
+      std::set<u32> united;
+      std::set_union(l_set.begin(), l_set.end(), r_set.begin(), r_set.end(),
+                     std::inserter(united, united.end()));
+      std::set<u32> common;
+      std::set_intersection(l_set.begin(), l_set.end(), r_set.begin(),
+                            r_set.end(), std::inserter(common, common.end()));
+
+      BOOST_CHECK_EQUAL(l.Intersects(r), !common.empty());
+
+      auto u = l;
+      u |= r;
+      BOOST_CHECK(u == ToBitmap(united));
+
+      auto c = l;
+      c &= r;
+      BOOST_CHECK(c == ToBitmap(common));
+
+      for (u32 i = 0; i < LIMIT; i += 97) {
+        BOOST_CHECK_EQUAL(u.Test(i), united.count(i) != 0);
+      }
+    }
+  }
+}
+
+// 疎な集合は同じ範囲の std::bitset よりずっと小さい事を確認する
+BOOST_AUTO_TEST_CASE(MemoryUsage) {
+  std::vector<u32> indices;
+  for (u32 i = 0; i < 1000; i++) indices.push_back(i * 8000);
+  fuzzuf::utils::CompactBitmap bitmap(indices);
+
+  BOOST_CHECK_EQUAL(bitmap.Count(), 1000);
+  BOOST_CHECK_LT(bitmap.GetMemoryUsage(), 8000 * 1000 / 8 / 16);
+}
@@ -0,0 +1,140 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+#define BOOST_TEST_MODULE util.cpu_affinity
+#define BOOST_TEST_DYN_LINK
+#include "fuzzuf/utils/cpu_affinity.hpp"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <boost/scope_exit.hpp>
+#include <boost/test/unit_test.hpp>
+#include <fstream>
+#include <string>
+
+#include "fuzzuf/utils/common.hpp"
+#include "fuzzuf/utils/filesystem.hpp"
+
+// Check if a CPU core locked by a fuzzuf instance can't be locked by another,
+// and the lock directory is shared with any user regardless of the umask
+BOOST_AUTO_TEST_CASE(LockCpu) {
+  std::string root_dir_template("/tmp/fuzzuf_test.XXXXXX");
+  auto *const raw_dirname = mkdtemp(root_dir_template.data());
+  BOOST_CHECK(raw_dirname != nullptr);
+
+  auto root_dir = fs::path(raw_dirname);
+  BOOST_SCOPE_EXIT(&root_dir) { fs::remove_all(root_dir); }
+  BOOST_SCOPE_EXIT_END
+
+  auto lock_dir = root_dir / "nested" / "lock";
+  fuzzuf::utils::SetCpuLockDir(lock_dir);
+
+  auto old_umask = umask(077);
+  BOOST_CHECK(fuzzuf::utils::LockCpu(0));
+  umask(old_umask);
+
+  struct stat st;
+  BOOST_CHECK_EQUAL(stat(lock_dir.c_str(), &st), 0);
+  BOOST_CHECK_EQUAL(st.st_mode & 07777, 01777);
+  BOOST_CHECK(fs::exists(lock_dir / "cpu0.lock"));
+
+  // Locking the same core again in this process succeeds
+  BOOST_CHECK(fuzzuf::utils::LockCpu(0));
+
+  // The lock conflicts with the others, which behave like other processes
+  // since flock() locks are owned by open file descriptions
+  int fd = open((lock_dir / "cpu0.lock").c_str(), O_RDONLY);
+  BOOST_CHECK(fd >= 0);
+  BOOST_CHECK(flock(fd, LOCK_EX | LOCK_NB) < 0);
+  close(fd);
+
+  // A core locked by another fuzzuf instance can't be locked
+  fd = open((lock_dir / "cpu1.lock").c_str(), O_RDONLY | O_CREAT, 0666);
+  BOOST_CHECK(fd >= 0);
+  BOOST_CHECK_EQUAL(flock(fd, LOCK_EX | LOCK_NB), 0);
+  BOOST_CHECK(!fuzzuf::utils::LockCpu(1));
+
+  // The core can be locked once it is released
+  close(fd);
+  BOOST_CHECK(fuzzuf::utils::LockCpu(1));
+}
+
+// Check if a CPU core is not considered locked when the lock file can't be
+// opened
+BOOST_AUTO_TEST_CASE(LockCpuWithoutLockDir) {
+  std::string root_dir_template("/tmp/fuzzuf_test.XXXXXX");
+  auto *const raw_dirname = mkdtemp(root_dir_template.data());
+  BOOST_CHECK(raw_dirname != nullptr);
+
+  auto root_dir = fs::path(raw_dirname);
+  BOOST_SCOPE_EXIT(&root_dir) { fs::remove_all(root_dir); }
+  BOOST_SCOPE_EXIT_END
+
+  // The lock directory can't be created under a regular file
+  std::ofstream((root_dir / "file").native());
+  fuzzuf::utils::SetCpuLockDir(root_dir / "file" / "lock");
+  BOOST_CHECK(!fuzzuf::utils::LockCpu(2));
+}
+
+// Check if a CPU core taken by LockVacantCpu is unlocked on release, and can
+// be taken again
+BOOST_AUTO_TEST_CASE(ReleaseVacantCpu) {
+  std::string root_dir_template("/tmp/fuzzuf_test.XXXXXX");
+  auto *const raw_dirname = mkdtemp(root_dir_template.data());
+  BOOST_CHECK(raw_dirname != nullptr);
+
+  auto root_dir = fs::path(raw_dirname);
+  BOOST_SCOPE_EXIT(&root_dir) { fs::remove_all(root_dir); }
+  BOOST_SCOPE_EXIT_END
+
+  fuzzuf::utils::SetCpuLockDir(root_dir);
+
+  const int cpu_core_count = fuzzuf::utils::GetCpuCore();
+  const int cpuid = fuzzuf::utils::LockVacantCpu(cpu_core_count);
+  // Every core may be busy on the host running the test
+  if (cpuid == fuzzuf::utils::CPUID_DO_NOT_BIND) return;
+
+  const auto lock_path =
+      root_dir / ("cpu" + std::to_string(cpuid) + ".lock");
+  int fd = open(lock_path.c_str(), O_RDONLY);
+  BOOST_CHECK(fd >= 0);
+  BOOST_CHECK(flock(fd, LOCK_EX | LOCK_NB) < 0);
+
+  fuzzuf::utils::ReleaseVacantCpu(cpuid);
+  BOOST_CHECK_EQUAL(flock(fd, LOCK_EX | LOCK_NB), 0);
+  close(fd);
+
+  BOOST_CHECK_EQUAL(fuzzuf::utils::LockVacantCpu(cpu_core_count), cpuid);
+  fuzzuf::utils::ReleaseVacantCpu(cpuid);
+}
+
+// Check if the SMT siblings are sorted and contain the core itself
+BOOST_AUTO_TEST_CASE(GetSmtSiblings) {
+  auto siblings = fuzzuf::utils::GetSmtSiblings(0);
+  BOOST_CHECK(std::is_sorted(siblings.begin(), siblings.end()));
+  BOOST_CHECK(std::count(siblings.begin(), siblings.end(), 0) == 1);
+
+  // Without the topology, only the core itself is returned
+  const int nonexistent = 1 << 20;
+  siblings = fuzzuf::utils::GetSmtSiblings(nonexistent);
+  BOOST_CHECK_EQUAL(siblings.size(), 1u);
+  BOOST_CHECK_EQUAL(siblings[0], nonexistent);
+}
@@ -171,3 +171,59 @@ BOOST_AUTO_TEST_CASE(TestWalkerDiscreteDistributionBiased) {
     BOOST_CHECK(std::abs(z) < Z);
   }
 }
+
+BOOST_AUTO_TEST_CASE(TestFenwickDiscreteDistributionUpdate) {
+  constexpr double Z = 3.32;       // alpha=0.001, Z_{0.0005} (0.1% error)
+  constexpr size_t iter = 100000;  // smaller than simple test
+
+  /* Build weights partly from a vector and partly by Push, then Set them */
+  std::vector<double> w{5.0, 0.0, 30.0, 1.0, 0.0, 12.0, 7.0};
+  FenwickDiscreteDistribution<size_t> s(std::vector<double>(3, 1.0));
+  for (size_t i = 3; i < w.size(); i++) s.Push(100.0);
+  for (size_t i = 0; i < w.size(); i++) s.Set(i, w[i]);
+
+  BOOST_CHECK_EQUAL(s.Size(), w.size());
+  std::vector<size_t> res(w.size());
+  for (size_t i = 0; i < iter; i++) {
+    size_t index = s();
+    BOOST_CHECK(index < w.size());
+    res[index]++;
+  }
+
+  /* Run statistical test for each result */
+  double sum = std::accumulate(w.begin(), w.end(), 0.0);
+  for (size_t i = 0; i < w.size(); i++) {
+    BOOST_CHECK_EQUAL(s.Get(i), w[i]);
+    const double z = Z_SCORE(iter, res[i], w[i] / sum);
+    if (std::isnan(z)) {
+      /* sqrt(V) ~ 0.0 case */
+      BOOST_CHECK(res[i] == 0);
+    } else {
+      BOOST_CHECK(std::abs(z) < Z);
+    }
+  }
+
+  /* Test invalid weights */
+  FenwickDiscreteDistribution<size_t> empty;
+  BOOST_CHECK_THROW(empty(), std::out_of_range);
+  BOOST_CHECK_THROW(empty.Push(-1.0), std::range_error);
+  empty.Push(0.0);
+  BOOST_CHECK_THROW(empty(), std::range_error);
+  BOOST_CHECK_THROW(s.Set(0, std::nan("")), std::range_error);
+}
+
+BOOST_AUTO_TEST_CASE(TestFenwickDiscreteDistributionSetToZero) {
+  /* Weights which can't be represented exactly leave rounding errors in the
+     tree and the sum after they are set and reset */
+  FenwickDiscreteDistribution<size_t> s(std::vector<double>(100, 0.0));
+  for (size_t round = 0; round < 100; round++) {
+    for (size_t i = 0; i < s.Size(); i++) s.Set(i, 0.1 * (i + round + 1));
+    for (size_t i = 0; i < s.Size(); i++) s.Set(i, 0.0);
+  }
+  BOOST_CHECK_THROW(s(), std::range_error);
+
+  /* The only positive weight is always chosen */
+  for (size_t i = 0; i < s.Size(); i++) s.Set(i, 0.3 * (i + 1));
+  for (size_t i = 0; i < s.Size(); i++) s.Set(i, i == 42 ? 1e-300 : 0.0);
+  for (size_t i = 0; i < 1000; i++) BOOST_CHECK_EQUAL(s(), 42);
+}
@@ -0,0 +1,178 @@
+#!/usr/bin/env node
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/*
+ * Long-lived worker which runs esfuzz.js and typer/typer.js of DIE on request,
+ * so that node and the modules of DIE are loaded only once per fuzzing
+ * campaign instead of once per mutation.
+ *
+ * Usage: node mutator_worker.js path/to/DIE/fuzz/TS
+ *
+ * Requests are read from fd 3 and responses are written to fd 4, so that the
+ * messages the scripts print to stdout don't break them. All integers are 32
+ * bit little endian.
+ *   Request:  field count, then each field as its length and bytes. The first
+ *             field is "mutate" or "instrument", and the rest are passed to
+ *             esfuzz.js or typer.js respectively as their arguments.
+ *   Response: exit status of the script, buffer count, then each buffer as
+ *             its length and bytes. For "mutate", the buffers are the pairs of
+ *             each mutant and its type file. "instrument" returns no buffer.
+ *
+ * The requests are processed synchronously. The scripts must finish their
+ * work before they return, as they do when they are run by node directly.
+ */
+'use strict';
+
+const fs = require('fs');
+const Module = require('module');
+const path = require('path');
+
+const REQUEST_FD = 3;
+const RESPONSE_FD = 4;
+
+const tsDir = path.resolve(process.argv[2]);
+const scripts = {
+  mutate: path.join(tsDir, 'esfuzz.js'),
+  instrument: path.join(tsDir, 'typer', 'typer.js'),
+};
+
+class ExitCalled extends Error {
+  constructor(code) {
+    super(`process.exit(${code})`);
+    this.code = code;
+  }
+}
+
+/* Run the script as `node script ...args` does. Only the script itself is
+ * reloaded on each call, and the modules it requires stay in the cache. */
+function runScript(script, args) {
+  const argv = process.argv;
+  const exit = process.exit;
+  const mainModule = process.mainModule;
+  process.argv = [argv[0], script, ...args];
+  process.exitCode = undefined;
+  process.exit = (code) => {
+    throw new ExitCalled(code === undefined ? 0 : code);
+  };
+  try {
+    delete require.cache[require.resolve(script)];
+    // Load the script as the main module, so that `require.main === module`
+    // holds in it
+    Module._load(script, null, true);
+    return process.exitCode || 0;
+  } catch (e) {
+    if (e instanceof ExitCalled) return e.code;
+    console.error(e);
+    return 1;
+  } finally {
+    process.argv = argv;
+    process.exit = exit;
+    process.mainModule = mainModule;
+    process.exitCode = undefined;
+  }
+}
+
+function readIfExists(file) {
+  try {
+    return fs.readFileSync(file);
+  } catch (e) {
+    return null;
+  }
+}
+
+function removeIfExists(file) {
+  try {
+    fs.unlinkSync(file);
+  } catch (e) {
+    // Nothing to remove
+  }
+}
+
+function mutate(args) {
+  const [, outDir, count] = args;
+  const outputs = [];
+  for (let i = 0; i < parseInt(count, 10); i++)
+    outputs.push(path.join(outDir, `${i}.js`));
+
+  // Remove the mutants of the last request, so that they are not returned
+  // again if esfuzz fails to write some of them
+  for (const js of outputs) {
+    removeIfExists(js);
+    removeIfExists(`${js}.t`);
+  }
+
+  const status = runScript(scripts.mutate, args);
+
+  const buffers = [];
+  for (const js of outputs) {
+    const code = readIfExists(js);
+    const type = readIfExists(`${js}.t`);
+    if (code && type && code.length && type.length) buffers.push(code, type);
+  }
+  return [status, buffers];
+}
+
+function readExact(length) {
+  const buffer = Buffer.alloc(length);
+  let offset = 0;
+  while (offset < length) {
+    const n = fs.readSync(REQUEST_FD, buffer, offset, length - offset, null);
+    if (n === 0) process.exit(0); // The fuzzer has closed the pipe
+    offset += n;
+  }
+  return buffer;
+}
+
+function readU32() {
+  return readExact(4).readUInt32LE(0);
+}
+
+function readRequest() {
+  const fields = [];
+  for (let count = readU32(); count > 0; count--)
+    fields.push(readExact(readU32()).toString());
+  return fields;
+}
+
+function u32(value) {
+  const buffer = Buffer.alloc(4);
+  buffer.writeUInt32LE(value >>> 0, 0);
+  return buffer;
+}
+
+function writeResponse(status, buffers) {
+  const chunks = [u32(status), u32(buffers.length)];
+  for (const buffer of buffers) chunks.push(u32(buffer.length), buffer);
+
+  const response = Buffer.concat(chunks);
+  let offset = 0;
+  while (offset < response.length) {
+    offset += fs.writeSync(RESPONSE_FD, response, offset,
+                           response.length - offset);
+  }
+}
+
+for (;;) {
+  const [op, ...args] = readRequest();
+  if (op === 'mutate')
+    writeResponse(...mutate(args));
+  else if (op === 'instrument')
+    writeResponse(runScript(scripts.instrument, args), []);
+  else
+    writeResponse(1, []);
+}
@@ -57,6 +57,47 @@ KNOB<UINT32> KnobTimeout(KNOB_MODE_WRITEONCE, "pintool",
         "x", "1", "specify timeout in seconds");
 KNOB<string> KnobXLibraries(KNOB_MODE_WRITEONCE, "pintool",
         "l", "", "specify shared lobraries to be monitored, separated by comma (no spaces)");
+KNOB<UINT32> KnobBinary(KNOB_MODE_WRITEONCE, "pintool",
+        "binary", "0", "write the output in binary format");
+
+/* Binary format of the output. Keep in sync with
+ * include/fuzzuf/algorithms/vuzzer/vuzzer_feedback_format.hpp */
+struct BBCovHeader
+{
+    char magic[4];
+    UINT32 record_count;
+};
+struct BBCovRecord
+{
+    UINT64 addr;
+    UINT32 count;
+    UINT32 reserved;
+};
+
+/* Shared memory region to write the binary output to instead of the output
+ * file. Keep in sync with include/fuzzuf/feedback/shm_feedback.hpp */
+#define SHM_FEEDBACK_ENV_VAR "__FUZZUF_FEEDBACK_SHM"
+#define SHM_FEEDBACK_VERSION 1
+#define SHM_FEEDBACK_ATTACHED 1
+#define SHM_FEEDBACK_OVERFLOW 2
+#define SHM_FEEDBACK_RECORD_ALIGN 8
+struct ShmFeedbackHeader
+{
+    char magic[4];
+    UINT32 version;
+    UINT32 capacity;
+    UINT32 flags;
+    UINT32 size;
+    UINT32 record_count;
+};
+struct ShmFeedbackRecordHeader
+{
+    char tag[4];
+    UINT32 length;
+};
+
+static ShmFeedbackHeader* shm_feedback = NULL;
+static size_t shm_feedback_size;
 
 static FILE* trace;
 static FILE* offsets;
@@ -224,6 +265,67 @@ static VOID TimeoutF(VOID * arg)
 }
 
 
+/* Map the region passed by fuzzuf if any. Returns NULL if it's not available,
+ * in which case the output is written to the file. */
+ShmFeedbackHeader* AttachShmFeedback()
+{
+    const char* name = getenv(SHM_FEEDBACK_ENV_VAR);
+    if (!name)
+        return NULL;
+
+    /* shm_open() on Linux opens the file under /dev/shm */
+    std::string path = std::string("/dev/shm") + name;
+    int fd = open(path.c_str(), O_RDWR);
+    if (fd == -1)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(ShmFeedbackHeader))
+    {
+        close(fd);
+        return NULL;
+    }
+    void* addr = mmap(0, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return NULL;
+
+    ShmFeedbackHeader* header = (ShmFeedbackHeader*)addr;
+    if (memcmp(header->magic, "FZFB", 4) != 0 ||
+            header->version != SHM_FEEDBACK_VERSION ||
+            sizeof(ShmFeedbackHeader) + header->capacity > (size_t)st.st_size)
+    {
+        munmap(addr, st.st_size);
+        return NULL;
+    }
+    shm_feedback_size = st.st_size;
+    header->flags |= SHM_FEEDBACK_ATTACHED;
+    return header;
+}
+
+/* Append a record of length bytes to the region, and return the pointer to
+ * fill in. Returns NULL if it doesn't fit. */
+UINT8* AllocShmFeedbackRecord(const char* tag, UINT32 length)
+{
+    UINT64 padded = ((UINT64)length + SHM_FEEDBACK_RECORD_ALIGN - 1) /
+        SHM_FEEDBACK_RECORD_ALIGN * SHM_FEEDBACK_RECORD_ALIGN;
+    if (shm_feedback->size + sizeof(ShmFeedbackRecordHeader) + padded >
+            shm_feedback->capacity)
+    {
+        shm_feedback->flags |= SHM_FEEDBACK_OVERFLOW;
+        return NULL;
+    }
+
+    UINT8* records = (UINT8*)(shm_feedback + 1);
+    ShmFeedbackRecordHeader* record =
+        (ShmFeedbackRecordHeader*)(records + shm_feedback->size);
+    memcpy(record->tag, tag, 4);
+    record->length = length;
+    shm_feedback->size += sizeof(ShmFeedbackRecordHeader) + padded;
+    shm_feedback->record_count++;
+    return (UINT8*)(record + 1);
+}
+
 VOID Fini(INT32 code, VOID *v)
 {
     /*
@@ -235,13 +337,50 @@ VOID Fini(INT32 code, VOID *v)
        */
     //if(ret.second == true)
     map<ADDRINT,unsigned int>::iterator bb;
-    for (bb=bbcount.begin();bb!=bbcount.end();++bb)
+    UINT8* shm_record = NULL;
+    if (shm_feedback)
+    {
+        shm_record = AllocShmFeedbackRecord("VZBB",
+                sizeof(BBCovHeader) + bbcount.size() * sizeof(BBCovRecord));
+        /* Fall back to the file if it doesn't fit */
+        if (!shm_record)
+            trace = fopen(KnobOutputFile.Value().c_str(), "w");
+    }
+
+    if (shm_record)
+    {
+        BBCovHeader header = {{'V', 'Z', 'B', 'B'}, (UINT32)bbcount.size()};
+        memcpy(shm_record, &header, sizeof(header));
+        shm_record += sizeof(header);
+        for (bb=bbcount.begin();bb!=bbcount.end();++bb)
+        {
+            BBCovRecord record = {(UINT64)bb->first, bb->second, 0};
+            memcpy(shm_record, &record, sizeof(record));
+            shm_record += sizeof(record);
+        }
+        munmap(shm_feedback, shm_feedback_size);
+    }
+    else if (KnobBinary.Value() > 0)
+    {
+        BBCovHeader header = {{'V', 'Z', 'B', 'B'}, (UINT32)bbcount.size()};
+        fwrite(&header, sizeof(header), 1, trace);
+        for (bb=bbcount.begin();bb!=bbcount.end();++bb)
+        {
+            BBCovRecord record = {(UINT64)bb->first, bb->second, 0};
+            fwrite(&record, sizeof(record), 1, trace);
+        }
+    }
+    else
     {
-        fprintf(trace, "%p %u\n", (void *)bb->first, bb->second);
-        //fflush(trace);
+        for (bb=bbcount.begin();bb!=bbcount.end();++bb)
+        {
+            fprintf(trace, "%p %u\n", (void *)bb->first, bb->second);
+            //fflush(trace);
 
+        }
     }
-    fclose(trace);
+    if (trace)
+        fclose(trace);
     fclose(offsets);
     munmap(offsetmap, 18);
     close(ioffset);
@@ -296,7 +435,12 @@ int main(int argc, char * argv[])
 
 
     if (PIN_Init(argc, argv)) return Usage();
-    trace = fopen(KnobOutputFile.Value().c_str(), "w");
+    /* The output file is opened in Fini only if the output doesn't fit in
+       the shared memory */
+    if (KnobBinary.Value() > 0)
+        shm_feedback = AttachShmFeedback();
+    if (!shm_feedback)
+        trace = fopen(KnobOutputFile.Value().c_str(), "w");
     TRACE_AddInstrumentFunction(Trace, 0);
     /* lets add signal intercept for signal 1, 6, and 11. */
     INT32 signals[3]={1,6,11};
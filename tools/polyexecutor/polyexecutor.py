@@ -24,6 +24,55 @@ from polytracker.database import DBProgramTrace, CanonicalMap, DBReferencedValue
 from polytracker.tracing import ByteAccessType
 
 import argparse
+import mmap
+import struct
+
+# Shared memory region passed by fuzzuf to write the taint file to.
+# Keep in sync with include/fuzzuf/feedback/shm_feedback.hpp
+SHM_FEEDBACK_ENV_VAR = "__FUZZUF_FEEDBACK_SHM"
+SHM_FEEDBACK_HEADER = "=4s5I" # magic, version, capacity, flags, size, record_count
+SHM_FEEDBACK_RECORD_HEADER = "=4sI" # tag, length
+SHM_FEEDBACK_VERSION = 1
+SHM_FEEDBACK_ATTACHED = 1
+SHM_FEEDBACK_OVERFLOW = 2
+SHM_FEEDBACK_RECORD_ALIGN = 8
+
+def write_shm_feedback(tag, data):
+    """Append data to the shared memory region as a record tagged tag.
+    Returns False if the region is not available or data doesn't fit, in which
+    case data must be written to the file instead."""
+    name = os.environ.get(SHM_FEEDBACK_ENV_VAR)
+    if not name:
+        return False
+    try:
+        # shm_open() on Linux opens the file under /dev/shm
+        fd = os.open("/dev/shm" + name, os.O_RDWR)
+    except OSError:
+        return False
+    try:
+        with mmap.mmap(fd, 0) as shm:
+            header_size = struct.calcsize(SHM_FEEDBACK_HEADER)
+            record_header_size = struct.calcsize(SHM_FEEDBACK_RECORD_HEADER)
+            magic, version, capacity, flags, size, count = struct.unpack_from(SHM_FEEDBACK_HEADER, shm, 0)
+            if magic != b"FZFB" or version != SHM_FEEDBACK_VERSION or header_size + capacity > len(shm):
+                return False
+
+            flags |= SHM_FEEDBACK_ATTACHED
+            padded = -(-len(data) // SHM_FEEDBACK_RECORD_ALIGN) * SHM_FEEDBACK_RECORD_ALIGN
+            if size + record_header_size + padded > capacity:
+                flags |= SHM_FEEDBACK_OVERFLOW
+                struct.pack_into(SHM_FEEDBACK_HEADER, shm, 0, magic, version, capacity, flags, size, count)
+                return False
+
+            pos = header_size + size
+            struct.pack_into(SHM_FEEDBACK_RECORD_HEADER, shm, pos, tag, len(data))
+            pos += record_header_size
+            shm[pos:pos + len(data)] = data
+            size += record_header_size + padded
+            struct.pack_into(SHM_FEEDBACK_HEADER, shm, 0, magic, version, capacity, flags, size, count + 1)
+            return True
+    finally:
+        os.close(fd)
 
 class PolyExecutor:
     def __init__(self, cmd, input, db, debug):
@@ -105,6 +154,7 @@ if __name__ == '__main__':
     parser.add_argument("-o", "--output", help="Path to directory in which *.out files put", required=True)
     parser.add_argument("-d", "--db", default="polytracker.db")
     parser.add_argument("--debug", action="store_true")
+    parser.add_argument("--binary", action="store_true", help="Write the taint file in binary format")
     args = parser.parse_args()
 
     executor = PolyExecutor(args.cmd, args.input, args.db, args.debug)
@@ -122,7 +172,14 @@ if __name__ == '__main__':
     # for ref in trace.referenced_values:
     #     print(ref)
 
-    taint_file = open(args.output, "w+")
+    # The binary taint file is written at the end, to the shared memory if
+    # possible
+    taint_file = None if args.binary else open(args.output, "w+")
+    # Tuples of (type, first offset, values) written in binary format.
+    # Keep in sync with include/fuzzuf/algorithms/vuzzer/vuzzer_feedback_format.hpp
+    TAINT_TYPE_CMP = 0
+    TAINT_TYPE_LEA = 1
+    records = []
 
     ### NOTE: Assuming there is only one input file for taint analysis
     print("[*] CMP/LEA analysis")
@@ -141,7 +198,11 @@ if __name__ == '__main__':
                     label=access.label,
                     value=value_str
                     ))
-                taint_file.write("CMP {offset} {value}\n".format(offset=offset_str, value=value_str))
+                if args.binary:
+                    offsets = taint_forest.offsets(access.label)
+                    records.append((TAINT_TYPE_CMP, offsets[0] if offsets else 0, [ref.value & 0xffffffff for ref in referenced_value]))
+                else:
+                    taint_file.write("CMP {offset} {value}\n".format(offset=offset_str, value=value_str))
         elif access.access_type == ByteAccessType.MEMORY_ACCESS_OPERAND_ACCESS:
             offset_str = ','.join([f"{offset:#x}" for offset in taint_forest.offsets(access.label)])
             print("LEA(event_id={event_id}, function={function}, bb_index={bb_index}): Offset [{offset}] (label {label})".format(
@@ -151,7 +212,21 @@ if __name__ == '__main__':
                 offset=offset_str,
                 label=access.label,
             ))
-            taint_file.write("LEA {offset} {value}\n".format(offset=offset_str, value=""))
+            if args.binary:
+                offsets = taint_forest.offsets(access.label)
+                records.append((TAINT_TYPE_LEA, offsets[0] if offsets else 0, []))
+            else:
+                taint_file.write("LEA {offset} {value}\n".format(offset=offset_str, value=""))
+
+    if args.binary:
+        taint_data = bytearray(struct.pack("<4sI", b"VZTN", len(records)))
+        for type, offset, values in records:
+            taint_data += struct.pack("<III", type, offset & 0xffffffff, len(values))
+            taint_data += struct.pack("<%dI" % len(values), *values)
+        if not write_shm_feedback(b"VZTN", taint_data):
+            taint_file = open(args.output, "wb+")
+            taint_file.write(taint_data)
 
-    taint_file.close()
+    if taint_file:
+        taint_file.close()
     os.remove(args.db) # We should remove the taint db at every execution
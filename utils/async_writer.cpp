@@ -0,0 +1,128 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file async_writer.cpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#include "fuzzuf/utils/async_writer.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace fuzzuf::utils {
+
+AsyncWriter::AsyncWriter() {
+  sem_init(&posted, 0, 0);
+  worker = std::thread([this] { Run(); });
+}
+
+AsyncWriter::~AsyncWriter() {
+  stopping.store(true, std::memory_order_release);
+  sem_post(&posted);
+  worker.join();
+  sem_destroy(&posted);
+}
+
+bool AsyncWriter::Post(Job &&job) {
+  RethrowError();
+
+  std::size_t t = tail.load(std::memory_order_relaxed);
+  if (t - head.load(std::memory_order_acquire) == CAPACITY) return false;
+
+  jobs[t % CAPACITY] = std::move(job);
+  tail.store(t + 1, std::memory_order_release);
+  sem_post(&posted);
+  return true;
+}
+
+void AsyncWriter::PostOrWait(Job &&job) {
+  // Post leaves job as is when it returns false
+  while (!Post(std::move(job))) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+void AsyncWriter::Flush() {
+  std::size_t t = tail.load(std::memory_order_relaxed);
+  while (head.load(std::memory_order_acquire) != t) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  RethrowError();
+}
+
+void AsyncWriter::RethrowError() {
+  if (failed.load(std::memory_order_acquire)) std::rethrow_exception(error);
+}
+
+void AsyncWriter::Run() {
+  while (true) {
+    while (sem_wait(&posted) == -1 && errno == EINTR) {
+    }
+
+    // Each job has been counted by its own sem_post, so the ring is empty
+    // here only when woken up for stopping, after all the jobs have run.
+    std::size_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire)) {
+      if (stopping.load(std::memory_order_acquire)) return;
+      continue;
+    }
+
+    Job job = std::move(jobs[h % CAPACITY]);
+    jobs[h % CAPACITY] = nullptr;
+    try {
+      job();
+    } catch (...) {
+      if (!failed.load(std::memory_order_relaxed)) {
+        error = std::current_exception();
+        failed.store(true, std::memory_order_release);
+      }
+    }
+    head.store(h + 1, std::memory_order_release);
+  }
+}
+
+bool WriteFileAtomically(const fs::path &path, const void *data,
+                         std::size_t len) {
+  auto tmp_path = path.string() + ".tmp";
+  int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                0600);
+  if (fd < 0) return false;
+
+  auto *p = static_cast<const char *>(data);
+  while (len) {
+    ssize_t n = write(fd, p, len);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      close(fd);
+      unlink(tmp_path.c_str());
+      return false;
+    }
+    p += n;
+    len -= n;
+  }
+  close(fd);
+
+  return rename(tmp_path.c_str(), path.c_str()) == 0;
+}
+
+}  // namespace fuzzuf::utils
@@ -0,0 +1,150 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file checkpoint.cpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#include "fuzzuf/utils/checkpoint.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+namespace fuzzuf::utils {
+
+namespace {
+
+u64 Checksum(const std::vector<u8> &data, std::size_t len) {
+  return XXH3_64bits(data.data(), len);
+}
+
+// Only async-signal-safe functions are called here, since this also runs in a
+// child forked by WriteCheckpointFileInBackground
+bool WriteAll(int fd, const void *buf, std::size_t len) {
+  auto *p = static_cast<const u8 *>(buf);
+  while (len) {
+    ssize_t n = write(fd, p, len);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+
+bool WriteAndRename(const char *tmp_path, const char *path,
+                    const std::vector<u8> &data, u64 checksum) {
+  int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd < 0) return false;
+
+  bool ok = WriteAll(fd, data.data(), data.size()) &&
+            WriteAll(fd, &checksum, sizeof(checksum)) && fsync(fd) == 0;
+  close(fd);
+
+  return ok && rename(tmp_path, path) == 0;
+}
+
+}  // namespace
+
+CheckpointReader::CheckpointReader(std::vector<u8> &&data)
+    : data(std::move(data)) {
+  if (Read<u64>() != CheckpointWriter::MAGIC) {
+    throw exceptions::invalid_file("Not a checkpoint", __FILE__, __LINE__);
+  }
+  version = Read<u32>();
+}
+
+void CheckpointReader::Take(void *dest, std::size_t size) {
+  if (size > data.size() - offset) {
+    throw exceptions::invalid_file("Checkpoint is truncated", __FILE__,
+                                   __LINE__);
+  }
+  if (size) std::memcpy(dest, data.data() + offset, size);
+  offset += size;
+}
+
+bool CheckpointWriter::ResolveFileSizes() {
+  for (const auto &file_size : file_sizes) {
+    struct stat st;
+    if (stat(file_size.path.c_str(), &st) < 0) return false;
+    u32 size = st.st_size;
+    std::memcpy(data.data() + file_size.offset, &size, sizeof(size));
+  }
+  return true;
+}
+
+void WriteCheckpointFile(const fs::path &path, CheckpointWriter &writer) {
+  auto tmp_path = path.string() + ".tmp";
+  const auto &data = writer.GetData();
+  if (!writer.ResolveFileSizes() ||
+      !WriteAndRename(tmp_path.c_str(), path.c_str(), data,
+                      Checksum(data, data.size()))) {
+    throw exceptions::unable_to_create_file(
+        "Unable to write checkpoint " + path.string(), __FILE__, __LINE__);
+  }
+}
+
+pid_t WriteCheckpointFileInBackground(const fs::path &path,
+                                      CheckpointWriter &writer) {
+  // Everything the child allocates is prepared before fork. The child
+  // modifies only its own copy of writer.
+  auto tmp_path = path.string() + ".tmp";
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    const auto &data = writer.GetData();
+    _exit(writer.ResolveFileSizes() &&
+                  WriteAndRename(tmp_path.c_str(), path.c_str(), data,
+                                 Checksum(data, data.size()))
+              ? 0
+              : 1);
+  }
+  return pid;
+}
+
+CheckpointReader ReadCheckpointFile(const fs::path &path) {
+  std::vector<u8> data;
+  int fd = -1;
+  try {
+    fd = OpenFile(path.string(), O_RDONLY | O_CLOEXEC);
+    ReadFileAll(fd, data);
+  } catch (const FileError &e) {
+    if (fd >= 0) CloseFile(fd);
+    throw exceptions::invalid_file(e.what(), __FILE__, __LINE__);
+  }
+  CloseFile(fd);
+
+  u64 checksum;
+  if (data.size() < sizeof(checksum)) {
+    throw exceptions::invalid_file("Checkpoint is truncated", __FILE__,
+                                   __LINE__);
+  }
+  std::size_t len = data.size() - sizeof(checksum);
+  std::memcpy(&checksum, data.data() + len, sizeof(checksum));
+  if (checksum != Checksum(data, len)) {
+    throw exceptions::invalid_file("Checkpoint checksum mismatch", __FILE__,
+                                   __LINE__);
+  }
+  data.resize(len);
+
+  return CheckpointReader(std::move(data));
+}
+
+}  // namespace fuzzuf::utils
@@ -0,0 +1,257 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file compact_bitmap.cpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#include "fuzzuf/utils/compact_bitmap.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace fuzzuf::utils {
+
+CompactBitmap::CompactBitmap(const std::vector<u32> &sorted_indices) {
+  auto it = sorted_indices.begin();
+  while (it != sorted_indices.end()) {
+    u16 key = *it >> 16;
+    auto chunk_end = std::find_if(it, sorted_indices.end(),
+                                  [key](u32 i) { return (i >> 16) != key; });
+
+    Chunk chunk;
+    chunk.key = key;
+    chunk.count = std::distance(it, chunk_end);
+    if (chunk.count <= ARRAY_MAX) {
+      chunk.array.reserve(chunk.count);
+      for (; it != chunk_end; it++) chunk.array.push_back(u16(*it));
+    } else {
+      chunk.words.assign(WORDS, 0);
+      for (; it != chunk_end; it++) {
+        chunk.words[u16(*it) >> 6] |= u64(1) << (*it & 63);
+      }
+    }
+    chunks.push_back(std::move(chunk));
+  }
+}
+
+bool CompactBitmap::Chunk::Test(u16 low) const {
+  if (words.empty()) return std::binary_search(array.begin(), array.end(), low);
+  return (words[low >> 6] >> (low & 63)) & 1;
+}
+
+void CompactBitmap::Chunk::ToWords() {
+  if (!words.empty()) return;
+
+  words.assign(WORDS, 0);
+  for (u16 low : array) words[low >> 6] |= u64(1) << (low & 63);
+  array.clear();
+  array.shrink_to_fit();
+}
+
+// Recompute count and choose the representation taking less memory
+void CompactBitmap::Chunk::Normalize() {
+  if (words.empty()) {
+    count = array.size();
+    if (count > ARRAY_MAX) ToWords();
+    return;
+  }
+
+  count = 0;
+  for (u64 word : words) count += __builtin_popcountll(word);
+  if (count > ARRAY_MAX) return;
+
+  array.clear();
+  array.reserve(count);
+  for (u32 w = 0; w < WORDS; w++) {
+    for (u64 word = words[w]; word; word &= word - 1) {
+      array.push_back(u16((w << 6) | u32(__builtin_ctzll(word))));
+    }
+  }
+  words.clear();
+  words.shrink_to_fit();
+}
+
+void CompactBitmap::UniteChunk(Chunk &dest, const Chunk &src) {
+  if (dest.words.empty() && src.words.empty()) {
+    std::vector<u16> united;
+    united.reserve(dest.array.size() + src.array.size());
+    std::set_union(dest.array.begin(), dest.array.end(), src.array.begin(),
+                   src.array.end(), std::back_inserter(united));
+    united.shrink_to_fit();
+    dest.array = std::move(united);
+  } else {
+    dest.ToWords();
+    if (src.words.empty()) {
+      for (u16 low : src.array) dest.words[low >> 6] |= u64(1) << (low & 63);
+    } else {
+      for (u32 w = 0; w < WORDS; w++) dest.words[w] |= src.words[w];
+    }
+  }
+  dest.Normalize();
+}
+
+void CompactBitmap::IntersectChunk(Chunk &dest, const Chunk &src) {
+  if (dest.words.empty()) {
+    std::vector<u16> common;
+    if (src.words.empty()) {
+      std::set_intersection(dest.array.begin(), dest.array.end(),
+                            src.array.begin(), src.array.end(),
+                            std::back_inserter(common));
+    } else {
+      std::copy_if(dest.array.begin(), dest.array.end(),
+                   std::back_inserter(common),
+                   [&src](u16 low) { return src.Test(low); });
+    }
+    common.shrink_to_fit();
+    dest.array = std::move(common);
+  } else if (src.words.empty()) {
+    std::vector<u16> common;
+    std::copy_if(src.array.begin(), src.array.end(), std::back_inserter(common),
+                 [&dest](u16 low) { return dest.Test(low); });
+    dest.words.clear();
+    dest.words.shrink_to_fit();
+    dest.array = std::move(common);
+  } else {
+    for (u32 w = 0; w < WORDS; w++) dest.words[w] &= src.words[w];
+  }
+  dest.Normalize();
+}
+
+bool CompactBitmap::ChunksIntersect(const Chunk &l, const Chunk &r) {
+  if (l.words.empty() && r.words.empty()) {
+    auto li = l.array.begin();
+    auto ri = r.array.begin();
+    while (li != l.array.end() && ri != r.array.end()) {
+      if (*li == *ri) return true;
+      if (*li < *ri)
+        li++;
+      else
+        ri++;
+    }
+    return false;
+  }
+
+  if (l.words.empty() || r.words.empty()) {
+    const auto &sparse = l.words.empty() ? l : r;
+    const auto &dense = l.words.empty() ? r : l;
+    return std::any_of(sparse.array.begin(), sparse.array.end(),
+                       [&dense](u16 low) { return dense.Test(low); });
+  }
+
+  for (u32 w = 0; w < WORDS; w++) {
+    if (l.words[w] & r.words[w]) return true;
+  }
+  return false;
+}
+
+const CompactBitmap::Chunk *CompactBitmap::FindChunk(u16 key) const {
+  auto it = std::lower_bound(
+      chunks.begin(), chunks.end(), key,
+      [](const Chunk &chunk, u16 key) { return chunk.key < key; });
+  if (it == chunks.end() || it->key != key) return nullptr;
+  return &*it;
+}
+
+bool CompactBitmap::Test(u32 index) const {
+  auto chunk = FindChunk(index >> 16);
+  return chunk && chunk->Test(u16(index));
+}
+
+std::size_t CompactBitmap::Count() const {
+  std::size_t count = 0;
+  for (const auto &chunk : chunks) count += chunk.count;
+  return count;
+}
+
+bool CompactBitmap::Intersects(const CompactBitmap &other) const {
+  auto li = chunks.begin();
+  auto ri = other.chunks.begin();
+  while (li != chunks.end() && ri != other.chunks.end()) {
+    if (li->key < ri->key) {
+      li++;
+    } else if (ri->key < li->key) {
+      ri++;
+    } else {
+      if (ChunksIntersect(*li, *ri)) return true;
+      li++;
+      ri++;
+    }
+  }
+  return false;
+}
+
+CompactBitmap &CompactBitmap::operator|=(const CompactBitmap &other) {
+  std::vector<Chunk> united;
+  united.reserve(chunks.size() + other.chunks.size());
+
+  auto li = chunks.begin();
+  auto ri = other.chunks.begin();
+  while (li != chunks.end() || ri != other.chunks.end()) {
+    if (ri == other.chunks.end() ||
+        (li != chunks.end() && li->key < ri->key)) {
+      united.push_back(std::move(*li++));
+    } else if (li == chunks.end() || ri->key < li->key) {
+      united.push_back(*ri++);
+    } else {
+      UniteChunk(*li, *ri++);
+      united.push_back(std::move(*li++));
+    }
+  }
+
+  chunks = std::move(united);
+  return *this;
+}
+
+CompactBitmap &CompactBitmap::operator&=(const CompactBitmap &other) {
+  std::vector<Chunk> common;
+
+  auto ri = other.chunks.begin();
+  for (auto &chunk : chunks) {
+    while (ri != other.chunks.end() && ri->key < chunk.key) ri++;
+    if (ri == other.chunks.end()) break;
+    if (ri->key != chunk.key) continue;
+
+    IntersectChunk(chunk, *ri);
+    if (chunk.count) common.push_back(std::move(chunk));
+  }
+
+  chunks = std::move(common);
+  return *this;
+}
+
+bool CompactBitmap::operator==(const CompactBitmap &other) const {
+  // Each chunk always takes the representation determined by its count, so
+  // equal sets have identical chunks
+  return std::equal(chunks.begin(), chunks.end(), other.chunks.begin(),
+                    other.chunks.end(), [](const Chunk &l, const Chunk &r) {
+                      return l.key == r.key && l.count == r.count &&
+                             l.array == r.array && l.words == r.words;
+                    });
+}
+
+std::size_t CompactBitmap::GetMemoryUsage() const {
+  std::size_t usage = chunks.capacity() * sizeof(Chunk);
+  for (const auto &chunk : chunks) {
+    usage += chunk.array.capacity() * sizeof(u16) +
+             chunk.words.capacity() * sizeof(u64);
+  }
+  return usage;
+}
+
+}  // namespace fuzzuf::utils
@@ -0,0 +1,288 @@
+/*
+ * fuzzuf
+ * Copyright (C) 2021-2023 Ricerca Security
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+/**
+ * @file cpu_affinity.cpp
+ * @author Ricerca Security <fuzzuf-dev@ricsec.co.jp>
+ */
+#include "fuzzuf/utils/cpu_affinity.hpp"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "fuzzuf/logger/logger.hpp"
+#include "fuzzuf/utils/common.hpp"
+
+namespace fuzzuf::utils {
+
+namespace {
+
+fs::path cpu_lock_dir = DEFAULT_CPU_LOCK_DIR;
+// CPU core ID -> fd of the lock file held by this process
+std::map<int, int> cpu_lock_fds;
+// CPU core IDs handed out by LockVacantCpu
+std::set<int> vacant_cpus_taken;
+bool bind_put_to_smt_sibling = false;
+int bound_cpuid = CPUID_DO_NOT_BIND;
+#if defined(__linux__)
+cpu_set_t put_cpu_set;
+
+bool SetAffinity(int cpuid) {
+  cpu_set_t c;
+  CPU_ZERO(&c);
+  CPU_SET(cpuid, &c);
+  return sched_setaffinity(0, sizeof(c), &c) == 0;
+}
+#endif /* defined(__linux__) */
+
+}  // namespace
+
+void SetCpuLockDir(const fs::path &dir) { cpu_lock_dir = dir; }
+
+bool LockCpu(int cpuid) {
+  if (cpu_lock_fds.count(cpuid)) return true;
+
+  // The directory is shared by all users on the host like /tmp, so its mode
+  // is set explicitly instead of depending on the umask of the first fuzzuf
+  // instance. chmod is needed since mkdir applies the umask.
+  std::error_code ec;
+  fs::create_directories(cpu_lock_dir.parent_path(), ec);
+  if (mkdir(cpu_lock_dir.c_str(), 01777) == 0)
+    chmod(cpu_lock_dir.c_str(), 01777);
+
+  // flock() doesn't need write access, so the lock files created by other
+  // users can be locked regardless of the umask
+  const auto path = cpu_lock_dir / StrPrintf("cpu%d.lock", cpuid);
+  int fd = open(path.c_str(), O_RDONLY | O_CREAT | O_CLOEXEC, 0666);
+  if (fd < 0) {
+    // Without the lock, another instance could take the same core
+    MSG(cYEL "[!] " cRST "Unable to open %s: %s\n", path.c_str(),
+        std::strerror(errno));
+    return false;
+  }
+
+  if (flock(fd, LOCK_EX | LOCK_NB) < 0) {
+    // EWOULDBLOCK means that another process holds the lock
+    if (errno != EWOULDBLOCK)
+      MSG(cYEL "[!] " cRST "Unable to lock %s: %s\n", path.c_str(),
+          std::strerror(errno));
+    close(fd);
+    return false;
+  }
+
+  cpu_lock_fds.emplace(cpuid, fd);
+  return true;
+}
+
+std::vector<int> GetSmtSiblings(int cpuid) {
+  // The list looks like "0,4" or "0-1"
+  std::ifstream list(StrPrintf(
+      "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpuid));
+  std::set<int> siblings{cpuid};
+  std::string range;
+  while (std::getline(list, range, ',')) {
+    int first, last;
+    if (std::sscanf(range.c_str(), "%d-%d", &first, &last) == 2) {
+      for (int i = first; i <= last; ++i) siblings.insert(i);
+    } else if (std::sscanf(range.c_str(), "%d", &first) == 1) {
+      siblings.insert(first);
+    }
+  }
+  return std::vector<int>(siblings.begin(), siblings.end());
+}
+
+void SetBindPutToSmtSibling(bool enable) { bind_put_to_smt_sibling = enable; }
+
+int GetBoundCpu() { return bound_cpuid; }
+
+void BindPutCpu() {
+#if defined(__linux__)
+  if (bound_cpuid == CPUID_DO_NOT_BIND) return;
+  sched_setaffinity(0, sizeof(put_cpu_set), &put_cpu_set); /* Ignore errors */
+#endif /* defined(__linux__) */
+}
+
+void BindPutCpu(int cpuid) {
+  if (cpuid == CPUID_DO_NOT_BIND) {
+    BindPutCpu();
+    return;
+  }
+#if defined(__linux__)
+  SetAffinity(cpuid); /* Ignore errors */
+#endif /* defined(__linux__) */
+}
+
+int LockVacantCpu(int cpu_core_count) {
+#if defined(__linux__)
+  for (int cpuid : GetFreeCpu(cpu_core_count)) {
+    // LockCpu succeeds for the cores this process has locked already
+    if (cpuid == bound_cpuid || cpu_lock_fds.count(cpuid) ||
+        vacant_cpus_taken.count(cpuid))
+      continue;
+    if (LockCpu(cpuid)) {
+      vacant_cpus_taken.insert(cpuid);
+      return cpuid;
+    }
+  }
+#endif /* defined(__linux__) */
+  return CPUID_DO_NOT_BIND;
+}
+
+void ReleaseVacantCpu(int cpuid) {
+  if (!vacant_cpus_taken.erase(cpuid)) return;
+
+  auto lock = cpu_lock_fds.find(cpuid);
+  if (lock == cpu_lock_fds.end()) return;
+  close(lock->second);
+  cpu_lock_fds.erase(lock);
+}
+
+/**
+ * Bind a CPU core to current process.
+ * The cpuid_to_bind argument takes the following possible value:
+ *   1. fuzzuf::utils::CPUID_DO_NOT_BIND: Do not bind to any CPU core.
+ *   2. fuzzuf::utils::CPUID BIND_WHICHEVER: Bind to a free CPU core.
+ *   3. Integer value in [0, cpu_core_count): Bind to the specified CPU core.
+ *
+ * A core is considered free if no other process is bound to it (checked by
+ * scanning /proc) and its lock file is not held by another fuzzuf instance.
+ * Among free cores, the ones whose SMT siblings are also free are preferred.
+ * Once bound, subsequent calls keep the same core, so that the CLI can bind
+ * the process before executors launch their fork servers (which inherit the
+ * affinity), and the fuzzing algorithms can still call this function.
+ *
+ * @note
+ * This function is splitted from NativeLinuxExecutor to reduce executor
+ * dependencies from fuzzing algorithms. Each algorithm is responsible for
+ * explicitly call this function if needed.
+ *
+ * @param cpu_core_count The number of the CPU core.
+ * @param cpuid_to_bind CPU core ID to bind to current process.
+ * @return Binded CPU core ID.
+ */
+int BindCpu(int cpu_core_count, int cpuid_to_bind) {
+#if defined(__linux__)
+  if (cpuid_to_bind == CPUID_DO_NOT_BIND) {
+    return CPUID_DO_NOT_BIND;
+  }
+
+  if (bound_cpuid != CPUID_DO_NOT_BIND) {
+    if (cpuid_to_bind != CPUID_BIND_WHICHEVER && cpuid_to_bind != bound_cpuid) {
+      ERROR("The process is already bound to the CPU core #%d", bound_cpuid);
+    }
+    // The calling thread may not have inherited the affinity
+    if (!SetAffinity(bound_cpuid)) {
+      ERROR("sched_setaffinity failed");
+    }
+    return bound_cpuid;
+  }
+
+  int binded_cpuid = CPUID_BIND_WHICHEVER;
+
+  // If cpuid_to_bind is not CPUID_DO_NOT_BIND,
+  // then this function tries to bind this process to a cpu core somehow
+  std::set<int> vacant_cpus = fuzzuf::utils::GetFreeCpu(cpu_core_count);
+
+  if (cpuid_to_bind == CPUID_BIND_WHICHEVER) {
+    // this means "don't care which cpu core, but should bind"
+
+    // Try idle physical cores first, then the rest of the vacant cores
+    std::vector<int> candidates;
+    for (int cpuid : vacant_cpus) {
+      bool idle = true;
+      for (int sibling : GetSmtSiblings(cpuid))
+        idle = idle && vacant_cpus.count(sibling);
+      if (idle) candidates.push_back(cpuid);
+    }
+    for (int cpuid : vacant_cpus) {
+      if (std::find(candidates.begin(), candidates.end(), cpuid) ==
+          candidates.end())
+        candidates.push_back(cpuid);
+    }
+
+    for (int cpuid : candidates) {
+      if (LockCpu(cpuid)) {
+        binded_cpuid = cpuid;
+        break;
+      }
+    }
+
+    if (binded_cpuid == CPUID_BIND_WHICHEVER) {
+      ERROR("No more free CPU cores");
+    }
+  } else {
+    if (cpuid_to_bind < 0 || cpu_core_count <= cpuid_to_bind) {
+      ERROR("The CPU core id to bind should be between 0 and %d",
+            cpu_core_count - 1);
+    }
+
+    if (vacant_cpus.count(cpuid_to_bind) == 0) {
+      ERROR("The CPU core #%d to bind is not free!", cpuid_to_bind);
+    }
+
+    if (!LockCpu(cpuid_to_bind)) {
+      ERROR("The CPU core #%d to bind is locked by another fuzzuf instance!",
+            cpuid_to_bind);
+    }
+
+    binded_cpuid = cpuid_to_bind;
+  }
+
+  if (!SetAffinity(binded_cpuid)) {
+    ERROR("sched_setaffinity failed");
+  }
+  bound_cpuid = binded_cpuid;
+
+  // PUT processes share the core with the fuzzer unless a free SMT sibling is
+  // requested and available
+  CPU_ZERO(&put_cpu_set);
+  CPU_SET(binded_cpuid, &put_cpu_set);
+  if (bind_put_to_smt_sibling) {
+    for (int sibling : GetSmtSiblings(binded_cpuid)) {
+      if (sibling != binded_cpuid && vacant_cpus.count(sibling) &&
+          LockCpu(sibling)) {
+        CPU_ZERO(&put_cpu_set);
+        CPU_SET(sibling, &put_cpu_set);
+        break;
+      }
+    }
+  }
+
+  return binded_cpuid;
+#else  /* defined(__linux__) */
+  (void)cpu_core_count;
+  if (cpuid_to_bind != CPUID_DO_NOT_BIND) {
+    DEBUG("In this environment, processes cannot be binded to a cpu core.");
+  }
+  return CPUID_DO_NOT_BIND;
+#endif /* ^defined(__linux__) */
+}
+
+}  // namespace fuzzuf::utils